@@ -49,6 +49,10 @@ typedef enum {
     LLAISYS_DTYPE_C64 = 17,
     LLAISYS_DTYPE_C128 = 18,
     LLAISYS_DTYPE_BF16 = 19,
+    // Two 4-bit weights per byte: a [rows, cols] weight is a [rows, cols / 2] Q4 tensor.
+    // Within every 32 columns, byte b holds column b in its low nibble and column b + 16
+    // in its high nibble. Only meaningful with the scales attached by the quantize op.
+    LLAISYS_DTYPE_Q4 = 20,
 } llaisysDataType_t;
 
 // Runtime Types
@@ -63,4 +67,10 @@ typedef enum {
     LLAISYS_MEMCPY_D2D = 3,
 } llaisysMemcpyKind_t;
 
+// Device Memory Allocators
+typedef enum {
+    LLAISYS_ALLOCATOR_NAIVE = 0,   // every storage is its own device allocation
+    LLAISYS_ALLOCATOR_CACHING = 1, // freed storages are kept in size-class bins for reuse
+} llaisysAllocatorType_t;
+
 #endif // __LLAISYS_H__
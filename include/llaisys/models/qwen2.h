@@ -1,6 +1,7 @@
 #ifndef LLAISYS_MODELS_QWEN2_H
 #define LLAISYS_MODELS_QWEN2_H
 
+#include "../ops.h"
 #include "../tensor.h"
 
 __C {
@@ -31,12 +32,99 @@ __C {
 
     struct LlaisysQwen2Model;
 
+    // Receives each token llaisysQwen2ModelGenerate emits, as it is emitted; a nonzero
+    // return stops the generation after that token.
+    typedef int (*llaisysTokenCallback_t)(int64_t token, void *user_data);
+
+    // Receives each token llaisysQwen2SchedulerStep emits, with the id of its request and
+    // whether it is the request's last; a nonzero return ends that request after it.
+    typedef int (*llaisysRequestTokenCallback_t)(uint64_t request, int64_t token, int last, void *user_data);
+
     __export struct LlaisysQwen2Model *llaisysQwen2ModelCreate(const LlaisysQwen2Meta *meta, llaisysDeviceType_t device, int *device_ids, int ndevice);
 
     __export void llaisysQwen2ModelDestroy(struct LlaisysQwen2Model * model);
 
+    // Weight tensors are allocated by the model with the shapes in its meta; fill them with tensorLoad.
     __export struct LlaisysQwen2Weights *llaisysQwen2ModelWeights(struct LlaisysQwen2Model * model);
 
+    // Fills the weights from Hugging Face .safetensors files, converting dtypes as needed, and
+    // returns the number of tensors taken. Every weight must be found except the attention
+    // biases, which stay zero, and lm_head.weight, which ties the LM head to the embedding;
+    // a missing one is an error. On CPU, weights already in the model dtype are
+    // mapped from the files instead of copied; the files may be deleted but not modified
+    // while the model lives. Handles from Weights stay valid and see the loaded tensors.
+    // `weight_dtype` is the model dtype, or LLAISYS_DTYPE_I8 / LLAISYS_DTYPE_Q4 to quantize the
+    // linear weights (attention and MLP projections and the LM head) while loading: I8 per
+    // output channel, Q4 in symmetric groups of 32 columns. Linear weights the files already
+    // hold quantized (NAME plus NAME.scales, and NAME.zeros for asymmetric Q4) are mapped as
+    // they are, whatever `weight_dtype` says.
+    __export size_t llaisysQwen2ModelLoadSafetensors(struct LlaisysQwen2Model * model, const char **paths, size_t npath,
+                                                     llaisysDataType_t weight_dtype);
+
+    // Lays the F32/F16/BF16 linear weights out once for this host's linear kernels, so no
+    // Infer call repacks them, and returns how many were packed. CPU only; call after the
+    // weights are loaded. `cache_path` (may be null) names a file kept next to the
+    // checkpoint: when it matches the weights and the kernels it is mapped instead of
+    // packing, otherwise it is (re)written. Packed weights handles can only feed llaisysLinear.
+    // Each layer's q, k and v projections are packed together for llaisysLinearQKV, and its
+    // gate and up projections for llaisysLinearSwiGLU; each counts as the weights it holds,
+    // and their attn_q_w, attn_k_w, attn_v_w, mlp_gate_w and mlp_up_w handles are left empty.
+    __export size_t llaisysQwen2ModelPrepack(struct LlaisysQwen2Model * model, const char *cache_path);
+
+    // Runs `ntoken` tokens that continue the sequence held in the model's KV cache and
+    // returns the greedy next token. The first call after Create or Reset passes the prompt.
     __export int64_t llaisysQwen2ModelInfer(struct LlaisysQwen2Model * model, int64_t * token_ids, size_t ntoken);
+
+    // Infer with the next token drawn as llaisysSample does, the penalties looking at the
+    // whole cached sequence. The seed is offset by the sequence length, so every step draws
+    // afresh and a generation replays exactly from the same params.
+    __export int64_t llaisysQwen2ModelInferSample(struct LlaisysQwen2Model * model, int64_t * token_ids, size_t ntoken,
+                                                  const struct LlaisysSamplingParams *params);
+
+    // Generates from `prompt_ids` in one call: resets the model, runs the prompt, then decodes
+    // one token at a time with `params` as llaisysQwen2ModelInferSample does. Each new token
+    // goes to `callback` (may be null) with `user_data`. Stops after `max_new_tokens` tokens,
+    // after meta.end_token (which is emitted), when the callback asks to, or when the
+    // sequence fills maxseq. Returns the number of tokens emitted.
+    __export size_t llaisysQwen2ModelGenerate(struct LlaisysQwen2Model * model, int64_t * prompt_ids, size_t n,
+                                              const struct LlaisysSamplingParams *params, size_t max_new_tokens,
+                                              llaisysTokenCallback_t callback, void *user_data);
+
+    // Plans the activation memory for Infer calls of up to `max_tokens` tokens and returns its
+    // size in bytes. Longer inputs still work and run in chunks of this size. Create plans for
+    // 256 tokens (or maxseq, if smaller); a decode step never allocates memory.
+    __export size_t llaisysQwen2ModelReserve(struct LlaisysQwen2Model * model, size_t max_tokens);
+
+    // Drops the cached sequence so that the next Infer starts a new one.
+    __export void llaisysQwen2ModelReset(struct LlaisysQwen2Model * model);
+
+    // Continuous batching of many generations on one model, which must outlive it. Each Step
+    // is one batched forward pass that decodes a token for every running request and runs
+    // up to `prefill_chunk` prompt tokens besides, admitting queued requests as the chunk has
+    // room, so a long prompt is prefilled over several steps while the others keep decoding.
+    // Finished requests retire at once. Up to `max_batch` requests run at once; their KV
+    // caches share `num_blocks` blocks of `block_size` positions, which must hold at least
+    // maxseq positions. When the blocks run out the newest request is put back in the queue
+    // and later recomputed. The model's own Infer state is left alone.
+    struct LlaisysQwen2Scheduler;
+
+    __export struct LlaisysQwen2Scheduler *llaisysQwen2SchedulerCreate(struct LlaisysQwen2Model * model,
+                                                                       size_t max_batch, size_t num_blocks,
+                                                                       size_t block_size, size_t prefill_chunk);
+
+    __export void llaisysQwen2SchedulerDestroy(struct LlaisysQwen2Scheduler * scheduler);
+
+    // Queues a generation from `prompt_ids` and returns its request id. It stops as
+    // llaisysQwen2ModelGenerate does, `max_new_tokens` (positive) included, and draws its
+    // tokens with `params` from the same seeds as Generate; only the rounding of batched
+    // matrix products may differ.
+    __export uint64_t llaisysQwen2SchedulerSubmit(struct LlaisysQwen2Scheduler * scheduler, int64_t * prompt_ids,
+                                                  size_t n, const struct LlaisysSamplingParams *params,
+                                                  size_t max_new_tokens);
+
+    // Runs one iteration, passing each new token to `callback` (may be null) with
+    // `user_data`, and returns the number of requests still queued or running.
+    __export size_t llaisysQwen2SchedulerStep(struct LlaisysQwen2Scheduler * scheduler,
+                                              llaisysRequestTokenCallback_t callback, void *user_data);
 }
 #endif // LLAISYS_MODELS_QWEN2_H
@@ -4,14 +4,66 @@
 #include "tensor.h"
 
 __C {
+    // How llaisysSample picks a token, in this order: penalties, temperature, top-k, top-p.
+    struct LlaisysSamplingParams {
+        float temperature;        // logits are divided by it; <= 0 picks the most likely token
+        size_t top_k;             // draw among the k most likely tokens; 0 keeps all, 1 is greedy
+        float top_p;              // then among the fewest that hold top_p of their mass; 1 keeps all
+        float repetition_penalty; // > 0; 1 disables it
+        float presence_penalty;   // 0 disables it
+        uint64_t seed;            // the draw is a function of the seed alone
+    };
+
     __export void llaisysAdd(llaisysTensor_t c, llaisysTensor_t a, llaisysTensor_t b);
+    // residual += in, then out = rms_norm(residual) with `weight`, in one pass: the residual
+    // add and norm of a transformer layer without a second trip over the hidden state.
+    __export void llaisysAddRmsNorm(llaisysTensor_t out, llaisysTensor_t residual, llaisysTensor_t in, llaisysTensor_t weight, float eps);
     __export void llaisysArgmax(llaisysTensor_t max_idx, llaisysTensor_t max_val, llaisysTensor_t vals);
     __export void llaisysEmbedding(llaisysTensor_t out, llaisysTensor_t index, llaisysTensor_t weight);
     __export void llaisysLinear(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, llaisysTensor_t bias);
+    // The k largest outputs of llaisysLinear(in, weight) without a bias per input row, largest
+    // first, into idx [n, k] (int64) and val [n, k]; ties keep the lower index. The outputs
+    // themselves are never written, e.g. an LM head picks its tokens without any logits.
+    __export void llaisysLinearTopK(llaisysTensor_t idx, llaisysTensor_t val, llaisysTensor_t in, llaisysTensor_t weight);
+    // Repack an F32/F16/BF16 [out_features, in_features] weight once into the layout of this
+    // host's linear kernels. The returned tensor only feeds llaisysLinear; destroy it with
+    // tensorDestroy.
+    __export llaisysTensor_t llaisysLinearPrepack(llaisysTensor_t weight);
+    // Pack the q, k and v projection weights as one [nq + nk + nv, in_features] weight for
+    // llaisysLinearQKV (llaisysLinear takes it too). Destroy it with tensorDestroy.
+    __export llaisysTensor_t llaisysLinearPrepackQKV(llaisysTensor_t q, llaisysTensor_t k, llaisysTensor_t v);
+    // q, k and v projections in one pass over `in`, each written to its own contiguous tensor
+    // (e.g. rows of a KV cache); the biases may be null. With pos_ids and a rope_table from
+    // llaisysROPETable (both may be null), q and k are stored already rotated.
+    __export void llaisysLinearQKV(llaisysTensor_t q, llaisysTensor_t k, llaisysTensor_t v, llaisysTensor_t in,
+                                   llaisysTensor_t weight, llaisysTensor_t q_bias, llaisysTensor_t k_bias,
+                                   llaisysTensor_t v_bias, llaisysTensor_t pos_ids, llaisysTensor_t rope_table);
+    // Pack the [di, in_features] gate and up weights of a SwiGLU MLP together for
+    // llaisysLinearSwiGLU; the result is [2 * di, in_features]. Destroy it with tensorDestroy.
+    __export llaisysTensor_t llaisysLinearPrepackGateUp(llaisysTensor_t gate, llaisysTensor_t up);
+    // out = silu(in * gate^T) * (in * up^T) in one pass, gate_up from llaisysLinearPrepackGateUp.
+    __export void llaisysLinearSwiGLU(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t gate_up);
+    // Quantize a [rows, cols] weight; `out` gets `scales` (and `zeros`) attached, after which
+    // it can stand in for the weight in llaisysLinear. I8: per-output-channel, F32 scales
+    // [rows, 1], zeros null. Q4: out [rows, cols / 2], F16 scales [rows, groups] with groups
+    // of a multiple of 32 columns, and optional U8 zero points shaped like the scales.
+    __export void llaisysQuantize(llaisysTensor_t out, llaisysTensor_t scales, llaisysTensor_t in, llaisysTensor_t zeros);
     __export void llaisysRearrange(llaisysTensor_t out, llaisysTensor_t in);
     __export void llaisysRmsNorm(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, float eps);
     __export void llaisysROPE(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t pos_ids, float theta);
+    // Fill an F32 [npos, head_dim] table with the cos (first half of each row) and sin
+    // (second half) of the RoPE angles of positions 0..npos-1, for llaisysROPECached.
+    __export void llaisysROPETable(llaisysTensor_t table, float theta);
+    // llaisysROPE with the angles read from a llaisysROPETable table.
+    __export void llaisysROPECached(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t pos_ids, llaisysTensor_t table);
+    // Draw a token from `logits` into `idx` (one int64). Each distinct token of `history`
+    // (int64 ids, may be null) has its logit divided by repetition_penalty when positive,
+    // multiplied when negative, then lowered by presence_penalty. Equal seeds give equal
+    // tokens and consecutive seeds independent draws, so step the seed once per token.
+    __export void llaisysSample(llaisysTensor_t idx, llaisysTensor_t logits, llaisysTensor_t history,
+                                const struct LlaisysSamplingParams *params);
     __export void llaisysSelfAttention(llaisysTensor_t attn_val, llaisysTensor_t q, llaisysTensor_t k, llaisysTensor_t v, float scale);
+    __export void llaisysPagedSelfAttention(llaisysTensor_t attn_val, llaisysTensor_t q, llaisysTensor_t k_blocks, llaisysTensor_t v_blocks, llaisysTensor_t block_table, size_t kv_len, float scale);
     __export void llaisysSwiGLU(llaisysTensor_t out, llaisysTensor_t gate, llaisysTensor_t up);
 }
 
@@ -37,11 +37,38 @@ __C {
         memcpy_async_api memcpy_async;
     };
 
+    // Usage of a device allocator. Byte counts are in whole size classes.
+    struct LlaisysMemoryStats {
+        size_t bytes_in_use;           // held by live storages
+        size_t bytes_cached;           // freed and kept for reuse
+        size_t peak_bytes_in_use;      // high-water mark of bytes_in_use
+        size_t num_allocations;        // storages allocated so far
+        size_t num_device_allocations; // allocations that reached the device API
+    };
+
     // Llaisys API for getting the runtime APIs
     __export const LlaisysRuntimeAPI *llaisysGetRuntimeAPI(llaisysDeviceType_t);
 
     // Llaisys API for switching device context
     __export void llaisysSetContextRuntime(llaisysDeviceType_t, int);
+
+    // Llaisys API for the CPU thread pool shared by all CPU operators.
+    // num_threads <= 0 restores the default: LLAISYS_NUM_THREADS, or one thread per available CPU.
+    __export void llaisysSetNumThreads(int num_threads);
+    __export int llaisysGetNumThreads();
+    // Pin every worker thread to its own CPU (nonzero), or let the OS schedule them (zero).
+    __export void llaisysSetThreadPinning(uint8_t enable);
+
+    // Llaisys API for device memory allocators.
+    // Select the allocator for new storages on every device of `device_type`; existing storages
+    // are still returned to the allocator they came from. The default is LLAISYS_ALLOCATOR_CACHING
+    // unless the LLAISYS_ALLOCATOR environment variable is set to "naive".
+    __export void llaisysSetAllocator(llaisysDeviceType_t device_type, llaisysAllocatorType_t type);
+    __export llaisysAllocatorType_t llaisysGetAllocator(llaisysDeviceType_t device_type);
+    // Stats of the allocator currently selected for the device.
+    __export void llaisysGetMemoryStats(llaisysDeviceType_t device_type, int device_id, struct LlaisysMemoryStats *stats);
+    // Return all cached blocks of the device to the device API.
+    __export void llaisysTrimMemory(llaisysDeviceType_t device_type, int device_id);
 }
 
 #endif // LLAISYS_RUNTIME_H
@@ -13,6 +13,15 @@ __C {
         llaisysDeviceType_t device_type,
         int device_id);
 
+    // A read-only CPU tensor over `offset` and the following bytes of a file, mapped
+    // without copying. It keeps the mapping alive; ops may read it but not write it.
+    __export llaisysTensor_t tensorCreateFromFile(
+        const char *path,
+        size_t offset,
+        size_t *shape,
+        size_t ndim,
+        llaisysDataType_t dtype);
+
     __export void tensorDestroy(
         llaisysTensor_t tensor);
 
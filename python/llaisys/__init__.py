@@ -1,7 +1,9 @@
-from .runtime import RuntimeAPI
+from .runtime import RuntimeAPI, set_num_threads, get_num_threads, set_thread_pinning
+from .runtime import set_allocator, get_allocator, memory_stats, trim_memory
 from .libllaisys import DeviceType
 from .libllaisys import DataType
 from .libllaisys import MemcpyKind
+from .libllaisys import AllocatorType
 from .libllaisys import llaisysStream_t as Stream
 from .tensor import Tensor
 from .ops import Ops
@@ -10,9 +12,17 @@ from .models import *
 
 __all__ = [
     "RuntimeAPI",
+    "set_num_threads",
+    "get_num_threads",
+    "set_thread_pinning",
+    "set_allocator",
+    "get_allocator",
+    "memory_stats",
+    "trim_memory",
     "DeviceType",
     "DataType",
     "MemcpyKind",
+    "AllocatorType",
     "Stream",
     "Tensor",
     "Ops",
@@ -4,14 +4,19 @@ import ctypes
 from pathlib import Path
 
 from .runtime import load_runtime
-from .runtime import LlaisysRuntimeAPI
+from .runtime import LlaisysRuntimeAPI, LlaisysMemoryStats
 from .llaisys_types import llaisysDeviceType_t, DeviceType
 from .llaisys_types import llaisysDataType_t, DataType
 from .llaisys_types import llaisysMemcpyKind_t, MemcpyKind
+from .llaisys_types import llaisysAllocatorType_t, AllocatorType
 from .llaisys_types import llaisysStream_t
 from .tensor import llaisysTensor_t
 from .tensor import load_tensor
 from .ops import load_ops
+from .ops import LlaisysSamplingParams
+from .qwen2 import load_qwen2
+from .qwen2 import LlaisysQwen2Meta, LlaisysQwen2Weights, llaisysQwen2Model_t, llaisysTokenCallback_t
+from .qwen2 import llaisysQwen2Scheduler_t, llaisysRequestTokenCallback_t
 
 
 def load_shared_library():
@@ -38,11 +43,13 @@ LIB_LLAISYS = load_shared_library()
 load_runtime(LIB_LLAISYS)
 load_tensor(LIB_LLAISYS)
 load_ops(LIB_LLAISYS)
+load_qwen2(LIB_LLAISYS)
 
 
 __all__ = [
     "LIB_LLAISYS",
     "LlaisysRuntimeAPI",
+    "LlaisysMemoryStats",
     "llaisysStream_t",
     "llaisysTensor_t",
     "llaisysDataType_t",
@@ -51,5 +58,14 @@ __all__ = [
     "DeviceType",
     "llaisysMemcpyKind_t",
     "MemcpyKind",
+    "llaisysAllocatorType_t",
+    "AllocatorType",
     "llaisysStream_t",
+    "LlaisysSamplingParams",
+    "LlaisysQwen2Meta",
+    "LlaisysQwen2Weights",
+    "llaisysQwen2Model_t",
+    "llaisysTokenCallback_t",
+    "llaisysQwen2Scheduler_t",
+    "llaisysRequestTokenCallback_t",
 ]
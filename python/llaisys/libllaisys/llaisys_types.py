@@ -34,6 +34,7 @@ class DataType(IntEnum):
     C64 = 17
     C128 = 18
     BF16 = 19
+    Q4 = 20
 
 
 llaisysDataType_t = ctypes.c_int
@@ -49,6 +50,15 @@ class MemcpyKind(IntEnum):
 
 llaisysMemcpyKind_t = ctypes.c_int
 
+
+# Device Memory Allocator enum
+class AllocatorType(IntEnum):
+    NAIVE = 0
+    CACHING = 1
+
+
+llaisysAllocatorType_t = ctypes.c_int
+
 # Stream type (opaque pointer)
 llaisysStream_t = ctypes.c_void_p
 
@@ -59,5 +69,7 @@ __all__ = [
     "DataType",
     "llaisysMemcpyKind_t",
     "MemcpyKind",
+    "llaisysAllocatorType_t",
+    "AllocatorType",
     "llaisysStream_t",
 ]
@@ -1,10 +1,25 @@
 from .tensor import llaisysTensor_t
-from ctypes import c_float
+from ctypes import POINTER, Structure, c_float, c_size_t, c_uint64
+
+
+class LlaisysSamplingParams(Structure):
+    _fields_ = [
+        ("temperature", c_float),
+        ("top_k", c_size_t),
+        ("top_p", c_float),
+        ("repetition_penalty", c_float),
+        ("presence_penalty", c_float),
+        ("seed", c_uint64),
+    ]
+
 
 def load_ops(lib):
     lib.llaisysAdd.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
     lib.llaisysAdd.restype = None
 
+    lib.llaisysAddRmsNorm.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t, llaisysTensor_t, c_float]
+    lib.llaisysAddRmsNorm.restype = None
+
     lib.llaisysArgmax.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
     lib.llaisysArgmax.restype = None
 
@@ -14,6 +29,38 @@ def load_ops(lib):
     lib.llaisysLinear.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
     lib.llaisysLinear.restype = None
 
+    lib.llaisysLinearTopK.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
+    lib.llaisysLinearTopK.restype = None
+
+    lib.llaisysLinearPrepack.argtypes = [llaisysTensor_t]
+    lib.llaisysLinearPrepack.restype = llaisysTensor_t
+
+    lib.llaisysLinearPrepackQKV.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
+    lib.llaisysLinearPrepackQKV.restype = llaisysTensor_t
+
+    lib.llaisysLinearQKV.argtypes = [
+        llaisysTensor_t,
+        llaisysTensor_t,
+        llaisysTensor_t,
+        llaisysTensor_t,
+        llaisysTensor_t,
+        llaisysTensor_t,
+        llaisysTensor_t,
+        llaisysTensor_t,
+        llaisysTensor_t,  # pos_ids
+        llaisysTensor_t,  # rope_table
+    ]
+    lib.llaisysLinearQKV.restype = None
+
+    lib.llaisysLinearPrepackGateUp.argtypes = [llaisysTensor_t, llaisysTensor_t]
+    lib.llaisysLinearPrepackGateUp.restype = llaisysTensor_t
+
+    lib.llaisysLinearSwiGLU.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
+    lib.llaisysLinearSwiGLU.restype = None
+
+    lib.llaisysQuantize.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
+    lib.llaisysQuantize.restype = None
+
     lib.llaisysRearrange.argtypes = [llaisysTensor_t, llaisysTensor_t]
     lib.llaisysRearrange.restype = None
 
@@ -23,6 +70,20 @@ def load_ops(lib):
     lib.llaisysROPE.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t, c_float]
     lib.llaisysROPE.restype = None
 
+    lib.llaisysROPETable.argtypes = [llaisysTensor_t, c_float]
+    lib.llaisysROPETable.restype = None
+
+    lib.llaisysROPECached.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
+    lib.llaisysROPECached.restype = None
+
+    lib.llaisysSample.argtypes = [
+        llaisysTensor_t,  # idx
+        llaisysTensor_t,  # logits
+        llaisysTensor_t,  # history
+        POINTER(LlaisysSamplingParams),
+    ]
+    lib.llaisysSample.restype = None
+
     lib.llaisysSelfAttention.argtypes = [
         llaisysTensor_t,  # attn_val
         llaisysTensor_t,  # q
@@ -32,5 +93,16 @@ def load_ops(lib):
     ]
     lib.llaisysSelfAttention.restype = None
 
+    lib.llaisysPagedSelfAttention.argtypes = [
+        llaisysTensor_t,  # attn_val
+        llaisysTensor_t,  # q
+        llaisysTensor_t,  # k_blocks
+        llaisysTensor_t,  # v_blocks
+        llaisysTensor_t,  # block_table
+        c_size_t,  # kv_len
+        c_float    # scale
+    ]
+    lib.llaisysPagedSelfAttention.restype = None
+
     lib.llaisysSwiGLU.argtypes = [llaisysTensor_t, llaisysTensor_t, llaisysTensor_t]
     lib.llaisysSwiGLU.restype = None
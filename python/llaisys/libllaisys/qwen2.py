@@ -0,0 +1,137 @@
+from ctypes import CFUNCTYPE, POINTER, Structure, c_char_p, c_float, c_int, c_int64, c_size_t, c_uint64, c_void_p
+from .llaisys_types import llaisysDataType_t, llaisysDeviceType_t
+from .ops import LlaisysSamplingParams
+from .tensor import llaisysTensor_t
+
+
+class LlaisysQwen2Meta(Structure):
+    _fields_ = [
+        ("dtype", llaisysDataType_t),
+        ("nlayer", c_size_t),
+        ("hs", c_size_t),
+        ("nh", c_size_t),
+        ("nkvh", c_size_t),
+        ("dh", c_size_t),
+        ("di", c_size_t),
+        ("maxseq", c_size_t),
+        ("voc", c_size_t),
+        ("epsilon", c_float),
+        ("theta", c_float),
+        ("end_token", c_int64),
+    ]
+
+
+class LlaisysQwen2Weights(Structure):
+    _fields_ = [
+        ("in_embed", llaisysTensor_t),
+        ("out_embed", llaisysTensor_t),
+        ("out_norm_w", llaisysTensor_t),
+        ("attn_norm_w", POINTER(llaisysTensor_t)),
+        ("attn_q_w", POINTER(llaisysTensor_t)),
+        ("attn_q_b", POINTER(llaisysTensor_t)),
+        ("attn_k_w", POINTER(llaisysTensor_t)),
+        ("attn_k_b", POINTER(llaisysTensor_t)),
+        ("attn_v_w", POINTER(llaisysTensor_t)),
+        ("attn_v_b", POINTER(llaisysTensor_t)),
+        ("attn_o_w", POINTER(llaisysTensor_t)),
+        ("mlp_norm_w", POINTER(llaisysTensor_t)),
+        ("mlp_gate_w", POINTER(llaisysTensor_t)),
+        ("mlp_up_w", POINTER(llaisysTensor_t)),
+        ("mlp_down_w", POINTER(llaisysTensor_t)),
+    ]
+
+
+# Opaque model handle
+llaisysQwen2Model_t = c_void_p
+
+# int callback(int64_t token, void *user_data); nonzero stops the generation.
+llaisysTokenCallback_t = CFUNCTYPE(c_int, c_int64, c_void_p)
+
+# Opaque scheduler handle
+llaisysQwen2Scheduler_t = c_void_p
+
+# int callback(uint64_t request, int64_t token, int last, void *user_data); nonzero ends the request.
+llaisysRequestTokenCallback_t = CFUNCTYPE(c_int, c_uint64, c_int64, c_int, c_void_p)
+
+
+def load_qwen2(lib):
+    lib.llaisysQwen2ModelCreate.argtypes = [
+        POINTER(LlaisysQwen2Meta),
+        llaisysDeviceType_t,
+        POINTER(c_int),  # device_ids
+        c_int,  # ndevice
+    ]
+    lib.llaisysQwen2ModelCreate.restype = llaisysQwen2Model_t
+
+    lib.llaisysQwen2ModelDestroy.argtypes = [llaisysQwen2Model_t]
+    lib.llaisysQwen2ModelDestroy.restype = None
+
+    lib.llaisysQwen2ModelWeights.argtypes = [llaisysQwen2Model_t]
+    lib.llaisysQwen2ModelWeights.restype = POINTER(LlaisysQwen2Weights)
+
+    lib.llaisysQwen2ModelLoadSafetensors.argtypes = [
+        llaisysQwen2Model_t,
+        POINTER(c_char_p),  # paths
+        c_size_t,  # npath
+        llaisysDataType_t,  # weight_dtype
+    ]
+    lib.llaisysQwen2ModelLoadSafetensors.restype = c_size_t
+
+    lib.llaisysQwen2ModelPrepack.argtypes = [llaisysQwen2Model_t, c_char_p]
+    lib.llaisysQwen2ModelPrepack.restype = c_size_t
+
+    lib.llaisysQwen2ModelInfer.argtypes = [llaisysQwen2Model_t, POINTER(c_int64), c_size_t]
+    lib.llaisysQwen2ModelInfer.restype = c_int64
+
+    lib.llaisysQwen2ModelInferSample.argtypes = [
+        llaisysQwen2Model_t,
+        POINTER(c_int64),  # token_ids
+        c_size_t,  # ntoken
+        POINTER(LlaisysSamplingParams),
+    ]
+    lib.llaisysQwen2ModelInferSample.restype = c_int64
+
+    lib.llaisysQwen2ModelGenerate.argtypes = [
+        llaisysQwen2Model_t,
+        POINTER(c_int64),  # prompt_ids
+        c_size_t,  # n
+        POINTER(LlaisysSamplingParams),
+        c_size_t,  # max_new_tokens
+        llaisysTokenCallback_t,
+        c_void_p,  # user_data
+    ]
+    lib.llaisysQwen2ModelGenerate.restype = c_size_t
+
+    lib.llaisysQwen2ModelReserve.argtypes = [llaisysQwen2Model_t, c_size_t]
+    lib.llaisysQwen2ModelReserve.restype = c_size_t
+
+    lib.llaisysQwen2ModelReset.argtypes = [llaisysQwen2Model_t]
+    lib.llaisysQwen2ModelReset.restype = None
+
+    lib.llaisysQwen2SchedulerCreate.argtypes = [
+        llaisysQwen2Model_t,
+        c_size_t,  # max_batch
+        c_size_t,  # num_blocks
+        c_size_t,  # block_size
+        c_size_t,  # prefill_chunk
+    ]
+    lib.llaisysQwen2SchedulerCreate.restype = llaisysQwen2Scheduler_t
+
+    lib.llaisysQwen2SchedulerDestroy.argtypes = [llaisysQwen2Scheduler_t]
+    lib.llaisysQwen2SchedulerDestroy.restype = None
+
+    lib.llaisysQwen2SchedulerSubmit.argtypes = [
+        llaisysQwen2Scheduler_t,
+        POINTER(c_int64),  # prompt_ids
+        c_size_t,  # n
+        POINTER(LlaisysSamplingParams),
+        c_size_t,  # max_new_tokens
+    ]
+    lib.llaisysQwen2SchedulerSubmit.restype = c_uint64
+
+    lib.llaisysQwen2SchedulerStep.argtypes = [
+        llaisysQwen2Scheduler_t,
+        llaisysRequestTokenCallback_t,
+        c_void_p,  # user_data
+    ]
+    lib.llaisysQwen2SchedulerStep.restype = c_size_t
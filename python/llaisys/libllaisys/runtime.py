@@ -1,5 +1,5 @@
 import ctypes
-from ctypes import c_void_p, c_size_t, c_int, Structure, CFUNCTYPE
+from ctypes import c_void_p, c_size_t, c_int, c_uint8, Structure, CFUNCTYPE
 from .llaisys_types import *
 
 # Define function pointer types
@@ -38,6 +38,16 @@ class LlaisysRuntimeAPI(Structure):
     ]
 
 
+class LlaisysMemoryStats(Structure):
+    _fields_ = [
+        ("bytes_in_use", c_size_t),
+        ("bytes_cached", c_size_t),
+        ("peak_bytes_in_use", c_size_t),
+        ("num_allocations", c_size_t),
+        ("num_device_allocations", c_size_t),
+    ]
+
+
 # Load shared library
 def load_runtime(lib):
     # Declare API function prototypes
@@ -46,3 +56,24 @@ def load_runtime(lib):
 
     lib.llaisysSetContextRuntime.argtypes = [llaisysDeviceType_t, c_int]
     lib.llaisysSetContextRuntime.restype = None
+
+    lib.llaisysSetNumThreads.argtypes = [c_int]
+    lib.llaisysSetNumThreads.restype = None
+
+    lib.llaisysGetNumThreads.argtypes = []
+    lib.llaisysGetNumThreads.restype = c_int
+
+    lib.llaisysSetThreadPinning.argtypes = [c_uint8]
+    lib.llaisysSetThreadPinning.restype = None
+
+    lib.llaisysSetAllocator.argtypes = [llaisysDeviceType_t, llaisysAllocatorType_t]
+    lib.llaisysSetAllocator.restype = None
+
+    lib.llaisysGetAllocator.argtypes = [llaisysDeviceType_t]
+    lib.llaisysGetAllocator.restype = llaisysAllocatorType_t
+
+    lib.llaisysGetMemoryStats.argtypes = [llaisysDeviceType_t, c_int, ctypes.POINTER(LlaisysMemoryStats)]
+    lib.llaisysGetMemoryStats.restype = None
+
+    lib.llaisysTrimMemory.argtypes = [llaisysDeviceType_t, c_int]
+    lib.llaisysTrimMemory.restype = None
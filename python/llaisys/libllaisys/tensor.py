@@ -1,4 +1,4 @@
-from ctypes import POINTER, c_uint8, c_void_p, c_size_t, c_ssize_t, c_int
+from ctypes import POINTER, c_char_p, c_uint8, c_void_p, c_size_t, c_ssize_t, c_int
 from .llaisys_types import llaisysDataType_t, llaisysDeviceType_t
 
 # Handle type
@@ -15,6 +15,15 @@ def load_tensor(lib):
     ]
     lib.tensorCreate.restype = llaisysTensor_t
 
+    lib.tensorCreateFromFile.argtypes = [
+        c_char_p,  # path
+        c_size_t,  # offset
+        POINTER(c_size_t),  # shape
+        c_size_t,  # ndim
+        llaisysDataType_t,  # dtype
+    ]
+    lib.tensorCreateFromFile.restype = llaisysTensor_t
+
     # Function: tensorDestroy
     lib.tensorDestroy.argtypes = [llaisysTensor_t]
     lib.tensorDestroy.restype = None
@@ -1,23 +1,85 @@
-from typing import Sequence
+from typing import Callable, Sequence
 from ..libllaisys import LIB_LLAISYS
-from ..libllaisys import DeviceType
+from ..libllaisys import DeviceType, DataType
+from ..libllaisys import LlaisysQwen2Meta, LlaisysSamplingParams, llaisysTokenCallback_t
+from ..libllaisys import llaisysRequestTokenCallback_t
 
+from ctypes import byref, c_char_p, c_int, c_int64
 from pathlib import Path
-import safetensors
+import json
 
 
-class Qwen2:
+_DTYPES = {
+    "float32": DataType.F32,
+    "float16": DataType.F16,
+    "bfloat16": DataType.BF16,
+}
+
 
-    def __init__(self, model_path, device: DeviceType = DeviceType.CPU):
-        # TODO: Implement model constructor
+class Qwen2:
 
+    def __init__(
+        self,
+        model_path,
+        device: DeviceType = DeviceType.CPU,
+        max_seq_len: int = 4096,
+        weight_dtype: DataType = None,
+        prepack: bool = True,
+        prepack_cache: bool = True,
+    ):
+        # weight_dtype=DataType.I8 (per output channel) or DataType.Q4 (groups of 32) quantizes
+        # the linear weights at load. Checkpoints from scripts/quantize_qwen2.py are
+        # already quantized and load as they are.
+        # prepack lays the remaining float linear weights out for the CPU kernels once, here,
+        # instead of on every call; with prepack_cache the result is kept in
+        # MODEL_DIR/llaisys.packed and mapped by later loads on the same kind of CPU.
         model_path = Path(model_path)
+        with open(model_path / "config.json") as f:
+            config = json.load(f)
+
+        dtype = _DTYPES[config.get("torch_dtype", "bfloat16")]
+        eos = config.get("eos_token_id", -1)
+        self.end_token = eos[0] if isinstance(eos, list) else eos
+        nh = config["num_attention_heads"]
+        # The KV cache is allocated for the whole context up front, so cap it.
+        self.max_seq_len = min(config.get("max_position_embeddings", max_seq_len), max_seq_len)
+
+        meta = LlaisysQwen2Meta(
+            dtype=dtype,
+            nlayer=config["num_hidden_layers"],
+            hs=config["hidden_size"],
+            nh=nh,
+            nkvh=config.get("num_key_value_heads", nh),
+            dh=config["hidden_size"] // nh,
+            di=config["intermediate_size"],
+            maxseq=self.max_seq_len,
+            voc=config["vocab_size"],
+            epsilon=config.get("rms_norm_eps", 1e-6),
+            theta=config.get("rope_theta", 10000.0),
+            end_token=self.end_token,
+        )
+        device_ids = (c_int * 1)(0)
+        self._model = LIB_LLAISYS.llaisysQwen2ModelCreate(byref(meta), device, device_ids, 1)
 
-        for file in sorted(model_path.glob("*.safetensors")):
-            data_ = safetensors.safe_open(file, framework="numpy", device="cpu")
-            for name_ in data_.keys():
-                ## TODO: load the model weights
-                pass
+        # Parsed, mapped and converted natively; tied embeddings need no lm_head.weight.
+        # A checkpoint missing any other weight fails the load.
+        files = sorted(str(f).encode() for f in model_path.glob("*.safetensors"))
+        if not files:
+            raise FileNotFoundError(f"no .safetensors files in {model_path}")
+        paths = (c_char_p * len(files))(*files)
+        if weight_dtype is None:
+            weight_dtype = dtype
+        LIB_LLAISYS.llaisysQwen2ModelLoadSafetensors(self._model, paths, len(files), weight_dtype)
+        if prepack and device == DeviceType.CPU:
+            cache = str(model_path / "llaisys.packed").encode() if prepack_cache else None
+            LIB_LLAISYS.llaisysQwen2ModelPrepack(self._model, cache)
+        # Weights mapped from the files, or packed, replaced ones allocated at creation.
+        LIB_LLAISYS.llaisysTrimMemory(device, 0)
+
+    def __del__(self):
+        if getattr(self, "_model", None) is not None:
+            LIB_LLAISYS.llaisysQwen2ModelDestroy(self._model)
+            self._model = None
 
     def generate(
         self,
@@ -26,8 +88,99 @@ class Qwen2:
         top_k: int = 1,
         top_p: float = 0.8,
         temperature: float = 0.8,
+        repetition_penalty: float = 1.0,
+        presence_penalty: float = 0.0,
+        seed: int = 0,
+        on_token: Callable[[int], bool] = None,
+    ):
+        # The whole generation runs natively in one call; tokens are drawn as llaisysSample
+        # does, so top_k=1 or temperature=0 is greedy and a seed replays the same output.
+        # on_token streams each new token as it is produced; returning True stops early.
+        if max_new_tokens is None:
+            max_new_tokens = 128
+        params = LlaisysSamplingParams(
+            temperature, top_k, top_p, repetition_penalty, presence_penalty, seed
+        )
+        tokens = list(inputs)
+        ids = (c_int64 * len(tokens))(*tokens)
+
+        def emit(token, _user_data):
+            tokens.append(token)
+            return 1 if on_token is not None and on_token(token) else 0
+
+        LIB_LLAISYS.llaisysQwen2ModelGenerate(
+            self._model, ids, len(ids), byref(params), max_new_tokens, llaisysTokenCallback_t(emit), None
+        )
+        return tokens
+
+    def scheduler(
+        self, max_batch: int = 16, num_blocks: int = None, block_size: int = 16, prefill_chunk: int = 128
     ):
+        # A Qwen2Scheduler serving many generations at once on this model. By default the
+        # shared KV cache has room for max_batch full-length sequences. Prompts are run
+        # prefill_chunk tokens per step alongside the decodes.
+        if num_blocks is None:
+            num_blocks = max_batch * -(-self.max_seq_len // block_size)
+        return Qwen2Scheduler(self, max_batch, num_blocks, block_size, prefill_chunk)
+
+
+class Qwen2Scheduler:
+    # Continuous batching: submit() queues generations and every step() advances all the
+    # running ones by a token in one batched forward pass, along with a chunk of the prompts
+    # being prefilled, admitting queued ones as others finish. Generations draw from the
+    # same seeds as Qwen2.generate, so greedy ones match it up to the rounding of wider
+    # batches.
+
+    def __init__(self, model: Qwen2, max_batch: int, num_blocks: int, block_size: int, prefill_chunk: int):
+        self._model = model  # kept alive for the native scheduler
+        self._scheduler = LIB_LLAISYS.llaisysQwen2SchedulerCreate(
+            model._model, max_batch, num_blocks, block_size, prefill_chunk
+        )
+
+    def __del__(self):
+        if getattr(self, "_scheduler", None) is not None:
+            LIB_LLAISYS.llaisysQwen2SchedulerDestroy(self._scheduler)
+            self._scheduler = None
+
+    def submit(
+        self,
+        inputs: Sequence[int],
+        max_new_tokens: int = None,
+        top_k: int = 1,
+        top_p: float = 0.8,
+        temperature: float = 0.8,
+        repetition_penalty: float = 1.0,
+        presence_penalty: float = 0.0,
+        seed: int = 0,
+    ) -> int:
+        # Queue a generation with Qwen2.generate's arguments and return its request id.
+        if max_new_tokens is None:
+            max_new_tokens = 128
+        params = LlaisysSamplingParams(
+            temperature, top_k, top_p, repetition_penalty, presence_penalty, seed
+        )
+        ids = (c_int64 * len(inputs))(*inputs)
+        return LIB_LLAISYS.llaisysQwen2SchedulerSubmit(self._scheduler, ids, len(ids), byref(params), max_new_tokens)
+
+    def step(self, on_token: Callable[[int, int, bool], bool] = None) -> int:
+        # Run one iteration. on_token(request, token, last) sees every new token; returning
+        # True ends that request. Returns how many requests are still queued or running.
+        def emit(request, token, last, _user_data):
+            return 1 if on_token is not None and on_token(request, token, bool(last)) else 0
+
+        return LIB_LLAISYS.llaisysQwen2SchedulerStep(self._scheduler, llaisysRequestTokenCallback_t(emit), None)
+
+    def generate(self, batch: Sequence[Sequence[int]], **kwargs):
+        # Run every input of `batch` to completion with submit()'s arguments, along with any
+        # requests already queued, and return the inputs followed by their generated tokens.
+        outputs = {self.submit(inputs, **kwargs): list(inputs) for inputs in batch}
+        order = list(outputs)
 
-        # TODO: Implement generate function
+        def collect(request, token, _last):
+            if request in outputs:
+                outputs[request].append(token)
+            return False
 
-        return []
+        while self.step(collect):
+            pass
+        return [outputs[request] for request in order]
@@ -1,6 +1,6 @@
-from .libllaisys import LIB_LLAISYS
+from .libllaisys import LIB_LLAISYS, LlaisysSamplingParams
 from .tensor import Tensor
-from ctypes import c_float, c_int
+from ctypes import byref, c_float, c_int, c_size_t
 
 
 class Ops:
@@ -8,6 +8,13 @@ class Ops:
     def add(c: Tensor, a: Tensor, b: Tensor):
         LIB_LLAISYS.llaisysAdd(c.lib_tensor(), a.lib_tensor(), b.lib_tensor())
 
+    @staticmethod
+    def add_rms_norm(out: Tensor, residual: Tensor, inp: Tensor, weight: Tensor, eps: float):
+        # residual += inp, then out = rms_norm(residual, weight, eps).
+        LIB_LLAISYS.llaisysAddRmsNorm(
+            out.lib_tensor(), residual.lib_tensor(), inp.lib_tensor(), weight.lib_tensor(), c_float(eps)
+        )
+
     @staticmethod
     def argmax(max_idx: Tensor, max_val: Tensor, vals: Tensor):
         LIB_LLAISYS.llaisysArgmax(max_idx.lib_tensor(), max_val.lib_tensor(), vals.lib_tensor())
@@ -19,9 +26,69 @@ class Ops:
         )
 
     @staticmethod
-    def linear(out: Tensor, inp: Tensor, weight: Tensor, bias: Tensor):
+    def linear(out: Tensor, inp: Tensor, weight: Tensor, bias: Tensor = None):
         LIB_LLAISYS.llaisysLinear(
-            out.lib_tensor(), inp.lib_tensor(), weight.lib_tensor(), bias.lib_tensor()
+            out.lib_tensor(),
+            inp.lib_tensor(),
+            weight.lib_tensor(),
+            None if bias is None else bias.lib_tensor(),
+        )
+
+    @staticmethod
+    def linear_topk(idx: Tensor, val: Tensor, inp: Tensor, weight: Tensor):
+        # The idx.shape()[1] largest outputs of each row, without computing the whole row.
+        LIB_LLAISYS.llaisysLinearTopK(idx.lib_tensor(), val.lib_tensor(), inp.lib_tensor(), weight.lib_tensor())
+
+    @staticmethod
+    def linear_prepack(weight: Tensor) -> Tensor:
+        # The weight repacked for this host's kernels; only Ops.linear can read it.
+        return Tensor(tensor=LIB_LLAISYS.llaisysLinearPrepack(weight.lib_tensor()))
+
+    @staticmethod
+    def linear_prepack_qkv(q: Tensor, k: Tensor, v: Tensor) -> Tensor:
+        # The three attention projections packed as one weight, for Ops.linear_qkv or Ops.linear.
+        return Tensor(tensor=LIB_LLAISYS.llaisysLinearPrepackQKV(q.lib_tensor(), k.lib_tensor(), v.lib_tensor()))
+
+    @staticmethod
+    def linear_qkv(
+        q: Tensor,
+        k: Tensor,
+        v: Tensor,
+        inp: Tensor,
+        weight: Tensor,
+        q_bias: Tensor = None,
+        k_bias: Tensor = None,
+        v_bias: Tensor = None,
+        pos_ids: Tensor = None,
+        rope_table: Tensor = None,
+    ):
+        # With pos_ids and a table from Ops.rope_table, q and k come out rotated.
+        LIB_LLAISYS.llaisysLinearQKV(
+            q.lib_tensor(),
+            k.lib_tensor(),
+            v.lib_tensor(),
+            inp.lib_tensor(),
+            weight.lib_tensor(),
+            *(None if t is None else t.lib_tensor() for t in (q_bias, k_bias, v_bias, pos_ids, rope_table)),
+        )
+
+    @staticmethod
+    def linear_prepack_gate_up(gate: Tensor, up: Tensor) -> Tensor:
+        # Both MLP projections packed together; only Ops.linear_swiglu can read it.
+        return Tensor(tensor=LIB_LLAISYS.llaisysLinearPrepackGateUp(gate.lib_tensor(), up.lib_tensor()))
+
+    @staticmethod
+    def linear_swiglu(out: Tensor, inp: Tensor, gate_up: Tensor):
+        # out = silu(inp @ gate.T) * (inp @ up.T), in one pass over inp.
+        LIB_LLAISYS.llaisysLinearSwiGLU(out.lib_tensor(), inp.lib_tensor(), gate_up.lib_tensor())
+
+    @staticmethod
+    def quantize(out: Tensor, scales: Tensor, inp: Tensor, zeros: Tensor = None):
+        LIB_LLAISYS.llaisysQuantize(
+            out.lib_tensor(),
+            scales.lib_tensor(),
+            inp.lib_tensor(),
+            None if zeros is None else zeros.lib_tensor(),
         )
 
     @staticmethod
@@ -40,6 +107,40 @@ class Ops:
             out.lib_tensor(), inp.lib_tensor(), pos_ids.lib_tensor(), c_float(theta)
         )
 
+    @staticmethod
+    def rope_table(table: Tensor, theta: float):
+        # cos | sin of the angles of every position, [npos, head_dim] F32, for Ops.rope_cached.
+        LIB_LLAISYS.llaisysROPETable(table.lib_tensor(), c_float(theta))
+
+    @staticmethod
+    def rope_cached(out: Tensor, inp: Tensor, pos_ids: Tensor, table: Tensor):
+        LIB_LLAISYS.llaisysROPECached(
+            out.lib_tensor(), inp.lib_tensor(), pos_ids.lib_tensor(), table.lib_tensor()
+        )
+
+    @staticmethod
+    def sample(
+        idx: Tensor,
+        logits: Tensor,
+        history: Tensor = None,
+        temperature: float = 1.0,
+        top_k: int = 0,
+        top_p: float = 1.0,
+        repetition_penalty: float = 1.0,
+        presence_penalty: float = 0.0,
+        seed: int = 0,
+    ):
+        # Draws one token id into idx; equal seeds draw equal tokens.
+        params = LlaisysSamplingParams(
+            temperature, top_k, top_p, repetition_penalty, presence_penalty, seed
+        )
+        LIB_LLAISYS.llaisysSample(
+            idx.lib_tensor(),
+            logits.lib_tensor(),
+            history.lib_tensor() if history is not None else None,
+            byref(params),
+        )
+
     @staticmethod
     def self_attention(attn_val: Tensor, q: Tensor, k: Tensor, v: Tensor, scale: float):
         LIB_LLAISYS.llaisysSelfAttention(
@@ -50,6 +151,26 @@ class Ops:
             c_float(scale),
         )
 
+    @staticmethod
+    def paged_self_attention(
+        attn_val: Tensor,
+        q: Tensor,
+        k_blocks: Tensor,
+        v_blocks: Tensor,
+        block_table: Tensor,
+        kv_len: int,
+        scale: float,
+    ):
+        LIB_LLAISYS.llaisysPagedSelfAttention(
+            attn_val.lib_tensor(),
+            q.lib_tensor(),
+            k_blocks.lib_tensor(),
+            v_blocks.lib_tensor(),
+            block_table.lib_tensor(),
+            c_size_t(kv_len),
+            c_float(scale),
+        )
+
     @staticmethod
     def swiglu(out: Tensor, gate: Tensor, up: Tensor):
         LIB_LLAISYS.llaisysSwiGLU(out.lib_tensor(), gate.lib_tensor(), up.lib_tensor())
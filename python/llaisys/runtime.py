@@ -1,6 +1,6 @@
 from . import libllaisys
 from .libllaisys import LIB_LLAISYS
-from ctypes import c_void_p
+from ctypes import byref, c_void_p
 
 
 class RuntimeAPI:
@@ -66,3 +66,35 @@ class RuntimeAPI:
         self._api.contents.memcpy_async(
             dst, src, size, libllaisys.llaisysMemcpyKind_t(kind), stream
         )
+
+
+# CPU thread pool shared by all CPU operators; num_threads <= 0 restores the default.
+def set_num_threads(num_threads: int) -> None:
+    LIB_LLAISYS.llaisysSetNumThreads(num_threads)
+
+
+def get_num_threads() -> int:
+    return LIB_LLAISYS.llaisysGetNumThreads()
+
+
+def set_thread_pinning(enable: bool) -> None:
+    LIB_LLAISYS.llaisysSetThreadPinning(1 if enable else 0)
+
+
+# Device memory allocator. New storages of every device of `device_type` use `allocator`.
+def set_allocator(device_type: libllaisys.DeviceType, allocator: libllaisys.AllocatorType) -> None:
+    LIB_LLAISYS.llaisysSetAllocator(device_type, allocator)
+
+
+def get_allocator(device_type: libllaisys.DeviceType) -> libllaisys.AllocatorType:
+    return libllaisys.AllocatorType(LIB_LLAISYS.llaisysGetAllocator(device_type))
+
+
+def memory_stats(device_type: libllaisys.DeviceType, device_id: int = 0) -> dict:
+    stats = libllaisys.LlaisysMemoryStats()
+    LIB_LLAISYS.llaisysGetMemoryStats(device_type, device_id, byref(stats))
+    return {name: getattr(stats, name) for name, _ in stats._fields_}
+
+
+def trim_memory(device_type: libllaisys.DeviceType, device_id: int = 0) -> None:
+    LIB_LLAISYS.llaisysTrimMemory(device_type, device_id)
@@ -33,6 +33,20 @@ class Tensor:
                 c_int(device_id),
             )
 
+    @staticmethod
+    def from_file(path, offset: int, shape: Sequence[int], dtype: DataType) -> "Tensor":
+        # Read-only CPU tensor mapped straight from the file, without a copy.
+        _shape = (c_size_t * len(shape))(*shape)
+        return Tensor(
+            tensor=LIB_LLAISYS.tensorCreateFromFile(
+                str(path).encode(),
+                c_size_t(offset),
+                _shape,
+                c_size_t(len(shape)),
+                llaisysDataType_t(dtype),
+            )
+        )
+
     def __del__(self):
         if hasattr(self, "_tensor") and self._tensor is not None:
             LIB_LLAISYS.tensorDestroy(self._tensor)
@@ -0,0 +1,174 @@
+"""Quantize the linear weights of a Qwen2 checkpoint offline.
+
+The output directory is a copy of the model whose .safetensors files hold the
+attention and MLP projections and the LM head quantized by llaisys itself, so the
+codes match what quantizing at load time would give:
+
+    NAME         I8 [rows, cols], or U8 [rows, cols / 2] holding packed Q4 bytes
+    NAME.scales  F32 [rows, 1] for I8, F16 [rows, cols / group] for Q4
+    NAME.zeros   U8 like the scales, for asymmetric Q4 only
+
+llaisys.models.Qwen2 maps these straight from the files, so loading needs neither
+the original weights nor any repacking.
+
+    python scripts/quantize_qwen2.py MODEL_DIR OUT_DIR --dtype q4 --group 128
+"""
+
+import argparse
+import ctypes
+import json
+import re
+import shutil
+import struct
+from pathlib import Path
+
+import llaisys
+
+LINEAR = re.compile(
+    r"(model\.layers\.\d+\.(self_attn\.[qkvo]_proj|mlp\.(gate|up|down)_proj)|lm_head)\.weight"
+)
+
+DTYPES = {
+    "F32": (llaisys.DataType.F32, 4),
+    "F16": (llaisys.DataType.F16, 2),
+    "BF16": (llaisys.DataType.BF16, 2),
+    "I8": (llaisys.DataType.I8, 1),
+    "U8": (llaisys.DataType.U8, 1),
+}
+
+
+def read_header(path: Path):
+    with open(path, "rb") as f:
+        (size,) = struct.unpack("<Q", f.read(8))
+        header = json.loads(f.read(size))
+    header.pop("__metadata__", None)
+    # Make the offsets absolute, as tensorCreateFromFile takes them.
+    for entry in header.values():
+        entry["offset"] = 8 + size + entry["data_offsets"][0]
+    return header
+
+
+class Output:
+    """A tensor of the output file: its dtype, shape and how to produce its bytes."""
+
+    def __init__(self, name, dtype, shape, produce):
+        self.name, self.dtype, self.shape, self.produce = name, dtype, shape, produce
+
+    def nbytes(self):
+        n = DTYPES[self.dtype][1]
+        for s in self.shape:
+            n *= s
+        return n
+
+
+def tensor_bytes(t: llaisys.Tensor, nbytes: int) -> bytes:
+    return ctypes.string_at(t.data_ptr(), nbytes)
+
+
+def quantized_outputs(path, name, entry, args):
+    rows, cols = entry["shape"]
+    src_dtype = DTYPES[entry["dtype"]][0]
+    if args.dtype == "i8":
+        q_dtype, q_shape, s_dtype, s_shape = llaisys.DataType.I8, (rows, cols), "F32", (rows, 1)
+        q_name = "I8"
+    else:
+        assert cols % args.group == 0, f"{name}: {cols} columns do not split into groups of {args.group}"
+        q_dtype, q_shape, s_dtype, s_shape = llaisys.DataType.Q4, (rows, cols // 2), "F16", (rows, cols // args.group)
+        q_name = "U8"
+    zeros = args.dtype == "q4" and args.asymmetric
+
+    # Quantized once, on the first of its outputs to be written.
+    cache = {}
+
+    def run():
+        if not cache:
+            w = llaisys.Tensor.from_file(path, entry["offset"], (rows, cols), src_dtype)
+            q = llaisys.Tensor(q_shape, q_dtype)
+            s = llaisys.Tensor(s_shape, DTYPES[s_dtype][0])
+            z = llaisys.Tensor(s_shape, llaisys.DataType.U8) if zeros else None
+            llaisys.Ops.quantize(q, s, w, z)
+            cache["q"] = tensor_bytes(q, q_shape[0] * q_shape[1])
+            cache["s"] = tensor_bytes(s, s_shape[0] * s_shape[1] * DTYPES[s_dtype][1])
+            cache["z"] = tensor_bytes(z, s_shape[0] * s_shape[1]) if zeros else None
+        return cache
+
+    outputs = [
+        Output(name, q_name, q_shape, lambda: run()["q"]),
+        Output(name + ".scales", s_dtype, s_shape, lambda: run()["s"]),
+    ]
+    if zeros:
+        outputs.append(Output(name + ".zeros", "U8", s_shape, lambda: run()["z"]))
+    return outputs
+
+
+def copied_output(path, name, entry):
+    def read():
+        with open(path, "rb") as f:
+            f.seek(entry["offset"])
+            return f.read(entry["data_offsets"][1] - entry["data_offsets"][0])
+
+    return Output(name, entry["dtype"], tuple(entry["shape"]), read)
+
+
+def write(path: Path, outputs, metadata):
+    # Widest elements first: the data section starts 8-byte aligned and has no holes,
+    # so every tensor ends up aligned to its element size for the mapped kernels.
+    outputs = sorted(outputs, key=lambda o: -DTYPES[o.dtype][1])
+    header = {"__metadata__": metadata}
+    offset = 0
+    for o in outputs:
+        header[o.name] = {"dtype": o.dtype, "shape": list(o.shape), "data_offsets": [offset, offset + o.nbytes()]}
+        offset += o.nbytes()
+    text = json.dumps(header, separators=(",", ":")).encode()
+    text += b" " * (-len(text) % 8)
+    with open(path, "wb") as f:
+        f.write(struct.pack("<Q", len(text)))
+        f.write(text)
+        for o in outputs:
+            data = o.produce()
+            assert len(data) == o.nbytes(), o.name
+            f.write(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("model", type=Path)
+    parser.add_argument("out", type=Path)
+    parser.add_argument("--dtype", default="q4", choices=["q4", "i8"])
+    parser.add_argument("--group", default=32, type=int, help="Q4 columns per scale, a multiple of 32")
+    parser.add_argument("--asymmetric", action="store_true", help="Q4 with a zero point per group")
+    args = parser.parse_args()
+    assert args.group > 0 and args.group % 32 == 0, "--group must be a multiple of 32"
+
+    args.out.mkdir(parents=True, exist_ok=True)
+    for f in args.model.iterdir():
+        # The packed-weight cache belongs to the source weights; the output gets its own.
+        if f.is_file() and f.suffix != ".safetensors" and f.name not in ("model.safetensors.index.json", "llaisys.packed"):
+            shutil.copy(f, args.out / f.name)
+
+    with open(args.model / "config.json") as f:
+        config = json.load(f)
+    files = sorted(args.model.glob("*.safetensors"))
+    headers = {path: read_header(path) for path in files}
+    has_lm_head = any("lm_head.weight" in h for h in headers.values())
+
+    metadata = {"format": "pt", "llaisys.quantization": args.dtype}
+    if args.dtype == "q4":
+        metadata["llaisys.q4_group"] = str(args.group)
+        metadata["llaisys.q4_zeros"] = str(args.asymmetric).lower()
+    for path in files:
+        outputs = []
+        for name, entry in headers[path].items():
+            if LINEAR.fullmatch(name):
+                outputs += quantized_outputs(path, name, entry, args)
+            else:
+                outputs.append(copied_output(path, name, entry))
+            if name == "model.embed_tokens.weight" and not has_lm_head and config.get("tie_word_embeddings", True):
+                # Tied: the input side stays in the model dtype, the LM head gets its own quantized copy.
+                outputs += quantized_outputs(path, "lm_head.weight", entry, args)
+        print(f"{path.name}: {len(outputs)} tensors")
+        write(args.out / path.name, outputs, metadata)
+
+
+if __name__ == "__main__":
+    main()
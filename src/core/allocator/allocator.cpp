@@ -0,0 +1,105 @@
+#include "allocator.hpp"
+
+#include "caching_allocator.hpp"
+#include "naive_allocator.hpp"
+
+#include "../../device/runtime_api.hpp"
+#include "../../utils.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace llaisys::core::allocators {
+namespace {
+llaisysAllocatorType_t defaultAllocatorType() {
+    if (const char *env = std::getenv("LLAISYS_ALLOCATOR")) {
+        if (std::strcmp(env, "naive") == 0) {
+            return LLAISYS_ALLOCATOR_NAIVE;
+        }
+    }
+    return LLAISYS_ALLOCATOR_CACHING;
+}
+
+struct Registry {
+    std::array<std::atomic<llaisysAllocatorType_t>, LLAISYS_DEVICE_TYPE_COUNT> types;
+    std::mutex mutex;
+    std::map<std::tuple<llaisysDeviceType_t, int, llaisysAllocatorType_t>, MemoryAllocator *> allocators;
+
+    Registry() {
+        const auto type = defaultAllocatorType();
+        for (auto &t : types) {
+            t.store(type);
+        }
+    }
+};
+
+// Never destroyed: storages and thread caches may still release into the
+// allocators while static and thread-local objects are torn down at exit.
+Registry &registry() {
+    static Registry *instance = new Registry;
+    return *instance;
+}
+
+void checkDeviceType(llaisysDeviceType_t device_type) {
+    CHECK_ARGUMENT(device_type >= 0 && device_type < LLAISYS_DEVICE_TYPE_COUNT, "invalid device type");
+}
+} // namespace
+
+llaisysAllocatorType_t allocatorType(llaisysDeviceType_t device_type) {
+    checkDeviceType(device_type);
+    return registry().types[device_type].load();
+}
+
+void setAllocatorType(llaisysDeviceType_t device_type, llaisysAllocatorType_t type) {
+    checkDeviceType(device_type);
+    CHECK_ARGUMENT(type == LLAISYS_ALLOCATOR_NAIVE || type == LLAISYS_ALLOCATOR_CACHING, "invalid allocator type");
+    registry().types[device_type].store(type);
+}
+
+MemoryAllocator *deviceAllocator(llaisysDeviceType_t device_type, int device_id, llaisysAllocatorType_t type) {
+    checkDeviceType(device_type);
+    auto &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto &allocator = reg.allocators[{device_type, device_id, type}];
+    if (allocator == nullptr) {
+        const LlaisysRuntimeAPI *api = llaisys::device::getRuntimeAPI(device_type);
+        switch (type) {
+        case LLAISYS_ALLOCATOR_NAIVE:
+            allocator = new NaiveAllocator(api);
+            break;
+        case LLAISYS_ALLOCATOR_CACHING:
+            allocator = new CachingAllocator(api);
+            break;
+        default:
+            CHECK_ARGUMENT(false, "invalid allocator type");
+        }
+    }
+    return allocator;
+}
+
+MemoryAllocator *deviceAllocator(llaisysDeviceType_t device_type, int device_id) {
+    return deviceAllocator(device_type, device_id, allocatorType(device_type));
+}
+
+void trimDevice(llaisysDeviceType_t device_type, int device_id) {
+    checkDeviceType(device_type);
+    auto &reg = registry();
+    std::vector<MemoryAllocator *> allocators;
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (const auto &[key, allocator] : reg.allocators) {
+            if (std::get<0>(key) == device_type && std::get<1>(key) == device_id) {
+                allocators.push_back(allocator);
+            }
+        }
+    }
+    for (auto allocator : allocators) {
+        allocator->trim();
+    }
+}
+} // namespace llaisys::core::allocators
@@ -14,6 +14,26 @@ public:
     virtual ~MemoryAllocator() = default;
     virtual std::byte *allocate(size_t size) = 0;
     virtual void release(std::byte *memory) = 0;
+    // Usage counters; figures an allocator does not track are left zero.
+    virtual LlaisysMemoryStats stats() const = 0;
+    // Return cached memory to the device. Allocators that cache nothing do nothing.
+    virtual void trim() {}
 };
 
+namespace allocators {
+// Allocators are process-wide: every thread's runtime of a device shares them, so
+// memory freed on one thread can be reused on another. They are created on first
+// use and live until the process exits.
+
+// Allocator type for new storages on devices of `device_type`.
+llaisysAllocatorType_t allocatorType(llaisysDeviceType_t device_type);
+void setAllocatorType(llaisysDeviceType_t device_type, llaisysAllocatorType_t type);
+
+// Allocator of the given type, or of the currently selected type, for a device.
+MemoryAllocator *deviceAllocator(llaisysDeviceType_t device_type, int device_id, llaisysAllocatorType_t type);
+MemoryAllocator *deviceAllocator(llaisysDeviceType_t device_type, int device_id);
+
+// Trim every allocator created for a device.
+void trimDevice(llaisysDeviceType_t device_type, int device_id);
+} // namespace allocators
 } // namespace llaisys::core
@@ -0,0 +1,303 @@
+#include "caching_allocator.hpp"
+
+#include "../../utils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace llaisys::core::allocators {
+namespace {
+constexpr size_t SMALL_SIZE = 4096;
+constexpr size_t LARGE_SIZE = size_t(32) << 20;
+constexpr size_t LARGE_STEP = size_t(2) << 20;
+
+size_t roundUp(size_t size, size_t step) {
+    return (size + step - 1) / step * step;
+}
+
+std::byte *alignUp(std::byte *raw) {
+    auto address = reinterpret_cast<uintptr_t>(raw);
+    address = (address + CachingAllocator::ALIGNMENT - 1) & ~uintptr_t(CachingAllocator::ALIGNMENT - 1);
+    return reinterpret_cast<std::byte *>(address);
+}
+
+// Set once the calling thread's caches are gone, so storages released during
+// thread teardown go straight to the shared bins.
+thread_local bool thread_caches_destroyed = false;
+} // namespace
+
+// A thread's caches, one per allocator it has used. On thread exit their blocks
+// move to the shared bins of their allocators.
+struct ThreadCacheHolder {
+    std::vector<std::shared_ptr<CachingAllocator::ThreadCache>> caches;
+
+    ~ThreadCacheHolder() {
+        thread_caches_destroyed = true;
+        for (auto &cache : caches) {
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            if (cache->owner != nullptr) {
+                cache->owner->_detach(*cache);
+            }
+        }
+    }
+};
+
+CachingAllocator::CachingAllocator(const LlaisysRuntimeAPI *runtime_api)
+    : MemoryAllocator(runtime_api), _bytes_in_use(0), _bytes_cached(0), _peak_bytes_in_use(0),
+      _num_allocations(0), _num_device_allocations(0) {
+}
+
+CachingAllocator::~CachingAllocator() {
+    trim();
+    std::vector<std::shared_ptr<ThreadCache>> caches;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        caches.swap(_thread_caches);
+    }
+    for (auto &cache : caches) {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        cache->owner = nullptr;
+    }
+}
+
+size_t CachingAllocator::sizeClass(size_t size) {
+    if (size <= SMALL_SIZE) {
+        return std::max(ALIGNMENT, roundUp(size, ALIGNMENT));
+    }
+    if (size > LARGE_SIZE) {
+        return roundUp(size, LARGE_STEP);
+    }
+    // Quarter steps of the largest power of two not above size: at most 25% waste.
+    size_t power = SMALL_SIZE;
+    while (power <= size / 2) {
+        power *= 2;
+    }
+    return roundUp(size, power / 4);
+}
+
+size_t CachingAllocator::LiveTable::_home(std::byte *memory) const {
+    // Fibonacci hashing; the low bits are always zero and also pick the shard.
+    const uint64_t key = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(memory) / ALIGNMENT);
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (_slots.size() - 1);
+}
+
+void CachingAllocator::LiveTable::_grow() {
+    std::vector<Slot> old(std::max<size_t>(_slots.size() * 2, 64));
+    old.swap(_slots);
+    _count = 0;
+    for (const Slot &slot : old) {
+        if (slot.memory != nullptr) {
+            insert(slot.memory, slot.block);
+        }
+    }
+}
+
+void CachingAllocator::LiveTable::insert(std::byte *memory, const Block &block) {
+    // Keep the load factor at or below 3/4.
+    if ((_count + 1) * 4 > _slots.size() * 3) {
+        _grow();
+    }
+    const size_t mask = _slots.size() - 1;
+    size_t i = _home(memory);
+    while (_slots[i].memory != nullptr) {
+        i = (i + 1) & mask;
+    }
+    _slots[i] = Slot{memory, block};
+    _count++;
+}
+
+bool CachingAllocator::LiveTable::take(std::byte *memory, Block &block) {
+    if (_count == 0) {
+        return false;
+    }
+    const size_t mask = _slots.size() - 1;
+    size_t i = _home(memory);
+    while (_slots[i].memory != memory) {
+        if (_slots[i].memory == nullptr) {
+            return false;
+        }
+        i = (i + 1) & mask;
+    }
+    block = _slots[i].block;
+    // Shift the rest of the probe run back over the hole instead of leaving a tombstone.
+    for (size_t j = (i + 1) & mask; _slots[j].memory != nullptr; j = (j + 1) & mask) {
+        const size_t home = _home(_slots[j].memory);
+        // Move entry j into the hole unless its home lies cyclically in (i, j].
+        const bool stays = i < j ? (home > i && home <= j) : (home > i || home <= j);
+        if (!stays) {
+            _slots[i] = _slots[j];
+            i = j;
+        }
+    }
+    _slots[i].memory = nullptr;
+    _count--;
+    return true;
+}
+
+CachingAllocator::Shard &CachingAllocator::_shard(std::byte *memory) {
+    return _live[(reinterpret_cast<uintptr_t>(memory) / ALIGNMENT) % NUM_SHARDS];
+}
+
+CachingAllocator::ThreadCache *CachingAllocator::_threadCache() {
+    if (thread_caches_destroyed) {
+        return nullptr;
+    }
+    thread_local ThreadCacheHolder holder;
+    for (auto &cache : holder.caches) {
+        if (cache->owner == this) {
+            return cache.get();
+        }
+    }
+    auto cache = std::make_shared<ThreadCache>();
+    cache->owner = this;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _thread_caches.push_back(cache);
+    }
+    holder.caches.push_back(cache);
+    return cache.get();
+}
+
+// Called with cache.mutex held.
+void CachingAllocator::_detach(ThreadCache &cache) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto &[size_class, blocks] : cache.bins) {
+        auto &bin = _bins[size_class];
+        bin.insert(bin.end(), blocks.begin(), blocks.end());
+    }
+    cache.bins.clear();
+    _thread_caches.erase(std::remove_if(_thread_caches.begin(), _thread_caches.end(),
+                                        [&](const auto &c) { return c.get() == &cache; }),
+                         _thread_caches.end());
+    cache.owner = nullptr;
+}
+
+std::byte *CachingAllocator::_deviceAllocate(size_t size_class, Block &block) {
+    block.raw = static_cast<std::byte *>(_api->malloc_device(size_class + ALIGNMENT));
+    if (block.raw == nullptr) {
+        // Out of memory: give the cached blocks back and try once more.
+        trim();
+        block.raw = static_cast<std::byte *>(_api->malloc_device(size_class + ALIGNMENT));
+    }
+    ASSERT(block.raw != nullptr, "CachingAllocator: out of device memory");
+    _num_device_allocations++;
+    return alignUp(block.raw);
+}
+
+void CachingAllocator::_freeBlocks(const std::vector<Block> &blocks) {
+    for (const auto &block : blocks) {
+        _bytes_cached -= block.size_class;
+        _api->free_device(block.raw);
+    }
+}
+
+std::byte *CachingAllocator::allocate(size_t size) {
+    const size_t size_class = sizeClass(size);
+    Block block{nullptr, size_class};
+
+    auto take = [&](std::unordered_map<size_t, std::vector<Block>> &bins) {
+        auto it = bins.find(size_class);
+        if (it == bins.end() || it->second.empty()) {
+            return false;
+        }
+        block = it->second.back();
+        it->second.pop_back();
+        return true;
+    };
+
+    bool cached = false;
+    if (size_class <= THREAD_CACHE_MAX_SIZE) {
+        if (ThreadCache *cache = _threadCache()) {
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            cached = take(cache->bins);
+        }
+    }
+    if (!cached) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        cached = take(_bins);
+    }
+
+    std::byte *memory;
+    if (cached) {
+        _bytes_cached -= size_class;
+        memory = alignUp(block.raw);
+    } else {
+        memory = _deviceAllocate(size_class, block);
+    }
+
+    {
+        auto &shard = _shard(memory);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.blocks.insert(memory, block);
+    }
+
+    _num_allocations++;
+    const size_t in_use = _bytes_in_use += size_class;
+    size_t peak = _peak_bytes_in_use.load();
+    while (in_use > peak && !_peak_bytes_in_use.compare_exchange_weak(peak, in_use)) {
+    }
+    return memory;
+}
+
+void CachingAllocator::release(std::byte *memory) {
+    if (memory == nullptr) {
+        return;
+    }
+    Block block;
+    {
+        auto &shard = _shard(memory);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const bool live = shard.blocks.take(memory, block);
+        ASSERT(live, "CachingAllocator: releasing memory it did not allocate");
+    }
+    _bytes_in_use -= block.size_class;
+    _bytes_cached += block.size_class;
+
+    if (block.size_class <= THREAD_CACHE_MAX_SIZE) {
+        if (ThreadCache *cache = _threadCache()) {
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            auto &bin = cache->bins[block.size_class];
+            if (bin.size() < THREAD_CACHE_DEPTH) {
+                bin.push_back(block);
+                return;
+            }
+        }
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _bins[block.size_class].push_back(block);
+}
+
+LlaisysMemoryStats CachingAllocator::stats() const {
+    LlaisysMemoryStats stats{};
+    stats.bytes_in_use = _bytes_in_use.load();
+    stats.bytes_cached = _bytes_cached.load();
+    stats.peak_bytes_in_use = _peak_bytes_in_use.load();
+    stats.num_allocations = _num_allocations.load();
+    stats.num_device_allocations = _num_device_allocations.load();
+    return stats;
+}
+
+void CachingAllocator::trim() {
+    std::vector<std::shared_ptr<ThreadCache>> caches;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        caches = _thread_caches;
+    }
+    std::vector<Block> blocks;
+    for (auto &cache : caches) {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        for (auto &[size_class, bin] : cache->bins) {
+            blocks.insert(blocks.end(), bin.begin(), bin.end());
+        }
+        cache->bins.clear();
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto &[size_class, bin] : _bins) {
+            blocks.insert(blocks.end(), bin.begin(), bin.end());
+        }
+        _bins.clear();
+    }
+    _freeBlocks(blocks);
+}
+} // namespace llaisys::core::allocators
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "allocator.hpp"
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace llaisys::core::allocators {
+// Caches freed blocks by size class instead of returning them to the device.
+//
+// Requests are rounded up to a size class (64-byte steps up to 4 KiB, then four
+// classes per power of two, then 2 MiB steps above 32 MiB) so that a steady-state
+// workload, such as decoding one token after another, keeps hitting the same bins
+// and stops calling the device API at all. Every block is 64-byte aligned.
+//
+// Small blocks are first kept in a per-thread cache of a few blocks per class;
+// the rest go to shared bins. trim() hands all cached blocks back to the device.
+class CachingAllocator : public MemoryAllocator {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+    // Largest class kept in per-thread caches, and how many blocks each class keeps.
+    static constexpr size_t THREAD_CACHE_MAX_SIZE = size_t(1) << 20;
+    static constexpr size_t THREAD_CACHE_DEPTH = 4;
+
+private:
+    struct Block {
+        std::byte *raw;    // pointer returned by the device API
+        size_t size_class; // usable bytes from the aligned pointer
+    };
+
+    struct ThreadCache {
+        // Only contended by trim() and thread exit.
+        std::mutex mutex;
+        CachingAllocator *owner;
+        std::unordered_map<size_t, std::vector<Block>> bins;
+    };
+    friend struct ThreadCacheHolder;
+
+    // Open-addressing table of live blocks by aligned pointer. It only allocates when
+    // it grows, so a steady-state workload tracks its blocks without touching the heap.
+    class LiveTable {
+    private:
+        struct Slot {
+            std::byte *memory = nullptr; // null for an empty slot
+            Block block;
+        };
+        std::vector<Slot> _slots;
+        size_t _count = 0;
+
+        size_t _home(std::byte *memory) const;
+        void _grow();
+
+    public:
+        void insert(std::byte *memory, const Block &block);
+        // Remove the entry of `memory` into `block`; false if there is none.
+        bool take(std::byte *memory, Block &block);
+    };
+
+    // Live blocks, sharded to keep concurrent frees apart.
+    static constexpr size_t NUM_SHARDS = 16;
+    struct Shard {
+        std::mutex mutex;
+        LiveTable blocks;
+    };
+    std::array<Shard, NUM_SHARDS> _live;
+
+    // Shared free bins and the registered thread caches.
+    std::mutex _mutex;
+    std::unordered_map<size_t, std::vector<Block>> _bins;
+    std::vector<std::shared_ptr<ThreadCache>> _thread_caches;
+
+    std::atomic<size_t> _bytes_in_use;
+    std::atomic<size_t> _bytes_cached;
+    std::atomic<size_t> _peak_bytes_in_use;
+    std::atomic<size_t> _num_allocations;
+    std::atomic<size_t> _num_device_allocations;
+
+    Shard &_shard(std::byte *memory);
+    ThreadCache *_threadCache();
+    void _detach(ThreadCache &cache);
+    std::byte *_deviceAllocate(size_t size_class, Block &block);
+    void _freeBlocks(const std::vector<Block> &blocks);
+
+public:
+    CachingAllocator(const LlaisysRuntimeAPI *runtime_api);
+    ~CachingAllocator();
+
+    std::byte *allocate(size_t size) override;
+    void release(std::byte *memory) override;
+    LlaisysMemoryStats stats() const override;
+    void trim() override;
+
+    // Size class a request of `size` bytes is served from.
+    static size_t sizeClass(size_t size);
+};
+} // namespace llaisys::core::allocators
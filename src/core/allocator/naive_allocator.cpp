@@ -3,14 +3,22 @@
 #include "../runtime/runtime.hpp"
 
 namespace llaisys::core::allocators {
-NaiveAllocator::NaiveAllocator(const LlaisysRuntimeAPI *runtime_api) : MemoryAllocator(runtime_api) {
+NaiveAllocator::NaiveAllocator(const LlaisysRuntimeAPI *runtime_api) : MemoryAllocator(runtime_api), _num_allocations(0) {
 }
 
 std::byte *NaiveAllocator::allocate(size_t size) {
+    _num_allocations++;
     return static_cast<std::byte *>(_api->malloc_device(size));
 }
 
 void NaiveAllocator::release(std::byte *memory) {
     _api->free_device(memory);
 }
-} // namespace llaisys::core::allocators
\ No newline at end of file
+
+LlaisysMemoryStats NaiveAllocator::stats() const {
+    LlaisysMemoryStats stats{};
+    stats.num_allocations = _num_allocations.load();
+    stats.num_device_allocations = stats.num_allocations;
+    return stats;
+}
+} // namespace llaisys::core::allocators
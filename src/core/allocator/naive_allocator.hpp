@@ -2,12 +2,20 @@
 
 #include "allocator.hpp"
 
+#include <atomic>
+
 namespace llaisys::core::allocators {
+// Passes every allocation straight to the device API. Only counts allocations,
+// since release() does not know the size of the block.
 class NaiveAllocator : public MemoryAllocator {
+private:
+    std::atomic<size_t> _num_allocations;
+
 public:
     NaiveAllocator(const LlaisysRuntimeAPI *runtime_api);
     ~NaiveAllocator() = default;
     std::byte *allocate(size_t size) override;
     void release(std::byte *memory) override;
+    LlaisysMemoryStats stats() const override;
 };
-} // namespace llaisys::core::allocators
\ No newline at end of file
+} // namespace llaisys::core::allocators
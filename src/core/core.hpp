@@ -10,9 +10,13 @@ class MemoryAllocator;
 
 class Runtime;
 class Context;
+class ThreadPool;
 
 // Global function to get thread local context
 Context &context();
+
+// Global function to get the process-wide CPU thread pool
+ThreadPool &threadPool();
 } // namespace core
 
 } // namespace llaisys
\ No newline at end of file
@@ -1,22 +1,31 @@
 #include "runtime.hpp"
 
 #include "../../device/runtime_api.hpp"
-#include "../allocator/naive_allocator.hpp"
+#include "../../utils.hpp"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace llaisys::core {
 Runtime::Runtime(llaisysDeviceType_t device_type, int device_id)
     : _device_type(device_type), _device_id(device_id), _is_active(false) {
     _api = llaisys::device::getRuntimeAPI(_device_type);
     _stream = _api->create_stream();
-    _allocator = new allocators::NaiveAllocator(_api);
 }
 
 Runtime::~Runtime() {
     if (!_is_active) {
         std::cerr << "Mallicious destruction of inactive runtime." << std::endl;
     }
-    delete _allocator;
-    _allocator = nullptr;
     _api->destroy_stream(_stream);
     _api = nullptr;
 }
@@ -47,18 +56,87 @@ const LlaisysRuntimeAPI *Runtime::api() const {
 }
 
 storage_t Runtime::allocateDeviceStorage(size_t size) {
-    return std::shared_ptr<Storage>(new Storage(_allocator->allocate(size), size, *this, false));
+    // Device memory comes from the allocator selected for this device, shared by all threads.
+    MemoryAllocator *allocator = allocators::deviceAllocator(_device_type, _device_id);
+    return std::shared_ptr<Storage>(new Storage(allocator->allocate(size), size, *this, allocator));
 }
 
 storage_t Runtime::allocateHostStorage(size_t size) {
-    return std::shared_ptr<Storage>(new Storage((std::byte *)_api->malloc_host(size), size, *this, true));
+    return std::shared_ptr<Storage>(new Storage((std::byte *)_api->malloc_host(size), size, *this, nullptr));
+}
+
+storage_t Runtime::mapFile(const std::string &path, size_t offset, size_t length) {
+    CHECK_ARGUMENT(_device_type == LLAISYS_DEVICE_CPU, "mapFile: only CPU memory can map files");
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    CHECK_ARGUMENT(file != INVALID_HANDLE_VALUE, "mapFile: cannot open file");
+    LARGE_INTEGER file_size_;
+    const bool stat_ok = GetFileSizeEx(file, &file_size_) != 0;
+    if (!stat_ok) {
+        CloseHandle(file);
+    }
+    CHECK_ARGUMENT(stat_ok, "mapFile: cannot stat file");
+    const size_t file_size = static_cast<size_t>(file_size_.QuadPart);
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const size_t granularity = info.dwAllocationGranularity;
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    CHECK_ARGUMENT(file >= 0, "mapFile: cannot open file");
+    struct stat st;
+    const bool stat_ok = ::fstat(file, &st) == 0;
+    if (!stat_ok) {
+        ::close(file);
+    }
+    CHECK_ARGUMENT(stat_ok, "mapFile: cannot stat file");
+    const size_t file_size = static_cast<size_t>(st.st_size);
+    const size_t granularity = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+#endif
+    if (length == 0 && offset < file_size) {
+        length = file_size - offset;
+    }
+    const bool in_range = length > 0 && offset <= file_size && length <= file_size - offset;
+    // Mappings start on a granularity boundary; the storage begins inside the first page.
+    const size_t start = offset / granularity * granularity;
+    const size_t mapping_size = offset + length - start;
+    void *mapping = nullptr;
+#if defined(_WIN32)
+    if (in_range) {
+        HANDLE file_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (file_mapping != nullptr) {
+            mapping = MapViewOfFile(file_mapping, FILE_MAP_READ, static_cast<DWORD>(uint64_t(start) >> 32),
+                                    static_cast<DWORD>(start), mapping_size);
+            CloseHandle(file_mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    if (in_range) {
+        mapping = ::mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, file, static_cast<off_t>(start));
+        if (mapping == MAP_FAILED) {
+            mapping = nullptr;
+        }
+    }
+    ::close(file);
+#endif
+    CHECK_ARGUMENT(in_range, "mapFile: range exceeds the file");
+    ASSERT(mapping != nullptr, "mapFile: failed to map file");
+    auto memory = static_cast<std::byte *>(mapping) + (offset - start);
+    return std::shared_ptr<Storage>(new Storage(memory, length, *this, mapping, mapping_size));
 }
 
 void Runtime::freeStorage(Storage *storage) {
-    if (storage->isHost()) {
+    if (storage->isMapped()) {
+#if defined(_WIN32)
+        UnmapViewOfFile(storage->_mapping);
+#else
+        ::munmap(storage->_mapping, storage->_mapping_size);
+#endif
+    } else if (storage->isHost()) {
         _api->free_host(storage->memory());
     } else {
-        _allocator->release(storage->memory());
+        storage->_allocator->release(storage->memory());
     }
 }
 
@@ -4,13 +4,14 @@
 #include "../../device/runtime_api.hpp"
 #include "../allocator/allocator.hpp"
 
+#include <string>
+
 namespace llaisys::core {
 class Runtime {
 private:
     llaisysDeviceType_t _device_type;
     int _device_id;
     const LlaisysRuntimeAPI *_api;
-    MemoryAllocator *_allocator;
     bool _is_active;
     void _activate();
     void _deactivate();
@@ -39,6 +40,10 @@ public:
     storage_t allocateDeviceStorage(size_t size);
     ;
     storage_t allocateHostStorage(size_t size);
+    // Map `length` bytes of a file from `offset` on, read-only (length 0: to the end of
+    // the file). CPU runtimes only. Pages are loaded on first touch and shared through
+    // the page cache with every other process mapping the same file.
+    storage_t mapFile(const std::string &path, size_t offset, size_t length);
     void freeStorage(Storage *storage);
 
     llaisysStream_t stream() const;
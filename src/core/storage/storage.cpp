@@ -3,8 +3,12 @@
 #include "../runtime/runtime.hpp"
 
 namespace llaisys::core {
-Storage::Storage(std::byte *memory, size_t size, Runtime &runtime, bool is_host)
-    : _memory(memory), _size(size), _runtime(runtime), _is_host(is_host) {}
+Storage::Storage(std::byte *memory, size_t size, Runtime &runtime, MemoryAllocator *allocator)
+    : _memory(memory), _size(size), _runtime(runtime), _allocator(allocator), _mapping(nullptr), _mapping_size(0) {}
+
+Storage::Storage(std::byte *memory, size_t size, Runtime &runtime, void *mapping, size_t mapping_size)
+    : _memory(memory), _size(size), _runtime(runtime), _allocator(nullptr), _mapping(mapping),
+      _mapping_size(mapping_size) {}
 
 Storage::~Storage() {
     _runtime.freeStorage(this);
@@ -35,6 +39,14 @@ int Storage::deviceId() const {
 }
 
 bool Storage::isHost() const {
-    return _is_host;
+    return _allocator == nullptr && _mapping == nullptr;
+}
+
+bool Storage::isMapped() const {
+    return _mapping != nullptr;
+}
+
+bool Storage::isReadOnly() const {
+    return isMapped();
 }
 } // namespace llaisys::core
\ No newline at end of file
@@ -11,8 +11,14 @@ private:
     std::byte *_memory;
     size_t _size;
     Runtime &_runtime;
-    bool _is_host;
-    Storage(std::byte *memory, size_t size, Runtime &runtime, bool is_host);
+    // The allocator device memory goes back to; null for host and mapped memory.
+    MemoryAllocator *_allocator;
+    // The whole mapped region of a file-backed storage, unmapped on destruction;
+    // _memory may start inside it. Null otherwise.
+    void *_mapping;
+    size_t _mapping_size;
+    Storage(std::byte *memory, size_t size, Runtime &runtime, MemoryAllocator *allocator);
+    Storage(std::byte *memory, size_t size, Runtime &runtime, void *mapping, size_t mapping_size);
 
 public:
     friend class Runtime;
@@ -23,6 +29,9 @@ public:
     llaisysDeviceType_t deviceType() const;
     int deviceId() const;
     bool isHost() const;
+    // File-backed memory mapped read-only by Runtime::mapFile.
+    bool isMapped() const;
+    bool isReadOnly() const;
 };
 
 }; // namespace llaisys::core
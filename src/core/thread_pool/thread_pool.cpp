@@ -0,0 +1,304 @@
+#include "thread_pool.hpp"
+
+#include "../../utils.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace llaisys::core {
+namespace {
+// Set while a thread runs loop bodies, so that nested loops run inline.
+thread_local bool t_in_parallel = false;
+
+// Yields before an idle worker blocks. Operators run back to back, so most loops
+// start while the workers are still spinning and skip the wake-up latency.
+constexpr int IDLE_SPINS = 2000;
+
+// CPUs this process may run on, in ascending order.
+std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        unsigned n = std::thread::hardware_concurrency();
+        for (unsigned cpu = 0; cpu < std::max(n, 1u); cpu++) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return cpus;
+}
+
+size_t defaultNumThreads() {
+    if (const char *env = std::getenv("LLAISYS_NUM_THREADS")) {
+        long n = std::strtol(env, nullptr, 10);
+        if (n > 0) {
+            return static_cast<size_t>(n);
+        }
+    }
+    return allowedCpus().size();
+}
+
+// Restrict `thread` to `cpu`, or to every allowed CPU when cpu < 0.
+void setAffinity(std::thread &thread, int cpu, const std::vector<int> &allowed) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpu >= 0) {
+        CPU_SET(cpu, &set);
+    } else {
+        for (int c : allowed) {
+            CPU_SET(c, &set);
+        }
+    }
+    pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    if (cpu >= 0) {
+        mask = DWORD_PTR(1) << (cpu % (8 * sizeof(DWORD_PTR)));
+    } else {
+        DWORD_PTR system_mask = 0;
+        GetProcessAffinityMask(GetCurrentProcess(), &mask, &system_mask);
+    }
+    SetThreadAffinityMask(static_cast<HANDLE>(thread.native_handle()), mask);
+#else
+    (void)thread;
+    (void)cpu;
+    (void)allowed;
+#endif
+}
+} // namespace
+
+ThreadPool::ThreadPool()
+    : _num_threads(defaultNumThreads()), _pinned(false), _generation(0), _busy(0), _stop(false),
+      _fn(nullptr), _begin(0), _end(0), _grain(1) {
+    _startWorkers();
+}
+
+ThreadPool::~ThreadPool() {
+    _stopWorkers();
+}
+
+void ThreadPool::_startWorkers() {
+    _queues.reset(new Queue[_num_threads]);
+    _stop = false;
+    // The caller is participant 0, worker w is participant w + 1.
+    const uint64_t generation = _generation.load();
+    for (size_t id = 1; id < _num_threads; id++) {
+        _workers.emplace_back(&ThreadPool::_workerLoop, this, id, generation);
+    }
+    if (_pinned) {
+        _applyPinning();
+    }
+}
+
+void ThreadPool::_stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (auto &worker : _workers) {
+        worker.join();
+    }
+    _workers.clear();
+}
+
+void ThreadPool::_workerLoop(size_t id, uint64_t seen) {
+    t_in_parallel = true;
+    while (true) {
+        for (int i = 0; i < IDLE_SPINS && _generation.load(std::memory_order_acquire) == seen; i++) {
+            std::this_thread::yield();
+        }
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [&] { return _stop || _generation.load() != seen; });
+            if (_stop) {
+                return;
+            }
+            seen = _generation.load();
+        }
+        _work(id);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_busy == 0) {
+                _done.notify_one();
+            }
+        }
+    }
+}
+
+void ThreadPool::_work(size_t id) {
+    size_t chunk;
+    do {
+        while (_pop(id, chunk)) {
+            _runChunk(chunk);
+        }
+    } while (_steal(id));
+}
+
+bool ThreadPool::_pop(size_t id, size_t &chunk) {
+    Queue &queue = _queues[id];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.begin == queue.end) {
+        return false;
+    }
+    chunk = queue.begin++;
+    return true;
+}
+
+bool ThreadPool::_steal(size_t id) {
+    for (size_t offset = 1; offset < _num_threads; offset++) {
+        Queue &victim = _queues[(id + offset) % _num_threads];
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            size_t available = victim.end - victim.begin;
+            if (available == 0) {
+                continue;
+            }
+            end = victim.end;
+            begin = end - (available + 1) / 2;
+            victim.end = begin;
+        }
+        Queue &own = _queues[id];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.begin = begin;
+        own.end = end;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::_runChunk(size_t chunk) {
+    size_t begin = _begin + chunk * _grain;
+    size_t end = std::min(_end, begin + _grain);
+    try {
+        (*_fn)(begin, end);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(_error_mutex);
+        if (!_error) {
+            _error = std::current_exception();
+        }
+    }
+}
+
+size_t ThreadPool::numThreads() const {
+    return _num_threads;
+}
+
+void ThreadPool::setNumThreads(size_t num_threads) {
+    ASSERT(!t_in_parallel, "ThreadPool: setNumThreads called from inside a parallel loop");
+    if (num_threads == 0) {
+        num_threads = defaultNumThreads();
+    }
+    std::lock_guard<std::mutex> job(_job_mutex);
+    if (num_threads == _num_threads) {
+        return;
+    }
+    _stopWorkers();
+    _num_threads = num_threads;
+    _startWorkers();
+}
+
+bool ThreadPool::pinned() const {
+    return _pinned;
+}
+
+void ThreadPool::setPinned(bool pinned) {
+    ASSERT(!t_in_parallel, "ThreadPool: setPinned called from inside a parallel loop");
+    std::lock_guard<std::mutex> job(_job_mutex);
+    _pinned = pinned;
+    _applyPinning();
+}
+
+void ThreadPool::_applyPinning() {
+    std::vector<int> cpus = allowedCpus();
+    for (size_t w = 0; w < _workers.size(); w++) {
+        setAffinity(_workers[w], _pinned ? cpus[(w + 1) % cpus.size()] : -1, cpus);
+    }
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain, ChunkFn fn) {
+    if (begin >= end) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    const size_t n_chunks = (end - begin + grain - 1) / grain;
+    if (t_in_parallel || n_chunks == 1) {
+        fn(begin, end);
+        return;
+    }
+
+    std::lock_guard<std::mutex> job(_job_mutex);
+    if (_workers.empty()) {
+        // Still inside the job lock, so reconfiguring from fn must be caught too.
+        t_in_parallel = true;
+        try {
+            fn(begin, end);
+        } catch (...) {
+            t_in_parallel = false;
+            throw;
+        }
+        t_in_parallel = false;
+        return;
+    }
+
+    // Hand every participant a contiguous run of chunks up front; stealing evens out the rest.
+    const size_t participants = std::min(_num_threads, n_chunks);
+    for (size_t id = 0; id < _num_threads; id++) {
+        Queue &queue = _queues[id];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.begin = id < participants ? n_chunks * id / participants : 0;
+        queue.end = id < participants ? n_chunks * (id + 1) / participants : 0;
+    }
+    _fn = &fn;
+    _begin = begin;
+    _end = end;
+    _grain = grain;
+    _error = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _busy = _workers.size();
+        _generation.fetch_add(1, std::memory_order_release);
+    }
+    _wake.notify_all();
+
+    t_in_parallel = true;
+    _work(0);
+    t_in_parallel = false;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [&] { return _busy == 0; });
+    }
+    _fn = nullptr;
+
+    if (_error) {
+        std::rethrow_exception(std::exchange(_error, nullptr));
+    }
+}
+
+ThreadPool &threadPool() {
+    static ThreadPool pool;
+    return pool;
+}
+} // namespace llaisys::core
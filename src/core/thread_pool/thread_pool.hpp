@@ -0,0 +1,122 @@
+#pragma once
+#include "../core.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace llaisys::core {
+// Non-owning reference to a loop body fn(chunk_begin, chunk_end). Unlike std::function
+// it never allocates, so operators can be called on the decode path without touching
+// the heap. The referenced callable must outlive the loop, as any argument does.
+class ChunkFn {
+private:
+    const void *_fn;
+    void (*_call)(const void *, size_t, size_t);
+
+public:
+    template <typename Fn>
+    ChunkFn(const Fn &fn)
+        : _fn(&fn), _call([](const void *f, size_t begin, size_t end) { (*static_cast<const Fn *>(f))(begin, end); }) {}
+
+    void operator()(size_t begin, size_t end) const {
+        _call(_fn, begin, end);
+    }
+};
+
+// Process-wide pool of CPU worker threads shared by every operator.
+//
+// A parallel loop is cut into chunks of `grain` iterations. Every participant
+// (the calling thread plus the workers) starts with a contiguous run of chunks in
+// its own deque, pops from the front of it, and once it runs dry steals half of
+// the remaining run from the back of another participant's deque. Only one loop
+// runs at a time; loops started from inside a loop body run inline.
+class ThreadPool {
+private:
+    // A deque of chunk indices [begin, end): the owner pops from begin, thieves take from end.
+    struct Queue {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    size_t _num_threads;
+    std::atomic<bool> _pinned;
+    std::vector<std::thread> _workers;
+    std::unique_ptr<Queue[]> _queues;
+
+    // Serializes loops and reconfiguration.
+    std::mutex _job_mutex;
+
+    // Worker wake-up and completion.
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    std::atomic<uint64_t> _generation;
+    size_t _busy;
+    bool _stop;
+
+    // The loop being executed.
+    const ChunkFn *_fn;
+    size_t _begin;
+    size_t _end;
+    size_t _grain;
+    std::exception_ptr _error;
+    std::mutex _error_mutex;
+
+    void _startWorkers();
+    void _stopWorkers();
+    void _applyPinning();
+    void _workerLoop(size_t id, uint64_t seen);
+    void _work(size_t id);
+    bool _pop(size_t id, size_t &chunk);
+    bool _steal(size_t id);
+    void _runChunk(size_t chunk);
+
+public:
+    ThreadPool();
+    ~ThreadPool();
+
+    // Prevent copy
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Prevent move
+    ThreadPool(ThreadPool &&) = delete;
+    ThreadPool &operator=(ThreadPool &&) = delete;
+
+    // Number of threads a loop runs on, including the caller.
+    size_t numThreads() const;
+    // Resize the pool. 0 restores the default: LLAISYS_NUM_THREADS if set,
+    // otherwise the number of CPUs this process may run on. Waits for the running loop,
+    // so it must not be called from inside a loop body.
+    void setNumThreads(size_t num_threads);
+
+    bool pinned() const;
+    // Bind worker i to the i-th CPU this process may run on (the caller keeps its own
+    // affinity), or release the workers again. A no-op where unsupported. Waits for
+    // the running loop, so it must not be called from inside a loop body.
+    void setPinned(bool pinned);
+
+    // Call fn(chunk_begin, chunk_end) over disjoint pieces covering [begin, end). Work
+    // spread across the pool goes in chunks of at most `grain`, but a loop that fits in
+    // one grain, runs inside another parallel loop or finds no workers is run inline as a
+    // single fn(begin, end) call, so fn must accept a range spanning several grains.
+    // Returns once every chunk has run; the first exception thrown by fn is rethrown.
+    void parallelFor(size_t begin, size_t end, size_t grain, ChunkFn fn);
+};
+
+// The process-wide pool, created on first use.
+ThreadPool &threadPool();
+
+// Shorthand for threadPool().parallelFor(); the entry point for operators.
+inline void parallel_for(size_t begin, size_t end, size_t grain, ChunkFn fn) {
+    threadPool().parallelFor(begin, end, grain, fn);
+}
+} // namespace llaisys::core
@@ -0,0 +1,123 @@
+#include "cpu_isa.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LLAISYS_CPU_X86
+#ifdef _MSC_VER
+#include <immintrin.h>
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace llaisys::device::cpu {
+#ifdef LLAISYS_CPU_X86
+static void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#ifdef _MSC_VER
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; i++) {
+        regs[i] = static_cast<unsigned>(out[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Register state the OS saves on context switches (XCR0).
+static uint64_t xgetbv0() {
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+static Isa probeIsa() {
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    unsigned max_leaf = regs[0];
+    if (max_leaf < 1) {
+        return Isa::GENERIC;
+    }
+
+    cpuid(1, 0, regs);
+    const unsigned ecx1 = regs[2];
+    const bool sse4 = (ecx1 >> 19 & 1) && (ecx1 >> 20 & 1);
+    const bool fma = ecx1 >> 12 & 1;
+    const bool osxsave = ecx1 >> 27 & 1;
+    const bool avx = ecx1 >> 28 & 1;
+    const bool f16c = ecx1 >> 29 & 1;
+    if (!sse4) {
+        return Isa::GENERIC;
+    }
+
+    // The OS must preserve YMM (and for AVX-512, opmask and ZMM) state as well.
+    const uint64_t xcr0 = osxsave ? xgetbv0() : 0;
+    const bool os_avx = (xcr0 & 0x6) == 0x6;
+    const bool os_avx512 = (xcr0 & 0xE6) == 0xE6;
+    if (max_leaf < 7 || !avx || !os_avx || !fma || !f16c) {
+        return Isa::SSE4;
+    }
+
+    cpuid(7, 0, regs);
+    const unsigned ebx7 = regs[1];
+    const bool avx2 = ebx7 >> 5 & 1;
+    const bool avx512 = (ebx7 >> 16 & 1) && (ebx7 >> 17 & 1) && (ebx7 >> 30 & 1) && (ebx7 >> 31 & 1);
+    if (!avx2) {
+        return Isa::SSE4;
+    }
+    if (!avx512 || !os_avx512) {
+        return Isa::AVX2;
+    }
+    return Isa::AVX512;
+}
+#else
+static Isa probeIsa() {
+    return Isa::GENERIC;
+}
+#endif
+
+static Isa envIsaCap() {
+    const char *env = std::getenv("LLAISYS_CPU_ISA");
+    if (env == nullptr) {
+        return Isa::AVX512;
+    }
+    static const Isa tiers[] = {Isa::GENERIC, Isa::SSE4, Isa::AVX2, Isa::AVX512};
+    for (Isa isa : tiers) {
+        if (std::strcmp(env, isaName(isa)) == 0) {
+            return isa;
+        }
+    }
+    return Isa::AVX512;
+}
+
+Isa hostIsa() {
+    static const Isa isa = [] {
+        Isa probed = probeIsa();
+        Isa cap = envIsaCap();
+        return probed < cap ? probed : cap;
+    }();
+    return isa;
+}
+
+const char *isaName(Isa isa) {
+    switch (isa) {
+    case Isa::SSE4:
+        return "sse4";
+    case Isa::AVX2:
+        return "avx2";
+    case Isa::AVX512:
+        return "avx512";
+    case Isa::GENERIC:
+    default:
+        return "generic";
+    }
+}
+} // namespace llaisys::device::cpu
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+
+namespace llaisys::device::cpu {
+// Instruction-set tiers that CPU kernels are compiled for, in increasing order.
+//   SSE4:   SSE4.1 + SSE4.2
+//   AVX2:   AVX2 + FMA + F16C
+//   AVX512: AVX-512 F/BW/DQ/VL + FMA + F16C
+enum class Isa : int {
+    GENERIC = 0,
+    SSE4 = 1,
+    AVX2 = 2,
+    AVX512 = 3,
+};
+
+// Best tier supported by both the host CPU and the operating system. The host is
+// probed once; the LLAISYS_CPU_ISA environment variable (generic, sse4, avx2 or
+// avx512) can lower, but never raise, the result.
+Isa hostIsa();
+
+const char *isaName(Isa isa);
+
+// Pick the best variant the host can run. Variants that were not compiled into
+// this build are passed as nullptr.
+template <typename Fn>
+Fn selectIsa(Fn generic, Fn sse4, Fn avx2, Fn avx512) {
+    Isa isa = hostIsa();
+    if (isa >= Isa::AVX512 && avx512 != nullptr) {
+        return avx512;
+    }
+    if (isa >= Isa::AVX2 && avx2 != nullptr) {
+        return avx2;
+    }
+    if (isa >= Isa::SSE4 && sse4 != nullptr) {
+        return sse4;
+    }
+    return generic;
+}
+} // namespace llaisys::device::cpu
+
+// Kernels that have per-ISA variants are declared once for every tier:
+//     LLAISYS_CPU_DECLARE_VARIANTS(void add(std::byte *c, ...));
+// defines generic::add, sse4::add, avx2::add and avx512::add in the current namespace.
+// Each variant is defined in its own translation unit compiled with the matching
+// -m flags, with LLAISYS_CPU_ISA set to the tier's namespace name.
+#define LLAISYS_CPU_DECLARE_VARIANTS(...) \
+    namespace generic {                   \
+    __VA_ARGS__;                          \
+    }                                     \
+    namespace sse4 {                      \
+    __VA_ARGS__;                          \
+    }                                     \
+    namespace avx2 {                      \
+    __VA_ARGS__;                          \
+    }                                     \
+    namespace avx512 {                    \
+    __VA_ARGS__;                          \
+    }
+
+// The build defines LLAISYS_CPU_HAVE_<TIER> for every variant it compiles.
+#ifdef LLAISYS_CPU_HAVE_SSE4
+#define LLAISYS_CPU_VARIANT_SSE4(fn) &sse4::fn
+#else
+#define LLAISYS_CPU_VARIANT_SSE4(fn) nullptr
+#endif
+#ifdef LLAISYS_CPU_HAVE_AVX2
+#define LLAISYS_CPU_VARIANT_AVX2(fn) &avx2::fn
+#else
+#define LLAISYS_CPU_VARIANT_AVX2(fn) nullptr
+#endif
+#ifdef LLAISYS_CPU_HAVE_AVX512
+#define LLAISYS_CPU_VARIANT_AVX512(fn) &avx512::fn
+#else
+#define LLAISYS_CPU_VARIANT_AVX512(fn) nullptr
+#endif
+
+// Resolve `fn` to its best variant. Meant for namespace-scope statics so the
+// binding happens once, when the library is loaded.
+#define LLAISYS_CPU_SELECT(fn)                                   \
+    ::llaisys::device::cpu::selectIsa<decltype(&generic::fn)>(   \
+        &generic::fn, LLAISYS_CPU_VARIANT_SSE4(fn),              \
+        LLAISYS_CPU_VARIANT_AVX2(fn), LLAISYS_CPU_VARIANT_AVX512(fn))
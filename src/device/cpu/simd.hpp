@@ -0,0 +1,451 @@
+#pragma once
+
+// SIMD building blocks for CPU kernels.
+//
+// This header is compiled once per instruction-set variant (see cpu_isa.hpp) and
+// picks its vector width from the compiler's target macros. Everything in it has
+// internal linkage on purpose: an inline function with external linkage would be
+// emitted by every variant, and the linker is free to keep the AVX-512 copy for
+// callers that run on hosts without AVX-512. For the same reason kernels built
+// against this header must stay away from STL templates and out-of-line helpers
+// such as utils::cast; allocation and threading belong in the dispatching code.
+
+#include "../../utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <math.h>
+#include <type_traits>
+
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE4_1__)
+// llaisys.h defines __C, which the intrinsic headers use as a parameter name.
+#pragma push_macro("__C")
+#undef __C
+// GCC 12 flags the self-initialized placeholders behind _mm512_undefined_*().
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+#include <immintrin.h>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#pragma pop_macro("__C")
+#endif
+
+namespace llaisys::device::cpu::simd {
+namespace {
+
+inline size_t smin(size_t a, size_t b) {
+    return a < b ? a : b;
+}
+
+inline float fmax2(float a, float b) {
+    return a > b ? a : b;
+}
+
+// ---------------------------------------------------------------------------
+// Scalar conversions
+// ---------------------------------------------------------------------------
+
+inline float bits_to_f32(uint32_t bits) {
+    float out;
+    std::memcpy(&out, &bits, sizeof(out));
+    return out;
+}
+
+inline uint32_t f32_to_bits(float val) {
+    uint32_t bits;
+    std::memcpy(&bits, &val, sizeof(bits));
+    return bits;
+}
+
+inline float to_float(float val) {
+    return val;
+}
+
+inline float to_float(int8_t val) {
+    return static_cast<float>(val);
+}
+
+inline float to_float(uint8_t val) {
+    return static_cast<float>(val);
+}
+
+inline float to_float(bf16_t val) {
+    return bits_to_f32(static_cast<uint32_t>(val._v) << 16);
+}
+
+inline float to_float(fp16_t val) {
+#if defined(__F16C__)
+    return _cvtsh_ss(val._v);
+#else
+    uint32_t h = val._v;
+    uint32_t sign = (h & 0x8000) << 16;
+    uint32_t exponent = (h >> 10) & 0x1F;
+    uint32_t mantissa = h & 0x3FF;
+    if (exponent == 0x1F) {
+        return bits_to_f32(sign | 0x7F800000 | (mantissa << 13));
+    }
+    if (exponent == 0) {
+        // Zero or subnormal: mantissa * 2^-24, exact in float.
+        float mag = static_cast<float>(mantissa) * 5.9604644775390625e-8f;
+        return sign ? -mag : mag;
+    }
+    return bits_to_f32(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+#endif
+}
+
+// Round to nearest even, like the vector stores below.
+inline bf16_t to_bf16(float val) {
+    uint32_t bits = f32_to_bits(val);
+    bits += 0x7FFF + ((bits >> 16) & 1);
+    return bf16_t{static_cast<uint16_t>(bits >> 16)};
+}
+
+// Round to nearest even, like the F16C/AVX-512 stores below.
+inline fp16_t to_fp16(float val) {
+    uint32_t bits = f32_to_bits(val);
+    uint32_t sign = (bits >> 16) & 0x8000;
+    bits &= 0x7FFFFFFF;
+    uint16_t out;
+    if (bits >= 0x47800000) {
+        // Too large for fp16: infinity, or quiet NaN for NaN inputs.
+        out = bits > 0x7F800000 ? 0x7E00 : 0x7C00;
+    } else if (bits < 0x38800000) {
+        // Subnormal or zero: let a float add against 0.5 do the rounding.
+        out = static_cast<uint16_t>(f32_to_bits(bits_to_f32(bits) + 0.5f) - 0x3F000000);
+    } else {
+        bits += 0xC8000FFF + ((bits >> 13) & 1);
+        out = static_cast<uint16_t>(bits >> 13);
+    }
+    return fp16_t{static_cast<uint16_t>(out | sign)};
+}
+
+template <typename T>
+inline T from_float(float val) {
+    if constexpr (std::is_same_v<T, bf16_t>) {
+        return to_bf16(val);
+    } else if constexpr (std::is_same_v<T, fp16_t>) {
+        return to_fp16(val);
+    } else {
+        return val;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Float vectors: vfloat holds W lanes.
+// ---------------------------------------------------------------------------
+
+#if defined(__AVX512F__)
+
+constexpr size_t W = 16;
+using vfloat = __m512;
+
+inline vfloat vzero() { return _mm512_setzero_ps(); }
+inline vfloat vset1(float x) { return _mm512_set1_ps(x); }
+inline vfloat vload(const float *p) { return _mm512_loadu_ps(p); }
+inline void vstore(float *p, vfloat v) { _mm512_storeu_ps(p, v); }
+inline vfloat vload(const bf16_t *p) {
+    __m512i x = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(x, 16));
+}
+inline void vstore(bf16_t *p, vfloat v) {
+    __m512i x = _mm512_castps_si512(v);
+    __m512i lsb = _mm512_and_si512(_mm512_srli_epi32(x, 16), _mm512_set1_epi32(1));
+    x = _mm512_srli_epi32(_mm512_add_epi32(x, _mm512_add_epi32(lsb, _mm512_set1_epi32(0x7FFF))), 16);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), _mm512_cvtepi32_epi16(x));
+}
+inline vfloat vload(const fp16_t *p) {
+    return _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+}
+inline vfloat vload(const int8_t *p) {
+    return _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))));
+}
+inline vfloat vload(const uint8_t *p) {
+    return _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))));
+}
+inline void vstore(fp16_t *p, vfloat v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+inline vfloat vadd(vfloat a, vfloat b) { return _mm512_add_ps(a, b); }
+inline vfloat vsub(vfloat a, vfloat b) { return _mm512_sub_ps(a, b); }
+inline vfloat vmul(vfloat a, vfloat b) { return _mm512_mul_ps(a, b); }
+inline vfloat vdiv(vfloat a, vfloat b) { return _mm512_div_ps(a, b); }
+inline vfloat vmax(vfloat a, vfloat b) { return _mm512_max_ps(a, b); }
+inline vfloat vmin(vfloat a, vfloat b) { return _mm512_min_ps(a, b); }
+// a * b + c
+inline vfloat vfmadd(vfloat a, vfloat b, vfloat c) { return _mm512_fmadd_ps(a, b, c); }
+inline float vsum(vfloat v) { return _mm512_reduce_add_ps(v); }
+inline float vmaxval(vfloat v) { return _mm512_reduce_max_ps(v); }
+inline vfloat vfloor(vfloat v) { return _mm512_roundscale_ps(v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+// 2^n for integral n in [-127, 128].
+inline vfloat vexp2i(vfloat n) {
+    __m512i e = _mm512_add_epi32(_mm512_cvttps_epi32(n), _mm512_set1_epi32(127));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(e, 23));
+}
+
+#elif defined(__AVX2__)
+
+constexpr size_t W = 8;
+using vfloat = __m256;
+
+inline vfloat vzero() { return _mm256_setzero_ps(); }
+inline vfloat vset1(float x) { return _mm256_set1_ps(x); }
+inline vfloat vload(const float *p) { return _mm256_loadu_ps(p); }
+inline void vstore(float *p, vfloat v) { _mm256_storeu_ps(p, v); }
+inline vfloat vload(const bf16_t *p) {
+    __m256i x = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(x, 16));
+}
+inline void vstore(bf16_t *p, vfloat v) {
+    __m256i x = _mm256_castps_si256(v);
+    __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(x, 16), _mm256_set1_epi32(1));
+    x = _mm256_srli_epi32(_mm256_add_epi32(x, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7FFF))), 16);
+    // packus works per 128-bit lane; gather the two useful quarters into the low half.
+    x = _mm256_permute4x64_epi64(_mm256_packus_epi32(x, x), 0xD8);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm256_castsi256_si128(x));
+}
+inline vfloat vload(const fp16_t *p) {
+    return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+inline vfloat vload(const int8_t *p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))));
+}
+inline vfloat vload(const uint8_t *p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))));
+}
+inline void vstore(fp16_t *p, vfloat v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+}
+inline vfloat vadd(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+inline vfloat vsub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+inline vfloat vmul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+inline vfloat vdiv(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+inline vfloat vmax(vfloat a, vfloat b) { return _mm256_max_ps(a, b); }
+inline vfloat vmin(vfloat a, vfloat b) { return _mm256_min_ps(a, b); }
+inline vfloat vfmadd(vfloat a, vfloat b, vfloat c) { return _mm256_fmadd_ps(a, b, c); }
+inline float vsum(vfloat v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+inline float vmaxval(vfloat v) {
+    __m128 s = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_max_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_max_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+inline vfloat vfloor(vfloat v) { return _mm256_floor_ps(v); }
+inline vfloat vexp2i(vfloat n) {
+    __m256i e = _mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(127));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+}
+
+#elif defined(__SSE4_1__)
+
+constexpr size_t W = 4;
+using vfloat = __m128;
+
+inline vfloat vzero() { return _mm_setzero_ps(); }
+inline vfloat vset1(float x) { return _mm_set1_ps(x); }
+inline vfloat vload(const float *p) { return _mm_loadu_ps(p); }
+inline void vstore(float *p, vfloat v) { _mm_storeu_ps(p, v); }
+inline vfloat vload(const bf16_t *p) {
+    __m128i x = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)));
+    return _mm_castsi128_ps(_mm_slli_epi32(x, 16));
+}
+inline void vstore(bf16_t *p, vfloat v) {
+    __m128i x = _mm_castps_si128(v);
+    __m128i lsb = _mm_and_si128(_mm_srli_epi32(x, 16), _mm_set1_epi32(1));
+    x = _mm_srli_epi32(_mm_add_epi32(x, _mm_add_epi32(lsb, _mm_set1_epi32(0x7FFF))), 16);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_packus_epi32(x, x));
+}
+// No F16C below the AVX2 tier: convert lane by lane.
+inline vfloat vload(const fp16_t *p) {
+    return _mm_setr_ps(to_float(p[0]), to_float(p[1]), to_float(p[2]), to_float(p[3]));
+}
+inline vfloat vload(const int8_t *p) {
+    int32_t x;
+    std::memcpy(&x, p, sizeof(x));
+    return _mm_cvtepi32_ps(_mm_cvtepi8_epi32(_mm_cvtsi32_si128(x)));
+}
+inline vfloat vload(const uint8_t *p) {
+    int32_t x;
+    std::memcpy(&x, p, sizeof(x));
+    return _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(x)));
+}
+inline void vstore(fp16_t *p, vfloat v) {
+    alignas(16) float tmp[4];
+    _mm_store_ps(tmp, v);
+    for (size_t i = 0; i < 4; i++) {
+        p[i] = to_fp16(tmp[i]);
+    }
+}
+inline vfloat vadd(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+inline vfloat vsub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+inline vfloat vmul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+inline vfloat vdiv(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+inline vfloat vmax(vfloat a, vfloat b) { return _mm_max_ps(a, b); }
+inline vfloat vmin(vfloat a, vfloat b) { return _mm_min_ps(a, b); }
+inline vfloat vfmadd(vfloat a, vfloat b, vfloat c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+inline float vsum(vfloat v) {
+    __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+inline float vmaxval(vfloat v) {
+    __m128 s = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    s = _mm_max_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+inline vfloat vfloor(vfloat v) { return _mm_floor_ps(v); }
+inline vfloat vexp2i(vfloat n) {
+    __m128i e = _mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127));
+    return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+}
+
+#else
+
+// Portable fallback: a small fixed-size array the compiler can auto-vectorize.
+// Hot loops may test LLAISYS_SIMD_SCALAR to use plain float arrays instead.
+#define LLAISYS_SIMD_SCALAR
+constexpr size_t W = 4;
+struct vfloat {
+    float v[W];
+};
+
+inline vfloat vzero() { return vfloat{}; }
+inline vfloat vset1(float x) {
+    vfloat r;
+    for (size_t i = 0; i < W; i++) {
+        r.v[i] = x;
+    }
+    return r;
+}
+template <typename T>
+inline vfloat vload(const T *p) {
+    vfloat r;
+    for (size_t i = 0; i < W; i++) {
+        r.v[i] = to_float(p[i]);
+    }
+    return r;
+}
+template <typename T>
+inline void vstore(T *p, vfloat v) {
+    for (size_t i = 0; i < W; i++) {
+        p[i] = from_float<T>(v.v[i]);
+    }
+}
+#define LLAISYS_SIMD_BINARY_OP(name, expr) \
+    inline vfloat name(vfloat a, vfloat b) { \
+        vfloat r;                            \
+        for (size_t i = 0; i < W; i++) {     \
+            float x = a.v[i], y = b.v[i];    \
+            r.v[i] = (expr);                 \
+        }                                    \
+        return r;                            \
+    }
+LLAISYS_SIMD_BINARY_OP(vadd, x + y)
+LLAISYS_SIMD_BINARY_OP(vsub, x - y)
+LLAISYS_SIMD_BINARY_OP(vmul, x * y)
+LLAISYS_SIMD_BINARY_OP(vdiv, x / y)
+LLAISYS_SIMD_BINARY_OP(vmax, x > y ? x : y)
+LLAISYS_SIMD_BINARY_OP(vmin, x < y ? x : y)
+#undef LLAISYS_SIMD_BINARY_OP
+inline vfloat vfmadd(vfloat a, vfloat b, vfloat c) {
+    vfloat r;
+    for (size_t i = 0; i < W; i++) {
+        r.v[i] = a.v[i] * b.v[i] + c.v[i];
+    }
+    return r;
+}
+inline float vsum(vfloat v) {
+    float s = 0.0f;
+    for (size_t i = 0; i < W; i++) {
+        s += v.v[i];
+    }
+    return s;
+}
+inline float vmaxval(vfloat v) {
+    float m = v.v[0];
+    for (size_t i = 1; i < W; i++) {
+        m = fmax2(m, v.v[i]);
+    }
+    return m;
+}
+inline vfloat vfloor(vfloat v) {
+    vfloat r;
+    for (size_t i = 0; i < W; i++) {
+        r.v[i] = floorf(v.v[i]);
+    }
+    return r;
+}
+inline vfloat vexp2i(vfloat n) {
+    vfloat r;
+    for (size_t i = 0; i < W; i++) {
+        r.v[i] = bits_to_f32(static_cast<uint32_t>(static_cast<int32_t>(n.v[i]) + 127) << 23);
+    }
+    return r;
+}
+
+#endif
+
+// e^x with the Cephes single-precision polynomial (about 1 ulp over the clamped
+// range). Inputs below -88.38 flush to zero, inputs above 88.38 saturate.
+inline vfloat vexp(vfloat x) {
+    x = vmin(x, vset1(88.3762626647949f));
+    x = vmax(x, vset1(-88.3762626647949f));
+    vfloat fx = vfloor(vfmadd(x, vset1(1.44269504088896341f), vset1(0.5f)));
+    x = vsub(x, vmul(fx, vset1(0.693359375f)));
+    x = vsub(x, vmul(fx, vset1(-2.12194440e-4f)));
+    vfloat y = vset1(1.9875691500e-4f);
+    y = vfmadd(y, x, vset1(1.3981999507e-3f));
+    y = vfmadd(y, x, vset1(8.3334519073e-3f));
+    y = vfmadd(y, x, vset1(4.1665795894e-2f));
+    y = vfmadd(y, x, vset1(1.6666665459e-1f));
+    y = vfmadd(y, x, vset1(5.0000001201e-1f));
+    y = vfmadd(y, vmul(x, x), vadd(x, vset1(1.0f)));
+    return vmul(y, vexp2i(fx));
+}
+
+// Call fn(T{}) with the element type behind `type`. Only the floating-point
+// types kernels are written for are handled; callers validate `type` first.
+template <typename Fn>
+inline void with_dtype(llaisysDataType_t type, Fn &&fn) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return fn(float{});
+    case LLAISYS_DTYPE_BF16:
+        return fn(bf16_t{});
+    case LLAISYS_DTYPE_F16:
+        return fn(fp16_t{});
+    default:
+        return;
+    }
+}
+
+// Horizontal dot product of two length-n rows, accumulated in float.
+template <typename TA, typename TB>
+inline float dot(const TA *a, const TB *b, size_t n) {
+    vfloat acc0 = vzero(), acc1 = vzero();
+    size_t i = 0;
+    for (; i + 2 * W <= n; i += 2 * W) {
+        acc0 = vfmadd(vload(a + i), vload(b + i), acc0);
+        acc1 = vfmadd(vload(a + i + W), vload(b + i + W), acc1);
+    }
+    for (; i + W <= n; i += W) {
+        acc0 = vfmadd(vload(a + i), vload(b + i), acc0);
+    }
+    float sum = vsum(vadd(acc0, acc1));
+    for (; i < n; i++) {
+        sum += to_float(a[i]) * to_float(b[i]);
+    }
+    return sum;
+}
+
+} // namespace
+} // namespace llaisys::device::cpu::simd
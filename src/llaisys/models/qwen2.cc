@@ -0,0 +1,169 @@
+#include "llaisys/models/qwen2.h"
+
+#include "../llaisys_tensor.hpp"
+
+#include "../../models/qwen2/model.hpp"
+#include "../../models/qwen2/scheduler.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+__C {
+    struct LlaisysQwen2Model {
+        std::unique_ptr<llaisys::models::qwen2::Model> model;
+        LlaisysQwen2Weights weights;
+        // Backing arrays of the per-layer fields of `weights`.
+        std::vector<std::vector<llaisysTensor_t>> layer_arrays;
+        // Every handle in `weights`; they share the model's tensors.
+        std::vector<llaisysTensor_t> handles;
+    };
+
+    struct LlaisysQwen2Scheduler {
+        std::unique_ptr<llaisys::models::qwen2::Scheduler> scheduler;
+    };
+}
+
+namespace {
+llaisysTensor_t wrap(LlaisysQwen2Model *model, const llaisys::tensor_t &tensor) {
+    auto handle = new LlaisysTensor{tensor};
+    model->handles.push_back(handle);
+    return handle;
+}
+
+llaisysTensor_t *wrapLayers(LlaisysQwen2Model *model, llaisys::tensor_t llaisys::models::qwen2::LayerWeights::*field) {
+    std::vector<llaisysTensor_t> array;
+    for (const auto &layer : model->model->weights().layers) {
+        array.push_back(wrap(model, layer.*field));
+    }
+    model->layer_arrays.push_back(std::move(array));
+    return model->layer_arrays.back().data();
+}
+
+void syncLayers(LlaisysQwen2Model *model, llaisysTensor_t *handles,
+                llaisys::tensor_t llaisys::models::qwen2::LayerWeights::*field) {
+    const auto &layers = model->model->weights().layers;
+    for (size_t i = 0; i < layers.size(); i++) {
+        handles[i]->tensor = layers[i].*field;
+    }
+}
+
+// Point the handles at the model's weights again after the model replaced some.
+void syncHandles(LlaisysQwen2Model *model) {
+    using llaisys::models::qwen2::LayerWeights;
+    auto &weights = model->model->weights();
+    model->weights.in_embed->tensor = weights.in_embed;
+    model->weights.out_embed->tensor = weights.out_embed;
+    model->weights.out_norm_w->tensor = weights.out_norm_w;
+    syncLayers(model, model->weights.attn_norm_w, &LayerWeights::attn_norm_w);
+    syncLayers(model, model->weights.attn_q_w, &LayerWeights::attn_q_w);
+    syncLayers(model, model->weights.attn_q_b, &LayerWeights::attn_q_b);
+    syncLayers(model, model->weights.attn_k_w, &LayerWeights::attn_k_w);
+    syncLayers(model, model->weights.attn_k_b, &LayerWeights::attn_k_b);
+    syncLayers(model, model->weights.attn_v_w, &LayerWeights::attn_v_w);
+    syncLayers(model, model->weights.attn_v_b, &LayerWeights::attn_v_b);
+    syncLayers(model, model->weights.attn_o_w, &LayerWeights::attn_o_w);
+    syncLayers(model, model->weights.mlp_norm_w, &LayerWeights::mlp_norm_w);
+    syncLayers(model, model->weights.mlp_gate_w, &LayerWeights::mlp_gate_w);
+    syncLayers(model, model->weights.mlp_up_w, &LayerWeights::mlp_up_w);
+    syncLayers(model, model->weights.mlp_down_w, &LayerWeights::mlp_down_w);
+}
+} // namespace
+
+__C {
+    struct LlaisysQwen2Model *llaisysQwen2ModelCreate(const LlaisysQwen2Meta *meta, llaisysDeviceType_t device, int *device_ids, int ndevice) {
+        using llaisys::models::qwen2::LayerWeights;
+        int device_id = (device_ids != nullptr && ndevice > 0) ? device_ids[0] : 0;
+        auto model = new LlaisysQwen2Model;
+        model->model = std::make_unique<llaisys::models::qwen2::Model>(*meta, device, device_id);
+
+        auto &weights = model->model->weights();
+        model->weights.in_embed = wrap(model, weights.in_embed);
+        model->weights.out_embed = wrap(model, weights.out_embed);
+        model->weights.out_norm_w = wrap(model, weights.out_norm_w);
+        model->weights.attn_norm_w = wrapLayers(model, &LayerWeights::attn_norm_w);
+        model->weights.attn_q_w = wrapLayers(model, &LayerWeights::attn_q_w);
+        model->weights.attn_q_b = wrapLayers(model, &LayerWeights::attn_q_b);
+        model->weights.attn_k_w = wrapLayers(model, &LayerWeights::attn_k_w);
+        model->weights.attn_k_b = wrapLayers(model, &LayerWeights::attn_k_b);
+        model->weights.attn_v_w = wrapLayers(model, &LayerWeights::attn_v_w);
+        model->weights.attn_v_b = wrapLayers(model, &LayerWeights::attn_v_b);
+        model->weights.attn_o_w = wrapLayers(model, &LayerWeights::attn_o_w);
+        model->weights.mlp_norm_w = wrapLayers(model, &LayerWeights::mlp_norm_w);
+        model->weights.mlp_gate_w = wrapLayers(model, &LayerWeights::mlp_gate_w);
+        model->weights.mlp_up_w = wrapLayers(model, &LayerWeights::mlp_up_w);
+        model->weights.mlp_down_w = wrapLayers(model, &LayerWeights::mlp_down_w);
+        return model;
+    }
+
+    void llaisysQwen2ModelDestroy(struct LlaisysQwen2Model * model) {
+        for (auto handle : model->handles) {
+            delete handle;
+        }
+        delete model;
+    }
+
+    struct LlaisysQwen2Weights *llaisysQwen2ModelWeights(struct LlaisysQwen2Model * model) {
+        return &model->weights;
+    }
+
+    size_t llaisysQwen2ModelLoadSafetensors(struct LlaisysQwen2Model * model, const char **paths, size_t npath,
+                                            llaisysDataType_t weight_dtype) {
+        std::vector<std::string> files(paths, paths + npath);
+        size_t loaded = model->model->loadSafetensors(files, weight_dtype);
+        syncHandles(model);
+        return loaded;
+    }
+
+    size_t llaisysQwen2ModelPrepack(struct LlaisysQwen2Model * model, const char *cache_path) {
+        size_t packed = model->model->prepack(cache_path == nullptr ? std::string() : std::string(cache_path));
+        syncHandles(model);
+        return packed;
+    }
+
+    int64_t llaisysQwen2ModelInfer(struct LlaisysQwen2Model * model, int64_t * token_ids, size_t ntoken) {
+        return model->model->infer(token_ids, ntoken);
+    }
+
+    int64_t llaisysQwen2ModelInferSample(struct LlaisysQwen2Model * model, int64_t * token_ids, size_t ntoken,
+                                         const struct LlaisysSamplingParams *params) {
+        return model->model->infer(token_ids, ntoken, params);
+    }
+
+    size_t llaisysQwen2ModelGenerate(struct LlaisysQwen2Model * model, int64_t * prompt_ids, size_t n,
+                                     const struct LlaisysSamplingParams *params, size_t max_new_tokens,
+                                     llaisysTokenCallback_t callback, void *user_data) {
+        return model->model->generate(prompt_ids, n, *params, max_new_tokens, callback, user_data);
+    }
+
+    size_t llaisysQwen2ModelReserve(struct LlaisysQwen2Model * model, size_t max_tokens) {
+        return model->model->reserve(max_tokens);
+    }
+
+    void llaisysQwen2ModelReset(struct LlaisysQwen2Model * model) {
+        model->model->reset();
+    }
+
+    struct LlaisysQwen2Scheduler *llaisysQwen2SchedulerCreate(struct LlaisysQwen2Model * model, size_t max_batch,
+                                                              size_t num_blocks, size_t block_size,
+                                                              size_t prefill_chunk) {
+        auto scheduler = new LlaisysQwen2Scheduler;
+        scheduler->scheduler = std::make_unique<llaisys::models::qwen2::Scheduler>(
+            *model->model, max_batch, num_blocks, block_size, prefill_chunk);
+        return scheduler;
+    }
+
+    void llaisysQwen2SchedulerDestroy(struct LlaisysQwen2Scheduler * scheduler) {
+        delete scheduler;
+    }
+
+    uint64_t llaisysQwen2SchedulerSubmit(struct LlaisysQwen2Scheduler * scheduler, int64_t * prompt_ids, size_t n,
+                                         const struct LlaisysSamplingParams *params, size_t max_new_tokens) {
+        return scheduler->scheduler->submit(prompt_ids, n, *params, max_new_tokens);
+    }
+
+    size_t llaisysQwen2SchedulerStep(struct LlaisysQwen2Scheduler * scheduler,
+                                     llaisysRequestTokenCallback_t callback, void *user_data) {
+        return scheduler->scheduler->step(callback, user_data);
+    }
+}
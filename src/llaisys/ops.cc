@@ -3,12 +3,15 @@
 #include "llaisys_tensor.hpp"
 
 #include "../ops/add/op.hpp"
+#include "../ops/add_rms_norm/op.hpp"
 #include "../ops/argmax/op.hpp"
 #include "../ops/embedding/op.hpp"
 #include "../ops/linear/op.hpp"
+#include "../ops/quantize/op.hpp"
 #include "../ops/rearrange/op.hpp"
 #include "../ops/rms_norm/op.hpp"
 #include "../ops/rope/op.hpp"
+#include "../ops/sample/op.hpp"
 #include "../ops/self_attention/op.hpp"
 #include "../ops/swiglu/op.hpp"
 
@@ -16,6 +19,9 @@ __C {
     void llaisysAdd(llaisysTensor_t c, llaisysTensor_t a, llaisysTensor_t b) {
         llaisys::ops::add(c->tensor, a->tensor, b->tensor);
     }
+    void llaisysAddRmsNorm(llaisysTensor_t out, llaisysTensor_t residual, llaisysTensor_t in, llaisysTensor_t weight, float eps) {
+        llaisys::ops::add_rms_norm(out->tensor, residual->tensor, in->tensor, weight->tensor, eps);
+    }
     void llaisysArgmax(llaisysTensor_t max_idx, llaisysTensor_t max_val, llaisysTensor_t vals) {
         llaisys::ops::argmax(max_idx->tensor, max_val->tensor, vals->tensor);
     }
@@ -23,7 +29,33 @@ __C {
         llaisys::ops::embedding(out->tensor, index->tensor, weight->tensor);
     }
     void llaisysLinear(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t weight, llaisysTensor_t bias) {
-        llaisys::ops::linear(out->tensor, in->tensor, weight->tensor, bias->tensor);
+        llaisys::ops::linear(out->tensor, in->tensor, weight->tensor, bias ? bias->tensor : nullptr);
+    }
+    void llaisysLinearTopK(llaisysTensor_t idx, llaisysTensor_t val, llaisysTensor_t in, llaisysTensor_t weight) {
+        llaisys::ops::linear_topk(idx->tensor, val->tensor, in->tensor, weight->tensor);
+    }
+    llaisysTensor_t llaisysLinearPrepack(llaisysTensor_t weight) {
+        return new LlaisysTensor{llaisys::ops::linear_prepack(weight->tensor)};
+    }
+    llaisysTensor_t llaisysLinearPrepackQKV(llaisysTensor_t q, llaisysTensor_t k, llaisysTensor_t v) {
+        return new LlaisysTensor{llaisys::ops::linear_prepack_qkv(q->tensor, k->tensor, v->tensor)};
+    }
+    void llaisysLinearQKV(llaisysTensor_t q, llaisysTensor_t k, llaisysTensor_t v, llaisysTensor_t in,
+                          llaisysTensor_t weight, llaisysTensor_t q_bias, llaisysTensor_t k_bias,
+                          llaisysTensor_t v_bias, llaisysTensor_t pos_ids, llaisysTensor_t rope_table) {
+        llaisys::ops::linear_qkv(q->tensor, k->tensor, v->tensor, in->tensor, weight->tensor,
+                                 q_bias ? q_bias->tensor : nullptr, k_bias ? k_bias->tensor : nullptr,
+                                 v_bias ? v_bias->tensor : nullptr, pos_ids ? pos_ids->tensor : nullptr,
+                                 rope_table ? rope_table->tensor : nullptr);
+    }
+    llaisysTensor_t llaisysLinearPrepackGateUp(llaisysTensor_t gate, llaisysTensor_t up) {
+        return new LlaisysTensor{llaisys::ops::linear_prepack_gate_up(gate->tensor, up->tensor)};
+    }
+    void llaisysLinearSwiGLU(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t gate_up) {
+        llaisys::ops::linear_swiglu(out->tensor, in->tensor, gate_up->tensor);
+    }
+    void llaisysQuantize(llaisysTensor_t out, llaisysTensor_t scales, llaisysTensor_t in, llaisysTensor_t zeros) {
+        llaisys::ops::quantize(out->tensor, scales->tensor, in->tensor, zeros ? zeros->tensor : nullptr);
     }
     void llaisysRearrange(llaisysTensor_t out, llaisysTensor_t in) {
         llaisys::ops::rearrange(out->tensor, in->tensor);
@@ -34,9 +66,22 @@ __C {
     void llaisysROPE(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t pos_ids, float theta) {
         llaisys::ops::rope(out->tensor, in->tensor, pos_ids->tensor, theta);
     }
+    void llaisysROPETable(llaisysTensor_t table, float theta) {
+        llaisys::ops::rope_table(table->tensor, theta);
+    }
+    void llaisysROPECached(llaisysTensor_t out, llaisysTensor_t in, llaisysTensor_t pos_ids, llaisysTensor_t table) {
+        llaisys::ops::rope_cached(out->tensor, in->tensor, pos_ids->tensor, table->tensor);
+    }
+    void llaisysSample(llaisysTensor_t idx, llaisysTensor_t logits, llaisysTensor_t history,
+                       const struct LlaisysSamplingParams *params) {
+        llaisys::ops::sample(idx->tensor, logits->tensor, history ? history->tensor : nullptr, *params);
+    }
     void llaisysSelfAttention(llaisysTensor_t attn_val, llaisysTensor_t q, llaisysTensor_t k, llaisysTensor_t v, float scale) {
         llaisys::ops::self_attention(attn_val->tensor, q->tensor, k->tensor, v->tensor, scale);
     }
+    void llaisysPagedSelfAttention(llaisysTensor_t attn_val, llaisysTensor_t q, llaisysTensor_t k_blocks, llaisysTensor_t v_blocks, llaisysTensor_t block_table, size_t kv_len, float scale) {
+        llaisys::ops::paged_self_attention(attn_val->tensor, q->tensor, k_blocks->tensor, v_blocks->tensor, block_table->tensor, kv_len, scale);
+    }
     void llaisysSwiGLU(llaisysTensor_t out, llaisysTensor_t gate, llaisysTensor_t up) {
         llaisys::ops::swiglu(out->tensor, gate->tensor, up->tensor);
     }
@@ -1,5 +1,7 @@
 #include "llaisys/runtime.h"
+#include "../core/allocator/allocator.hpp"
 #include "../core/context/context.hpp"
+#include "../core/thread_pool/thread_pool.hpp"
 #include "../device/runtime_api.hpp"
 
 // Llaisys API for setting context runtime.
@@ -10,4 +12,33 @@ __C void llaisysSetContextRuntime(llaisysDeviceType_t device_type, int device_id
 // Llaisys API for getting the runtime APIs
 __C const LlaisysRuntimeAPI *llaisysGetRuntimeAPI(llaisysDeviceType_t device_type) {
     return llaisys::device::getRuntimeAPI(device_type);
-}
\ No newline at end of file
+}
+// Llaisys API for configuring the CPU thread pool
+__C void llaisysSetNumThreads(int num_threads) {
+    llaisys::core::threadPool().setNumThreads(num_threads > 0 ? static_cast<size_t>(num_threads) : 0);
+}
+
+__C int llaisysGetNumThreads() {
+    return static_cast<int>(llaisys::core::threadPool().numThreads());
+}
+
+__C void llaisysSetThreadPinning(uint8_t enable) {
+    llaisys::core::threadPool().setPinned(enable != 0);
+}
+
+// Llaisys API for device memory allocators
+__C void llaisysSetAllocator(llaisysDeviceType_t device_type, llaisysAllocatorType_t type) {
+    llaisys::core::allocators::setAllocatorType(device_type, type);
+}
+
+__C llaisysAllocatorType_t llaisysGetAllocator(llaisysDeviceType_t device_type) {
+    return llaisys::core::allocators::allocatorType(device_type);
+}
+
+__C void llaisysGetMemoryStats(llaisysDeviceType_t device_type, int device_id, LlaisysMemoryStats *stats) {
+    *stats = llaisys::core::allocators::deviceAllocator(device_type, device_id)->stats();
+}
+
+__C void llaisysTrimMemory(llaisysDeviceType_t device_type, int device_id) {
+    llaisys::core::allocators::trimDevice(device_type, device_id);
+}
@@ -1,5 +1,7 @@
 #include "llaisys_tensor.hpp"
 
+#include "../utils.hpp"
+
 #include <vector>
 
 __C {
@@ -13,6 +15,31 @@ __C {
         return new LlaisysTensor{llaisys::Tensor::create(shape_vec, dtype, device_type, device_id)};
     }
 
+    llaisysTensor_t tensorCreateFromFile(
+        const char *path,
+        size_t offset,
+        size_t *shape,
+        size_t ndim,
+        llaisysDataType_t dtype) {
+        std::vector<size_t> shape_vec(shape, shape + ndim);
+        size_t bytes = 0;
+        CHECK_ARGUMENT(llaisys::utils::tensorBytes(shape_vec, dtype, bytes), "tensorCreateFromFile: tensor too large");
+        // Map through the CPU runtime, then give the caller back its device.
+        auto &context = llaisys::core::context();
+        const llaisysDeviceType_t device_type = context.runtime().deviceType();
+        const int device_id = context.runtime().deviceId();
+        context.setDevice(LLAISYS_DEVICE_CPU, 0);
+        llaisys::core::storage_t storage;
+        try {
+            storage = context.runtime().mapFile(path, offset, bytes);
+        } catch (...) {
+            context.setDevice(device_type, device_id);
+            throw;
+        }
+        context.setDevice(device_type, device_id);
+        return new LlaisysTensor{llaisys::Tensor::create(shape_vec, dtype, storage)};
+    }
+
     void tensorDestroy(
         llaisysTensor_t tensor) {
         delete tensor;
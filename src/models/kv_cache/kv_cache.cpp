@@ -0,0 +1,97 @@
+#include "kv_cache.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+namespace llaisys::models {
+KVCache::KVCache(size_t nlayer, size_t capacity, size_t nkvh, size_t dh, llaisysDataType_t dtype,
+                 llaisysDeviceType_t device_type, int device_id)
+    : _capacity(capacity), _length(0) {
+    CHECK_ARGUMENT(capacity > 0, "KVCache: capacity must be positive");
+    _keys.reserve(nlayer);
+    _values.reserve(nlayer);
+    for (size_t i = 0; i < nlayer; i++) {
+        _keys.push_back(Tensor::create({capacity, nkvh, dh}, dtype, device_type, device_id));
+        _values.push_back(Tensor::create({capacity, nkvh, dh}, dtype, device_type, device_id));
+    }
+    _next.resize(nlayer);
+    _next_begin.resize(nlayer);
+}
+
+size_t KVCache::nlayer() const {
+    return _keys.size();
+}
+
+size_t KVCache::capacity() const {
+    return _capacity;
+}
+
+size_t KVCache::length() const {
+    return _length;
+}
+
+const KVCache::Rows &KVCache::next(size_t layer, size_t n) {
+    CHECK_ARGUMENT(layer < _keys.size(), "KVCache: layer out of range");
+    CHECK_ARGUMENT(n > 0 && _length + n <= _capacity, "KVCache: capacity exceeded");
+    Rows &rows = _next[layer];
+    if (!rows.key || rows.key->shape()[0] != n) {
+        const tensor_t &keys = _keys[layer];
+        const size_t width = keys->shape()[1] * keys->shape()[2];
+        rows.key = keys->slice(0, _length, _length + n);
+        rows.value = _values[layer]->slice(0, _length, _length + n);
+        rows.key_flat = rows.key->view({n, width});
+        rows.value_flat = rows.value->view({n, width});
+    } else if (_next_begin[layer] != _length) {
+        rows.key->reslice(*_keys[layer], 0, _length);
+        rows.value->reslice(*_values[layer], 0, _length);
+        rows.key_flat->reslice(*_keys[layer], 0, _length);
+        rows.value_flat->reslice(*_values[layer], 0, _length);
+    }
+    _next_begin[layer] = _length;
+    return rows;
+}
+
+const tensor_t &KVCache::keys(size_t layer) const {
+    CHECK_ARGUMENT(layer < _keys.size(), "KVCache: layer out of range");
+    return _keys[layer];
+}
+
+const tensor_t &KVCache::values(size_t layer) const {
+    CHECK_ARGUMENT(layer < _values.size(), "KVCache: layer out of range");
+    return _values[layer];
+}
+
+void KVCache::write(size_t layer, tensor_t k, tensor_t v) {
+    CHECK_ARGUMENT(layer < _keys.size(), "KVCache: layer out of range");
+    const tensor_t &keys = _keys[layer];
+    CHECK_ARGUMENT(k->isContiguous() && v->isContiguous(), "KVCache: k and v must be contiguous");
+    CHECK_SAME_SHAPE(k->shape(), v->shape());
+    CHECK_ARGUMENT(k->ndim() == 3 && k->shape()[1] == keys->shape()[1] && k->shape()[2] == keys->shape()[2],
+                   "KVCache: k and v must be [n, nkvh, dh]");
+    CHECK_ARGUMENT(k->dtype() == keys->dtype() && v->dtype() == keys->dtype(), "KVCache: dtype mismatch");
+    CHECK_ARGUMENT(_length + k->shape()[0] <= _capacity, "KVCache: capacity exceeded");
+
+    const auto device_type = keys->deviceType();
+    core::context().setDevice(device_type, keys->deviceId());
+    const auto kind = device_type == LLAISYS_DEVICE_CPU ? LLAISYS_MEMCPY_H2H : LLAISYS_MEMCPY_D2D;
+    const size_t row_bytes = k->shape()[1] * k->shape()[2] * k->elementSize();
+    const size_t bytes = k->shape()[0] * row_bytes;
+    const auto api = core::context().runtime().api();
+    api->memcpy_sync(keys->data() + _length * row_bytes, k->data(), bytes, kind);
+    api->memcpy_sync(_values[layer]->data() + _length * row_bytes, v->data(), bytes, kind);
+}
+
+void KVCache::append(size_t ntoken) {
+    CHECK_ARGUMENT(_length + ntoken <= _capacity, "KVCache: capacity exceeded");
+    _length += ntoken;
+}
+
+void KVCache::truncate(size_t length) {
+    CHECK_ARGUMENT(length <= _length, "KVCache: cannot truncate past the current length");
+    _length = length;
+}
+
+void KVCache::reset() {
+    _length = 0;
+}
+} // namespace llaisys::models
@@ -0,0 +1,63 @@
+#pragma once
+#include "../../tensor/tensor.hpp"
+
+#include <vector>
+
+namespace llaisys::models {
+// Per-layer key/value storage for one sequence, preallocated for `capacity` positions.
+//
+// Layer l keeps K and V as [capacity, nkvh, dh] tensors. A step writes its new rows,
+// either in place through next() or by copying them in with write(), and then commits
+// them with append(), which only moves the length. Attention reads the valid prefix,
+// so a longer history never copies or allocates cache memory.
+class KVCache {
+public:
+    // Views of the rows [length(), length() + n) a step fills, as [n, nkvh, dh] and as
+    // [n, nkvh * dh] for writers that take 2D outputs.
+    struct Rows {
+        tensor_t key;
+        tensor_t value;
+        tensor_t key_flat;
+        tensor_t value_flat;
+    };
+
+private:
+    std::vector<tensor_t> _keys;
+    std::vector<tensor_t> _values;
+    size_t _capacity;
+    size_t _length;
+    // Per layer, the views last handed out by next() and the position they start at.
+    std::vector<Rows> _next;
+    std::vector<size_t> _next_begin;
+
+public:
+    KVCache(size_t nlayer, size_t capacity, size_t nkvh, size_t dh, llaisysDataType_t dtype,
+            llaisysDeviceType_t device_type, int device_id);
+    ~KVCache() = default;
+
+    // Prevent copy
+    KVCache(const KVCache &) = delete;
+    KVCache &operator=(const KVCache &) = delete;
+
+    size_t nlayer() const;
+    size_t capacity() const;
+    // Positions committed so far.
+    size_t length() const;
+
+    // The next `n` rows of a layer, for a step to fill before append(). The views are kept
+    // and slid along as the length grows, so only a change of `n` builds new ones; they
+    // stay valid until the next call for the layer.
+    const Rows &next(size_t layer, size_t n);
+    // A layer's whole [capacity, nkvh, dh] tensors, for readers that take the length separately.
+    const tensor_t &keys(size_t layer) const;
+    const tensor_t &values(size_t layer) const;
+    // Copy [n, nkvh, dh] keys and values into rows [length(), length() + n) of a layer.
+    void write(size_t layer, tensor_t k, tensor_t v);
+
+    // Commit the next `ntoken` rows, which the caller has written.
+    void append(size_t ntoken);
+    // Drop every position from `length` on.
+    void truncate(size_t length);
+    void reset();
+};
+} // namespace llaisys::models
@@ -0,0 +1,189 @@
+#include "paged_kv_cache.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+#include <algorithm>
+
+namespace llaisys::models {
+PagedKVCache::PagedKVCache(size_t nlayer, size_t num_blocks, size_t block_size, size_t nkvh, size_t dh,
+                           llaisysDataType_t dtype, llaisysDeviceType_t device_type, int device_id)
+    : _num_blocks(num_blocks), _block_size(block_size), _device_type(device_type), _device_id(device_id) {
+    CHECK_ARGUMENT(num_blocks > 0 && block_size > 0, "PagedKVCache: num_blocks and block_size must be positive");
+    _keys.reserve(nlayer);
+    _values.reserve(nlayer);
+    for (size_t i = 0; i < nlayer; i++) {
+        _keys.push_back(Tensor::create({num_blocks, block_size, nkvh, dh}, dtype, device_type, device_id));
+        _values.push_back(Tensor::create({num_blocks, block_size, nkvh, dh}, dtype, device_type, device_id));
+    }
+    // Hand out low block ids first.
+    _free_blocks.resize(num_blocks);
+    for (size_t i = 0; i < num_blocks; i++) {
+        _free_blocks[i] = static_cast<int64_t>(num_blocks - 1 - i);
+    }
+}
+
+size_t PagedKVCache::nlayer() const {
+    return _keys.size();
+}
+
+size_t PagedKVCache::numBlocks() const {
+    return _num_blocks;
+}
+
+size_t PagedKVCache::blockSize() const {
+    return _block_size;
+}
+
+size_t PagedKVCache::freeBlocks() const {
+    return _free_blocks.size();
+}
+
+PagedKVCache::Sequence &PagedKVCache::_sequence(size_t seq) {
+    CHECK_ARGUMENT(seq < _sequences.size() && _sequences[seq].active, "PagedKVCache: unknown sequence");
+    return _sequences[seq];
+}
+
+const PagedKVCache::Sequence &PagedKVCache::_sequence(size_t seq) const {
+    CHECK_ARGUMENT(seq < _sequences.size() && _sequences[seq].active, "PagedKVCache: unknown sequence");
+    return _sequences[seq];
+}
+
+size_t PagedKVCache::addSequence() {
+    size_t seq;
+    if (!_free_sequences.empty()) {
+        seq = _free_sequences.back();
+        _free_sequences.pop_back();
+    } else {
+        seq = _sequences.size();
+        _sequences.emplace_back();
+    }
+    _sequences[seq].active = true;
+    _sequences[seq].length = 0;
+    return seq;
+}
+
+void PagedKVCache::removeSequence(size_t seq) {
+    Sequence &sequence = _sequence(seq);
+    truncate(seq, 0);
+    sequence.active = false;
+    _free_sequences.push_back(seq);
+}
+
+size_t PagedKVCache::length(size_t seq) const {
+    return _sequence(seq).length;
+}
+
+void PagedKVCache::_syncBlockTable(Sequence &sequence, size_t first) {
+    // The table only ever grows; double it so appends stay amortized O(1). A new table
+    // gets every entry, an existing one just those from `first` on.
+    if (!sequence.block_table || sequence.block_table->numel() < sequence.blocks.size()) {
+        size_t capacity = std::max<size_t>(16, sequence.block_table ? 2 * sequence.block_table->numel() : 0);
+        capacity = std::max(capacity, sequence.blocks.size());
+        sequence.block_table = Tensor::create({capacity}, LLAISYS_DTYPE_I64, _device_type, _device_id);
+        sequence.table_view = nullptr;
+        first = 0;
+    }
+    core::context().setDevice(_device_type, _device_id);
+    core::context().runtime().api()->memcpy_sync(
+        sequence.block_table->data() + first * sizeof(int64_t), sequence.blocks.data() + first,
+        (sequence.blocks.size() - first) * sizeof(int64_t),
+        _device_type == LLAISYS_DEVICE_CPU ? LLAISYS_MEMCPY_H2H : LLAISYS_MEMCPY_H2D);
+    _fitTableView(sequence);
+}
+
+void PagedKVCache::_fitTableView(Sequence &sequence) {
+    const size_t n = sequence.blocks.size();
+    if (n == 0) {
+        return;
+    }
+    if (!sequence.table_view) {
+        sequence.table_view = sequence.block_table->slice(0, 0, n);
+    } else {
+        sequence.table_view->reslice(*sequence.block_table, 0, 0, n);
+    }
+}
+
+bool PagedKVCache::reserve(size_t seq, size_t ntoken) {
+    Sequence &sequence = _sequence(seq);
+    const size_t needed = (sequence.length + ntoken + _block_size - 1) / _block_size;
+    const size_t owned = sequence.blocks.size();
+    if (needed <= owned) {
+        return true;
+    }
+    if (needed - owned > _free_blocks.size()) {
+        return false;
+    }
+    while (sequence.blocks.size() < needed) {
+        sequence.blocks.push_back(_free_blocks.back());
+        _free_blocks.pop_back();
+    }
+    _syncBlockTable(sequence, owned);
+    return true;
+}
+
+void PagedKVCache::write(size_t layer, size_t seq, tensor_t k, tensor_t v) {
+    CHECK_ARGUMENT(layer < _keys.size(), "PagedKVCache: layer out of range");
+    const Sequence &sequence = _sequence(seq);
+    const tensor_t &k_blocks = _keys[layer];
+    CHECK_ARGUMENT(k->isContiguous() && v->isContiguous(), "PagedKVCache: k and v must be contiguous");
+    CHECK_SAME_SHAPE(k->shape(), v->shape());
+    CHECK_ARGUMENT(k->ndim() == 3 && k->shape()[1] == k_blocks->shape()[2] && k->shape()[2] == k_blocks->shape()[3],
+                   "PagedKVCache: k and v must be [n, nkvh, dh]");
+    CHECK_ARGUMENT(k->dtype() == k_blocks->dtype() && v->dtype() == k_blocks->dtype(),
+                   "PagedKVCache: dtype mismatch");
+
+    const size_t ntoken = k->shape()[0];
+    CHECK_ARGUMENT(sequence.length + ntoken <= sequence.blocks.size() * _block_size,
+                   "PagedKVCache: positions were not reserved");
+
+    core::context().setDevice(_device_type, _device_id);
+    const auto api = core::context().runtime().api();
+    const auto kind = _device_type == LLAISYS_DEVICE_CPU ? LLAISYS_MEMCPY_H2H : LLAISYS_MEMCPY_D2D;
+    const size_t row_bytes = k->shape()[1] * k->shape()[2] * k->elementSize();
+    for (size_t i = 0; i < ntoken;) {
+        const size_t pos = sequence.length + i;
+        const size_t offset = pos % _block_size;
+        const size_t rows = std::min(_block_size - offset, ntoken - i);
+        const size_t dst = (static_cast<size_t>(sequence.blocks[pos / _block_size]) * _block_size + offset) * row_bytes;
+        api->memcpy_sync(k_blocks->data() + dst, k->data() + i * row_bytes, rows * row_bytes, kind);
+        api->memcpy_sync(_values[layer]->data() + dst, v->data() + i * row_bytes, rows * row_bytes, kind);
+        i += rows;
+    }
+}
+
+void PagedKVCache::append(size_t seq, size_t ntoken) {
+    Sequence &sequence = _sequence(seq);
+    CHECK_ARGUMENT(sequence.length + ntoken <= sequence.blocks.size() * _block_size,
+                   "PagedKVCache: positions were not reserved");
+    sequence.length += ntoken;
+}
+
+void PagedKVCache::truncate(size_t seq, size_t length) {
+    Sequence &sequence = _sequence(seq);
+    CHECK_ARGUMENT(length <= sequence.length, "PagedKVCache: cannot truncate past the current length");
+    sequence.length = length;
+    const size_t needed = (length + _block_size - 1) / _block_size;
+    while (sequence.blocks.size() > needed) {
+        _free_blocks.push_back(sequence.blocks.back());
+        sequence.blocks.pop_back();
+    }
+    _fitTableView(sequence);
+}
+
+tensor_t PagedKVCache::keyBlocks(size_t layer) const {
+    CHECK_ARGUMENT(layer < _keys.size(), "PagedKVCache: layer out of range");
+    return _keys[layer];
+}
+
+tensor_t PagedKVCache::valueBlocks(size_t layer) const {
+    CHECK_ARGUMENT(layer < _values.size(), "PagedKVCache: layer out of range");
+    return _values[layer];
+}
+
+tensor_t PagedKVCache::blockTable(size_t seq) const {
+    const Sequence &sequence = _sequence(seq);
+    CHECK_ARGUMENT(!sequence.blocks.empty(), "PagedKVCache: sequence owns no blocks");
+    return sequence.table_view;
+}
+} // namespace llaisys::models
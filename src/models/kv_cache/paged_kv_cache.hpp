@@ -0,0 +1,81 @@
+#pragma once
+#include "../../tensor/tensor.hpp"
+
+#include <vector>
+
+namespace llaisys::models {
+// KV cache for many sequences sharing one pool of fixed-size blocks.
+//
+// Layer l keeps K and V as [num_blocks, block_size, nkvh, dh] tensors. A sequence
+// owns a block table listing its blocks in position order; position j lives at row
+// j % block_size of block table[j / block_size]. Blocks are taken from the pool as a
+// sequence grows and returned when it shrinks or is removed, so memory follows the
+// tokens actually cached instead of maxseq per sequence.
+class PagedKVCache {
+private:
+    struct Sequence {
+        std::vector<int64_t> blocks;
+        tensor_t block_table; // i64, the first blocks.size() entries mirror `blocks`
+        tensor_t table_view;  // those first blocks.size() entries, moved as they change
+        size_t length = 0;
+        bool active = false;
+    };
+
+    std::vector<tensor_t> _keys;
+    std::vector<tensor_t> _values;
+    size_t _num_blocks;
+    size_t _block_size;
+    llaisysDeviceType_t _device_type;
+    int _device_id;
+
+    std::vector<int64_t> _free_blocks;
+    std::vector<Sequence> _sequences;
+    std::vector<size_t> _free_sequences;
+
+    Sequence &_sequence(size_t seq);
+    const Sequence &_sequence(size_t seq) const;
+    // Mirror blocks[first:] into the block table, growing it as needed.
+    void _syncBlockTable(Sequence &sequence, size_t first);
+    // Fit table_view to the blocks the sequence owns.
+    void _fitTableView(Sequence &sequence);
+
+public:
+    PagedKVCache(size_t nlayer, size_t num_blocks, size_t block_size, size_t nkvh, size_t dh,
+                 llaisysDataType_t dtype, llaisysDeviceType_t device_type, int device_id);
+    ~PagedKVCache() = default;
+
+    // Prevent copy
+    PagedKVCache(const PagedKVCache &) = delete;
+    PagedKVCache &operator=(const PagedKVCache &) = delete;
+
+    size_t nlayer() const;
+    size_t numBlocks() const;
+    size_t blockSize() const;
+    size_t freeBlocks() const;
+
+    // Start an empty sequence and return its id. Ids of removed sequences are reused.
+    size_t addSequence();
+    // Return every block of `seq` to the pool.
+    void removeSequence(size_t seq);
+
+    // Positions committed for `seq`.
+    size_t length(size_t seq) const;
+    // Make sure `seq` owns blocks for `ntoken` more positions. Returns false, taking
+    // nothing, when the pool cannot supply them.
+    bool reserve(size_t seq, size_t ntoken);
+    // Copy keys and values [n, nkvh, dh] of positions [length, length + n) of `seq`
+    // into its blocks; the positions must have been reserved.
+    void write(size_t layer, size_t seq, tensor_t k, tensor_t v);
+    // Commit the next `ntoken` reserved positions.
+    void append(size_t seq, size_t ntoken);
+    // Drop positions from `length` on, returning whole blocks no longer needed.
+    void truncate(size_t seq, size_t length);
+
+    // The pools of one layer, for paged_self_attention.
+    tensor_t keyBlocks(size_t layer) const;
+    tensor_t valueBlocks(size_t layer) const;
+    // [nblocks] i64 view of the blocks `seq` owns. The view is kept and resized in place
+    // as the sequence takes or returns blocks.
+    tensor_t blockTable(size_t seq) const;
+};
+} // namespace llaisys::models
@@ -0,0 +1,86 @@
+#include "memory_planner.hpp"
+
+#include "../../utils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+
+namespace llaisys::models {
+MemoryPlanner::MemoryPlanner() : _size(0), _planned(false) {
+}
+
+size_t MemoryPlanner::add(size_t bytes, size_t first, size_t last) {
+    CHECK_ARGUMENT(!_planned, "MemoryPlanner: buffers must be added before plan()");
+    CHECK_ARGUMENT(first <= last, "MemoryPlanner: a buffer must be live for at least one step");
+    const size_t size = (std::max<size_t>(bytes, 1) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    _buffers.push_back({size, first, last, 0});
+    return _buffers.size() - 1;
+}
+
+void MemoryPlanner::plan() {
+    CHECK_ARGUMENT(!_planned, "MemoryPlanner: already planned");
+    std::vector<size_t> order(_buffers.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return _buffers[a].size > _buffers[b].size; });
+
+    std::vector<const Buffer *> placed;
+    std::vector<const Buffer *> live;
+    for (size_t id : order) {
+        Buffer &buffer = _buffers[id];
+        live.clear();
+        for (const Buffer *other : placed) {
+            if (other->first <= buffer.last && buffer.first <= other->last) {
+                live.push_back(other);
+            }
+        }
+        std::sort(live.begin(), live.end(), [](const Buffer *a, const Buffer *b) { return a->offset < b->offset; });
+
+        // Best fit among the gaps; past the last overlapping buffer otherwise.
+        size_t best = SIZE_MAX;
+        size_t best_gap = SIZE_MAX;
+        size_t end = 0;
+        for (const Buffer *other : live) {
+            if (other->offset >= end) {
+                const size_t gap = other->offset - end;
+                if (gap >= buffer.size && gap < best_gap) {
+                    best = end;
+                    best_gap = gap;
+                }
+            }
+            end = std::max(end, other->offset + other->size);
+        }
+        buffer.offset = best != SIZE_MAX ? best : end;
+        _size = std::max(_size, buffer.offset + buffer.size);
+        placed.push_back(&buffer);
+    }
+    _planned = true;
+}
+
+size_t MemoryPlanner::offset(size_t id) const {
+    CHECK_ARGUMENT(_planned, "MemoryPlanner: not planned yet");
+    CHECK_ARGUMENT(id < _buffers.size(), "MemoryPlanner: buffer id out of range");
+    return _buffers[id].offset;
+}
+
+size_t MemoryPlanner::size() const {
+    CHECK_ARGUMENT(_planned, "MemoryPlanner: not planned yet");
+    return _size;
+}
+
+size_t MemoryPlanner::peakLiveBytes() const {
+    size_t peak = 0;
+    for (const Buffer &buffer : _buffers) {
+        // The live total only rises where a buffer starts.
+        size_t live = 0;
+        for (const Buffer &other : _buffers) {
+            if (other.first <= buffer.first && buffer.first <= other.last) {
+                live += other.size;
+            }
+        }
+        peak = std::max(peak, live);
+    }
+    return peak;
+}
+} // namespace llaisys::models
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace llaisys::models {
+// Static placement of a forward pass's activations in one slab.
+//
+// The caller numbers the ops of its forward schedule and registers every
+// intermediate buffer with the inclusive range of steps it is live in (written
+// first to read last). Buffers whose ranges overlap get disjoint bytes; all others
+// may share them. Placement is greedy by size: the largest buffer goes first, each
+// into the smallest gap between already placed, overlapping buffers that fits it
+// (the lowest such gap on ties), or past the last of them when none does.
+// For a transformer step, whose buffers mostly die right after their one reader,
+// that lands on or near peakLiveBytes(), the lower bound for any placement.
+class MemoryPlanner {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+private:
+    struct Buffer {
+        size_t size;
+        size_t first;
+        size_t last;
+        size_t offset;
+    };
+
+    std::vector<Buffer> _buffers;
+    size_t _size;
+    bool _planned;
+
+public:
+    MemoryPlanner();
+
+    // Register a buffer of `bytes` live over steps [first, last]; returns its id.
+    size_t add(size_t bytes, size_t first, size_t last);
+    // Assign every offset. Must be called once, after the last add().
+    void plan();
+
+    // Byte offset of a buffer in the slab; 64-byte aligned.
+    size_t offset(size_t id) const;
+    // Bytes the slab needs.
+    size_t size() const;
+    // Largest total size of the buffers live at any one step.
+    size_t peakLiveBytes() const;
+};
+} // namespace llaisys::models
@@ -0,0 +1,281 @@
+#include "model.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+#include "../../ops/quantize/op.hpp"
+#include "../safetensors/safetensors.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <set>
+
+namespace llaisys::models::qwen2 {
+namespace {
+// Elements converted per task, so that the embeddings spread over several threads.
+constexpr size_t CONVERT_CHUNK = size_t(1) << 22;
+
+// Columns per scale when Q4 weights are quantized at load time.
+constexpr size_t Q4_GROUP = 32;
+
+struct LayerField {
+    const char *name;
+    tensor_t LayerWeights::*field;
+    bool linear;   // a linear weight, which may be quantized
+    bool optional; // left zero when the checkpoint lacks it
+};
+
+const LayerField LAYER_WEIGHTS[] = {
+    {"input_layernorm.weight", &LayerWeights::attn_norm_w, false, false},
+    {"self_attn.q_proj.weight", &LayerWeights::attn_q_w, true, false},
+    {"self_attn.q_proj.bias", &LayerWeights::attn_q_b, false, true},
+    {"self_attn.k_proj.weight", &LayerWeights::attn_k_w, true, false},
+    {"self_attn.k_proj.bias", &LayerWeights::attn_k_b, false, true},
+    {"self_attn.v_proj.weight", &LayerWeights::attn_v_w, true, false},
+    {"self_attn.v_proj.bias", &LayerWeights::attn_v_b, false, true},
+    {"self_attn.o_proj.weight", &LayerWeights::attn_o_w, true, false},
+    {"post_attention_layernorm.weight", &LayerWeights::mlp_norm_w, false, false},
+    {"mlp.gate_proj.weight", &LayerWeights::mlp_gate_w, true, false},
+    {"mlp.up_proj.weight", &LayerWeights::mlp_up_w, true, false},
+    {"mlp.down_proj.weight", &LayerWeights::mlp_down_w, true, false},
+};
+
+struct Slot {
+    tensor_t *tensor;
+    bool linear;
+};
+
+// The weight a checkpoint tensor fills, or a null slot for tensors the model does not use.
+Slot weightSlot(Weights &weights, const std::string &name) {
+    if (name == "model.embed_tokens.weight") {
+        return {&weights.in_embed, false};
+    }
+    if (name == "lm_head.weight") {
+        return {&weights.out_embed, true};
+    }
+    if (name == "model.norm.weight") {
+        return {&weights.out_norm_w, false};
+    }
+    const std::string prefix = "model.layers.";
+    if (name.compare(0, prefix.size(), prefix) != 0) {
+        return {};
+    }
+    const size_t dot = name.find('.', prefix.size());
+    if (dot == std::string::npos || dot == prefix.size()) {
+        return {};
+    }
+    const std::string index = name.substr(prefix.size(), dot - prefix.size());
+    if (!std::all_of(index.begin(), index.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return {};
+    }
+    const size_t layer = std::stoul(index);
+    if (layer >= weights.layers.size()) {
+        return {};
+    }
+    const std::string suffix = name.substr(dot + 1);
+    for (const auto &[field_name, field, linear, optional] : LAYER_WEIGHTS) {
+        if (suffix == field_name) {
+            return {&(weights.layers[layer].*field), linear};
+        }
+    }
+    return {};
+}
+
+struct Source {
+    const SafetensorsFile *file;
+    std::string name;
+};
+
+// A linear weight the checkpoint already stores quantized, as written by
+// scripts/quantize_qwen2.py: NAME holds I8 [rows, cols] or U8 [rows, cols / 2] bytes
+// of Q4, next to NAME.scales and, for asymmetric Q4, NAME.zeros.
+struct Stored {
+    llaisysDataType_t dtype; // I8 or Q4; INVALID for plain weights
+    std::vector<size_t> shape;
+    std::string scales;
+    std::string zeros; // empty without zero points
+};
+
+Stored storedFormat(const SafetensorsFile &file, const std::string &name, const std::vector<size_t> &shape) {
+    const auto &entries = file.entries();
+    const std::string scales = name + ".scales";
+    auto it = entries.find(scales);
+    if (it == entries.end()) {
+        return {LLAISYS_DTYPE_INVALID, shape, {}, {}};
+    }
+    const auto &entry = file.entry(name);
+    const auto &s = it->second;
+    const size_t rows = shape[0];
+    const size_t cols = shape[1];
+    CHECK_ARGUMENT(s.shape.size() == 2 && s.shape[0] == rows && s.shape[1] > 0,
+                   "Qwen2: quantized weight scales do not match the weight");
+    if (entry.dtype == LLAISYS_DTYPE_I8) {
+        CHECK_ARGUMENT(entry.shape == shape && s.dtype == LLAISYS_DTYPE_F32 && s.shape[1] == 1,
+                       "Qwen2: I8 weights need one F32 scale per row");
+        return {LLAISYS_DTYPE_I8, shape, scales, {}};
+    }
+    CHECK_ARGUMENT(entry.dtype == LLAISYS_DTYPE_U8 && entry.shape == (std::vector<size_t>{rows, cols / 2}),
+                   "Qwen2: quantized weights must be I8, or U8 bytes of Q4");
+    CHECK_ARGUMENT(s.dtype == LLAISYS_DTYPE_F16 && cols % (s.shape[1] * 32) == 0,
+                   "Qwen2: Q4 weights need F16 scales for groups of a multiple of 32 columns");
+    const std::string zeros = name + ".zeros";
+    if (entries.count(zeros) == 0) {
+        return {LLAISYS_DTYPE_Q4, entry.shape, scales, {}};
+    }
+    const auto &z = file.entry(zeros);
+    CHECK_ARGUMENT(z.dtype == LLAISYS_DTYPE_U8 && z.shape == s.shape, "Qwen2: Q4 zero points must be U8 like the scales");
+    return {LLAISYS_DTYPE_Q4, entry.shape, scales, zeros};
+}
+
+} // namespace
+
+size_t Model::loadSafetensors(const std::vector<std::string> &paths, llaisysDataType_t weight_dtype) {
+    CHECK_ARGUMENT(weight_dtype == _meta.dtype || weight_dtype == LLAISYS_DTYPE_I8 || weight_dtype == LLAISYS_DTYPE_Q4,
+                   "Qwen2: linear weights can only be stored in the model dtype, I8 or Q4");
+    std::vector<std::unique_ptr<SafetensorsFile>> files;
+    std::vector<std::pair<Slot, Source>> targets;
+    std::vector<std::pair<Slot, Source>> stored;
+    const Source *embed = nullptr;
+    bool has_lm_head = false;
+    for (const auto &path : paths) {
+        files.push_back(std::make_unique<SafetensorsFile>(path));
+        for (const auto &[name, entry] : files.back()->entries()) {
+            Slot slot = weightSlot(_weights, name);
+            if (slot.tensor == nullptr) {
+                continue;
+            }
+            const auto &shape = (*slot.tensor)->shape();
+            const bool quantized = slot.linear && storedFormat(*files.back(), name, shape).dtype != LLAISYS_DTYPE_INVALID;
+            CHECK_ARGUMENT(quantized || entry.shape == shape, "Qwen2: checkpoint tensor shape does not match the model");
+            CHECK_ARGUMENT(entry.dtype != LLAISYS_DTYPE_INVALID, "Qwen2: unsupported checkpoint dtype");
+            (quantized ? stored : targets).push_back({slot, Source{files.back().get(), name}});
+            has_lm_head = has_lm_head || slot.tensor == &_weights.out_embed;
+        }
+    }
+    for (const auto &[slot, source] : targets) {
+        if (slot.tensor == &_weights.in_embed) {
+            embed = &source;
+        }
+    }
+    if (!has_lm_head && embed != nullptr) {
+        // The embedding op keeps reading the input side in the model dtype; only the
+        // LM head copy is quantized.
+        targets.push_back({Slot{&_weights.out_embed, true}, *embed});
+    }
+
+    // Every weight but the attention biases must come from the checkpoint; an unfilled
+    // one would be left as whatever its allocation held.
+    std::set<const tensor_t *> filled;
+    for (const auto &[slot, source] : targets) {
+        filled.insert(slot.tensor);
+    }
+    for (const auto &[slot, source] : stored) {
+        filled.insert(slot.tensor);
+    }
+    auto require = [&](const tensor_t &weight, const std::string &name) {
+        CHECK_ARGUMENT(filled.count(&weight) != 0, "Qwen2: checkpoint lacks " + name);
+    };
+    require(_weights.in_embed, "model.embed_tokens.weight");
+    require(_weights.out_embed, "lm_head.weight");
+    require(_weights.out_norm_w, "model.norm.weight");
+    for (size_t layer = 0; layer < _weights.layers.size(); layer++) {
+        for (const auto &[field_name, field, linear, optional] : LAYER_WEIGHTS) {
+            if (!optional) {
+                require(_weights.layers[layer].*field, "model.layers." + std::to_string(layer) + "." + field_name);
+            }
+        }
+    }
+
+    // Weights already in the model dtype are used in place; the rest are converted
+    // in chunks, straight into CPU weights or through a host buffer for other devices.
+    struct Task {
+        const std::byte *src;
+        llaisysDataType_t src_dtype;
+        tensor_t dst;
+        size_t begin;
+        size_t end;
+    };
+    std::vector<Task> tasks;
+    std::vector<std::pair<tensor_t *, const Source *>> quantized;
+    for (const auto &[slot, source] : targets) {
+        const auto &entry = source.file->entry(source.name);
+        if (slot.linear && weight_dtype != _meta.dtype) {
+            quantized.push_back({slot.tensor, &source});
+            continue;
+        }
+        if (_device_type == LLAISYS_DEVICE_CPU && entry.dtype == _meta.dtype) {
+            *slot.tensor = source.file->tensor(source.name);
+            continue;
+        }
+        const size_t numel = (*slot.tensor)->numel();
+        const size_t chunk = _device_type == LLAISYS_DEVICE_CPU ? CONVERT_CHUNK : numel;
+        for (size_t begin = 0; begin < numel; begin += chunk) {
+            tasks.push_back(
+                {source.file->data(entry), entry.dtype, *slot.tensor, begin, std::min(numel, begin + chunk)});
+        }
+    }
+
+    core::parallel_for(0, tasks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            const Task &task = tasks[t];
+            const size_t src_size = utils::dsize(task.src_dtype);
+            const size_t dst_size = task.dst->elementSize();
+            const size_t n = task.end - task.begin;
+            if (_device_type == LLAISYS_DEVICE_CPU) {
+                convert(task.dst->data() + task.begin * dst_size, task.dst->dtype(),
+                        task.src + task.begin * src_size, task.src_dtype, n);
+            } else {
+                std::vector<std::byte> host(n * dst_size);
+                convert(host.data(), task.dst->dtype(), task.src + task.begin * src_size, task.src_dtype, n);
+                task.dst->load(host.data());
+            }
+        }
+    });
+
+    // Quantized CPU weights move to other devices together with their scales and zero points.
+    auto place = [&](const tensor_t &weight) {
+        if (_device_type == LLAISYS_DEVICE_CPU) {
+            return weight;
+        }
+        tensor_t w = _create(weight->shape(), weight->dtype());
+        w->load(weight->data());
+        tensor_t scales = _create(weight->scales()->shape(), weight->scales()->dtype());
+        scales->load(weight->scales()->data());
+        tensor_t zeros;
+        if (weight->zeros()) {
+            zeros = _create(weight->zeros()->shape(), weight->zeros()->dtype());
+            zeros->load(weight->zeros()->data());
+        }
+        w->setScales(scales, zeros);
+        return w;
+    };
+
+    // Quantized weights replace the allocated ones. The quantize op spreads the rows
+    // of each weight over the pool, reading the checkpoint dtype straight from the file.
+    for (const auto &[slot, source] : quantized) {
+        tensor_t weight = source->file->tensor(source->name);
+        const std::vector<size_t> shape = weight->shape();
+        tensor_t q;
+        tensor_t scales;
+        if (weight_dtype == LLAISYS_DTYPE_Q4) {
+            q = Tensor::create({shape[0], shape[1] / 2}, LLAISYS_DTYPE_Q4);
+            scales = Tensor::create({shape[0], shape[1] / Q4_GROUP}, LLAISYS_DTYPE_F16);
+        } else {
+            q = Tensor::create(shape, LLAISYS_DTYPE_I8);
+            scales = Tensor::create({shape[0], 1}, LLAISYS_DTYPE_F32);
+        }
+        ops::quantize(q, scales, weight);
+        *slot = place(q);
+    }
+
+    // Pre-quantized weights are mapped from the files as they are, whatever `weight_dtype` says.
+    for (const auto &[slot, source] : stored) {
+        const SafetensorsFile &file = *source.file;
+        const Stored format = storedFormat(file, source.name, (*slot.tensor)->shape());
+        tensor_t weight = file.tensor(source.name, format.shape, format.dtype);
+        weight->setScales(file.tensor(format.scales), format.zeros.empty() ? nullptr : file.tensor(format.zeros));
+        *slot.tensor = place(weight);
+    }
+    return targets.size() + stored.size();
+}
+} // namespace llaisys::models::qwen2
@@ -0,0 +1,507 @@
+#include "model.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+#include "../../ops/add_rms_norm/op.hpp"
+#include "../../ops/embedding/op.hpp"
+#include "../../ops/linear/op.hpp"
+#include "../../ops/rms_norm/op.hpp"
+#include "../../ops/rope/op.hpp"
+#include "../../ops/sample/op.hpp"
+#include "../../ops/self_attention/op.hpp"
+#include "../../ops/swiglu/op.hpp"
+
+#include "../memory_planner/memory_planner.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace llaisys::models::qwen2 {
+namespace {
+// Steps of one forward pass, for the activation planner. Every layer runs the same
+// schedule over the same buffers, so one layer stands for all of them:
+//    0  load ids              1  embedding
+//    2  residual add + attn rms_norm           3  q, k, v = linear
+//    4  q rope, k rope        5  attention       6  o_proj
+//    7  residual add + mlp rms_norm            8  gate = linear
+//    9  up = linear          10  swiglu         11  down = linear
+//   12  residual add + final rms_norm         13  lm head + argmax, or lm head + sample
+//   14  read back
+// Each residual add is fused into the norm after it, so the MLP output of one layer
+// is added at step 2 of the next (or at 12 after the last layer). With packed weights,
+// q, k and v come from one linear_qkv that also applies the ropes of step 4, and steps
+// 8-10 are one linear_swiglu at step 10 that reads MLP_NORMED. Q is roped in place, and
+// K and V go straight into the KV cache, or through KEY and VALUE into a paged one at
+// step 5, right before attention reads it. GATE and UP are only planned while some layer
+// lacks the fused weights, and KEY and VALUE only for a paged KV cache.
+// A buffer is live from the step that writes it to the last step that reads it;
+// HIDDEN, POS_IDS and MLP_PROJ are read again by the next layer, so they span all
+// layer steps.
+struct Lifetime {
+    size_t first;
+    size_t last;
+};
+
+constexpr Lifetime LIFETIMES[Model::NUM_BUFFERS] = {
+    {0, 1},   // TOKEN_IDS
+    {0, 11},  // POS_IDS: the ropes of the next layer read it again
+    {1, 12},  // HIDDEN
+    {2, 3},   // ATTN_NORMED
+    {3, 5},   // Q
+    {3, 5},   // KEY
+    {3, 5},   // VALUE
+    {5, 6},   // ATTN
+    {6, 7},   // ATTN_PROJ
+    {7, 10},  // MLP_NORMED: read by step 10 when gate and up are fused
+    {8, 10},  // GATE
+    {9, 10},  // UP
+    {10, 11}, // ACT
+    {2, 12},  // MLP_PROJ: added into HIDDEN by the next layer's step 2
+    {12, 13}, // OUT_NORMED
+    {13, 14}, // MAX_IDX
+    {13, 13}, // MAX_VAL
+    {13, 13}, // LOGITS
+};
+
+// Whether `sampling` needs the logits: greedy decoding without penalties is picked by
+// linear_topk straight from the LM head.
+bool needsLogits(const LlaisysSamplingParams *sampling) {
+    if (sampling == nullptr) {
+        return false;
+    }
+    const bool greedy = sampling->temperature <= 0.0f || sampling->top_k == 1;
+    return !greedy || sampling->repetition_penalty != 1.0f || sampling->presence_penalty != 0.0f;
+}
+
+// What ops::sample picks for a row sampled with null params.
+constexpr LlaisysSamplingParams GREEDY = {0.0f, 1, 1.0f, 1.0f, 0.0f, 0};
+
+// Copy `n` token ids from the host into I64 `ids` from position `pos` on, without a view.
+void storeIds(const tensor_t &ids, size_t pos, const int64_t *src, size_t n) {
+    core::context().runtime().api()->memcpy_sync(
+        ids->data() + pos * sizeof(int64_t), src, n * sizeof(int64_t),
+        ids->deviceType() == LLAISYS_DEVICE_CPU ? LLAISYS_MEMCPY_H2H : LLAISYS_MEMCPY_H2D);
+}
+} // namespace
+
+Model::Model(const LlaisysQwen2Meta &meta, llaisysDeviceType_t device_type, int device_id)
+    : _meta(meta), _device_type(device_type), _device_id(device_id),
+      _kv_cache(meta.nlayer, meta.maxseq, meta.nkvh, meta.dh, meta.dtype, device_type, device_id), _offsets{},
+      _max_tokens(0), _max_seqs(0), _paged(false), _split_mlp(false) {
+    CHECK_ARGUMENT(meta.nlayer > 0 && meta.hs > 0 && meta.dh > 0 && meta.maxseq > 0 && meta.voc > 0,
+                   "Qwen2: invalid model meta");
+    CHECK_ARGUMENT(meta.nkvh > 0 && meta.nh % meta.nkvh == 0, "Qwen2: nh must be a multiple of nkvh");
+
+    const size_t hs = meta.hs;
+    const size_t q_dim = meta.nh * meta.dh;
+    const size_t kv_dim = meta.nkvh * meta.dh;
+    const auto dtype = meta.dtype;
+
+    _weights.in_embed = _create({meta.voc, hs}, dtype);
+    _weights.out_embed = _create({meta.voc, hs}, dtype);
+    _weights.out_norm_w = _create({hs}, dtype);
+
+    // Checkpoints without attention biases leave them zero.
+    std::vector<std::byte> zeros(q_dim * utils::dsize(dtype));
+    _weights.layers.resize(meta.nlayer);
+    for (auto &layer : _weights.layers) {
+        layer.attn_norm_w = _create({hs}, dtype);
+        layer.attn_q_w = _create({q_dim, hs}, dtype);
+        layer.attn_q_b = _create({q_dim}, dtype);
+        layer.attn_k_w = _create({kv_dim, hs}, dtype);
+        layer.attn_k_b = _create({kv_dim}, dtype);
+        layer.attn_v_w = _create({kv_dim, hs}, dtype);
+        layer.attn_v_b = _create({kv_dim}, dtype);
+        layer.attn_o_w = _create({hs, q_dim}, dtype);
+        layer.mlp_norm_w = _create({hs}, dtype);
+        layer.mlp_gate_w = _create({meta.di, hs}, dtype);
+        layer.mlp_up_w = _create({meta.di, hs}, dtype);
+        layer.mlp_down_w = _create({hs, meta.di}, dtype);
+        layer.attn_q_b->load(zeros.data());
+        layer.attn_k_b->load(zeros.data());
+        layer.attn_v_b->load(zeros.data());
+    }
+    _rope_table = _create({meta.maxseq, meta.dh}, LLAISYS_DTYPE_F32);
+    ops::rope_table(_rope_table, meta.theta);
+    _history = _create({meta.maxseq}, LLAISYS_DTYPE_I64);
+
+    reserve(DEFAULT_MAX_TOKENS);
+}
+
+tensor_t Model::_create(const std::vector<size_t> &shape, llaisysDataType_t dtype) const {
+    return Tensor::create(shape, dtype, _device_type, _device_id);
+}
+
+size_t Model::reserve(size_t max_tokens, size_t max_seqs, bool paged) {
+    CHECK_ARGUMENT(max_tokens > 0 && max_seqs > 0, "Qwen2: max_tokens and max_seqs must be positive");
+    const size_t n = std::min(max_tokens, _meta.maxseq);
+    const size_t m = std::min(max_seqs, n);
+    const size_t kv_dim = _meta.nkvh * _meta.dh;
+    const size_t hs = _meta.hs;
+    const size_t q_dim = _meta.nh * _meta.dh;
+    const size_t es = utils::dsize(_meta.dtype);
+    const bool split_mlp = std::any_of(_weights.layers.begin(), _weights.layers.end(),
+                                       [](const LayerWeights &w) { return !w.mlp_gate_up_w; });
+    const size_t staged = paged ? n * kv_dim * es : 0;
+    const size_t gate_up = split_mlp ? n * _meta.di * es : 0;
+
+    const std::array<size_t, NUM_BUFFERS> bytes = {
+        n * sizeof(int64_t), // TOKEN_IDS
+        n * sizeof(int64_t), // POS_IDS
+        n * hs * es,         // HIDDEN
+        n * hs * es,         // ATTN_NORMED
+        n * q_dim * es,      // Q
+        staged,              // KEY
+        staged,              // VALUE
+        n * q_dim * es,      // ATTN
+        n * hs * es,         // ATTN_PROJ
+        n * hs * es,         // MLP_NORMED
+        gate_up,             // GATE
+        gate_up,             // UP
+        n * _meta.di * es,   // ACT
+        n * hs * es,         // MLP_PROJ
+        m * hs * es,         // OUT_NORMED
+        m * sizeof(int64_t), // MAX_IDX
+        m * es,              // MAX_VAL
+        m * _meta.voc * es,  // LOGITS
+    };
+
+    MemoryPlanner planner;
+    for (size_t b = 0; b < NUM_BUFFERS; b++) {
+        planner.add(bytes[b], LIFETIMES[b].first, LIFETIMES[b].last);
+    }
+    planner.plan();
+    for (size_t b = 0; b < NUM_BUFFERS; b++) {
+        _offsets[b] = planner.offset(b);
+    }
+
+    // Release the old slab before allocating the new one.
+    _act = Activations{};
+    _entry_rows.clear();
+    _head_views.clear();
+    _arena.reset();
+    core::context().setDevice(_device_type, _device_id);
+    _arena = core::context().runtime().allocateDeviceStorage(planner.size());
+    _max_tokens = n;
+    _max_seqs = m;
+    _paged = paged;
+    _split_mlp = split_mlp;
+    _token_ids.resize(n);
+    _positions.resize(n);
+    _predicted.resize(m);
+    return planner.size();
+}
+
+size_t Model::maxTokens() const {
+    return _max_tokens;
+}
+
+size_t Model::maxSeqs() const {
+    return _max_seqs;
+}
+
+bool Model::paged() const {
+    return _paged;
+}
+
+size_t Model::activationBytes() const {
+    return _arena->size();
+}
+
+void Model::_bind(size_t ntoken, size_t nseq) {
+    if (ntoken == _act.ntoken && nseq == _act.nseq) {
+        return;
+    }
+    const size_t hs = _meta.hs;
+    const size_t nh = _meta.nh;
+    const size_t nkvh = _meta.nkvh;
+    const size_t dh = _meta.dh;
+    const auto dtype = _meta.dtype;
+    auto &buf = _act.buf;
+    auto place = [&](Buffer b, const std::vector<size_t> &shape, llaisysDataType_t type) {
+        buf[b] = Tensor::create(shape, type, _arena, _offsets[b]);
+    };
+
+    place(TOKEN_IDS, {ntoken}, LLAISYS_DTYPE_I64);
+    place(POS_IDS, {ntoken}, LLAISYS_DTYPE_I64);
+    place(HIDDEN, {ntoken, hs}, dtype);
+    place(ATTN_NORMED, {ntoken, hs}, dtype);
+    place(Q, {ntoken, nh, dh}, dtype);
+    place(ATTN, {ntoken, nh * dh}, dtype);
+    place(ATTN_PROJ, {ntoken, hs}, dtype);
+    place(MLP_NORMED, {ntoken, hs}, dtype);
+    place(ACT, {ntoken, _meta.di}, dtype);
+    place(MLP_PROJ, {ntoken, hs}, dtype);
+    place(OUT_NORMED, {nseq, hs}, dtype);
+    place(MAX_IDX, {nseq, 1}, LLAISYS_DTYPE_I64);
+    place(MAX_VAL, {nseq, 1}, dtype);
+    place(LOGITS, {nseq, _meta.voc}, dtype);
+    if (_paged) {
+        place(KEY, {ntoken, nkvh, dh}, dtype);
+        place(VALUE, {ntoken, nkvh, dh}, dtype);
+        _act.staged = KVCache::Rows{buf[KEY], buf[VALUE], buf[KEY]->view({ntoken, nkvh * dh}),
+                                    buf[VALUE]->view({ntoken, nkvh * dh})};
+    }
+    if (_split_mlp) {
+        place(GATE, {ntoken, _meta.di}, dtype);
+        place(UP, {ntoken, _meta.di}, dtype);
+    }
+
+    _act.q_rows = buf[Q]->view({ntoken, nh * dh});
+    _act.attn_heads = buf[ATTN]->view({ntoken, nh, dh});
+    _act.hidden_last = buf[HIDDEN]->slice(0, ntoken - 1, ntoken);
+    _act.mlp_proj_last = buf[MLP_PROJ]->slice(0, ntoken - 1, ntoken);
+    _act.ntoken = ntoken;
+    _act.nseq = nseq;
+}
+
+const LlaisysQwen2Meta &Model::meta() const {
+    return _meta;
+}
+
+llaisysDeviceType_t Model::deviceType() const {
+    return _device_type;
+}
+
+int Model::deviceId() const {
+    return _device_id;
+}
+
+Weights &Model::weights() {
+    return _weights;
+}
+
+const KVCache &Model::kvCache() const {
+    return _kv_cache;
+}
+
+void Model::reset() {
+    _kv_cache.reset();
+}
+
+void Model::_qkv(size_t layer, const KVCache::Rows &kv) {
+    const LayerWeights &w = _weights.layers[layer];
+    const auto &buf = _act.buf;
+
+    // Attention. The previous layer's MLP output joins the residual stream here.
+    if (layer == 0) {
+        ops::rms_norm(buf[ATTN_NORMED], buf[HIDDEN], w.attn_norm_w, _meta.epsilon);
+    } else {
+        ops::add_rms_norm(buf[ATTN_NORMED], buf[HIDDEN], buf[MLP_PROJ], w.attn_norm_w, _meta.epsilon);
+    }
+
+    if (w.attn_qkv_w) {
+        ops::linear_qkv(buf[Q], kv.key, kv.value, buf[ATTN_NORMED], w.attn_qkv_w, w.attn_q_b, w.attn_k_b,
+                        w.attn_v_b, buf[POS_IDS], _rope_table);
+    } else {
+        ops::linear(_act.q_rows, buf[ATTN_NORMED], w.attn_q_w, w.attn_q_b);
+        ops::linear(kv.key_flat, buf[ATTN_NORMED], w.attn_k_w, w.attn_k_b);
+        ops::linear(kv.value_flat, buf[ATTN_NORMED], w.attn_v_w, w.attn_v_b);
+        ops::rope_cached(buf[Q], buf[Q], buf[POS_IDS], _rope_table);
+        ops::rope_cached(kv.key, kv.key, buf[POS_IDS], _rope_table);
+    }
+}
+
+void Model::_mlp(size_t layer) {
+    const LayerWeights &w = _weights.layers[layer];
+    const auto &buf = _act.buf;
+
+    ops::linear(buf[ATTN_PROJ], buf[ATTN], w.attn_o_w, nullptr);
+
+    // MLP
+    ops::add_rms_norm(buf[MLP_NORMED], buf[HIDDEN], buf[ATTN_PROJ], w.mlp_norm_w, _meta.epsilon);
+    if (w.mlp_gate_up_w) {
+        ops::linear_swiglu(buf[ACT], buf[MLP_NORMED], w.mlp_gate_up_w);
+    } else {
+        ops::linear(buf[GATE], buf[MLP_NORMED], w.mlp_gate_w, nullptr);
+        ops::linear(buf[UP], buf[MLP_NORMED], w.mlp_up_w, nullptr);
+        ops::swiglu(buf[ACT], buf[GATE], buf[UP]);
+    }
+    ops::linear(buf[MLP_PROJ], buf[ACT], w.mlp_down_w, nullptr);
+}
+
+void Model::_forwardLayer(size_t layer, size_t pos, size_t ntoken) {
+    // This step's rows of the cache, filled in place and committed by _forward.
+    _qkv(layer, _kv_cache.next(layer, ntoken));
+    ops::self_attention(_act.attn_heads, _act.buf[Q], _kv_cache.keys(layer), _kv_cache.values(layer), pos + ntoken,
+                        1.0f / std::sqrt(static_cast<float>(_meta.dh)));
+    _mlp(layer);
+}
+
+void Model::_forward(const int64_t *token_ids, size_t ntoken) {
+    _bind(ntoken, 1);
+    const size_t pos = _kv_cache.length();
+    std::iota(_positions.begin(), _positions.begin() + ntoken, static_cast<int64_t>(pos));
+    _act.buf[TOKEN_IDS]->load(token_ids);
+    _act.buf[POS_IDS]->load(_positions.data());
+    storeIds(_history, pos, token_ids, ntoken);
+
+    ops::embedding(_act.buf[HIDDEN], _act.buf[TOKEN_IDS], _weights.in_embed);
+    for (size_t layer = 0; layer < _meta.nlayer; layer++) {
+        _forwardLayer(layer, pos, ntoken);
+    }
+    _kv_cache.append(ntoken);
+}
+
+int64_t Model::infer(const int64_t *token_ids, size_t ntoken, const LlaisysSamplingParams *sampling) {
+    CHECK_ARGUMENT(ntoken > 0, "Qwen2: no input tokens");
+    CHECK_ARGUMENT(_kv_cache.length() + ntoken <= _kv_cache.capacity(), "Qwen2: sequence exceeds maxseq");
+
+    core::context().setDevice(_device_type, _device_id);
+    // Inputs longer than the plan run in chunks; the KV cache carries the context across.
+    for (size_t done = 0; done < ntoken;) {
+        const size_t n = std::min(_max_tokens, ntoken - done);
+        _forward(token_ids + done, n);
+        done += n;
+    }
+
+    // Only the last position predicts the next token, so only its row of the last
+    // layer's MLP output is added.
+    ops::add_rms_norm(_act.buf[OUT_NORMED], _act.hidden_last, _act.mlp_proj_last, _weights.out_norm_w,
+                      _meta.epsilon);
+    const size_t len = _kv_cache.length();
+    _head_rows.assign(1, HeadRow{sampling, _history, len});
+    _head();
+    return _predicted[0];
+}
+
+void Model::_head() {
+    const auto &buf = _act.buf;
+    const size_t nrow = _head_rows.size();
+    const bool logits = std::any_of(_head_rows.begin(), _head_rows.end(),
+                                    [](const HeadRow &row) { return needsLogits(row.sampling); });
+    if (logits) {
+        ops::linear(buf[LOGITS], buf[OUT_NORMED], _weights.out_embed, nullptr);
+        for (size_t r = 0; r < nrow; r++) {
+            LlaisysSamplingParams step = _head_rows[r].sampling != nullptr ? *_head_rows[r].sampling : GREEDY;
+            step.seed += _head_rows[r].length;
+            const tensor_t &idx = nrow == 1 ? buf[MAX_IDX] : _head_views[r].max_idx;
+            const tensor_t &row = nrow == 1 ? buf[LOGITS] : _head_views[r].logits;
+            ops::sample(idx, row, _head_rows[r].history, _head_rows[r].length, step);
+        }
+    } else {
+        ops::linear_topk(buf[MAX_IDX], buf[MAX_VAL], buf[OUT_NORMED], _weights.out_embed);
+    }
+
+    core::context().runtime().api()->memcpy_sync(
+        _predicted.data(), buf[MAX_IDX]->data(), nrow * sizeof(int64_t),
+        _device_type == LLAISYS_DEVICE_CPU ? LLAISYS_MEMCPY_H2H : LLAISYS_MEMCPY_D2H);
+}
+
+size_t Model::generate(const int64_t *prompt, size_t nprompt, const LlaisysSamplingParams &sampling,
+                       size_t max_new_tokens, llaisysTokenCallback_t callback, void *user_data) {
+    reset();
+    if (max_new_tokens == 0) {
+        return 0;
+    }
+    int64_t token = infer(prompt, nprompt, &sampling);
+    for (size_t emitted = 1;; emitted++) {
+        const bool stop = callback != nullptr && callback(token, user_data) != 0;
+        if (stop || token == _meta.end_token || emitted == max_new_tokens ||
+            _kv_cache.length() == _kv_cache.capacity()) {
+            return emitted;
+        }
+        token = infer(&token, 1, &sampling);
+    }
+}
+
+void Model::inferBatch(PagedKVCache &cache, const std::vector<BatchEntry> &batch) {
+    CHECK_ARGUMENT(!batch.empty(), "Qwen2: empty batch");
+    size_t ntoken = 0;
+    size_t nseq = 0;
+    for (const BatchEntry &entry : batch) {
+        CHECK_ARGUMENT(entry.ntoken > 0, "Qwen2: no input tokens");
+        CHECK_ARGUMENT(cache.length(entry.seq) + entry.ntoken <= _meta.maxseq, "Qwen2: sequence exceeds maxseq");
+        ntoken += entry.ntoken;
+        nseq += entry.next_token != nullptr;
+    }
+    CHECK_ARGUMENT(_paged, "Qwen2: activations were not reserved for a paged KV cache");
+    CHECK_ARGUMENT(ntoken <= _max_tokens && nseq <= _max_seqs, "Qwen2: batch exceeds the reserved activations");
+
+    core::context().setDevice(_device_type, _device_id);
+    _bind(ntoken, std::max<size_t>(nseq, 1));
+    const auto &buf = _act.buf;
+    while (_head_views.size() < nseq) {
+        const size_t r = _head_views.size();
+        _head_views.push_back(HeadViews{buf[OUT_NORMED]->slice(0, r, r + 1), buf[MAX_IDX]->slice(0, r, r + 1),
+                                        buf[LOGITS]->slice(0, r, r + 1)});
+    }
+
+    // Stack the entries' rows; each keeps its own positions.
+    size_t row = 0;
+    for (size_t i = 0; i < batch.size(); i++) {
+        const BatchEntry &entry = batch[i];
+        const size_t pos = cache.length(entry.seq);
+        const size_t end = row + entry.ntoken;
+        std::copy(entry.token_ids, entry.token_ids + entry.ntoken, _token_ids.begin() + row);
+        std::iota(_positions.begin() + row, _positions.begin() + end, static_cast<int64_t>(pos));
+        if (entry.history) {
+            storeIds(entry.history, pos, entry.token_ids, entry.ntoken);
+        }
+        if (i == _entry_rows.size()) {
+            _entry_rows.push_back(EntryRows{buf[Q]->slice(0, 0, 1), _act.attn_heads->slice(0, 0, 1),
+                                            buf[KEY]->slice(0, 0, 1), buf[VALUE]->slice(0, 0, 1),
+                                            buf[HIDDEN]->slice(0, 0, 1), buf[MLP_PROJ]->slice(0, 0, 1), nullptr, 0});
+        }
+        EntryRows &rows = _entry_rows[i];
+        rows.q->reslice(*buf[Q], 0, row, end);
+        rows.attn->reslice(*_act.attn_heads, 0, row, end);
+        rows.key->reslice(*buf[KEY], 0, row, end);
+        rows.value->reslice(*buf[VALUE], 0, row, end);
+        rows.hidden->reslice(*buf[HIDDEN], 0, end - 1);
+        rows.mlp_proj->reslice(*buf[MLP_PROJ], 0, end - 1);
+        rows.block_table = cache.blockTable(entry.seq);
+        rows.kv_len = pos + entry.ntoken;
+        row = end;
+    }
+    buf[TOKEN_IDS]->load(_token_ids.data());
+    buf[POS_IDS]->load(_positions.data());
+
+    ops::embedding(buf[HIDDEN], buf[TOKEN_IDS], _weights.in_embed);
+    const float scale = 1.0f / std::sqrt(static_cast<float>(_meta.dh));
+    for (size_t layer = 0; layer < _meta.nlayer; layer++) {
+        _qkv(layer, _act.staged);
+        for (size_t i = 0; i < batch.size(); i++) {
+            const EntryRows &rows = _entry_rows[i];
+            cache.write(layer, batch[i].seq, rows.key, rows.value);
+            ops::paged_self_attention(rows.attn, rows.q, cache.keyBlocks(layer), cache.valueBlocks(layer),
+                                      rows.block_table, rows.kv_len, scale);
+        }
+        _mlp(layer);
+    }
+    for (const BatchEntry &entry : batch) {
+        cache.append(entry.seq, entry.ntoken);
+    }
+    if (nseq == 0) {
+        return;
+    }
+
+    // The last row of each entry that predicts goes through the LM head; in a batch of
+    // decodes that is every row.
+    _head_rows.clear();
+    if (nseq == ntoken) {
+        ops::add_rms_norm(buf[OUT_NORMED], buf[HIDDEN], buf[MLP_PROJ], _weights.out_norm_w, _meta.epsilon);
+    }
+    for (size_t i = 0; i < batch.size(); i++) {
+        const BatchEntry &entry = batch[i];
+        if (entry.next_token == nullptr) {
+            continue;
+        }
+        if (nseq != ntoken) {
+            ops::add_rms_norm(_head_views[_head_rows.size()].out_normed, _entry_rows[i].hidden,
+                              _entry_rows[i].mlp_proj, _weights.out_norm_w, _meta.epsilon);
+        }
+        const size_t len = cache.length(entry.seq);
+        _head_rows.push_back(HeadRow{entry.sampling, entry.history, len});
+    }
+    _head();
+    size_t r = 0;
+    for (const BatchEntry &entry : batch) {
+        if (entry.next_token != nullptr) {
+            *entry.next_token = _predicted[r++];
+        }
+    }
+}
+} // namespace llaisys::models::qwen2
@@ -0,0 +1,234 @@
+#pragma once
+#include "llaisys/models/qwen2.h"
+
+#include "../../tensor/tensor.hpp"
+#include "../kv_cache/kv_cache.hpp"
+#include "../kv_cache/paged_kv_cache.hpp"
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace llaisys::models::qwen2 {
+struct LayerWeights {
+    tensor_t attn_norm_w;
+    tensor_t attn_q_w;
+    tensor_t attn_q_b;
+    tensor_t attn_k_w;
+    tensor_t attn_k_b;
+    tensor_t attn_v_w;
+    tensor_t attn_v_b;
+    tensor_t attn_o_w;
+    // attn_q_w, attn_k_w and attn_v_w packed together by prepack(), which then drops them.
+    tensor_t attn_qkv_w;
+    tensor_t mlp_norm_w;
+    tensor_t mlp_gate_w;
+    tensor_t mlp_up_w;
+    tensor_t mlp_down_w;
+    // mlp_gate_w and mlp_up_w packed together by prepack(), which then drops them.
+    tensor_t mlp_gate_up_w;
+};
+
+struct Weights {
+    tensor_t in_embed;
+    tensor_t out_embed;
+    tensor_t out_norm_w;
+    std::vector<LayerWeights> layers;
+};
+
+// Qwen2 decoder running the whole forward pass on llaisys ops.
+//
+// Weights are allocated up front with the shapes in the meta and filled by the
+// caller. Every call to infer() appends its tokens to a KV cache that persists
+// until reset(), so a decode step only computes the new token.
+//
+// Activations live in one slab laid out by a MemoryPlanner for steps of up to
+// maxTokens() tokens, every layer reusing the same buffers; longer inputs run in
+// chunks of that size. The tensors over the slab, like the views of the KV cache rows
+// a step writes, are only rebuilt when the step size changes, so a decode step does no
+// heap allocation at all.
+//
+// inferBatch() runs several sequences of a PagedKVCache in one pass instead, their rows
+// stacked through every linear and each attending to its own cached positions; the
+// Scheduler builds continuous batching on it.
+class Model {
+public:
+    // Activations planned for by default: one prefill chunk, or a batch of decodes.
+    static constexpr size_t DEFAULT_MAX_TOKENS = 256;
+
+    // Activation buffers, in slab order of the planner.
+    enum Buffer : size_t {
+        TOKEN_IDS,   // [n] i64
+        POS_IDS,     // [n] i64
+        HIDDEN,      // [n, hs], the residual stream
+        ATTN_NORMED, // [n, hs]
+        Q,           // [n, nh, dh], roped in place; K and V are written to the KV cache
+        KEY,         // [n, nkvh, dh], K on its way to a paged KV cache; only if paged
+        VALUE,       // [n, nkvh, dh], V on its way to a paged KV cache; only if paged
+        ATTN,        // [n, nh * dh]
+        ATTN_PROJ,   // [n, hs]
+        MLP_NORMED,  // [n, hs]
+        GATE,        // [n, di], only while some layer lacks mlp_gate_up_w
+        UP,          // [n, di], only while some layer lacks mlp_gate_up_w
+        ACT,         // [n, di]
+        MLP_PROJ,    // [n, hs]
+        OUT_NORMED,  // [m, hs], one row per sequence that predicts a token
+        MAX_IDX,     // [m, 1] i64, picked by the LM head without materializing logits
+        MAX_VAL,     // [m, 1]
+        LOGITS,      // [m, voc], only written when sampling
+        NUM_BUFFERS
+    };
+
+    // One sequence's share of an inferBatch() step.
+    struct BatchEntry {
+        size_t seq;                            // sequence of the PagedKVCache
+        const int64_t *token_ids;              // its new tokens
+        size_t ntoken;
+        const LlaisysSamplingParams *sampling; // null for greedy
+        tensor_t history;                      // I64 [maxseq] ids of the sequence, or null
+        int64_t *next_token;                   // receives the predicted token; null for none
+    };
+
+private:
+    // Tensors over the slab for a step of `ntoken` tokens, plus the other views ops need.
+    struct Activations {
+        size_t ntoken = 0;
+        size_t nseq = 0;
+        std::array<tensor_t, NUM_BUFFERS> buf;
+        tensor_t q_rows;        // Q as [n, nh * dh]
+        KVCache::Rows staged;   // KEY and VALUE, for a paged KV cache to copy from
+        tensor_t attn_heads;    // ATTN as [n, nh, dh]
+        tensor_t hidden_last;   // last row of HIDDEN
+        tensor_t mlp_proj_last; // last row of MLP_PROJ
+    };
+
+    LlaisysQwen2Meta _meta;
+    llaisysDeviceType_t _device_type;
+    int _device_id;
+    Weights _weights;
+
+    KVCache _kv_cache;
+    // cos | sin of the RoPE angles of positions [0, maxseq), F32 [maxseq, dh] (see
+    // ops::rope_table), shared by every layer and head.
+    tensor_t _rope_table;
+    // Ids of the tokens in the KV cache, I64 [maxseq], for the sampling penalties.
+    tensor_t _history;
+
+    // What the LM head needs for one row of OUT_NORMED.
+    struct HeadRow {
+        const LlaisysSamplingParams *sampling;
+        tensor_t history; // ids of the sequence for the penalties, or null
+        size_t length;    // of the sequence: the ids of `history` in use, and the seed offset
+    };
+    // Views of one BatchEntry's rows, shared by every layer of a step. Each batch slot
+    // keeps its views across steps and moves them with Tensor::reslice.
+    struct EntryRows {
+        tensor_t q;
+        tensor_t attn;
+        tensor_t key;
+        tensor_t value;
+        tensor_t hidden;   // last row of HIDDEN
+        tensor_t mlp_proj; // last row of MLP_PROJ
+        tensor_t block_table;
+        size_t kv_len;
+    };
+    // Row r of OUT_NORMED, MAX_IDX and LOGITS, for head row r of a batch.
+    struct HeadViews {
+        tensor_t out_normed;
+        tensor_t max_idx;
+        tensor_t logits;
+    };
+
+    core::storage_t _arena;
+    std::array<size_t, NUM_BUFFERS> _offsets;
+    size_t _max_tokens;
+    size_t _max_seqs;
+    bool _paged;     // KEY and VALUE are planned
+    bool _split_mlp; // GATE and UP are planned
+    Activations _act;
+    std::vector<int64_t> _token_ids;
+    std::vector<int64_t> _positions;
+    std::vector<HeadRow> _head_rows;
+    // Both only grow, and are dropped with the slab they view.
+    std::vector<EntryRows> _entry_rows;
+    std::vector<HeadViews> _head_views;
+    std::vector<int64_t> _predicted;
+
+    tensor_t _create(const std::vector<size_t> &shape, llaisysDataType_t dtype) const;
+    void _bind(size_t ntoken, size_t nseq);
+    void _forward(const int64_t *token_ids, size_t ntoken);
+    void _forwardLayer(size_t layer, size_t pos, size_t ntoken);
+    // The attention input of a layer: q into Q, k and v into `kv`, roped.
+    void _qkv(size_t layer, const KVCache::Rows &kv);
+    // The rest of a layer once ATTN holds the attention output.
+    void _mlp(size_t layer);
+    // Next tokens of the first _head_rows.size() rows of OUT_NORMED, into _predicted.
+    void _head();
+
+public:
+    Model(const LlaisysQwen2Meta &meta, llaisysDeviceType_t device_type, int device_id);
+    ~Model() = default;
+
+    // Prevent copy
+    Model(const Model &) = delete;
+    Model &operator=(const Model &) = delete;
+
+    const LlaisysQwen2Meta &meta() const;
+    llaisysDeviceType_t deviceType() const;
+    int deviceId() const;
+    Weights &weights();
+
+    // Fill the weights from Hugging Face safetensors files and return how many tensors
+    // were taken. Without an lm_head.weight the output embedding is tied to the input
+    // one; without attention biases they stay zero. Any other missing weight is an
+    // error. On CPU, weights stored in the model dtype are mapped from the files in
+    // place of the allocated ones; all others are converted across the thread pool.
+    // With `weight_dtype` I8 or Q4, the linear weights (attention and MLP projections and
+    // the LM head) are quantized instead, I8 per output channel and Q4 in symmetric groups
+    // of 32 columns; the rest keep the model dtype. Linear weights the checkpoint already
+    // stores quantized (see scripts/quantize_qwen2.py) are mapped as they are.
+    size_t loadSafetensors(const std::vector<std::string> &paths, llaisysDataType_t weight_dtype);
+
+    // Replace the F32/F16/BF16 linear weights (not quantized ones) with ops::linear_prepack
+    // layouts and return how many were packed; CPU only. Each layer's q, k and v projections
+    // go into attn_qkv_w for ops::linear_qkv instead, and its gate and up projections into
+    // mlp_gate_up_w for ops::linear_swiglu. With a `cache_path`, a cache file
+    // there that matches these weights and this host's kernels is mapped instead of packing,
+    // and one is written otherwise (silently skipped if the path is not writable). The
+    // activations are planned again, without the buffers the fused ops leave unused.
+    size_t prepack(const std::string &cache_path);
+
+    const KVCache &kvCache() const;
+
+    // Plan and allocate the activations for steps of up to `max_tokens` tokens (capped
+    // at maxseq) of which up to `max_seqs` predict a token, replacing the current plan.
+    // Only a `paged` plan stages K and V for inferBatch(). Returns the slab size in bytes.
+    size_t reserve(size_t max_tokens, size_t max_seqs = 1, bool paged = false);
+    size_t maxTokens() const;
+    size_t maxSeqs() const;
+    bool paged() const;
+    size_t activationBytes() const;
+
+    // Forget the cached sequence; the next infer() starts at position 0.
+    void reset();
+
+    // Run `ntoken` new tokens after the cached sequence and return the next token: the
+    // greedy one, or one drawn by ops::sample with `sampling` over the whole cached
+    // sequence. The seed is offset by the sequence length, so every position gets its own
+    // draw and a sequence replays exactly from the same seed.
+    int64_t infer(const int64_t *token_ids, size_t ntoken, const LlaisysSamplingParams *sampling = nullptr);
+
+    // Start a new sequence from `prompt` and decode until `max_new_tokens` tokens, the end
+    // token, a nonzero return from `callback` or a full KV cache, handing each token to
+    // `callback` (may be null) as it comes. Returns how many tokens were emitted.
+    size_t generate(const int64_t *prompt, size_t nprompt, const LlaisysSamplingParams &sampling,
+                    size_t max_new_tokens, llaisysTokenCallback_t callback, void *user_data);
+
+    // Run every entry's tokens after its sequence in `cache` as one step, their rows
+    // stacked in batch order, and commit them to the cache, which must have reserved the
+    // positions. Entries with a next_token get it as infer() would pick it. The model's
+    // own KV cache is left alone. At most maxTokens() tokens and maxSeqs() next tokens,
+    // from a paged reserve().
+    void inferBatch(PagedKVCache &cache, const std::vector<BatchEntry> &batch);
+};
+} // namespace llaisys::models::qwen2
@@ -0,0 +1,298 @@
+#include "model.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+#include "../../ops/linear/op.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace llaisys::models::qwen2 {
+namespace {
+// Packed-weight cache file: a header, one entry per packed weight in the order of
+// packJobs(), then the packed blobs, each starting on a BLOB_ALIGN boundary so
+// that the mapped file can feed the kernels directly.
+constexpr char CACHE_MAGIC[8] = {'L', 'L', 'P', 'A', 'C', 'K', '0', '4'};
+constexpr size_t BLOB_ALIGN = 64;
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+// Bytes of a weight hashed per thread-pool task.
+constexpr size_t HASH_CHUNK = size_t(4) << 20;
+
+struct CacheHeader {
+    char magic[8];
+    uint64_t packing;
+    uint64_t count;
+    uint64_t fingerprint; // of every source weight, in entry order
+};
+
+struct CacheEntry {
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t dtype;
+    uint64_t fingerprint;
+    uint64_t offset;
+    uint64_t bytes;
+};
+
+// How the sources of a packed weight are combined.
+enum class PackKind {
+    LINEAR,  // one weight, packed in place
+    QKV,     // q, k and v concatenated for ops::linear_qkv
+    GATE_UP, // gate and up interleaved for ops::linear_swiglu
+};
+
+// One packed weight and the weights it is packed from.
+struct PackJob {
+    PackKind kind;
+    tensor_t *dst;
+    std::vector<tensor_t *> sources;
+
+    size_t rows() const {
+        size_t rows = 0;
+        for (tensor_t *w : sources) {
+            rows += (*w)->shape()[0];
+        }
+        return rows;
+    }
+    size_t cols() const {
+        return (*sources[0])->shape()[1];
+    }
+    llaisysDataType_t dtype() const {
+        return (*sources[0])->dtype();
+    }
+    uint64_t packing() const {
+        return kind == PackKind::GATE_UP ? ops::linear_gate_up_packing(LLAISYS_DEVICE_CPU)
+                                         : ops::linear_packing(LLAISYS_DEVICE_CPU);
+    }
+    size_t bytes() const {
+        return kind == PackKind::GATE_UP
+                   ? ops::linear_gate_up_packed_bytes(LLAISYS_DEVICE_CPU, dtype(), rows() / 2, cols())
+                   : ops::linear_packed_bytes(LLAISYS_DEVICE_CPU, dtype(), rows(), cols());
+    }
+    tensor_t pack() const {
+        switch (kind) {
+        case PackKind::QKV:
+            return ops::linear_prepack_qkv(*sources[0], *sources[1], *sources[2]);
+        case PackKind::GATE_UP:
+            return ops::linear_prepack_gate_up(*sources[0], *sources[1]);
+        default:
+            return ops::linear_prepack(*sources[0]);
+        }
+    }
+};
+
+bool packable(const tensor_t &w) {
+    return w && w->packing() == 0 && w->scales() == nullptr;
+}
+
+// Whether `group` can be packed as one weight: all packable, of one dtype and width.
+bool packableTogether(const std::vector<tensor_t *> &group) {
+    for (tensor_t *w : group) {
+        if (!packable(*w) || (*w)->dtype() != (*group[0])->dtype() || (*w)->shape()[1] != (*group[0])->shape()[1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The weights linear reads that can be packed: the float projections and LM head.
+// Each layer's q/k/v and gate/up projections are packed together when they can be.
+std::vector<PackJob> packJobs(Weights &weights) {
+    std::vector<PackJob> jobs;
+    auto add = [&](tensor_t &w) {
+        if (packable(w)) {
+            jobs.push_back({PackKind::LINEAR, &w, {&w}});
+        }
+    };
+    auto addGroup = [&](PackKind kind, tensor_t &dst, std::vector<tensor_t *> group) {
+        if (packableTogether(group)) {
+            jobs.push_back({kind, &dst, std::move(group)});
+            return;
+        }
+        for (tensor_t *w : group) {
+            add(*w);
+        }
+    };
+    for (auto &layer : weights.layers) {
+        addGroup(PackKind::QKV, layer.attn_qkv_w, {&layer.attn_q_w, &layer.attn_k_w, &layer.attn_v_w});
+        add(layer.attn_o_w);
+        addGroup(PackKind::GATE_UP, layer.mlp_gate_up_w, {&layer.mlp_gate_w, &layer.mlp_up_w});
+        add(layer.mlp_down_w);
+    }
+    add(weights.out_embed);
+    return jobs;
+}
+
+// FNV-1a over 64-bit words, then the trailing bytes.
+uint64_t hashBytes(const std::byte *data, size_t n, uint64_t h) {
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        h = (h ^ word) * FNV_PRIME;
+    }
+    for (; i < n; i++) {
+        h = (h ^ static_cast<uint8_t>(data[i])) * FNV_PRIME;
+    }
+    return h;
+}
+
+// Hash of every byte of a weight, continuing from `h` (chained over the sources of a
+// packed weight), so that a checkpoint changed in place never matches a stale cache.
+// Chunks are hashed across the pool and their hashes chained in order.
+uint64_t fingerprint(const tensor_t &weight, uint64_t h) {
+    const size_t bytes = weight->numel() * weight->elementSize();
+    const std::byte *data = weight->data();
+    std::vector<uint64_t> chunks((bytes + HASH_CHUNK - 1) / HASH_CHUNK);
+    core::parallel_for(0, chunks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; c++) {
+            const size_t offset = c * HASH_CHUNK;
+            chunks[c] = hashBytes(data + offset, std::min(HASH_CHUNK, bytes - offset), FNV_OFFSET);
+        }
+    });
+    h = hashBytes(reinterpret_cast<const std::byte *>(&bytes), sizeof(bytes), h);
+    return hashBytes(reinterpret_cast<const std::byte *>(chunks.data()), chunks.size() * sizeof(uint64_t), h);
+}
+
+size_t alignUp(size_t n) {
+    return (n + BLOB_ALIGN - 1) / BLOB_ALIGN * BLOB_ALIGN;
+}
+
+// Entries for `jobs` as they would be laid out in a fresh cache.
+std::vector<CacheEntry> cacheEntries(const std::vector<PackJob> &jobs) {
+    std::vector<CacheEntry> entries;
+    size_t offset = alignUp(sizeof(CacheHeader) + jobs.size() * sizeof(CacheEntry));
+    for (const PackJob &job : jobs) {
+        uint64_t h = FNV_OFFSET;
+        for (tensor_t *w : job.sources) {
+            h = fingerprint(*w, h);
+        }
+        const size_t bytes = job.bytes();
+        entries.push_back({job.rows(), job.cols(), static_cast<uint64_t>(job.dtype()), h, offset, bytes});
+        offset = alignUp(offset + bytes);
+    }
+    return entries;
+}
+
+// Fingerprint of the whole set of weights `entries` are packed from.
+uint64_t cacheFingerprint(const std::vector<CacheEntry> &entries) {
+    uint64_t h = FNV_OFFSET;
+    for (const CacheEntry &entry : entries) {
+        h = hashBytes(reinterpret_cast<const std::byte *>(&entry.fingerprint), sizeof(entry.fingerprint), h);
+    }
+    return h;
+}
+
+// Whether the file at `path` holds exactly `expected`, packed as this host packs.
+bool cacheMatches(const std::string &path, const std::vector<CacheEntry> &expected) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    CacheHeader header;
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.packing != ops::linear_packing(LLAISYS_DEVICE_CPU) || header.count != expected.size() ||
+        header.fingerprint != cacheFingerprint(expected)) {
+        return false;
+    }
+    std::vector<CacheEntry> entries(expected.size());
+    if (!in.read(reinterpret_cast<char *>(entries.data()), entries.size() * sizeof(CacheEntry))) {
+        return false;
+    }
+    in.seekg(0, std::ios::end);
+    const size_t file_size = static_cast<size_t>(in.tellg());
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (std::memcmp(&entries[i], &expected[i], sizeof(CacheEntry)) != 0 ||
+            entries[i].offset + entries[i].bytes > file_size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Write the packed weights next to the checkpoint. The file is renamed into place
+// once complete, so a reader never maps half of it. Failing to write it is not an
+// error: the cache only saves the next load some time.
+void writeCache(const std::string &path, const std::vector<PackJob> &jobs, const std::vector<CacheEntry> &entries) {
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return;
+        }
+        CacheHeader header;
+        std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        header.packing = ops::linear_packing(LLAISYS_DEVICE_CPU);
+        header.count = entries.size();
+        header.fingerprint = cacheFingerprint(entries);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(CacheEntry));
+        size_t pos = sizeof(header) + entries.size() * sizeof(CacheEntry);
+        const char zeros[BLOB_ALIGN] = {};
+        for (size_t i = 0; i < entries.size(); i++) {
+            out.write(zeros, entries[i].offset - pos);
+            out.write(reinterpret_cast<const char *>((*jobs[i].dst)->data()), entries[i].bytes);
+            pos = entries[i].offset + entries[i].bytes;
+        }
+        if (!out) {
+            out.close();
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+    }
+}
+} // namespace
+
+size_t Model::prepack(const std::string &cache_path) {
+    CHECK_ARGUMENT(_device_type == LLAISYS_DEVICE_CPU, "Qwen2: linear weights can only be prepacked on CPU");
+    std::vector<PackJob> jobs = packJobs(_weights);
+    if (jobs.empty()) {
+        return 0;
+    }
+    const std::vector<CacheEntry> entries = cacheEntries(jobs);
+    size_t packed = 0;
+    // Weights packed together are dropped once packed: only the fused op reads them.
+    auto finish = [&](PackJob &job) {
+        packed += job.sources.size();
+        if (job.kind != PackKind::LINEAR) {
+            for (tensor_t *w : job.sources) {
+                *w = nullptr;
+            }
+        }
+    };
+
+    if (!cache_path.empty() && cacheMatches(cache_path, entries)) {
+        core::context().setDevice(LLAISYS_DEVICE_CPU, 0);
+        core::storage_t file = core::context().runtime().mapFile(cache_path, 0, 0);
+        for (size_t i = 0; i < jobs.size(); i++) {
+            *jobs[i].dst = Tensor::createPacked({jobs[i].rows(), jobs[i].cols()}, jobs[i].dtype(), jobs[i].packing(),
+                                                entries[i].bytes, file, entries[i].offset);
+            finish(jobs[i]);
+        }
+    } else {
+        // The prepack ops spread each weight over the pool.
+        for (PackJob &job : jobs) {
+            *job.dst = job.pack();
+        }
+        if (!cache_path.empty()) {
+            writeCache(cache_path, jobs, entries);
+        }
+        for (PackJob &job : jobs) {
+            finish(job);
+        }
+    }
+
+    // The constructor planned GATE and UP for the unfused MLP, which linear_swiglu skips.
+    reserve(_max_tokens, _max_seqs, _paged);
+    return packed;
+}
+} // namespace llaisys::models::qwen2
@@ -0,0 +1,148 @@
+#include "scheduler.hpp"
+
+#include "../../utils.hpp"
+
+#include <algorithm>
+
+namespace llaisys::models::qwen2 {
+Scheduler::Scheduler(Model &model, size_t max_batch, size_t num_blocks, size_t block_size, size_t prefill_chunk)
+    : _model(model),
+      _cache(model.meta().nlayer, num_blocks, block_size, model.meta().nkvh, model.meta().dh, model.meta().dtype,
+             model.deviceType(), model.deviceId()),
+      _max_batch(max_batch), _prefill_chunk(prefill_chunk) {
+    const auto &meta = model.meta();
+    CHECK_ARGUMENT(max_batch > 0 && max_batch <= meta.maxseq, "Scheduler: max_batch must be within [1, maxseq]");
+    CHECK_ARGUMENT(prefill_chunk > 0, "Scheduler: prefill_chunk must be positive");
+    CHECK_ARGUMENT(num_blocks * block_size >= meta.maxseq, "Scheduler: the KV cache must hold a maxseq sequence");
+    _reserve();
+}
+
+void Scheduler::_reserve() {
+    // Capped at maxseq by the model, which still leaves room for every decode.
+    const size_t max_tokens = _max_batch + _prefill_chunk;
+    if (_model.maxTokens() < std::min(max_tokens, _model.meta().maxseq) || _model.maxSeqs() < _max_batch ||
+        !_model.paged()) {
+        _model.reserve(std::max(_model.maxTokens(), max_tokens), _max_batch, true);
+    }
+}
+
+uint64_t Scheduler::submit(const int64_t *prompt, size_t nprompt, const LlaisysSamplingParams &sampling,
+                           size_t max_new_tokens) {
+    const auto &meta = _model.meta();
+    CHECK_ARGUMENT(nprompt > 0 && nprompt <= meta.maxseq, "Scheduler: prompt length must be within [1, maxseq]");
+    CHECK_ARGUMENT(max_new_tokens > 0, "Scheduler: max_new_tokens must be positive");
+    CHECK_ARGUMENT(sampling.repetition_penalty > 0.0f, "Scheduler: repetition_penalty must be positive");
+
+    auto request = std::make_unique<Request>();
+    request->id = _next_id++;
+    request->tokens.assign(prompt, prompt + nprompt);
+    request->sampling = sampling;
+    request->max_new_tokens = max_new_tokens;
+    request->history = Tensor::create({meta.maxseq}, LLAISYS_DTYPE_I64, _model.deviceType(), _model.deviceId());
+    _waiting.push_back(std::move(request));
+    return _waiting.back()->id;
+}
+
+size_t Scheduler::pending() const {
+    return _waiting.size() + _running.size();
+}
+
+size_t Scheduler::_pending(const Request &request) const {
+    return request.tokens.size() - _cache.length(request.seq);
+}
+
+bool Scheduler::_admit(Request &request) {
+    // Leave every running request a spare block to grow into, so that admitting one does
+    // not force a preemption at the next step.
+    const size_t blocks = (request.tokens.size() + _cache.blockSize() - 1) / _cache.blockSize();
+    if (!_running.empty() && blocks + _running.size() > _cache.freeBlocks()) {
+        return false;
+    }
+    request.seq = _cache.addSequence();
+    if (!_cache.reserve(request.seq, request.tokens.size())) {
+        _cache.removeSequence(request.seq);
+        return false;
+    }
+    return true;
+}
+
+void Scheduler::_preemptLast() {
+    std::unique_ptr<Request> request = std::move(_running.back());
+    _running.pop_back();
+    _cache.removeSequence(request->seq);
+    _waiting.push_front(std::move(request));
+}
+
+bool Scheduler::_emit(Request &request, int64_t token, llaisysRequestTokenCallback_t callback, void *user_data) {
+    request.tokens.push_back(token);
+    request.emitted++;
+    // Every token but the newest is in the cache, which is full at maxseq.
+    const bool last = token == _model.meta().end_token || request.emitted == request.max_new_tokens
+                   || request.tokens.size() > _model.meta().maxseq;
+    const bool stop = callback != nullptr && callback(request.id, token, last ? 1 : 0, user_data) != 0;
+    return last || stop;
+}
+
+size_t Scheduler::step(llaisysRequestTokenCallback_t callback, void *user_data) {
+    // The model may have been reserved for smaller steps since.
+    _reserve();
+
+    // Every running request needs blocks for the tokens it still has to run; one that
+    // cannot get them preempts the youngest request, possibly itself.
+    for (size_t i = 0; i < _running.size();) {
+        if (_cache.reserve(_running[i]->seq, _pending(*_running[i]))) {
+            i++;
+        } else {
+            _preemptLast();
+        }
+    }
+
+    // One row for every decode, then prompt tokens up to the chunk in admission order,
+    // admitting queued requests while it has room. A request whose last pending token
+    // makes it into the step predicts its next token.
+    const size_t ndecode = std::count_if(_running.begin(), _running.end(),
+                                         [&](const std::unique_ptr<Request> &r) { return _pending(*r) == 1; });
+    size_t budget = std::min(_prefill_chunk, _model.maxTokens() - ndecode);
+    _next_tokens.resize(_max_batch);
+    _batch.clear();
+    // Admitted requests count against the chunk even with a single token to run.
+    auto schedule = [&](size_t i, bool admitted) {
+        Request &request = *_running[i];
+        const size_t pending = _pending(request);
+        const size_t n = pending == 1 && !admitted ? 1 : std::min(pending, budget);
+        if (pending > 1 || admitted) {
+            budget -= n;
+        }
+        if (n > 0) {
+            _batch.push_back(Model::BatchEntry{request.seq, request.tokens.data() + _cache.length(request.seq), n,
+                                               &request.sampling, request.history,
+                                               n == pending ? &_next_tokens[i] : nullptr});
+        }
+    };
+    for (size_t i = 0; i < _running.size(); i++) {
+        schedule(i, false);
+    }
+    while (budget > 0 && !_waiting.empty() && _running.size() < _max_batch && _admit(*_waiting.front())) {
+        _running.push_back(std::move(_waiting.front()));
+        _waiting.pop_front();
+        schedule(_running.size() - 1, true);
+    }
+    if (_batch.empty()) {
+        return pending();
+    }
+    _model.inferBatch(_cache, _batch);
+
+    for (const Model::BatchEntry &entry : _batch) {
+        if (entry.next_token == nullptr) {
+            continue;
+        }
+        std::unique_ptr<Request> &request = _running[entry.next_token - _next_tokens.data()];
+        if (_emit(*request, *entry.next_token, callback, user_data)) {
+            _cache.removeSequence(request->seq);
+            request.reset();
+        }
+    }
+    _running.erase(std::remove(_running.begin(), _running.end(), nullptr), _running.end());
+    return pending();
+}
+} // namespace llaisys::models::qwen2
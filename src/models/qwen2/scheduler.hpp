@@ -0,0 +1,83 @@
+#pragma once
+#include "model.hpp"
+
+#include "../kv_cache/paged_kv_cache.hpp"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace llaisys::models::qwen2 {
+// Continuous batching of many generations over one Model.
+//
+// Requests queue up with submit() and make progress in step()s. A step is a single
+// Model::inferBatch pass that decodes one token for every running request past its
+// prompt and runs up to `prefill_chunk` prompt tokens besides: the next chunk of the
+// prompts being prefilled, in admission order, admitting queued requests while the chunk,
+// the batch and the paged KV cache have room. A long prompt is thus spread over several
+// steps instead of stalling every decode behind it. Each new token goes to the callback,
+// and requests that finished retire at once, freeing their slots and blocks. Throughput
+// follows the batch size: the weights are streamed once per step, not once per request.
+//
+// Blocks are taken as sequences grow. When the pool runs dry the most recently admitted
+// request is preempted: its blocks are freed and it goes back to the front of the queue,
+// to prefill its prompt and emitted tokens again when readmitted. A token's seed only
+// depends on its position, so neither preemption nor the company a request keeps changes
+// what it draws; only the rounding of wider batches differs from Model::generate, which
+// can tip a sampled token.
+class Scheduler {
+private:
+    struct Request {
+        uint64_t id;
+        std::vector<int64_t> tokens; // the prompt, then every emitted token
+        LlaisysSamplingParams sampling;
+        size_t max_new_tokens;
+        size_t emitted = 0;
+        // Its sequence in the KV cache while running; the tokens not in it yet are run by
+        // the coming steps.
+        size_t seq = 0;
+        tensor_t history; // I64 [maxseq] for the sampling penalties, kept across preemptions
+    };
+
+    Model &_model;
+    PagedKVCache _cache;
+    size_t _max_batch;
+    size_t _prefill_chunk;
+    uint64_t _next_id = 0;
+    std::deque<std::unique_ptr<Request>> _waiting;
+    std::vector<std::unique_ptr<Request>> _running; // in admission order
+    std::vector<Model::BatchEntry> _batch;
+    std::vector<int64_t> _next_tokens;
+
+    // Make sure the model's activations fit a step of the whole batch.
+    void _reserve();
+    // Start `request` in the KV cache with blocks for its tokens; false if there are none.
+    bool _admit(Request &request);
+    void _preemptLast();
+    // Tokens of `request` still to run, the last of which predicts its next token.
+    size_t _pending(const Request &request) const;
+    // Record and report a new token of `request`; true when the request is done.
+    bool _emit(Request &request, int64_t token, llaisysRequestTokenCallback_t callback, void *user_data);
+
+public:
+    // Sequences share `num_blocks` blocks of `block_size` positions, which must hold at
+    // least one maxseq sequence. Reserves the model's activations for steps of `max_batch`
+    // decodes and `prefill_chunk` prompt tokens.
+    Scheduler(Model &model, size_t max_batch, size_t num_blocks, size_t block_size, size_t prefill_chunk);
+    ~Scheduler() = default;
+
+    // Prevent copy
+    Scheduler(const Scheduler &) = delete;
+    Scheduler &operator=(const Scheduler &) = delete;
+
+    // Queue a generation of up to `max_new_tokens` tokens after `prompt` and return its id.
+    uint64_t submit(const int64_t *prompt, size_t nprompt, const LlaisysSamplingParams &sampling,
+                    size_t max_new_tokens);
+
+    // Run one iteration, handing every new token to `callback` (may be null), and return
+    // how many requests are still queued or running.
+    size_t step(llaisysRequestTokenCallback_t callback, void *user_data);
+
+    size_t pending() const;
+};
+} // namespace llaisys::models::qwen2
@@ -0,0 +1,330 @@
+#include "safetensors.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+
+namespace llaisys::models {
+namespace {
+llaisysDataType_t parseDtype(const std::string &name) {
+    static const std::map<std::string, llaisysDataType_t> dtypes = {
+        {"BOOL", LLAISYS_DTYPE_BOOL}, {"U8", LLAISYS_DTYPE_U8}, {"I8", LLAISYS_DTYPE_I8},
+        {"I16", LLAISYS_DTYPE_I16}, {"U16", LLAISYS_DTYPE_U16}, {"I32", LLAISYS_DTYPE_I32},
+        {"U32", LLAISYS_DTYPE_U32}, {"I64", LLAISYS_DTYPE_I64}, {"U64", LLAISYS_DTYPE_U64},
+        {"F16", LLAISYS_DTYPE_F16}, {"BF16", LLAISYS_DTYPE_BF16}, {"F32", LLAISYS_DTYPE_F32},
+        {"F64", LLAISYS_DTYPE_F64},
+    };
+    auto it = dtypes.find(name);
+    return it == dtypes.end() ? LLAISYS_DTYPE_INVALID : it->second;
+}
+
+// Just enough JSON for a safetensors header: an object of tensor entries plus an
+// optional "__metadata__" object, which is skipped.
+class HeaderParser {
+private:
+    const char *_p;
+    const char *_end;
+
+    void _fail() const {
+        CHECK_ARGUMENT(false, "safetensors: malformed header");
+    }
+
+    void _skipSpace() {
+        while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r')) {
+            _p++;
+        }
+    }
+
+    bool _consume(char c) {
+        _skipSpace();
+        if (_p < _end && *_p == c) {
+            _p++;
+            return true;
+        }
+        return false;
+    }
+
+    void _expect(char c) {
+        if (!_consume(c)) {
+            _fail();
+        }
+    }
+
+    std::string _string() {
+        _expect('"');
+        std::string s;
+        while (_p < _end && *_p != '"') {
+            char c = *_p++;
+            if (c != '\\') {
+                s.push_back(c);
+                continue;
+            }
+            if (_p >= _end) {
+                _fail();
+            }
+            c = *_p++;
+            switch (c) {
+            case 'b':
+                s.push_back('\b');
+                break;
+            case 'f':
+                s.push_back('\f');
+                break;
+            case 'n':
+                s.push_back('\n');
+                break;
+            case 'r':
+                s.push_back('\r');
+                break;
+            case 't':
+                s.push_back('\t');
+                break;
+            case 'u': {
+                if (_end - _p < 4) {
+                    _fail();
+                }
+                unsigned code = 0;
+                for (int i = 0; i < 4; i++) {
+                    const int h = static_cast<unsigned char>(*_p++);
+                    if (!std::isxdigit(h)) {
+                        _fail();
+                    }
+                    code = code * 16 + static_cast<unsigned>(std::isdigit(h) ? h - '0' : std::tolower(h) - 'a' + 10);
+                }
+                // UTF-8 encode; names are ASCII in practice.
+                if (code < 0x80) {
+                    s.push_back(static_cast<char>(code));
+                } else if (code < 0x800) {
+                    s.push_back(static_cast<char>(0xc0 | (code >> 6)));
+                    s.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+                } else {
+                    s.push_back(static_cast<char>(0xe0 | (code >> 12)));
+                    s.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+                    s.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+                }
+                break;
+            }
+            default: // '"', '\\' and '/'
+                s.push_back(c);
+            }
+        }
+        _expect('"');
+        return s;
+    }
+
+    size_t _unsigned() {
+        _skipSpace();
+        if (_p >= _end || *_p < '0' || *_p > '9') {
+            _fail();
+        }
+        size_t value = 0;
+        while (_p < _end && *_p >= '0' && *_p <= '9') {
+            const size_t d = static_cast<size_t>(*_p++ - '0');
+            if (value > (SIZE_MAX - d) / 10) {
+                _fail();
+            }
+            value = value * 10 + d;
+        }
+        return value;
+    }
+
+    std::vector<size_t> _unsignedArray() {
+        std::vector<size_t> values;
+        _expect('[');
+        if (_consume(']')) {
+            return values;
+        }
+        do {
+            values.push_back(_unsigned());
+        } while (_consume(','));
+        _expect(']');
+        return values;
+    }
+
+    void _skipValue() {
+        _skipSpace();
+        if (_p >= _end) {
+            _fail();
+        }
+        if (*_p == '"') {
+            _string();
+        } else if (_consume('{')) {
+            if (!_consume('}')) {
+                do {
+                    _string();
+                    _expect(':');
+                    _skipValue();
+                } while (_consume(','));
+                _expect('}');
+            }
+        } else if (_consume('[')) {
+            if (!_consume(']')) {
+                do {
+                    _skipValue();
+                } while (_consume(','));
+                _expect(']');
+            }
+        } else {
+            // Number or literal
+            while (_p < _end && *_p != ',' && *_p != '}' && *_p != ']' && *_p != ' ' && *_p != '\n') {
+                _p++;
+            }
+        }
+    }
+
+public:
+    HeaderParser(const char *begin, size_t size) : _p(begin), _end(begin + size) {}
+
+    // Entries with offsets relative to the data section.
+    std::map<std::string, SafetensorsFile::Entry> parse() {
+        std::map<std::string, SafetensorsFile::Entry> entries;
+        _expect('{');
+        if (_consume('}')) {
+            return entries;
+        }
+        do {
+            std::string name = _string();
+            _expect(':');
+            if (name == "__metadata__") {
+                _skipValue();
+                continue;
+            }
+            SafetensorsFile::Entry entry{LLAISYS_DTYPE_INVALID, {}, 0, 0};
+            std::vector<size_t> offsets;
+            bool has_dtype = false;
+            bool has_shape = false;
+            _expect('{');
+            if (!_consume('}')) {
+                do {
+                    std::string key = _string();
+                    _expect(':');
+                    if (key == "dtype") {
+                        entry.dtype = parseDtype(_string());
+                        has_dtype = true;
+                    } else if (key == "shape") {
+                        entry.shape = _unsignedArray();
+                        has_shape = true;
+                    } else if (key == "data_offsets") {
+                        offsets = _unsignedArray();
+                    } else {
+                        _skipValue();
+                    }
+                } while (_consume(','));
+                _expect('}');
+            }
+            if (!has_dtype || !has_shape || offsets.size() != 2 || offsets[0] > offsets[1]) {
+                _fail();
+            }
+            entry.offset = offsets[0];
+            entry.bytes = offsets[1] - offsets[0];
+            entries[name] = std::move(entry);
+        } while (_consume(','));
+        _expect('}');
+        return entries;
+    }
+};
+} // namespace
+
+SafetensorsFile::SafetensorsFile(const std::string &path) : _path(path) {
+    core::context().setDevice(LLAISYS_DEVICE_CPU, 0);
+    _storage = core::context().runtime().mapFile(path, 0, 0);
+    const std::byte *base = _storage->memory();
+    const size_t size = _storage->size();
+    CHECK_ARGUMENT(size >= 8, "safetensors: file too short");
+
+    uint64_t header_size = 0;
+    for (size_t i = 0; i < 8; i++) {
+        header_size |= static_cast<uint64_t>(base[i]) << (8 * i);
+    }
+    CHECK_ARGUMENT(header_size <= size - 8, "safetensors: header exceeds the file");
+    const size_t data_start = 8 + static_cast<size_t>(header_size);
+
+    _entries = HeaderParser(reinterpret_cast<const char *>(base + 8), header_size).parse();
+    for (auto &[name, entry] : _entries) {
+        CHECK_ARGUMENT(entry.offset + entry.bytes <= size - data_start, "safetensors: tensor data exceeds the file");
+        entry.offset += data_start;
+        if (entry.dtype != LLAISYS_DTYPE_INVALID) {
+            size_t bytes = 0;
+            CHECK_ARGUMENT(utils::tensorBytes(entry.shape, entry.dtype, bytes) && bytes == entry.bytes,
+                           "safetensors: tensor size does not match its shape");
+        }
+    }
+}
+
+const std::string &SafetensorsFile::path() const {
+    return _path;
+}
+
+const std::map<std::string, SafetensorsFile::Entry> &SafetensorsFile::entries() const {
+    return _entries;
+}
+
+const SafetensorsFile::Entry &SafetensorsFile::entry(const std::string &name) const {
+    auto it = _entries.find(name);
+    CHECK_ARGUMENT(it != _entries.end(), "safetensors: no such tensor");
+    return it->second;
+}
+
+const std::byte *SafetensorsFile::data(const Entry &entry) const {
+    return _storage->memory() + entry.offset;
+}
+
+tensor_t SafetensorsFile::tensor(const std::string &name) const {
+    const Entry &e = entry(name);
+    CHECK_ARGUMENT(e.dtype != LLAISYS_DTYPE_INVALID, "safetensors: unsupported tensor dtype");
+    return Tensor::create(e.shape, e.dtype, _storage, e.offset);
+}
+
+tensor_t SafetensorsFile::tensor(const std::string &name, const std::vector<size_t> &shape,
+                                 llaisysDataType_t dtype) const {
+    const Entry &e = entry(name);
+    size_t bytes = 0;
+    CHECK_ARGUMENT(utils::tensorBytes(shape, dtype, bytes) && bytes == e.bytes,
+                   "safetensors: tensor size does not match its shape");
+    return Tensor::create(shape, dtype, _storage, e.offset);
+}
+
+namespace {
+template <typename To, typename From>
+void convertTyped(To *dst, const From *src, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = utils::cast<To>(utils::cast<float>(src[i]));
+    }
+}
+
+template <typename To>
+void convertFrom(To *dst, const std::byte *src, llaisysDataType_t src_dtype, size_t n) {
+    switch (src_dtype) {
+    case LLAISYS_DTYPE_F32:
+        return convertTyped(dst, reinterpret_cast<const float *>(src), n);
+    case LLAISYS_DTYPE_F16:
+        return convertTyped(dst, reinterpret_cast<const fp16_t *>(src), n);
+    case LLAISYS_DTYPE_BF16:
+        return convertTyped(dst, reinterpret_cast<const bf16_t *>(src), n);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(src_dtype);
+    }
+}
+} // namespace
+
+void convert(std::byte *dst, llaisysDataType_t dst_dtype, const std::byte *src, llaisysDataType_t src_dtype,
+             size_t n) {
+    if (dst_dtype == src_dtype) {
+        std::memcpy(dst, src, n * utils::dsize(dst_dtype));
+        return;
+    }
+    switch (dst_dtype) {
+    case LLAISYS_DTYPE_F32:
+        return convertFrom(reinterpret_cast<float *>(dst), src, src_dtype, n);
+    case LLAISYS_DTYPE_F16:
+        return convertFrom(reinterpret_cast<fp16_t *>(dst), src, src_dtype, n);
+    case LLAISYS_DTYPE_BF16:
+        return convertFrom(reinterpret_cast<bf16_t *>(dst), src, src_dtype, n);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(dst_dtype);
+    }
+}
+} // namespace llaisys::models
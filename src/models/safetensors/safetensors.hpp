@@ -0,0 +1,46 @@
+#pragma once
+#include "../../tensor/tensor.hpp"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace llaisys::models {
+// A .safetensors checkpoint, mapped read-only as a whole.
+//
+// The file is an 8-byte little-endian header length, a JSON header naming every
+// tensor's dtype, shape and byte range, and then the tensor data. tensor() views
+// the data in place, so a weight whose dtype already matches costs no copy and no
+// memory beyond the page cache; convert() handles the other dtypes.
+class SafetensorsFile {
+public:
+    struct Entry {
+        llaisysDataType_t dtype; // LLAISYS_DTYPE_INVALID for dtypes llaisys lacks
+        std::vector<size_t> shape;
+        size_t offset; // from the start of the file
+        size_t bytes;
+    };
+
+private:
+    std::string _path;
+    core::storage_t _storage;
+    std::map<std::string, Entry> _entries;
+
+public:
+    explicit SafetensorsFile(const std::string &path);
+
+    const std::string &path() const;
+    const std::map<std::string, Entry> &entries() const;
+    const Entry &entry(const std::string &name) const;
+    const std::byte *data(const Entry &entry) const;
+
+    // Read-only CPU tensor over the data of `name`.
+    tensor_t tensor(const std::string &name) const;
+    // The same, with the bytes taken as `dtype` and `shape`, e.g. U8 data as packed Q4.
+    tensor_t tensor(const std::string &name, const std::vector<size_t> &shape, llaisysDataType_t dtype) const;
+};
+
+// Convert `n` elements between floating-point types (F32, F16, BF16); equal types copy.
+void convert(std::byte *dst, llaisysDataType_t dst_dtype, const std::byte *src, llaisysDataType_t src_dtype,
+             size_t n);
+} // namespace llaisys::models
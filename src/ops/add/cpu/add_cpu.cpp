@@ -1,33 +1,32 @@
 #include "add_cpu.hpp"
 
+#define LLAISYS_CPU_ISA generic
+#include "add_kernel.hpp"
+
+#include "../../../core/llaisys_core.hpp"
 #include "../../../utils.hpp"
 
-#include <cmath>
 #include <cstddef>
-#include <type_traits>
-
-template <typename T>
-void add_(T *c, const T *a, const T *b, size_t numel) {
-    for (size_t i = 0; i < numel; i++) {
-        if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-            c[i] = llaisys::utils::cast<T>(llaisys::utils::cast<float>(a[i]) + llaisys::utils::cast<float>(b[i]));
-        } else {
-            c[i] = a[i] + b[i];
-        }
-    }
-}
 
 namespace llaisys::ops::cpu {
+namespace {
+const auto add_impl = LLAISYS_CPU_SELECT(add);
+
+// Elements per task: large enough to amortize scheduling, small enough to balance.
+constexpr size_t GRAIN = 16384;
+} // namespace
+
 void add(std::byte *c, const std::byte *a, const std::byte *b, llaisysDataType_t type, size_t numel) {
     switch (type) {
     case LLAISYS_DTYPE_F32:
-        return add_(reinterpret_cast<float *>(c), reinterpret_cast<const float *>(a), reinterpret_cast<const float *>(b), numel);
     case LLAISYS_DTYPE_BF16:
-        return add_(reinterpret_cast<llaisys::bf16_t *>(c), reinterpret_cast<const llaisys::bf16_t *>(a),
-                    reinterpret_cast<const llaisys::bf16_t *>(b), numel);
     case LLAISYS_DTYPE_F16:
-        return add_(reinterpret_cast<llaisys::fp16_t *>(c), reinterpret_cast<const llaisys::fp16_t *>(a),
-                    reinterpret_cast<const llaisys::fp16_t *>(b), numel);
+    {
+        const size_t es = utils::dsize(type);
+        return core::parallel_for(0, numel, GRAIN, [&](size_t begin, size_t end) {
+            add_impl(c + begin * es, a + begin * es, b + begin * es, type, end - begin);
+        });
+    }
     default:
         EXCEPTION_UNSUPPORTED_DATATYPE(type);
     }
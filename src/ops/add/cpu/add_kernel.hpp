@@ -0,0 +1,40 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../../device/cpu/cpu_isa.hpp"
+
+#include <cstddef>
+
+namespace llaisys::ops::cpu {
+// c = a + b over `numel` contiguous elements of a floating-point `type`.
+LLAISYS_CPU_DECLARE_VARIANTS(void add(std::byte *c, const std::byte *a, const std::byte *b,
+                                      llaisysDataType_t type, size_t numel))
+} // namespace llaisys::ops::cpu
+
+#ifdef LLAISYS_CPU_ISA
+#include "../../../device/cpu/simd.hpp"
+
+namespace {
+using namespace llaisys::device::cpu::simd;
+
+template <typename T>
+void add_(T *c, const T *a, const T *b, size_t numel) {
+    size_t i = 0;
+    for (; i + W <= numel; i += W) {
+        vstore(c + i, vadd(vload(a + i), vload(b + i)));
+    }
+    for (; i < numel; i++) {
+        c[i] = from_float<T>(to_float(a[i]) + to_float(b[i]));
+    }
+}
+} // namespace
+
+namespace llaisys::ops::cpu::LLAISYS_CPU_ISA {
+void add(std::byte *c, const std::byte *a, const std::byte *b, llaisysDataType_t type, size_t numel) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        add_(reinterpret_cast<T *>(c), reinterpret_cast<const T *>(a), reinterpret_cast<const T *>(b), numel);
+    });
+}
+} // namespace llaisys::ops::cpu::LLAISYS_CPU_ISA
+#endif // LLAISYS_CPU_ISA
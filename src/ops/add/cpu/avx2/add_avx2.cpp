@@ -0,0 +1,2 @@
+#define LLAISYS_CPU_ISA avx2
+#include "../add_kernel.hpp"
@@ -0,0 +1,2 @@
+#define LLAISYS_CPU_ISA avx512
+#include "../add_kernel.hpp"
@@ -0,0 +1,39 @@
+#include "add_rms_norm_cpu.hpp"
+
+#define LLAISYS_CPU_ISA generic
+#include "add_rms_norm_kernel.hpp"
+
+#include "../../../core/llaisys_core.hpp"
+#include "../../../utils.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace llaisys::ops::cpu {
+namespace {
+const auto add_rms_norm_impl = LLAISYS_CPU_SELECT(add_rms_norm);
+
+// Elements per task: large enough to amortize scheduling, small enough to balance.
+constexpr size_t GRAIN = 16384;
+} // namespace
+
+void add_rms_norm(std::byte *out, std::byte *residual, const std::byte *in, const std::byte *weight,
+                  llaisysDataType_t type, size_t batch_size, size_t hidden_size, float eps) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+    case LLAISYS_DTYPE_BF16:
+    case LLAISYS_DTYPE_F16:
+    {
+        const size_t es = utils::dsize(type);
+        const size_t row_bytes = hidden_size * es;
+        const size_t rows_per_task = std::max<size_t>(1, GRAIN / std::max<size_t>(hidden_size, 1));
+        return core::parallel_for(0, batch_size, rows_per_task, [&](size_t begin, size_t end) {
+            add_rms_norm_impl(out + begin * row_bytes, residual + begin * row_bytes, in + begin * row_bytes,
+                              weight, type, end - begin, hidden_size, eps);
+        });
+    }
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+} // namespace llaisys::ops::cpu
@@ -0,0 +1,70 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../../device/cpu/cpu_isa.hpp"
+
+#include <cstddef>
+
+namespace llaisys::ops::cpu {
+// For every row b: residual[b, :] += in[b, :], then
+// out[b, :] = residual[b, :] / sqrt(mean(residual[b, :]^2) + eps) * weight.
+LLAISYS_CPU_DECLARE_VARIANTS(void add_rms_norm(std::byte *out, std::byte *residual, const std::byte *in,
+                                               const std::byte *weight, llaisysDataType_t type,
+                                               size_t batch_size, size_t hidden_size, float eps))
+} // namespace llaisys::ops::cpu
+
+#ifdef LLAISYS_CPU_ISA
+#include "../../../device/cpu/simd.hpp"
+
+namespace {
+using namespace llaisys::device::cpu::simd;
+
+// The sum is written back first and the squares are taken of the stored value, so a
+// narrow residual is normalized exactly as add followed by rms_norm would see it. The
+// second sweep reads the row back from L1 instead of memory.
+template <typename T>
+void add_rms_norm_(T *out, T *residual, const T *in, const T *weight, size_t batch_size, size_t hidden_size,
+                   float eps) {
+    for (size_t b = 0; b < batch_size; b++) {
+        T *r = residual + b * hidden_size;
+        const T *x = in + b * hidden_size;
+        T *y = out + b * hidden_size;
+
+        vfloat acc = vzero();
+        size_t i = 0;
+        for (; i + W <= hidden_size; i += W) {
+            vstore(r + i, vadd(vload(r + i), vload(x + i)));
+            vfloat s = vload(r + i);
+            acc = vfmadd(s, s, acc);
+        }
+        float sum_squares = vsum(acc);
+        for (; i < hidden_size; i++) {
+            r[i] = from_float<T>(to_float(r[i]) + to_float(x[i]));
+            float s = to_float(r[i]);
+            sum_squares += s * s;
+        }
+        float scale = 1.0f / sqrtf(sum_squares / hidden_size + eps);
+
+        const vfloat vscale = vset1(scale);
+        i = 0;
+        for (; i + W <= hidden_size; i += W) {
+            vstore(y + i, vmul(vmul(vload(r + i), vscale), vload(weight + i)));
+        }
+        for (; i < hidden_size; i++) {
+            y[i] = from_float<T>(to_float(r[i]) * scale * to_float(weight[i]));
+        }
+    }
+}
+} // namespace
+
+namespace llaisys::ops::cpu::LLAISYS_CPU_ISA {
+void add_rms_norm(std::byte *out, std::byte *residual, const std::byte *in, const std::byte *weight,
+                  llaisysDataType_t type, size_t batch_size, size_t hidden_size, float eps) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        add_rms_norm_(reinterpret_cast<T *>(out), reinterpret_cast<T *>(residual), reinterpret_cast<const T *>(in),
+                      reinterpret_cast<const T *>(weight), batch_size, hidden_size, eps);
+    });
+}
+} // namespace llaisys::ops::cpu::LLAISYS_CPU_ISA
+#endif // LLAISYS_CPU_ISA
@@ -0,0 +1,49 @@
+#include "op.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+#include "cpu/add_rms_norm_cpu.hpp"
+
+namespace llaisys::ops {
+void add_rms_norm(tensor_t out, tensor_t residual, tensor_t in, tensor_t weight, float eps) {
+    CHECK_SAME_DEVICE(out, residual, in, weight);
+
+    ASSERT(out->isContiguous() && residual->isContiguous() && in->isContiguous() && weight->isContiguous(),
+           "Add RMS Norm: all tensors must be contiguous.");
+
+    CHECK_SAME_DTYPE(out->dtype(), residual->dtype(), in->dtype(), weight->dtype());
+
+    ASSERT(out->shape().size() == 2 && weight->shape().size() == 1,
+           "Add RMS Norm: out, residual and in must be 2D, weight must be 1D.");
+
+    CHECK_SAME_SHAPE(out->shape(), residual->shape(), in->shape());
+
+    ASSERT(weight->shape()[0] == in->shape()[1],
+           "Add RMS Norm: weight size must match input hidden dimension.");
+
+    size_t batch_size = in->shape()[0];
+    size_t hidden_size = in->shape()[1];
+
+    // always support cpu calculation
+    if (out->deviceType() == LLAISYS_DEVICE_CPU) {
+        return cpu::add_rms_norm(out->data(), residual->data(), in->data(), weight->data(),
+                                 out->dtype(), batch_size, hidden_size, eps);
+    }
+
+    llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
+
+    switch (out->deviceType()) {
+    case LLAISYS_DEVICE_CPU:
+        return cpu::add_rms_norm(out->data(), residual->data(), in->data(), weight->data(),
+                                 out->dtype(), batch_size, hidden_size, eps);
+#ifdef ENABLE_NVIDIA_API
+    case LLAISYS_DEVICE_NVIDIA:
+        TO_BE_IMPLEMENTED();
+        return;
+#endif
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+} // namespace llaisys::ops
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "../../tensor/tensor.hpp"
+
+namespace llaisys::ops {
+// residual += in; out = rms_norm(residual, weight, eps), in one pass over the rows.
+// The norm sees the residual as stored, so the result matches add followed by rms_norm.
+void add_rms_norm(tensor_t out, tensor_t residual, tensor_t in, tensor_t weight, float eps);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../../device/cpu/cpu_isa.hpp"
+
+#include <cstddef>
+
+namespace llaisys::ops::cpu {
+// Index and value of the first maximum of `numel` contiguous elements.
+LLAISYS_CPU_DECLARE_VARIANTS(void argmax(int64_t *max_idx, std::byte *max_val, const std::byte *vals,
+                                         llaisysDataType_t type, size_t numel))
+} // namespace llaisys::ops::cpu
+
+#ifdef LLAISYS_CPU_ISA
+#include "../../../device/cpu/simd.hpp"
+
+namespace {
+using namespace llaisys::device::cpu::simd;
+
+// Two passes: a vector max reduction, then a scan for the first element equal to
+// it. The second pass usually stops early and keeps the lowest-index tie break.
+template <typename T>
+void argmax_(int64_t *max_idx, T *max_val, const T *vals, size_t numel) {
+    const float neg_inf = -HUGE_VALF;
+    float max_value = neg_inf;
+    size_t i = 0;
+    if (numel >= W) {
+        vfloat vmax_acc = vset1(neg_inf);
+        for (; i + W <= numel; i += W) {
+            vmax_acc = vmax(vmax_acc, vload(vals + i));
+        }
+        max_value = vmaxval(vmax_acc);
+    }
+    for (; i < numel; i++) {
+        max_value = fmax2(max_value, to_float(vals[i]));
+    }
+
+    int64_t max_index = 0;
+    for (size_t j = 0; j < numel; j++) {
+        if (to_float(vals[j]) == max_value) {
+            max_index = static_cast<int64_t>(j);
+            break;
+        }
+    }
+    *max_idx = max_index;
+    *max_val = from_float<T>(max_value);
+}
+} // namespace
+
+namespace llaisys::ops::cpu::LLAISYS_CPU_ISA {
+void argmax(int64_t *max_idx, std::byte *max_val, const std::byte *vals, llaisysDataType_t type, size_t numel) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        argmax_(max_idx, reinterpret_cast<T *>(max_val), reinterpret_cast<const T *>(vals), numel);
+    });
+}
+} // namespace llaisys::ops::cpu::LLAISYS_CPU_ISA
+#endif // LLAISYS_CPU_ISA
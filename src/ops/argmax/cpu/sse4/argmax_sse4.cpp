@@ -0,0 +1,2 @@
+#define LLAISYS_CPU_ISA sse4
+#include "../argmax_kernel.hpp"
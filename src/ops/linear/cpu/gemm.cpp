@@ -0,0 +1,383 @@
+#include "gemm.hpp"
+
+#define LLAISYS_CPU_ISA generic
+#include "gemm_kernel.hpp"
+
+#include "../../../core/llaisys_core.hpp"
+#include "../../../utils.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace {
+using llaisys::ops::cpu::GemmKernel;
+using llaisys::ops::cpu::GemmOutput;
+
+// Cache blocking. A KC x nr micro-panel of B stays in L1 while it is swept by
+// every mr x KC sliver of A, the packed MC x KC block of A stays in L2, and the
+// packed KC x NC panel of B is sized for a slice of L3. MC and NC hold whole
+// register tiles for every kernel variant.
+constexpr size_t MC = 72;
+constexpr size_t KC = llaisys::ops::cpu::GEMM_KC;
+constexpr size_t NC = llaisys::ops::cpu::GEMM_NC;
+
+const GemmKernel &kernel = llaisys::ops::cpu::active_gemm_kernel();
+
+// Per-thread scratch, grown on demand and reused across calls.
+struct Workspace {
+    std::vector<float> a_pack;
+    std::vector<float> b_pack;
+    std::vector<float> c_tile;
+};
+
+Workspace &workspace() {
+    thread_local Workspace ws;
+    if (ws.c_tile.empty()) {
+        ws.a_pack.resize(MC * KC);
+        ws.b_pack.resize(KC * NC);
+        ws.c_tile.resize(MC * NC);
+    }
+    return ws;
+}
+
+// B as the drivers see it: elements of the activation type, I8 rows with per-row F32
+// scales, Q4 rows with F16 scales and optional zero points per group, or already in
+// micro-panel order (see gemm_prepack), possibly as interleaved gate/up pairs.
+struct Weight {
+    const std::byte *data;
+    size_t ld; // in elements of `type`
+    llaisysDataType_t type;
+    const void *scales;
+    const uint8_t *zeros;
+    size_t groups;
+    bool packed;
+    bool gate_up;
+};
+
+size_t round_up(size_t n, size_t to) {
+    return (n + to - 1) / to * to;
+}
+
+// Copy B^T into micro-panels, as pack_b would, but once and in B's own dtype. `E` is
+// an unsigned integer as wide as an element: nothing is converted, only moved.
+// row(r) is row r of B as packed, or null for zero padding.
+template <typename E, typename Row>
+void prepack_(E *dst, const Row &row, size_t n, size_t k) {
+    const size_t nr = kernel.nr;
+    llaisys::core::parallel_for(0, (n + NC - 1) / NC, 1, [&](size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+            const size_t n0 = t * NC;
+            const size_t nc = std::min(NC, n - n0);
+            const size_t np = round_up(nc, nr);
+            E *block = dst + n0 * k;
+            for (size_t pc = 0; pc < k; pc += KC) {
+                const size_t kc = std::min(KC, k - pc);
+                E *slice = block + np * pc;
+                for (size_t jr = 0; jr < np; jr += nr) {
+                    E *panel = slice + jr * kc;
+                    for (size_t j = 0; j < nr; j++) {
+                        const E *src = row(n0 + jr + j);
+                        for (size_t p = 0; p < kc; p++) {
+                            panel[p * nr + j] = src != nullptr ? src[pc + p] : E(0);
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+// The row-wise concatenation of `parts` weights of n[s] rows each.
+template <typename E>
+void prepack_concat(E *dst, const std::byte *const *b, const size_t *n, size_t parts, size_t k) {
+    size_t rows = 0;
+    for (size_t s = 0; s < parts; s++) {
+        rows += n[s];
+    }
+    prepack_(
+        dst,
+        [&](size_t r) -> const E * {
+            for (size_t s = 0; s < parts; r -= n[s], s++) {
+                if (r < n[s]) {
+                    return reinterpret_cast<const E *>(b[s]) + r * k;
+                }
+            }
+            return nullptr;
+        },
+        rows, k);
+}
+
+// Gate and up micro-panels in alternation (see gemm_prepack_gate_up).
+template <typename E>
+void prepack_gate_up(E *dst, const E *gate, const E *up, size_t n, size_t k) {
+    const size_t nr = kernel.nr;
+    prepack_(
+        dst,
+        [&](size_t r) -> const E * {
+            const size_t q = r % (2 * nr);
+            const size_t src_row = r / (2 * nr) * nr + q % nr;
+            if (src_row >= n) {
+                return nullptr;
+            }
+            return (q < nr ? gate : up) + src_row * k;
+        },
+        2 * round_up(n, nr), k);
+}
+
+// C as one [m, n] matrix with row stride ldc.
+GemmOutput single(std::byte *c, size_t ldc, const std::byte *bias, size_t n) {
+    return GemmOutput{{c}, {ldc}, {bias}, {n}, 1};
+}
+
+// Compute one MC x NC tile of A * B^T. Tiles are independent, so each one is owned by
+// exactly one thread and no synchronization is needed on C. For a gate/up B the tile
+// covers nc / 2 columns of C, starting at n0 / 2, of the n it has.
+void gemm_tile(const GemmOutput &c, const std::byte *a, size_t lda, const Weight &b, llaisysDataType_t type,
+               size_t m0, size_t mc, size_t n0, size_t nc, size_t n, size_t k) {
+    const size_t es = llaisys::utils::dsize(type);
+    Workspace &ws = workspace();
+    float *a_pack = ws.a_pack.data();
+    float *b_pack = ws.b_pack.data();
+    float *c_tile = ws.c_tile.data();
+    std::fill(c_tile, c_tile + MC * NC, 0.0f);
+
+    for (size_t pc = 0; pc < k; pc += KC) {
+        size_t kc = std::min(KC, k - pc);
+        const float *b_panel = b_pack;
+        if (b.packed) {
+            // F32 panels are read in place; narrower ones only need widening, not reordering.
+            const size_t np = round_up(nc, kernel.nr);
+            const std::byte *panel = b.data + (n0 * k + np * pc) * es;
+            if (type == LLAISYS_DTYPE_F32) {
+                b_panel = reinterpret_cast<const float *>(panel);
+            } else {
+                kernel.widen(b_pack, panel, type, np * kc);
+            }
+        } else if (b.type == LLAISYS_DTYPE_Q4) {
+            kernel.pack_b_q4(b_pack, reinterpret_cast<const uint8_t *>(b.data + n0 * b.ld), b.ld,
+                             static_cast<const llaisys::fp16_t *>(b.scales) + n0 * b.groups,
+                             b.zeros == nullptr ? nullptr : b.zeros + n0 * b.groups, b.groups, k / b.groups, pc,
+                             nc, kc);
+        } else if (b.type == LLAISYS_DTYPE_I8) {
+            kernel.pack_b_q8(b_pack, reinterpret_cast<const int8_t *>(b.data + n0 * b.ld + pc), b.ld,
+                             static_cast<const float *>(b.scales) + n0, nc, kc);
+        } else {
+            kernel.pack_b(b_pack, b.data + (n0 * b.ld + pc) * es, b.ld, type, nc, kc);
+        }
+        kernel.pack_a(a_pack, a + (m0 * lda + pc) * es, lda, type, mc, kc);
+        kernel.macro_kernel(c_tile, NC, a_pack, b_panel, mc, nc, kc);
+    }
+
+    if (b.gate_up) {
+        const size_t nr = kernel.nr;
+        for (size_t jr = 0; jr < nc && (n0 + jr) / 2 < n; jr += 2 * nr) {
+            const size_t j = (n0 + jr) / 2;
+            kernel.store_swiglu(c.c[0] + (m0 * c.ldc[0] + j) * es, c.ldc[0], c_tile + jr, c_tile + jr + nr, NC,
+                                type, mc, std::min(nr, n - j));
+        }
+        return;
+    }
+    llaisys::ops::cpu::gemm_rope(c, m0, n0, c_tile, NC, NC, 0, type, mc, nc);
+    llaisys::ops::cpu::gemm_store(c, m0, n0, c_tile, NC, type, mc, nc);
+}
+
+void gemm(const GemmOutput &c, const std::byte *a, size_t lda, const Weight &b, llaisysDataType_t type, size_t m,
+          size_t n, size_t k) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+    case LLAISYS_DTYPE_BF16:
+    case LLAISYS_DTYPE_F16:
+        break;
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+
+    // Rows of B: a gate/up B holds both projections of the n columns of C.
+    const size_t nb = b.gate_up ? 2 * round_up(n, kernel.nr) : n;
+    const size_t m_tiles = (m + MC - 1) / MC;
+    const size_t n_tiles = (nb + NC - 1) / NC;
+
+    llaisys::core::parallel_for(0, m_tiles * n_tiles, 1, [&](size_t t_begin, size_t t_end) {
+        for (size_t t = t_begin; t < t_end; t++) {
+            size_t m0 = (t / n_tiles) * MC;
+            size_t n0 = (t % n_tiles) * NC;
+            gemm_tile(c, a, lda, b, type, m0, std::min(MC, m - m0), n0, std::min(NC, nb - n0), n, k);
+        }
+    });
+}
+} // namespace
+
+namespace llaisys::ops::cpu {
+const GemmKernel &active_gemm_kernel() {
+    static const GemmKernel &selected = [] () -> const GemmKernel & {
+        const GemmKernel &k = LLAISYS_CPU_SELECT(gemm_kernel)();
+        ASSERT(MC % k.mr == 0 && NC % (2 * k.nr) == 0,
+               "GEMM: cache blocks must hold whole register tiles and gate/up panel pairs");
+        return k;
+    }();
+    return selected;
+}
+
+void gemm_nt(std::byte *c, size_t ldc,
+             const std::byte *a, size_t lda,
+             const std::byte *b, size_t ldb,
+             const std::byte *bias, llaisysDataType_t type,
+             size_t m, size_t n, size_t k) {
+    gemm(single(c, ldc, bias, n), a, lda, Weight{b, ldb, type, nullptr, nullptr, 0, false, false}, type, m, n, k);
+}
+
+void gemm_nt_q8(std::byte *c, size_t ldc,
+                const std::byte *a, size_t lda,
+                const int8_t *b, size_t ldb, const float *scales,
+                const std::byte *bias, llaisysDataType_t type,
+                size_t m, size_t n, size_t k) {
+    gemm(single(c, ldc, bias, n), a, lda,
+         Weight{reinterpret_cast<const std::byte *>(b), ldb, LLAISYS_DTYPE_I8, scales, nullptr, 1, false, false},
+         type, m, n, k);
+}
+
+void gemm_nt_q4(std::byte *c, size_t ldc,
+                const std::byte *a, size_t lda,
+                const uint8_t *b, size_t ldb, const fp16_t *scales, const uint8_t *zeros, size_t groups,
+                const std::byte *bias, llaisysDataType_t type,
+                size_t m, size_t n, size_t k) {
+    gemm(single(c, ldc, bias, n), a, lda,
+         Weight{reinterpret_cast<const std::byte *>(b), ldb, LLAISYS_DTYPE_Q4, scales, zeros, groups, false, false},
+         type, m, n, k);
+}
+
+uint64_t gemm_packing() {
+    return static_cast<uint64_t>(kernel.nr) | static_cast<uint64_t>(KC) << 16 | static_cast<uint64_t>(NC) << 32;
+}
+
+size_t gemm_packed_numel(size_t n, size_t k) {
+    return round_up(n, kernel.nr) * k;
+}
+
+void gemm_prepack(std::byte *dst, const std::byte *b, llaisysDataType_t type, size_t n, size_t k) {
+    gemm_prepack_concat(dst, &b, &n, 1, type, k);
+}
+
+void gemm_prepack_concat(std::byte *dst, const std::byte *const *b, const size_t *n, size_t parts,
+                         llaisysDataType_t type, size_t k) {
+    switch (utils::dsize(type)) {
+    case 4:
+        return prepack_concat(reinterpret_cast<uint32_t *>(dst), b, n, parts, k);
+    case 2:
+        return prepack_concat(reinterpret_cast<uint16_t *>(dst), b, n, parts, k);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+
+void gemm_store(const GemmOutput &c, size_t i0, size_t j0, const float *src, size_t lds, llaisysDataType_t type,
+                size_t m, size_t n) {
+    const size_t es = utils::dsize(type);
+    for (size_t s = 0, begin = 0; s < c.parts && n > 0; begin = c.end[s], s++) {
+        if (j0 >= c.end[s]) {
+            continue;
+        }
+        const size_t w = std::min(n, c.end[s] - j0);
+        const size_t j = j0 - begin;
+        // gemm_rope has already added the bias of rotated parts.
+        const bool biased = c.bias[s] != nullptr && (c.rope_table == nullptr || !c.rope[s]);
+        kernel.store(c.c[s] + (i0 * c.ldc[s] + j) * es, c.ldc[s], src, lds, biased ? c.bias[s] + j * es : nullptr,
+                     type, m, w);
+        src += w;
+        j0 += w;
+        n -= w;
+    }
+}
+
+void gemm_rope(const GemmOutput &c, size_t i0, size_t j0, float *tile, size_t ld, size_t panel, size_t panel_stride,
+               llaisysDataType_t type, size_t m, size_t n) {
+    if (c.rope_table == nullptr) {
+        return;
+    }
+    const size_t es = utils::dsize(type);
+    const size_t half = c.head_dim / 2;
+    thread_local std::vector<float> head_bias;
+    head_bias.resize(c.head_dim);
+    auto at = [&](size_t i, size_t j) { return tile + (j / panel) * panel_stride + i * ld + j % panel; };
+    for (size_t s = 0, begin = 0; s < c.parts; begin = c.end[s], s++) {
+        const size_t lo = std::max(begin, j0);
+        const size_t hi = std::min(c.end[s], j0 + n);
+        if (!c.rope[s] || lo >= hi) {
+            continue;
+        }
+        ASSERT((lo - begin) % c.head_dim == 0 && (hi - begin) % c.head_dim == 0,
+               "GEMM: RoPE heads must not straddle blocks.");
+        for (size_t h = lo - j0; h < hi - j0; h += c.head_dim) {
+            // The bias goes in before the rotation; gemm_store leaves it out for these parts.
+            if (c.bias[s] != nullptr) {
+                kernel.widen(head_bias.data(), c.bias[s] + (j0 + h - begin) * es, type, c.head_dim);
+            }
+            for (size_t i = 0; i < m; i++) {
+                const float *cos = c.rope_table + c.pos[i0 + i] * c.head_dim;
+                // A run of pairs is contiguous until either half reaches the end of its panel.
+                for (size_t d = 0; d < half;) {
+                    const size_t a = h + d;
+                    const size_t b = a + half;
+                    const size_t len = std::min({half - d, panel - a % panel, panel - b % panel});
+                    float *pa = at(i, a);
+                    float *pb = at(i, b);
+                    if (c.bias[s] != nullptr) {
+                        for (size_t t = 0; t < len; t++) {
+                            pa[t] += head_bias[d + t];
+                            pb[t] += head_bias[half + d + t];
+                        }
+                    }
+                    kernel.rotate(pa, pb, cos + d, cos + half + d, len);
+                    d += len;
+                }
+            }
+        }
+    }
+}
+
+void gemm_nt_packed(std::byte *c, size_t ldc,
+                    const std::byte *a, size_t lda,
+                    const std::byte *b,
+                    const std::byte *bias, llaisysDataType_t type,
+                    size_t m, size_t n, size_t k) {
+    gemm(single(c, ldc, bias, n), a, lda, Weight{b, k, type, nullptr, nullptr, 0, true, false}, type, m, n, k);
+}
+
+uint64_t gemm_gate_up_packing() {
+    return gemm_packing() | static_cast<uint64_t>(1) << 48;
+}
+
+size_t gemm_gate_up_numel(size_t n, size_t k) {
+    return 2 * round_up(n, kernel.nr) * k;
+}
+
+void gemm_prepack_gate_up(std::byte *dst, const std::byte *gate, const std::byte *up, llaisysDataType_t type,
+                          size_t n, size_t k) {
+    switch (utils::dsize(type)) {
+    case 4:
+        return prepack_gate_up(reinterpret_cast<uint32_t *>(dst), reinterpret_cast<const uint32_t *>(gate),
+                               reinterpret_cast<const uint32_t *>(up), n, k);
+    case 2:
+        return prepack_gate_up(reinterpret_cast<uint16_t *>(dst), reinterpret_cast<const uint16_t *>(gate),
+                               reinterpret_cast<const uint16_t *>(up), n, k);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+
+void gemm_nt_packed_split(const GemmOutput &c,
+                          const std::byte *a, size_t lda,
+                          const std::byte *b, llaisysDataType_t type,
+                          size_t m, size_t n, size_t k) {
+    gemm(c, a, lda, Weight{b, k, type, nullptr, nullptr, 0, true, false}, type, m, n, k);
+}
+
+void gemm_nt_packed_swiglu(std::byte *c, size_t ldc,
+                           const std::byte *a, size_t lda,
+                           const std::byte *b, llaisysDataType_t type,
+                           size_t m, size_t n, size_t k) {
+    gemm(single(c, ldc, nullptr, n), a, lda, Weight{b, k, type, nullptr, nullptr, 0, true, true}, type, m, n, k);
+}
+} // namespace llaisys::ops::cpu
@@ -0,0 +1,114 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../../utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace llaisys::ops::cpu {
+// Depth and width of the B panels the GEMM sweeps; they fix the prepacked layout too.
+constexpr size_t GEMM_KC = 256;
+constexpr size_t GEMM_NC = 256;
+
+// C[m, n] = sum_k A[m, k] * B[n, k] + bias[n]
+// A: [m, k] with row stride lda, B: [n, k] with row stride ldb (i.e. a linear weight),
+// C: [m, n] with row stride ldc. All operands share `type`; bias is optional.
+// Accumulation is always done in float32.
+void gemm_nt(std::byte *c, size_t ldc,
+             const std::byte *a, size_t lda,
+             const std::byte *b, size_t ldb,
+             const std::byte *bias, llaisysDataType_t type,
+             size_t m, size_t n, size_t k);
+
+// gemm_nt with an I8 B and one F32 scale per row of B (per output feature); A, C and
+// bias are `type`. B is dequantized while it is packed.
+void gemm_nt_q8(std::byte *c, size_t ldc,
+                const std::byte *a, size_t lda,
+                const int8_t *b, size_t ldb, const float *scales,
+                const std::byte *bias, llaisysDataType_t type,
+                size_t m, size_t n, size_t k);
+
+// gemm_nt with a Q4 B of k / 2 bytes per row (ldb in bytes), F16 scales and optional U8
+// zero points of `groups` per row. B is dequantized while it is packed.
+void gemm_nt_q4(std::byte *c, size_t ldc,
+                const std::byte *a, size_t lda,
+                const uint8_t *b, size_t ldb, const fp16_t *scales, const uint8_t *zeros, size_t groups,
+                const std::byte *bias, llaisysDataType_t type,
+                size_t m, size_t n, size_t k);
+
+// C split by columns across up to GEMM_MAX_PARTS matrices: columns [end[s - 1], end[s])
+// of the product land in part s, at c[s] with row stride ldc[s], plus bias[s] (optional).
+// One pass over a concatenated B then fills separate outputs, e.g. fused q/k/v projections.
+constexpr size_t GEMM_MAX_PARTS = 3;
+struct GemmOutput {
+    std::byte *c[GEMM_MAX_PARTS];
+    size_t ldc[GEMM_MAX_PARTS];
+    const std::byte *bias[GEMM_MAX_PARTS];
+    size_t end[GEMM_MAX_PARTS];
+    size_t parts;
+    // Optional RoPE epilogue: parts with rope[s] set are cut into heads of head_dim
+    // columns, and row i of each head is rotated by row pos[i] of rope_table (see
+    // ops::rope_table) before it is stored. Heads must not straddle GEMM_NC blocks.
+    bool rope[GEMM_MAX_PARTS];
+    const float *rope_table;
+    const int64_t *pos;
+    size_t head_dim;
+};
+
+// Store rows [i0, i0 + m) and columns [j0, j0 + n) of the product, given as float src
+// with row stride lds, into the parts of C they belong to.
+void gemm_store(const GemmOutput &c, size_t i0, size_t j0, const float *src, size_t lds, llaisysDataType_t type,
+                size_t m, size_t n);
+
+// Apply c's RoPE epilogue to rows [i0, i0 + m) and columns [j0, j0 + n) of the product,
+// held in float in `tile`: column j0 + j of row i0 + i is at
+//   tile[(j / panel) * panel_stride + i * ld + j % panel],
+// which covers both a row-major tile (panel >= n) and GEMV accumulators in micro-panels.
+// The biases of rotated parts are added here, before the rotation, and not by gemm_store.
+void gemm_rope(const GemmOutput &c, size_t i0, size_t j0, float *tile, size_t ld, size_t panel, size_t panel_stride,
+               llaisysDataType_t type, size_t m, size_t n);
+
+// Prepacked B. gemm_prepack lays a [n, k] B out once in the order the tiles consume it:
+// blocks of GEMM_NC rows, each split into GEMM_KC-deep slices of nr-wide micro-panels,
+//   dst[n0 * k + np * pc + jr * kc + p * nr + j] = B[n0 + jr + j, pc + p],
+// with np = nc rounded up to nr and the padding zeroed. Elements keep their dtype.
+// gemm_packing() names the layout (nr and the blocking) of the kernel picked for this host;
+// a blob packed under another value cannot be read.
+uint64_t gemm_packing();
+size_t gemm_packed_numel(size_t n, size_t k);
+void gemm_prepack(std::byte *dst, const std::byte *b, llaisysDataType_t type, size_t n, size_t k);
+// gemm_prepack of the row-wise concatenation of `parts` [n[s], k] weights b[s].
+void gemm_prepack_concat(std::byte *dst, const std::byte *const *b, const size_t *n, size_t parts,
+                         llaisysDataType_t type, size_t k);
+
+// gemm_nt with B from gemm_prepack. F32 panels feed the micro-kernel directly; F16 and
+// BF16 ones are only widened, with no per-call reordering.
+void gemm_nt_packed(std::byte *c, size_t ldc,
+                    const std::byte *a, size_t lda,
+                    const std::byte *b,
+                    const std::byte *bias, llaisysDataType_t type,
+                    size_t m, size_t n, size_t k);
+// gemm_nt_packed into a C split by columns.
+void gemm_nt_packed_split(const GemmOutput &c,
+                          const std::byte *a, size_t lda,
+                          const std::byte *b, llaisysDataType_t type,
+                          size_t m, size_t n, size_t k);
+
+// The [n, k] gate and up projections of a SwiGLU MLP packed as one B of
+// 2 * round_up(n, nr) rows whose micro-panels alternate: panel 2q holds gate rows
+// [q * nr, q * nr + nr) and panel 2q + 1 the same up rows, so a pair never straddles a
+// GEMM_NC block. The layout is otherwise gemm_prepack's, tagged gemm_gate_up_packing().
+uint64_t gemm_gate_up_packing();
+size_t gemm_gate_up_numel(size_t n, size_t k);
+void gemm_prepack_gate_up(std::byte *dst, const std::byte *gate, const std::byte *up, llaisysDataType_t type,
+                          size_t n, size_t k);
+
+// C[m, n] = silu(A * gate^T) * (A * up^T) with B from gemm_prepack_gate_up. Both
+// projections come out of the same float tile, and the activation is applied as it is
+// stored, so neither is ever written out.
+void gemm_nt_packed_swiglu(std::byte *c, size_t ldc,
+                           const std::byte *a, size_t lda,
+                           const std::byte *b, llaisysDataType_t type,
+                           size_t m, size_t n, size_t k);
+} // namespace llaisys::ops::cpu
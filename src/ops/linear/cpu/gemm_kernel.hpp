@@ -0,0 +1,541 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../../device/cpu/cpu_isa.hpp"
+#include "../../../utils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace llaisys::ops::cpu {
+// Weight rows that share one sweep over the input row in the GEMV path.
+constexpr size_t GEMV_ROWS = 4;
+
+// ISA-specific pieces of the GEMM/GEMV drivers. The drivers own blocking,
+// threading and scratch memory; a kernel only ever touches the pointers it is given.
+// Every pointer into A, B, C or bias is already offset to the block being processed.
+struct GemmKernel {
+    // Register tile of the micro-kernel: mr rows of A against nr columns of B.
+    size_t mr;
+    size_t nr;
+    // Pack an mc x kc block of A into mr-row slivers: dst[ir][p][i] = A[ir + i, p].
+    // Rows past mc are zero filled up to the next multiple of mr.
+    void (*pack_a)(float *dst, const std::byte *a, size_t lda, llaisysDataType_t type, size_t mc, size_t kc);
+    // Pack a kc x nc panel of B^T into nr-column micro-panels: dst[jr][p][j] = B[jr + j, p].
+    // Columns past nc are zero filled up to the next multiple of nr.
+    void (*pack_b)(float *dst, const std::byte *b, size_t ldb, llaisysDataType_t type, size_t nc, size_t kc);
+    // pack_b for an I8 weight with per-row scales, dequantized on the way:
+    // dst[jr][p][j] = B[jr + j, p] * scales[jr + j].
+    void (*pack_b_q8)(float *dst, const int8_t *b, size_t ldb, const float *scales, size_t nc, size_t kc);
+    // pack_b for a Q4 weight (see LLAISYS_DTYPE_Q4), dequantized on the way. b, scales and
+    // zeros point at the first row of the panel, whose columns start at k0; ldb is in bytes
+    // and `groups` is the row stride of scales and zeros. zeros is null for symmetric groups.
+    void (*pack_b_q4)(float *dst, const uint8_t *b, size_t ldb, const fp16_t *scales, const uint8_t *zeros,
+                      size_t groups, size_t group, size_t k0, size_t nc, size_t kc);
+    // C[mc, nc] += packed A * packed B, with mc and nc rounded up to whole register tiles.
+    void (*macro_kernel)(float *c, size_t ldc, const float *a_pack, const float *b_pack,
+                         size_t mc, size_t nc, size_t kc);
+    // dst[i, j] = src[i, j] + bias[j], converted to `type`. bias is optional.
+    void (*store)(std::byte *dst, size_t ldd, const float *src, size_t lds, const std::byte *bias,
+                  llaisysDataType_t type, size_t m, size_t n);
+    // dst[i, j] = silu(gate[i, j]) * up[i, j], converted to `type`; gate and up share the
+    // row stride lds. The epilogue of the fused gate/up projection.
+    void (*store_swiglu)(std::byte *dst, size_t ldd, const float *gate, const float *up, size_t lds,
+                         llaisysDataType_t type, size_t m, size_t n);
+    // Rotate n float pairs in place, as RoPE does: a' = a cos - b sin, b' = b cos + a sin.
+    void (*rotate)(float *a, float *b, const float *cos, const float *sin, size_t n);
+    // dst[i] = src[i] widened to float.
+    void (*widen)(float *dst, const std::byte *src, llaisysDataType_t type, size_t n);
+    // out[r] = dot(x, W[r]) for r < rows <= GEMV_ROWS, accumulated in float.
+    void (*dot_rows)(float *out, const float *x, const std::byte *w, size_t ldw, llaisysDataType_t type,
+                     size_t rows, size_t k);
+    // dot_rows over I8 weight rows: out[r] = scales[r] * dot(x, W[r]). The int8 values
+    // are widened in registers; the row scale is applied once to the float sum.
+    void (*dot_rows_q8)(float *out, const float *x, const int8_t *w, size_t ldw, const float *scales,
+                        size_t rows, size_t k);
+    // dot_rows over Q4 weight rows of k = groups * group columns:
+    //   out[r] = sum_g s[r, g] * (dot(x_g, q_g[r]) - z[r, g] * xsum[g])
+    // where xsum[g] is the sum of x over group g. The nibbles are unpacked in registers
+    // and each group's partial dot is scaled as a vector, so the horizontal sum runs once.
+    void (*dot_rows_q4)(float *out, const float *x, const float *xsum, const uint8_t *w, size_t ldw,
+                        const fp16_t *scales, const uint8_t *zeros, size_t groups, size_t group, size_t rows);
+    // GEMV against one kc x nr micro-panel of a prepacked B (see gemm_prepack):
+    // out[i, j] += sum_p x[i, p] * panel[p, j] for i < rows, j < nr, with rows of out nr apart.
+    // Every vector lane is its own output feature, so no horizontal sums are needed.
+    void (*dot_panel)(float *out, const float *x, size_t ldx, const std::byte *panel, llaisysDataType_t type,
+                      size_t rows, size_t kc);
+};
+
+LLAISYS_CPU_DECLARE_VARIANTS(const GemmKernel &gemm_kernel())
+
+// The best variant for the host CPU, resolved once when the library is loaded.
+const GemmKernel &active_gemm_kernel();
+} // namespace llaisys::ops::cpu
+
+#ifdef LLAISYS_CPU_ISA
+#include "../../../device/cpu/simd.hpp"
+
+namespace {
+using namespace llaisys::device::cpu::simd;
+
+#if defined(__AVX512F__)
+constexpr size_t MR = 12;
+constexpr size_t NV = 2;
+#elif defined(__AVX2__)
+constexpr size_t MR = 6;
+constexpr size_t NV = 2;
+#elif defined(__SSE4_1__)
+constexpr size_t MR = 4;
+constexpr size_t NV = 2;
+#else
+constexpr size_t MR = 4;
+constexpr size_t NV = 4;
+#endif
+// MR x NV vector accumulators plus one broadcast of A and NV loads of B fill,
+// without spilling, the register file of each tier.
+constexpr size_t NR = NV * W;
+
+template <typename T>
+void pack_a_(float *dst, const T *a, size_t lda, size_t mc, size_t kc) {
+    for (size_t ir = 0; ir < mc; ir += MR) {
+        size_t mr = smin(MR, mc - ir);
+        for (size_t i = 0; i < MR; i++) {
+            if (i < mr) {
+                const T *src = a + (ir + i) * lda;
+                for (size_t p = 0; p < kc; p++) {
+                    dst[p * MR + i] = to_float(src[p]);
+                }
+            } else {
+                for (size_t p = 0; p < kc; p++) {
+                    dst[p * MR + i] = 0.0f;
+                }
+            }
+        }
+        dst += MR * kc;
+    }
+}
+
+// Every row of B is read contiguously and converted to float exactly once per panel.
+// Quantized rows are multiplied by their scale on the way; plain ones pass no scales.
+template <typename T>
+void pack_b_(float *dst, const T *b, size_t ldb, const float *scales, size_t nc, size_t kc) {
+    for (size_t jr = 0; jr < nc; jr += NR) {
+        size_t nr = smin(NR, nc - jr);
+        for (size_t j = 0; j < NR; j++) {
+            if (j < nr) {
+                const T *src = b + (jr + j) * ldb;
+                if (scales != nullptr) {
+                    const float scale = scales[jr + j];
+                    for (size_t p = 0; p < kc; p++) {
+                        dst[p * NR + j] = to_float(src[p]) * scale;
+                    }
+                    continue;
+                }
+                for (size_t p = 0; p < kc; p++) {
+                    dst[p * NR + j] = to_float(src[p]);
+                }
+            } else {
+                for (size_t p = 0; p < kc; p++) {
+                    dst[p * NR + j] = 0.0f;
+                }
+            }
+        }
+        dst += NR * kc;
+    }
+}
+
+// C[MR, NR] += A_sliver[kc, MR]^T * B_micro_panel[kc, NR]
+// The accumulators stay in vector registers for the whole k loop.
+#ifdef LLAISYS_SIMD_SCALAR
+inline void micro_kernel(size_t kc, const float *a, const float *b, float *c, size_t ldc) {
+    float acc[MR][NR] = {};
+    for (size_t p = 0; p < kc; p++) {
+        // Staging the B row in a local keeps the compiler from re-reading it per row
+        // and lets it vectorize along NR at every optimization level.
+        float bv[NR];
+        for (size_t j = 0; j < NR; j++) {
+            bv[j] = b[p * NR + j];
+        }
+        for (size_t i = 0; i < MR; i++) {
+            float av = a[p * MR + i];
+            for (size_t j = 0; j < NR; j++) {
+                acc[i][j] += av * bv[j];
+            }
+        }
+    }
+    for (size_t i = 0; i < MR; i++) {
+        for (size_t j = 0; j < NR; j++) {
+            c[i * ldc + j] += acc[i][j];
+        }
+    }
+}
+#else
+inline void micro_kernel(size_t kc, const float *a, const float *b, float *c, size_t ldc) {
+    vfloat acc[MR][NV];
+    for (size_t i = 0; i < MR; i++) {
+        for (size_t v = 0; v < NV; v++) {
+            acc[i][v] = vzero();
+        }
+    }
+    for (size_t p = 0; p < kc; p++) {
+        vfloat bv[NV];
+        for (size_t v = 0; v < NV; v++) {
+            bv[v] = vload(b + p * NR + v * W);
+        }
+        for (size_t i = 0; i < MR; i++) {
+            vfloat av = vset1(a[p * MR + i]);
+            for (size_t v = 0; v < NV; v++) {
+                acc[i][v] = vfmadd(av, bv[v], acc[i][v]);
+            }
+        }
+    }
+    for (size_t i = 0; i < MR; i++) {
+        for (size_t v = 0; v < NV; v++) {
+            float *dst = c + i * ldc + v * W;
+            vstore(dst, vadd(vload(dst), acc[i][v]));
+        }
+    }
+}
+#endif
+
+void pack_a(float *dst, const std::byte *a, size_t lda, llaisysDataType_t type, size_t mc, size_t kc) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        pack_a_(dst, reinterpret_cast<const T *>(a), lda, mc, kc);
+    });
+}
+
+void pack_b(float *dst, const std::byte *b, size_t ldb, llaisysDataType_t type, size_t nc, size_t kc) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        pack_b_(dst, reinterpret_cast<const T *>(b), ldb, nullptr, nc, kc);
+    });
+}
+
+void pack_b_q8(float *dst, const int8_t *b, size_t ldb, const float *scales, size_t nc, size_t kc) {
+    pack_b_(dst, b, ldb, scales, nc, kc);
+}
+
+// Q4 columns come in 32-column blocks, and groups and KC are whole blocks. Each group
+// expands its 16 codes into a table once, so a weight costs a lookup.
+void pack_b_q4(float *dst, const uint8_t *b, size_t ldb, const llaisys::fp16_t *scales, const uint8_t *zeros,
+               size_t groups, size_t group, size_t k0, size_t nc, size_t kc) {
+    for (size_t jr = 0; jr < nc; jr += NR) {
+        size_t nr = smin(NR, nc - jr);
+        for (size_t j = 0; j < NR; j++) {
+            if (j >= nr) {
+                for (size_t p = 0; p < kc; p++) {
+                    dst[p * NR + j] = 0.0f;
+                }
+                continue;
+            }
+            const uint8_t *src = b + (jr + j) * ldb;
+            const llaisys::fp16_t *s = scales + (jr + j) * groups;
+            const uint8_t *z = zeros == nullptr ? nullptr : zeros + (jr + j) * groups;
+            float lut[16];
+            for (size_t p = 0; p < kc; p += 32) {
+                const size_t c = k0 + p;
+                if (p == 0 || c % group == 0) {
+                    const float scale = to_float(s[c / group]);
+                    const float zero = z == nullptr ? 8.0f : static_cast<float>(z[c / group]);
+                    for (size_t q = 0; q < 16; q++) {
+                        lut[q] = (static_cast<float>(q) - zero) * scale;
+                    }
+                }
+                const uint8_t *block = src + c / 2;
+                for (size_t h = 0; h < 16; h++) {
+                    dst[(p + h) * NR + j] = lut[block[h] & 15];
+                    dst[(p + 16 + h) * NR + j] = lut[block[h] >> 4];
+                }
+            }
+        }
+        dst += NR * kc;
+    }
+}
+
+void macro_kernel(float *c, size_t ldc, const float *a_pack, const float *b_pack, size_t mc, size_t nc, size_t kc) {
+    for (size_t jr = 0; jr < nc; jr += NR) {
+        const float *bp = b_pack + jr * kc;
+        for (size_t ir = 0; ir < mc; ir += MR) {
+            micro_kernel(kc, a_pack + ir * kc, bp, c + ir * ldc + jr, ldc);
+        }
+    }
+}
+
+template <typename T>
+void store_(T *dst, size_t ldd, const float *src, size_t lds, const T *bias, size_t m, size_t n) {
+    for (size_t i = 0; i < m; i++) {
+        const float *s = src + i * lds;
+        T *d = dst + i * ldd;
+        size_t j = 0;
+        if (bias != nullptr) {
+            for (; j + W <= n; j += W) {
+                vstore(d + j, vadd(vload(s + j), vload(bias + j)));
+            }
+            for (; j < n; j++) {
+                d[j] = from_float<T>(s[j] + to_float(bias[j]));
+            }
+        } else {
+            for (; j + W <= n; j += W) {
+                vstore(d + j, vload(s + j));
+            }
+            for (; j < n; j++) {
+                d[j] = from_float<T>(s[j]);
+            }
+        }
+    }
+}
+
+void store(std::byte *dst, size_t ldd, const float *src, size_t lds, const std::byte *bias,
+           llaisysDataType_t type, size_t m, size_t n) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        store_(reinterpret_cast<T *>(dst), ldd, src, lds, reinterpret_cast<const T *>(bias), m, n);
+    });
+}
+
+template <typename T>
+void store_swiglu_(T *dst, size_t ldd, const float *gate, const float *up, size_t lds, size_t m, size_t n) {
+    const vfloat one = vset1(1.0f);
+    const vfloat zero = vzero();
+    for (size_t i = 0; i < m; i++) {
+        const float *g = gate + i * lds;
+        const float *u = up + i * lds;
+        T *d = dst + i * ldd;
+        size_t j = 0;
+        for (; j + W <= n; j += W) {
+            vfloat gv = vload(g + j);
+            vstore(d + j, vmul(vload(u + j), vdiv(gv, vadd(one, vexp(vsub(zero, gv))))));
+        }
+        for (; j < n; j++) {
+            d[j] = from_float<T>(u[j] * (g[j] / (1.0f + expf(-g[j]))));
+        }
+    }
+}
+
+void store_swiglu(std::byte *dst, size_t ldd, const float *gate, const float *up, size_t lds,
+                  llaisysDataType_t type, size_t m, size_t n) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        store_swiglu_(reinterpret_cast<T *>(dst), ldd, gate, up, lds, m, n);
+    });
+}
+
+void rotate(float *a, float *b, const float *cos, const float *sin, size_t n) {
+    size_t d = 0;
+    for (; d + W <= n; d += W) {
+        vfloat va = vload(a + d), vb = vload(b + d);
+        vfloat vc = vload(cos + d), vs = vload(sin + d);
+        vstore(a + d, vsub(vmul(va, vc), vmul(vb, vs)));
+        vstore(b + d, vfmadd(va, vs, vmul(vb, vc)));
+    }
+    for (; d < n; d++) {
+        const float va = a[d], vb = b[d];
+        a[d] = va * cos[d] - vb * sin[d];
+        b[d] = vb * cos[d] + va * sin[d];
+    }
+}
+
+void widen(float *dst, const std::byte *src, llaisysDataType_t type, size_t n) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        const T *s = reinterpret_cast<const T *>(src);
+        size_t i = 0;
+        for (; i + W <= n; i += W) {
+            vstore(dst + i, vload(s + i));
+        }
+        for (; i < n; i++) {
+            dst[i] = to_float(s[i]);
+        }
+    });
+}
+
+// Two independent accumulators per row hide the FMA latency.
+template <size_t R, typename T>
+void dot_rows_(float *out, const float *x, const T *w, size_t ldw, size_t k) {
+    vfloat acc0[R], acc1[R];
+    for (size_t r = 0; r < R; r++) {
+        acc0[r] = vzero();
+        acc1[r] = vzero();
+    }
+    size_t p = 0;
+    for (; p + 2 * W <= k; p += 2 * W) {
+        vfloat x0 = vload(x + p);
+        vfloat x1 = vload(x + p + W);
+        for (size_t r = 0; r < R; r++) {
+            acc0[r] = vfmadd(x0, vload(w + r * ldw + p), acc0[r]);
+            acc1[r] = vfmadd(x1, vload(w + r * ldw + p + W), acc1[r]);
+        }
+    }
+    for (size_t r = 0; r < R; r++) {
+        float sum = vsum(vadd(acc0[r], acc1[r]));
+        for (size_t q = p; q < k; q++) {
+            sum += x[q] * to_float(w[r * ldw + q]);
+        }
+        out[r] = sum;
+    }
+}
+
+void dot_rows(float *out, const float *x, const std::byte *w, size_t ldw, llaisysDataType_t type,
+              size_t rows, size_t k) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        const T *wt = reinterpret_cast<const T *>(w);
+        if (rows == llaisys::ops::cpu::GEMV_ROWS) {
+            return dot_rows_<llaisys::ops::cpu::GEMV_ROWS>(out, x, wt, ldw, k);
+        }
+        for (size_t r = 0; r < rows; r++) {
+            dot_rows_<1>(out + r, x, wt + r * ldw, ldw, k);
+        }
+    });
+}
+
+// The W bytes at w + h hold columns h.. (low nibbles) and 16 + h.. (high nibbles) of a
+// 32-column block; they are split in float, where v = 16 * hi + lo is exact.
+template <size_t R>
+void dot_rows_q4_(float *out, const float *x, const float *xsum, const uint8_t *w, size_t ldw,
+                  const llaisys::fp16_t *scales, const uint8_t *zeros, size_t groups, size_t group) {
+    const vfloat sixteenth = vset1(1.0f / 16.0f);
+    const vfloat minus16 = vset1(-16.0f);
+    vfloat acc[R];
+    float correction[R];
+    for (size_t r = 0; r < R; r++) {
+        acc[r] = vzero();
+        correction[r] = 0.0f;
+    }
+    for (size_t g = 0; g < groups; g++) {
+        vfloat part[R];
+        for (size_t r = 0; r < R; r++) {
+            part[r] = vzero();
+        }
+        for (size_t b = g * group; b < (g + 1) * group; b += 32) {
+            for (size_t h = 0; h < 16; h += W) {
+                vfloat x_lo = vload(x + b + h);
+                vfloat x_hi = vload(x + b + 16 + h);
+                for (size_t r = 0; r < R; r++) {
+                    vfloat v = vload(w + r * ldw + b / 2 + h);
+                    vfloat hi = vfloor(vmul(v, sixteenth));
+                    vfloat lo = vfmadd(hi, minus16, v);
+                    part[r] = vfmadd(lo, x_lo, part[r]);
+                    part[r] = vfmadd(hi, x_hi, part[r]);
+                }
+            }
+        }
+        for (size_t r = 0; r < R; r++) {
+            float scale = to_float(scales[r * groups + g]);
+            float zero = zeros == nullptr ? 8.0f : static_cast<float>(zeros[r * groups + g]);
+            acc[r] = vfmadd(vset1(scale), part[r], acc[r]);
+            correction[r] += scale * zero * xsum[g];
+        }
+    }
+    for (size_t r = 0; r < R; r++) {
+        out[r] = vsum(acc[r]) - correction[r];
+    }
+}
+
+void dot_rows_q4(float *out, const float *x, const float *xsum, const uint8_t *w, size_t ldw,
+                 const llaisys::fp16_t *scales, const uint8_t *zeros, size_t groups, size_t group, size_t rows) {
+    if (rows == llaisys::ops::cpu::GEMV_ROWS) {
+        return dot_rows_q4_<llaisys::ops::cpu::GEMV_ROWS>(out, x, xsum, w, ldw, scales, zeros, groups, group);
+    }
+    for (size_t r = 0; r < rows; r++) {
+        dot_rows_q4_<1>(out + r, x, xsum, w + r * ldw, ldw, scales + r * groups,
+                        zeros == nullptr ? nullptr : zeros + r * groups, groups, group);
+    }
+}
+
+void dot_rows_q8(float *out, const float *x, const int8_t *w, size_t ldw, const float *scales,
+                 size_t rows, size_t k) {
+    if (rows == llaisys::ops::cpu::GEMV_ROWS) {
+        dot_rows_<llaisys::ops::cpu::GEMV_ROWS>(out, x, w, ldw, k);
+    } else {
+        for (size_t r = 0; r < rows; r++) {
+            dot_rows_<1>(out + r, x, w + r * ldw, ldw, k);
+        }
+    }
+    for (size_t r = 0; r < rows; r++) {
+        out[r] *= scales[r];
+    }
+}
+// Few rows leave few accumulator chains; those unroll k by two to keep the FMA pipes busy.
+template <size_t R, typename T>
+void dot_panel_(float *out, const float *x, size_t ldx, const T *panel, size_t kc) {
+    constexpr size_t U = R <= 2 ? 2 : 1;
+    vfloat acc[U][R][NV];
+    for (size_t u = 0; u < U; u++) {
+        for (size_t r = 0; r < R; r++) {
+            for (size_t v = 0; v < NV; v++) {
+                acc[u][r][v] = u == 0 ? vload(out + r * NR + v * W) : vzero();
+            }
+        }
+    }
+    size_t p = 0;
+    for (; p + U <= kc; p += U) {
+        __builtin_prefetch(reinterpret_cast<const char *>(panel + p * NR) + 4096);
+        for (size_t u = 0; u < U; u++) {
+            vfloat b[NV];
+            for (size_t v = 0; v < NV; v++) {
+                b[v] = vload(panel + (p + u) * NR + v * W);
+            }
+            for (size_t r = 0; r < R; r++) {
+                vfloat a = vset1(x[r * ldx + p + u]);
+                for (size_t v = 0; v < NV; v++) {
+                    acc[u][r][v] = vfmadd(a, b[v], acc[u][r][v]);
+                }
+            }
+        }
+    }
+    for (; p < kc; p++) {
+        for (size_t v = 0; v < NV; v++) {
+            vfloat b = vload(panel + p * NR + v * W);
+            for (size_t r = 0; r < R; r++) {
+                acc[0][r][v] = vfmadd(vset1(x[r * ldx + p]), b, acc[0][r][v]);
+            }
+        }
+    }
+    for (size_t r = 0; r < R; r++) {
+        for (size_t v = 0; v < NV; v++) {
+            vfloat sum = acc[0][r][v];
+            for (size_t u = 1; u < U; u++) {
+                sum = vadd(sum, acc[u][r][v]);
+            }
+            vstore(out + r * NR + v * W, sum);
+        }
+    }
+}
+
+void dot_panel(float *out, const float *x, size_t ldx, const std::byte *panel, llaisysDataType_t type,
+               size_t rows, size_t kc) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        const T *b = reinterpret_cast<const T *>(panel);
+        for (size_t i = 0; i < rows; i += 4) {
+            float *o = out + i * NR;
+            const float *xi = x + i * ldx;
+            switch (smin(4, rows - i)) {
+            case 1:
+                dot_panel_<1>(o, xi, ldx, b, kc);
+                break;
+            case 2:
+                dot_panel_<2>(o, xi, ldx, b, kc);
+                break;
+            case 3:
+                dot_panel_<3>(o, xi, ldx, b, kc);
+                break;
+            default:
+                dot_panel_<4>(o, xi, ldx, b, kc);
+            }
+        }
+    });
+}
+} // namespace
+
+namespace llaisys::ops::cpu::LLAISYS_CPU_ISA {
+const GemmKernel &gemm_kernel() {
+    static const GemmKernel kernel = {MR,        NR,           pack_a, pack_b,       pack_b_q8,
+                                      pack_b_q4, macro_kernel, store,  store_swiglu, rotate,
+                                      widen,     dot_rows,     dot_rows_q8, dot_rows_q4, dot_panel};
+    return kernel;
+}
+} // namespace llaisys::ops::cpu::LLAISYS_CPU_ISA
+#endif // LLAISYS_CPU_ISA
@@ -0,0 +1,350 @@
+#include "gemv.hpp"
+
+#include "gemm.hpp"
+#include "gemm_kernel.hpp"
+
+#include "../../../core/llaisys_core.hpp"
+#include "../../../utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+using llaisys::ops::cpu::GEMM_KC;
+using llaisys::ops::cpu::GEMM_NC;
+using llaisys::ops::cpu::GEMV_ROWS;
+using llaisys::ops::cpu::GemmKernel;
+using llaisys::ops::cpu::GemmOutput;
+
+// Output features handed to a thread at a time.
+constexpr size_t N_BLOCK = 64;
+
+const GemmKernel &kernel = llaisys::ops::cpu::active_gemm_kernel();
+
+// Widen the input rows once up front; every thread then reads them from cache.
+const float *widen_rows(const std::byte *x, size_t ldx, llaisysDataType_t type, size_t m, size_t k) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+    case LLAISYS_DTYPE_BF16:
+    case LLAISYS_DTYPE_F16:
+        break;
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+    const size_t es = llaisys::utils::dsize(type);
+    thread_local std::vector<float> x_buf;
+    x_buf.resize(m * k);
+    for (size_t i = 0; i < m; i++) {
+        kernel.widen(x_buf.data() + i * k, x + i * ldx * es, type, k);
+    }
+    return x_buf.data();
+}
+
+// Shared by all weight formats: dot(acc, i, j, rows) fills acc with input row i against
+// weight rows [j, j + rows).
+template <typename Dot>
+void gemv(std::byte *y, size_t ldy, const std::byte *bias, llaisysDataType_t type, size_t m, size_t n,
+          const Dot &dot) {
+    const size_t es = llaisys::utils::dsize(type);
+    llaisys::core::parallel_for(0, n, N_BLOCK, [&](size_t n0, size_t n1) {
+        for (size_t j = n0; j < n1; j += GEMV_ROWS) {
+            size_t rows = std::min(GEMV_ROWS, n1 - j);
+            for (size_t i = 0; i < m; i++) {
+                float acc[GEMV_ROWS];
+                dot(acc, i, j, rows);
+                kernel.store(y + (i * ldy + j) * es, ldy, acc, GEMV_ROWS,
+                             bias == nullptr ? nullptr : bias + j * es, type, 1, rows);
+            }
+        }
+    });
+}
+
+// Fill acc with the m widened rows of xf against the nc packed weight rows from n0,
+// one accumulator per panel: row i of column n0 + jr + j lands in acc[jr * m + i * nr + j].
+// A block of GEMM_NC rows is one contiguous run of the packed weight, streamed front to back.
+void dot_block(float *acc, const float *xf, const std::byte *w, llaisysDataType_t type, size_t m, size_t n0,
+               size_t nc, size_t k) {
+    const size_t es = llaisys::utils::dsize(type);
+    const size_t nr = kernel.nr;
+    const size_t np = (nc + nr - 1) / nr * nr;
+    std::fill(acc, acc + np * m, 0.0f);
+    const std::byte *panel = w + n0 * k * es;
+    for (size_t pc = 0; pc < k; pc += GEMM_KC) {
+        const size_t kc = std::min(GEMM_KC, k - pc);
+        for (size_t jr = 0; jr < np; jr += nr, panel += kc * nr * es) {
+            kernel.dot_panel(acc + jr * m, xf + pc, k, panel, type, m, kc);
+        }
+    }
+}
+
+// Sweep a weight from gemm_prepack, or from gemm_prepack_gate_up when `gate_up` is set
+// (and then n counts outputs, each fed by one gate and one up row). Each thread streams
+// whole blocks of GEMM_NC rows.
+void gemv_packed(const GemmOutput &y, const std::byte *x, size_t ldx, const std::byte *w, llaisysDataType_t type,
+                 size_t m, size_t n, size_t k, bool gate_up) {
+    const float *xf = widen_rows(x, ldx, type, m, k);
+    const size_t es = llaisys::utils::dsize(type);
+    const size_t nr = kernel.nr;
+    const size_t nb = gate_up ? 2 * ((n + nr - 1) / nr * nr) : n;
+    llaisys::core::parallel_for(0, (nb + GEMM_NC - 1) / GEMM_NC, 1, [&](size_t t0, size_t t1) {
+        thread_local std::vector<float> acc_buf;
+        acc_buf.resize(GEMM_NC * m);
+        float *acc = acc_buf.data();
+        for (size_t t = t0; t < t1; t++) {
+            const size_t n0 = t * GEMM_NC;
+            const size_t nc = std::min(GEMM_NC, nb - n0);
+            dot_block(acc, xf, w, type, m, n0, nc, k);
+            if (gate_up) {
+                for (size_t jr = 0; jr < nc && (n0 + jr) / 2 < n; jr += 2 * nr) {
+                    const size_t j = (n0 + jr) / 2;
+                    kernel.store_swiglu(y.c[0] + j * es, y.ldc[0], acc + jr * m, acc + (jr + nr) * m, nr, type, m,
+                                        std::min(nr, n - j));
+                }
+                continue;
+            }
+            llaisys::ops::cpu::gemm_rope(y, 0, n0, acc, nr, nr, nr * m, type, m, nc);
+            for (size_t jr = 0; jr < nc; jr += nr) {
+                llaisys::ops::cpu::gemm_store(y, 0, n0 + jr, acc + jr * m, nr, type, m, std::min(nr, nc - jr));
+            }
+        }
+    });
+}
+
+// A candidate of a top-k sweep. Larger values come first, and among equal ones the
+// lower index, as argmax picks them.
+struct Candidate {
+    float val;
+    int64_t idx;
+};
+
+bool better(const Candidate &a, const Candidate &b) {
+    return a.val > b.val || (a.val == b.val && a.idx < b.idx);
+}
+
+// Keeps the worst of the k candidates in `heap` on top; NaNs never get in.
+void offer(Candidate *heap, size_t k, const Candidate &c) {
+    if (better(c, heap[0])) {
+        std::pop_heap(heap, heap + k, better);
+        heap[k - 1] = c;
+        std::push_heap(heap, heap + k, better);
+    }
+}
+
+// Round n outputs (n <= GEMM_NC) to `type` the way linear stores them, so that the
+// selection matches linear + argmax.
+void round_outputs(float *v, size_t n, llaisysDataType_t type) {
+    if (type == LLAISYS_DTYPE_F32) {
+        return;
+    }
+    std::byte stored[GEMM_NC * sizeof(float)];
+    kernel.store(stored, n, v, n, nullptr, type, 1, n);
+    kernel.widen(v, stored, type, n);
+}
+
+// The topk best of the n outputs of each of m rows, into idx[m, topk] and val[m, topk]
+// (of `type`) from best to worst. The outputs are cut into units of `unit` features and
+// the units into a few chunks per thread; block(heaps, j0, j1) offers features
+// [j0, j1) to the m heaps of its chunk, and the chunks are merged at the end, so no
+// chunk waits on another and no output is ever stored.
+template <typename Block>
+void topk_sweep(int64_t *idx, std::byte *val, size_t topk, llaisysDataType_t type, size_t m, size_t n, size_t unit,
+                const Block &block) {
+    const size_t units = (n + unit - 1) / unit;
+    const size_t grain = std::max<size_t>(1, units / (4 * llaisys::core::threadPool().numThreads()));
+    const size_t chunks = (units + grain - 1) / grain;
+    thread_local std::vector<Candidate> heap_buf;
+    heap_buf.assign(chunks * m * topk, Candidate{-HUGE_VALF, INT64_MAX});
+    Candidate *heaps = heap_buf.data();
+    llaisys::core::parallel_for(0, units, grain, [&](size_t u0, size_t u1) {
+        block(heaps + u0 / grain * m * topk, u0 * unit, std::min(n, u1 * unit));
+    });
+
+    const size_t es = llaisys::utils::dsize(type);
+    thread_local std::vector<float> vals;
+    vals.resize(topk);
+    for (size_t i = 0; i < m; i++) {
+        Candidate *best = heaps + i * topk;
+        for (size_t c = 1; c < chunks; c++) {
+            for (size_t e = 0; e < topk; e++) {
+                offer(best, topk, heaps[(c * m + i) * topk + e]);
+            }
+        }
+        std::sort(best, best + topk, better);
+        for (size_t e = 0; e < topk; e++) {
+            idx[i * topk + e] = best[e].idx;
+            vals[e] = best[e].val;
+        }
+        kernel.store(val + i * topk * es, topk, vals.data(), topk, nullptr, type, 1, topk);
+    }
+}
+
+// topk_sweep over a row-major weight in any format; dot is as for gemv.
+template <typename Dot>
+void gemv_topk(int64_t *idx, std::byte *val, size_t topk, llaisysDataType_t type, size_t m, size_t n,
+               const Dot &dot) {
+    topk_sweep(idx, val, topk, type, m, n, N_BLOCK, [&](Candidate *heaps, size_t j0, size_t j1) {
+        // Outputs are gathered GEMM_NC at a time to be rounded together.
+        thread_local std::vector<float> out_buf;
+        out_buf.resize(GEMM_NC * m);
+        float *out = out_buf.data();
+        for (size_t s0 = j0; s0 < j1; s0 += GEMM_NC) {
+            const size_t s1 = std::min(j1, s0 + GEMM_NC);
+            for (size_t j = s0; j < s1; j += GEMV_ROWS) {
+                for (size_t i = 0; i < m; i++) {
+                    dot(out + i * GEMM_NC + (j - s0), i, j, std::min(GEMV_ROWS, s1 - j));
+                }
+            }
+            for (size_t i = 0; i < m; i++) {
+                float *row = out + i * GEMM_NC;
+                round_outputs(row, s1 - s0, type);
+                for (size_t j = s0; j < s1; j++) {
+                    offer(heaps + i * topk, topk, {row[j - s0], static_cast<int64_t>(j)});
+                }
+            }
+        }
+    });
+}
+
+// Per-group sums of the widened input rows, which carry Q4 zero points out of the inner loop.
+const float *group_sums(const float *xf, size_t m, size_t k, size_t groups) {
+    const size_t group = k / groups;
+    thread_local std::vector<float> xsum_buf;
+    xsum_buf.resize(m * groups);
+    for (size_t i = 0; i < m; i++) {
+        for (size_t g = 0; g < groups; g++) {
+            const float *xg = xf + i * k + g * group;
+            float sum = 0.0f;
+            for (size_t p = 0; p < group; p++) {
+                sum += xg[p];
+            }
+            xsum_buf[i * groups + g] = sum;
+        }
+    }
+    return xsum_buf.data();
+}
+} // namespace
+
+namespace llaisys::ops::cpu {
+void gemv_nt(std::byte *y, size_t ldy,
+             const std::byte *x, size_t ldx,
+             const std::byte *w, size_t ldw,
+             const std::byte *bias, llaisysDataType_t type,
+             size_t m, size_t n, size_t k) {
+    const float *xf = widen_rows(x, ldx, type, m, k);
+    const size_t es = utils::dsize(type);
+    gemv(y, ldy, bias, type, m, n, [&](float *acc, size_t i, size_t j, size_t rows) {
+        kernel.dot_rows(acc, xf + i * k, w + j * ldw * es, ldw, type, rows, k);
+    });
+}
+
+void gemv_nt_q8(std::byte *y, size_t ldy,
+                const std::byte *x, size_t ldx,
+                const int8_t *w, size_t ldw, const float *scales,
+                const std::byte *bias, llaisysDataType_t type,
+                size_t m, size_t n, size_t k) {
+    const float *xf = widen_rows(x, ldx, type, m, k);
+    gemv(y, ldy, bias, type, m, n, [&](float *acc, size_t i, size_t j, size_t rows) {
+        kernel.dot_rows_q8(acc, xf + i * k, w + j * ldw, ldw, scales + j, rows, k);
+    });
+}
+
+void gemv_nt_q4(std::byte *y, size_t ldy,
+                const std::byte *x, size_t ldx,
+                const uint8_t *w, size_t ldw, const fp16_t *scales, const uint8_t *zeros, size_t groups,
+                const std::byte *bias, llaisysDataType_t type,
+                size_t m, size_t n, size_t k) {
+    const float *xf = widen_rows(x, ldx, type, m, k);
+    const size_t group = k / groups;
+    const float *xsum = group_sums(xf, m, k, groups);
+    gemv(y, ldy, bias, type, m, n, [&](float *acc, size_t i, size_t j, size_t rows) {
+        kernel.dot_rows_q4(acc, xf + i * k, xsum + i * groups, w + j * ldw, ldw, scales + j * groups,
+                           zeros == nullptr ? nullptr : zeros + j * groups, groups, group, rows);
+    });
+}
+
+void gemv_nt_packed(std::byte *y, size_t ldy,
+                    const std::byte *x, size_t ldx,
+                    const std::byte *w,
+                    const std::byte *bias, llaisysDataType_t type,
+                    size_t m, size_t n, size_t k) {
+    gemv_packed(GemmOutput{{y}, {ldy}, {bias}, {n}, 1}, x, ldx, w, type, m, n, k, false);
+}
+
+void gemv_nt_packed_split(const GemmOutput &y,
+                          const std::byte *x, size_t ldx,
+                          const std::byte *w, llaisysDataType_t type,
+                          size_t m, size_t n, size_t k) {
+    gemv_packed(y, x, ldx, w, type, m, n, k, false);
+}
+
+void gemv_nt_packed_swiglu(std::byte *y, size_t ldy,
+                           const std::byte *x, size_t ldx,
+                           const std::byte *w, llaisysDataType_t type,
+                           size_t m, size_t n, size_t k) {
+    gemv_packed(GemmOutput{{y}, {ldy}, {nullptr}, {n}, 1}, x, ldx, w, type, m, n, k, true);
+}
+
+void gemv_topk_nt(int64_t *idx, std::byte *val, size_t topk,
+                  const std::byte *x, size_t ldx,
+                  const std::byte *w, size_t ldw, llaisysDataType_t type,
+                  size_t m, size_t n, size_t k) {
+    const float *xf = widen_rows(x, ldx, type, m, k);
+    const size_t es = utils::dsize(type);
+    gemv_topk(idx, val, topk, type, m, n, [&](float *acc, size_t i, size_t j, size_t rows) {
+        kernel.dot_rows(acc, xf + i * k, w + j * ldw * es, ldw, type, rows, k);
+    });
+}
+
+void gemv_topk_nt_q8(int64_t *idx, std::byte *val, size_t topk,
+                     const std::byte *x, size_t ldx,
+                     const int8_t *w, size_t ldw, const float *scales, llaisysDataType_t type,
+                     size_t m, size_t n, size_t k) {
+    const float *xf = widen_rows(x, ldx, type, m, k);
+    gemv_topk(idx, val, topk, type, m, n, [&](float *acc, size_t i, size_t j, size_t rows) {
+        kernel.dot_rows_q8(acc, xf + i * k, w + j * ldw, ldw, scales + j, rows, k);
+    });
+}
+
+void gemv_topk_nt_q4(int64_t *idx, std::byte *val, size_t topk,
+                     const std::byte *x, size_t ldx,
+                     const uint8_t *w, size_t ldw, const fp16_t *scales, const uint8_t *zeros, size_t groups,
+                     llaisysDataType_t type, size_t m, size_t n, size_t k) {
+    const float *xf = widen_rows(x, ldx, type, m, k);
+    const size_t group = k / groups;
+    const float *xsum = group_sums(xf, m, k, groups);
+    gemv_topk(idx, val, topk, type, m, n, [&](float *acc, size_t i, size_t j, size_t rows) {
+        kernel.dot_rows_q4(acc, xf + i * k, xsum + i * groups, w + j * ldw, ldw, scales + j * groups,
+                           zeros == nullptr ? nullptr : zeros + j * groups, groups, group, rows);
+    });
+}
+
+void gemv_topk_nt_packed(int64_t *idx, std::byte *val, size_t topk,
+                         const std::byte *x, size_t ldx,
+                         const std::byte *w, llaisysDataType_t type,
+                         size_t m, size_t n, size_t k) {
+    const float *xf = widen_rows(x, ldx, type, m, k);
+    const size_t nr = kernel.nr;
+    topk_sweep(idx, val, topk, type, m, n, GEMM_NC, [&](Candidate *heaps, size_t j0, size_t j1) {
+        thread_local std::vector<float> acc_buf;
+        acc_buf.resize(GEMM_NC * m);
+        float *acc = acc_buf.data();
+        float row[GEMM_NC];
+        for (size_t n0 = j0; n0 < j1; n0 += GEMM_NC) {
+            const size_t nc = std::min(GEMM_NC, j1 - n0);
+            dot_block(acc, xf, w, type, m, n0, nc, k);
+            for (size_t i = 0; i < m; i++) {
+                for (size_t j = 0; j < nc; j++) {
+                    row[j] = acc[j / nr * nr * m + i * nr + j % nr];
+                }
+                round_outputs(row, nc, type);
+                for (size_t j = 0; j < nc; j++) {
+                    offer(heaps + i * topk, topk, {row[j], static_cast<int64_t>(n0 + j)});
+                }
+            }
+        }
+    });
+}
+} // namespace llaisys::ops::cpu
@@ -0,0 +1,84 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../../utils.hpp"
+
+#include "gemm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace llaisys::ops::cpu {
+// Up to this many input rows, linear streams the weight once instead of packing it. GEMM
+// widens or unpacks every weight panel per call, which only pays off over wider inputs
+// than a step of batched decodes.
+constexpr size_t GEMV_MAX_ROWS = 16;
+
+// y[m, n] = sum_k x[m, k] * W[n, k] + bias[n], for m <= GEMV_MAX_ROWS.
+// Same operand conventions as gemm_nt, tuned for the memory-bound decode shape:
+// every weight row is read exactly once and out_features are split across threads.
+void gemv_nt(std::byte *y, size_t ldy,
+             const std::byte *x, size_t ldx,
+             const std::byte *w, size_t ldw,
+             const std::byte *bias, llaisysDataType_t type,
+             size_t m, size_t n, size_t k);
+
+// gemv_nt with an I8 weight and one F32 scale per weight row. Every weight byte is
+// read once and widened in registers, so decode moves a quarter of the F32 traffic.
+void gemv_nt_q8(std::byte *y, size_t ldy,
+                const std::byte *x, size_t ldx,
+                const int8_t *w, size_t ldw, const float *scales,
+                const std::byte *bias, llaisysDataType_t type,
+                size_t m, size_t n, size_t k);
+
+// gemv_nt with a Q4 weight of k / 2 bytes per row (ldw in bytes) and F16 scales and
+// optional U8 zero points of `groups` per row. Decode reads half a byte per weight.
+void gemv_nt_q4(std::byte *y, size_t ldy,
+                const std::byte *x, size_t ldx,
+                const uint8_t *w, size_t ldw, const fp16_t *scales, const uint8_t *zeros, size_t groups,
+                const std::byte *bias, llaisysDataType_t type,
+                size_t m, size_t n, size_t k);
+
+// gemv_nt with W from gemm_prepack. Each thread sweeps whole micro-panels, keeping
+// one output feature per vector lane.
+void gemv_nt_packed(std::byte *y, size_t ldy,
+                    const std::byte *x, size_t ldx,
+                    const std::byte *w,
+                    const std::byte *bias, llaisysDataType_t type,
+                    size_t m, size_t n, size_t k);
+// gemv_nt_packed into a y split by columns (see GemmOutput).
+void gemv_nt_packed_split(const GemmOutput &y,
+                          const std::byte *x, size_t ldx,
+                          const std::byte *w, llaisysDataType_t type,
+                          size_t m, size_t n, size_t k);
+
+// y[m, n] = silu(x * gate^T) * (x * up^T) with W from gemm_prepack_gate_up. The input
+// rows are read once for both projections, whose panels sit side by side in the stream.
+void gemv_nt_packed_swiglu(std::byte *y, size_t ldy,
+                           const std::byte *x, size_t ldx,
+                           const std::byte *w, llaisysDataType_t type,
+                           size_t m, size_t n, size_t k);
+
+// The topk largest outputs of each row of gemv_nt without a bias, from largest down, as
+// feature indices in idx[m, topk] and values of `type` in val[m, topk]. Outputs are
+// rounded to `type` and compared as linear + argmax would see them (ties keep the
+// lower index) but never stored: each thread keeps the best of its run of features,
+// and the runs are merged once at the end.
+void gemv_topk_nt(int64_t *idx, std::byte *val, size_t topk,
+                  const std::byte *x, size_t ldx,
+                  const std::byte *w, size_t ldw, llaisysDataType_t type,
+                  size_t m, size_t n, size_t k);
+// gemv_topk_nt over the weights of gemv_nt_q8, gemv_nt_q4 and gemv_nt_packed.
+void gemv_topk_nt_q8(int64_t *idx, std::byte *val, size_t topk,
+                     const std::byte *x, size_t ldx,
+                     const int8_t *w, size_t ldw, const float *scales, llaisysDataType_t type,
+                     size_t m, size_t n, size_t k);
+void gemv_topk_nt_q4(int64_t *idx, std::byte *val, size_t topk,
+                     const std::byte *x, size_t ldx,
+                     const uint8_t *w, size_t ldw, const fp16_t *scales, const uint8_t *zeros, size_t groups,
+                     llaisysDataType_t type, size_t m, size_t n, size_t k);
+void gemv_topk_nt_packed(int64_t *idx, std::byte *val, size_t topk,
+                         const std::byte *x, size_t ldx,
+                         const std::byte *w, llaisysDataType_t type,
+                         size_t m, size_t n, size_t k);
+} // namespace llaisys::ops::cpu
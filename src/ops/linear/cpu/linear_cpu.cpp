@@ -1,73 +1,180 @@
 #include "linear_cpu.hpp"
 
+#include "gemm.hpp"
+#include "gemv.hpp"
+
 #include "../../../utils.hpp"
 
-#include <cmath>
 #include <cstddef>
-#include <type_traits>
 
-template <typename T>
-void linear_(T *out, const T *in, const T *weight, const T *bias,
-             size_t batch_size, size_t in_features, size_t out_features) {
+namespace llaisys::ops::cpu {
+void linear(std::byte *out, const std::byte *in, const std::byte *weight, const std::byte *bias,
+            llaisysDataType_t type, size_t batch_size, size_t in_features, size_t out_features) {
     // Y = X * W^T + b
     // X: [batch_size, in_features]
-    // W: [out_features, in_features] 
+    // W: [out_features, in_features]
     // Y: [batch_size, out_features]
-    
-    for (size_t b = 0; b < batch_size; b++) {
-        for (size_t o = 0; o < out_features; o++) {
-            float sum = 0.0f;
-            
-            // Compute dot product of input row with weight row
-            for (size_t i = 0; i < in_features; i++) {
-                float x_val, w_val;
-                if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-                    x_val = llaisys::utils::cast<float>(in[b * in_features + i]);
-                    w_val = llaisys::utils::cast<float>(weight[o * in_features + i]);
-                } else {
-                    x_val = in[b * in_features + i];
-                    w_val = weight[o * in_features + i];
-                }
-                sum += x_val * w_val;
-            }
-            
-            // Add bias if provided
-            if (bias != nullptr) {
-                if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-                    sum += llaisys::utils::cast<float>(bias[o]);
-                } else {
-                    sum += bias[o];
-                }
-            }
-            
-            // Store result
-            if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-                out[b * out_features + o] = llaisys::utils::cast<T>(sum);
-            } else {
-                out[b * out_features + o] = sum;
-            }
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+    case LLAISYS_DTYPE_BF16:
+    case LLAISYS_DTYPE_F16:
+        // Decode steps feed one (or a few) rows: stream the weight instead of packing it.
+        if (batch_size <= GEMV_MAX_ROWS) {
+            return gemv_nt(out, out_features, in, in_features, weight, in_features, bias, type,
+                           batch_size, out_features, in_features);
         }
+        return gemm_nt(out, out_features, in, in_features, weight, in_features, bias, type,
+                       batch_size, out_features, in_features);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
     }
 }
 
-namespace llaisys::ops::cpu {
-void linear(std::byte *out, const std::byte *in, const std::byte *weight, const std::byte *bias,
-            llaisysDataType_t type, size_t batch_size, size_t in_features, size_t out_features) {
+void linear_q8(std::byte *out, const std::byte *in, const int8_t *weight, const float *scales,
+               const std::byte *bias, llaisysDataType_t type, size_t batch_size, size_t in_features,
+               size_t out_features) {
+    if (batch_size <= GEMV_MAX_ROWS) {
+        return gemv_nt_q8(out, out_features, in, in_features, weight, in_features, scales, bias, type,
+                          batch_size, out_features, in_features);
+    }
+    return gemm_nt_q8(out, out_features, in, in_features, weight, in_features, scales, bias, type,
+                      batch_size, out_features, in_features);
+}
+
+void linear_q4(std::byte *out, const std::byte *in, const uint8_t *weight, const fp16_t *scales,
+               const uint8_t *zeros, size_t groups, const std::byte *bias, llaisysDataType_t type,
+               size_t batch_size, size_t in_features, size_t out_features) {
+    if (batch_size <= GEMV_MAX_ROWS) {
+        return gemv_nt_q4(out, out_features, in, in_features, weight, in_features / 2, scales, zeros, groups,
+                          bias, type, batch_size, out_features, in_features);
+    }
+    return gemm_nt_q4(out, out_features, in, in_features, weight, in_features / 2, scales, zeros, groups, bias,
+                      type, batch_size, out_features, in_features);
+}
+
+void linear_packed(std::byte *out, const std::byte *in, const std::byte *weight, const std::byte *bias,
+                   llaisysDataType_t type, size_t batch_size, size_t in_features, size_t out_features) {
+    if (batch_size <= GEMV_MAX_ROWS) {
+        return gemv_nt_packed(out, out_features, in, in_features, weight, bias, type,
+                              batch_size, out_features, in_features);
+    }
+    return gemm_nt_packed(out, out_features, in, in_features, weight, bias, type,
+                          batch_size, out_features, in_features);
+}
+
+void linear_topk(int64_t *idx, std::byte *val, size_t topk, const std::byte *in, const std::byte *weight,
+                 llaisysDataType_t type, size_t batch_size, size_t in_features, size_t out_features) {
+    gemv_topk_nt(idx, val, topk, in, in_features, weight, in_features, type, batch_size, out_features, in_features);
+}
+
+void linear_topk_q8(int64_t *idx, std::byte *val, size_t topk, const std::byte *in, const int8_t *weight,
+                    const float *scales, llaisysDataType_t type, size_t batch_size, size_t in_features,
+                    size_t out_features) {
+    gemv_topk_nt_q8(idx, val, topk, in, in_features, weight, in_features, scales, type, batch_size, out_features,
+                    in_features);
+}
+
+void linear_topk_q4(int64_t *idx, std::byte *val, size_t topk, const std::byte *in, const uint8_t *weight,
+                    const fp16_t *scales, const uint8_t *zeros, size_t groups, llaisysDataType_t type,
+                    size_t batch_size, size_t in_features, size_t out_features) {
+    gemv_topk_nt_q4(idx, val, topk, in, in_features, weight, in_features / 2, scales, zeros, groups, type,
+                    batch_size, out_features, in_features);
+}
+
+void linear_topk_packed(int64_t *idx, std::byte *val, size_t topk, const std::byte *in, const std::byte *weight,
+                        llaisysDataType_t type, size_t batch_size, size_t in_features, size_t out_features) {
+    gemv_topk_nt_packed(idx, val, topk, in, in_features, weight, type, batch_size, out_features, in_features);
+}
+
+void linear_packed_split(std::byte *const *outs, const std::byte *const *biases, const size_t *cols, size_t parts,
+                         const std::byte *in, const std::byte *weight, llaisysDataType_t type, size_t batch_size,
+                         size_t in_features, const int64_t *pos, const float *rope_table, size_t head_dim,
+                         size_t rope_parts) {
+    ASSERT(parts >= 1 && parts <= GEMM_MAX_PARTS, "Linear: too many output parts.");
+    ASSERT(rope_table == nullptr || rope_fusable(head_dim), "Linear: RoPE heads cannot be fused.");
+    GemmOutput out{};
+    size_t out_features = 0;
+    for (size_t s = 0; s < parts; s++) {
+        out_features += cols[s];
+        out.c[s] = outs[s];
+        out.ldc[s] = cols[s];
+        out.bias[s] = biases[s];
+        out.end[s] = out_features;
+        out.rope[s] = s < rope_parts;
+    }
+    out.parts = parts;
+    out.rope_table = rope_table;
+    out.pos = pos;
+    out.head_dim = head_dim;
+    if (batch_size <= GEMV_MAX_ROWS) {
+        return gemv_nt_packed_split(out, in, in_features, weight, type, batch_size, out_features, in_features);
+    }
+    return gemm_nt_packed_split(out, in, in_features, weight, type, batch_size, out_features, in_features);
+}
+
+bool rope_fusable(size_t head_dim) {
+    return head_dim > 0 && head_dim % 2 == 0 && GEMM_NC % head_dim == 0;
+}
+
+uint64_t packing() {
+    return gemm_packing();
+}
+
+size_t packed_bytes(llaisysDataType_t type, size_t out_features, size_t in_features) {
+    return gemm_packed_numel(out_features, in_features) * utils::dsize(type);
+}
+
+void prepack(std::byte *dst, const std::byte *weight, llaisysDataType_t type, size_t out_features,
+             size_t in_features) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+    case LLAISYS_DTYPE_BF16:
+    case LLAISYS_DTYPE_F16:
+        return gemm_prepack(dst, weight, type, out_features, in_features);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+
+void linear_swiglu(std::byte *out, const std::byte *in, const std::byte *gate_up, llaisysDataType_t type,
+                   size_t batch_size, size_t in_features, size_t out_features) {
+    if (batch_size <= GEMV_MAX_ROWS) {
+        return gemv_nt_packed_swiglu(out, out_features, in, in_features, gate_up, type,
+                                     batch_size, out_features, in_features);
+    }
+    return gemm_nt_packed_swiglu(out, out_features, in, in_features, gate_up, type,
+                                 batch_size, out_features, in_features);
+}
+
+void prepack_concat(std::byte *dst, const std::byte *const *weights, const size_t *rows, size_t parts,
+                    llaisysDataType_t type, size_t in_features) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+    case LLAISYS_DTYPE_BF16:
+    case LLAISYS_DTYPE_F16:
+        return gemm_prepack_concat(dst, weights, rows, parts, type, in_features);
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+
+uint64_t gate_up_packing() {
+    return gemm_gate_up_packing();
+}
+
+size_t gate_up_packed_bytes(llaisysDataType_t type, size_t out_features, size_t in_features) {
+    return gemm_gate_up_numel(out_features, in_features) * utils::dsize(type);
+}
+
+void prepack_gate_up(std::byte *dst, const std::byte *gate, const std::byte *up, llaisysDataType_t type,
+                     size_t out_features, size_t in_features) {
     switch (type) {
     case LLAISYS_DTYPE_F32:
-        return linear_(reinterpret_cast<float *>(out), reinterpret_cast<const float *>(in),
-                      reinterpret_cast<const float *>(weight), reinterpret_cast<const float *>(bias),
-                      batch_size, in_features, out_features);
     case LLAISYS_DTYPE_BF16:
-        return linear_(reinterpret_cast<llaisys::bf16_t *>(out), reinterpret_cast<const llaisys::bf16_t *>(in),
-                      reinterpret_cast<const llaisys::bf16_t *>(weight), reinterpret_cast<const llaisys::bf16_t *>(bias),
-                      batch_size, in_features, out_features);
     case LLAISYS_DTYPE_F16:
-        return linear_(reinterpret_cast<llaisys::fp16_t *>(out), reinterpret_cast<const llaisys::fp16_t *>(in),
-                      reinterpret_cast<const llaisys::fp16_t *>(weight), reinterpret_cast<const llaisys::fp16_t *>(bias),
-                      batch_size, in_features, out_features);
+        return gemm_prepack_gate_up(dst, gate, up, type, out_features, in_features);
     default:
         EXCEPTION_UNSUPPORTED_DATATYPE(type);
     }
 }
-} // namespace llaisys::ops::cpu
\ No newline at end of file
+} // namespace llaisys::ops::cpu
@@ -1,9 +1,71 @@
 #pragma once
 #include "llaisys.h"
 
+#include "../../../utils.hpp"
+
 #include <cstddef>
+#include <cstdint>
 
 namespace llaisys::ops::cpu {
 void linear(std::byte *out, const std::byte *in, const std::byte *weight, const std::byte *bias,
             llaisysDataType_t type, size_t batch_size, size_t in_features, size_t out_features);
-}
\ No newline at end of file
+
+// linear with an I8 weight and one F32 scale per output feature.
+void linear_q8(std::byte *out, const std::byte *in, const int8_t *weight, const float *scales,
+               const std::byte *bias, llaisysDataType_t type, size_t batch_size, size_t in_features,
+               size_t out_features);
+
+// linear with a Q4 weight of [out_features, in_features / 2] bytes and F16 scales and
+// optional U8 zero points of `groups` per output feature.
+void linear_q4(std::byte *out, const std::byte *in, const uint8_t *weight, const fp16_t *scales,
+               const uint8_t *zeros, size_t groups, const std::byte *bias, llaisysDataType_t type,
+               size_t batch_size, size_t in_features, size_t out_features);
+
+// linear with a weight laid out by prepack (see gemm_prepack).
+void linear_packed(std::byte *out, const std::byte *in, const std::byte *weight, const std::byte *bias,
+                   llaisysDataType_t type, size_t batch_size, size_t in_features, size_t out_features);
+
+// The topk largest outputs of linear (without a bias) for each input row, as indices and
+// values [batch_size, topk], without storing the outputs (see gemv_topk_nt); one
+// function per weight format, as above.
+void linear_topk(int64_t *idx, std::byte *val, size_t topk, const std::byte *in, const std::byte *weight,
+                 llaisysDataType_t type, size_t batch_size, size_t in_features, size_t out_features);
+void linear_topk_q8(int64_t *idx, std::byte *val, size_t topk, const std::byte *in, const int8_t *weight,
+                    const float *scales, llaisysDataType_t type, size_t batch_size, size_t in_features,
+                    size_t out_features);
+void linear_topk_q4(int64_t *idx, std::byte *val, size_t topk, const std::byte *in, const uint8_t *weight,
+                    const fp16_t *scales, const uint8_t *zeros, size_t groups, llaisysDataType_t type,
+                    size_t batch_size, size_t in_features, size_t out_features);
+void linear_topk_packed(int64_t *idx, std::byte *val, size_t topk, const std::byte *in, const std::byte *weight,
+                        llaisysDataType_t type, size_t batch_size, size_t in_features, size_t out_features);
+
+// The packing tag and byte size of a prepacked [out_features, in_features] weight, and
+// the packing itself.
+uint64_t packing();
+size_t packed_bytes(llaisysDataType_t type, size_t out_features, size_t in_features);
+void prepack(std::byte *dst, const std::byte *weight, llaisysDataType_t type, size_t out_features,
+             size_t in_features);
+
+// linear_packed with the output features split across `parts` (<= 3) contiguous outputs:
+// outs[s] is [batch_size, cols[s]] with optional biases[s], taking the next cols[s] features.
+// With a rope_table, the first rope_parts outputs are rotated as rope_cached would, by the
+// table rows at pos[i], before they are stored (see rope_fusable).
+void linear_packed_split(std::byte *const *outs, const std::byte *const *biases, const size_t *cols, size_t parts,
+                         const std::byte *in, const std::byte *weight, llaisysDataType_t type, size_t batch_size,
+                         size_t in_features, const int64_t *pos, const float *rope_table, size_t head_dim,
+                         size_t rope_parts);
+// Whether linear_packed_split can rotate heads of head_dim features (outputs of whole heads).
+bool rope_fusable(size_t head_dim);
+// prepack of the row-wise concatenation of `parts` [rows[s], in_features] weights.
+void prepack_concat(std::byte *dst, const std::byte *const *weights, const size_t *rows, size_t parts,
+                    llaisysDataType_t type, size_t in_features);
+
+// out = silu(in * gate^T) * (in * up^T) with gate and up packed by prepack_gate_up
+// (see gemm_prepack_gate_up), each [out_features, in_features].
+void linear_swiglu(std::byte *out, const std::byte *in, const std::byte *gate_up, llaisysDataType_t type,
+                   size_t batch_size, size_t in_features, size_t out_features);
+uint64_t gate_up_packing();
+size_t gate_up_packed_bytes(llaisysDataType_t type, size_t out_features, size_t in_features);
+void prepack_gate_up(std::byte *dst, const std::byte *gate, const std::byte *up, llaisysDataType_t type,
+                     size_t out_features, size_t in_features);
+} // namespace llaisys::ops::cpu
@@ -5,33 +5,92 @@
 
 #include "cpu/linear_cpu.hpp"
 
+#include "../rope/op.hpp"
+
 namespace llaisys::ops {
+namespace {
+// The checks of a linear weight in any of its formats against the input it multiplies.
+void check_weight(const tensor_t &weight, const tensor_t &in) {
+    // A prepacked weight has its own layout, checked against the kernels below.
+    const bool packed = weight->packing() != 0;
+    ASSERT(packed || weight->isContiguous(), "Linear: weight tensor must be contiguous.");
+
+    // A quantized weight is I8 with per-output-channel scales or Q4 with group scales;
+    // otherwise it matches the input.
+    const bool q4 = weight->dtype() == LLAISYS_DTYPE_Q4;
+    const bool quantized = q4 || weight->dtype() == LLAISYS_DTYPE_I8;
+    ASSERT(quantized || in->dtype() == weight->dtype(), "Linear: out, in, weight must have same dtype.");
+    ASSERT(in->shape().size() == 2 && weight->shape().size() == 2, "Linear: all tensors must be 2D.");
+
+    // Q4 packs two columns per byte.
+    const size_t in_features = in->shape()[1];
+    ASSERT(weight->shape()[1] * (q4 ? 2 : 1) == in_features, "Linear: weight shape mismatch.");
+    if (quantized) {
+        ASSERT(weight->scales() != nullptr, "Linear: quantized weight has no scales.");
+    }
+    if (quantized && !q4) {
+        const auto &scales = weight->scales();
+        ASSERT(scales->dtype() == LLAISYS_DTYPE_F32 && scales->shape()[1] == 1,
+               "Linear: I8 weight needs one F32 scale per output feature.");
+    }
+    if (q4) {
+        const auto &scales = weight->scales();
+        ASSERT(scales->dtype() == LLAISYS_DTYPE_F16, "Linear: Q4 weight needs F16 scales.");
+        ASSERT(in_features % (scales->shape()[1] * 32) == 0,
+               "Linear: Q4 groups must be a multiple of 32 columns.");
+    }
+
+    if (packed) {
+        ASSERT(weight->packing() == linear_packing(weight->deviceType()),
+               "Linear: weight was packed for another kernel; prepack it again.");
+    }
+}
+} // namespace
+
 void linear(tensor_t out, tensor_t in, tensor_t weight, tensor_t bias) {
     CHECK_SAME_DEVICE(out, in, weight);
     if (bias) CHECK_SAME_DEVICE(out, bias);
     
-    ASSERT(out->isContiguous() && in->isContiguous() && weight->isContiguous(), 
-           "Linear: out, in, weight tensors must be contiguous.");
+    ASSERT(out->isContiguous() && in->isContiguous(), "Linear: out, in, weight tensors must be contiguous.");
     if (bias) ASSERT(bias->isContiguous(), "Linear: bias tensor must be contiguous.");
-    
-    ASSERT(out->dtype() == in->dtype() && in->dtype() == weight->dtype(), 
-           "Linear: out, in, weight must have same dtype.");
+    check_weight(weight, in);
+    const bool packed = weight->packing() != 0;
+    const bool q4 = weight->dtype() == LLAISYS_DTYPE_Q4;
+    const bool quantized = q4 || weight->dtype() == LLAISYS_DTYPE_I8;
+    ASSERT(out->dtype() == in->dtype(), "Linear: out, in, weight must have same dtype.");
     if (bias) ASSERT(bias->dtype() == out->dtype(), "Linear: bias must have same dtype as out.");
     
-    ASSERT(in->shape().size() == 2 && weight->shape().size() == 2 && out->shape().size() == 2,
-           "Linear: all tensors must be 2D.");
+    ASSERT(out->shape().size() == 2, "Linear: all tensors must be 2D.");
     if (bias) ASSERT(bias->shape().size() == 1, "Linear: bias must be 1D.");
     
     size_t batch_size = in->shape()[0];
     size_t in_features = in->shape()[1];
     size_t out_features = weight->shape()[0];
     
-    ASSERT(weight->shape()[1] == in_features, "Linear: weight shape mismatch.");
     ASSERT(out->shape()[0] == batch_size && out->shape()[1] == out_features, 
            "Linear: output shape mismatch.");
     if (bias) ASSERT(bias->shape()[0] == out_features, "Linear: bias shape mismatch.");
 
     // always support cpu calculation
+    if (out->deviceType() == LLAISYS_DEVICE_CPU && packed) {
+        return cpu::linear_packed(out->data(), in->data(), weight->data(),
+                                  bias ? bias->data() : nullptr, out->dtype(),
+                                  batch_size, in_features, out_features);
+    }
+    if (out->deviceType() == LLAISYS_DEVICE_CPU && q4) {
+        const auto &zeros = weight->zeros();
+        return cpu::linear_q4(out->data(), in->data(), reinterpret_cast<const uint8_t *>(weight->data()),
+                              reinterpret_cast<const fp16_t *>(weight->scales()->data()),
+                              zeros ? reinterpret_cast<const uint8_t *>(zeros->data()) : nullptr,
+                              weight->scales()->shape()[1], bias ? bias->data() : nullptr, out->dtype(),
+                              batch_size, in_features, out_features);
+    }
+    if (out->deviceType() == LLAISYS_DEVICE_CPU && quantized) {
+        return cpu::linear_q8(out->data(), in->data(), reinterpret_cast<const int8_t *>(weight->data()),
+                              reinterpret_cast<const float *>(weight->scales()->data()),
+                              bias ? bias->data() : nullptr, out->dtype(),
+                              batch_size, in_features, out_features);
+    }
     if (out->deviceType() == LLAISYS_DEVICE_CPU) {
         return cpu::linear(out->data(), in->data(), weight->data(), 
                           bias ? bias->data() : nullptr, out->dtype(), 
@@ -54,4 +113,328 @@ void linear(tensor_t out, tensor_t in, tensor_t weight, tensor_t bias) {
         EXCEPTION_UNSUPPORTED_DEVICE;
     }
 }
+
+void linear_topk(tensor_t idx, tensor_t val, tensor_t in, tensor_t weight) {
+    CHECK_SAME_DEVICE(idx, val, in, weight);
+    ASSERT(idx->isContiguous() && val->isContiguous() && in->isContiguous(),
+           "LinearTopK: idx, val and in tensors must be contiguous.");
+    check_weight(weight, in);
+    ASSERT(idx->dtype() == LLAISYS_DTYPE_I64, "LinearTopK: idx must be int64 type.");
+    ASSERT(val->dtype() == in->dtype(), "LinearTopK: val must have same dtype as in.");
+    ASSERT(idx->shape().size() == 2 && val->shape().size() == 2, "LinearTopK: idx and val must be 2D.");
+    CHECK_SAME_SHAPE(idx->shape(), val->shape());
+
+    const size_t batch_size = in->shape()[0];
+    const size_t in_features = in->shape()[1];
+    const size_t out_features = weight->shape()[0];
+    const size_t topk = idx->shape()[1];
+    ASSERT(idx->shape()[0] == batch_size, "LinearTopK: idx and val need one row per input row.");
+    ASSERT(topk > 0 && topk <= out_features, "LinearTopK: k must be within [1, out_features].");
+
+    auto *idx_data = reinterpret_cast<int64_t *>(idx->data());
+    const bool q4 = weight->dtype() == LLAISYS_DTYPE_Q4;
+
+    // always support cpu calculation
+    if (in->deviceType() == LLAISYS_DEVICE_CPU && weight->packing() != 0) {
+        return cpu::linear_topk_packed(idx_data, val->data(), topk, in->data(), weight->data(), in->dtype(),
+                                       batch_size, in_features, out_features);
+    }
+    if (in->deviceType() == LLAISYS_DEVICE_CPU && q4) {
+        const auto &zeros = weight->zeros();
+        return cpu::linear_topk_q4(idx_data, val->data(), topk, in->data(),
+                                   reinterpret_cast<const uint8_t *>(weight->data()),
+                                   reinterpret_cast<const fp16_t *>(weight->scales()->data()),
+                                   zeros ? reinterpret_cast<const uint8_t *>(zeros->data()) : nullptr,
+                                   weight->scales()->shape()[1], in->dtype(), batch_size, in_features,
+                                   out_features);
+    }
+    if (in->deviceType() == LLAISYS_DEVICE_CPU && weight->dtype() == LLAISYS_DTYPE_I8) {
+        return cpu::linear_topk_q8(idx_data, val->data(), topk, in->data(),
+                                   reinterpret_cast<const int8_t *>(weight->data()),
+                                   reinterpret_cast<const float *>(weight->scales()->data()), in->dtype(),
+                                   batch_size, in_features, out_features);
+    }
+    if (in->deviceType() == LLAISYS_DEVICE_CPU) {
+        return cpu::linear_topk(idx_data, val->data(), topk, in->data(), weight->data(), in->dtype(), batch_size,
+                                in_features, out_features);
+    }
+
+    llaisys::core::context().setDevice(in->deviceType(), in->deviceId());
+
+    switch (in->deviceType()) {
+    case LLAISYS_DEVICE_CPU:
+        return cpu::linear_topk(idx_data, val->data(), topk, in->data(), weight->data(), in->dtype(), batch_size,
+                                in_features, out_features);
+#ifdef ENABLE_NVIDIA_API
+    case LLAISYS_DEVICE_NVIDIA:
+        TO_BE_IMPLEMENTED();
+        return;
+#endif
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+
+uint64_t linear_packing(llaisysDeviceType_t device_type) {
+    switch (device_type) {
+    case LLAISYS_DEVICE_CPU:
+        return cpu::packing();
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+
+size_t linear_packed_bytes(llaisysDeviceType_t device_type, llaisysDataType_t dtype, size_t out_features,
+                           size_t in_features) {
+    switch (device_type) {
+    case LLAISYS_DEVICE_CPU:
+        return cpu::packed_bytes(dtype, out_features, in_features);
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+
+tensor_t linear_prepack(tensor_t weight) {
+    ASSERT(weight->shape().size() == 2, "Linear: weight must be 2D.");
+    ASSERT(weight->isContiguous(), "Linear: only a contiguous weight can be packed.");
+    ASSERT(weight->dtype() == LLAISYS_DTYPE_F32 || weight->dtype() == LLAISYS_DTYPE_F16 ||
+               weight->dtype() == LLAISYS_DTYPE_BF16,
+           "Linear: only F32, F16 and BF16 weights can be packed.");
+
+    const size_t out_features = weight->shape()[0];
+    const size_t in_features = weight->shape()[1];
+    const auto device_type = weight->deviceType();
+    auto packed = Tensor::createPacked(weight->shape(), weight->dtype(), linear_packing(device_type),
+                                       linear_packed_bytes(device_type, weight->dtype(), out_features, in_features),
+                                       device_type, weight->deviceId());
+
+    switch (device_type) {
+    case LLAISYS_DEVICE_CPU:
+        cpu::prepack(packed->data(), weight->data(), weight->dtype(), out_features, in_features);
+        return packed;
+#ifdef ENABLE_NVIDIA_API
+    case LLAISYS_DEVICE_NVIDIA:
+        TO_BE_IMPLEMENTED();
+        return nullptr;
+#endif
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+
+void linear_qkv(tensor_t q, tensor_t k, tensor_t v, tensor_t in, tensor_t weight, tensor_t q_bias,
+                tensor_t k_bias, tensor_t v_bias, tensor_t pos_ids, tensor_t rope_table) {
+    CHECK_SAME_DEVICE(q, k, v, in, weight);
+    ASSERT(weight->packing() != 0 && weight->packing() == linear_packing(weight->deviceType()),
+           "LinearQKV: weight must come from linear_prepack_qkv on this host.");
+    ASSERT(in->isContiguous() && in->shape().size() == 2, "LinearQKV: in must be a contiguous 2D tensor.");
+    ASSERT(weight->shape()[1] == in->shape()[1], "LinearQKV: weight shape mismatch.");
+
+    const size_t batch_size = in->shape()[0];
+    if (batch_size == 0) {
+        // No rows to write, nor any to tell the outputs' widths by.
+        return;
+    }
+    const size_t in_features = in->shape()[1];
+    const tensor_t outs[3] = {q, k, v};
+    const tensor_t biases[3] = {q_bias, k_bias, v_bias};
+    std::byte *out_data[3];
+    const std::byte *bias_data[3];
+    size_t cols[3];
+    size_t out_features = 0;
+    for (size_t s = 0; s < 3; s++) {
+        const tensor_t &out = outs[s];
+        CHECK_SAME_DTYPE(out->dtype(), in->dtype(), weight->dtype());
+        ASSERT(out->isContiguous() && out->shape()[0] == batch_size,
+               "LinearQKV: outputs must be contiguous with one row per input row.");
+        cols[s] = out->numel() / batch_size;
+        out_data[s] = out->data();
+        bias_data[s] = nullptr;
+        if (biases[s]) {
+            CHECK_SAME_DEVICE(out, biases[s]);
+            CHECK_SAME_DTYPE(out->dtype(), biases[s]->dtype());
+            ASSERT(biases[s]->isContiguous() && biases[s]->numel() == cols[s], "LinearQKV: bias shape mismatch.");
+            bias_data[s] = biases[s]->data();
+        }
+        out_features += cols[s];
+    }
+    ASSERT(weight->shape()[0] == out_features, "LinearQKV: outputs do not match the weight's rows.");
+
+    const int64_t *pos = nullptr;
+    const float *table = nullptr;
+    size_t head_dim = 0;
+    if (rope_table) {
+        ASSERT(pos_ids, "LinearQKV: a RoPE table needs pos_ids.");
+        CHECK_SAME_DEVICE(in, pos_ids, rope_table);
+        ASSERT(pos_ids->dtype() == LLAISYS_DTYPE_I64 && rope_table->dtype() == LLAISYS_DTYPE_F32,
+               "LinearQKV: pos_ids must be int64 and the RoPE table F32.");
+        ASSERT(pos_ids->isContiguous() && pos_ids->numel() == batch_size && rope_table->isContiguous() &&
+                   rope_table->shape().size() == 2,
+               "LinearQKV: pos_ids must hold one position per row and the RoPE table must be 2D.");
+        head_dim = rope_table->shape()[1];
+        ASSERT(cols[0] % head_dim == 0 && cols[1] % head_dim == 0,
+               "LinearQKV: q and k must be whole heads of the RoPE table's width.");
+        pos = reinterpret_cast<const int64_t *>(pos_ids->data());
+        table = reinterpret_cast<const float *>(rope_table->data());
+    }
+
+    // always support cpu calculation
+    if (in->deviceType() == LLAISYS_DEVICE_CPU) {
+        if (table == nullptr || cpu::rope_fusable(head_dim)) {
+            if (table != nullptr) {
+                for (size_t i = 0; i < batch_size; i++) {
+                    ASSERT(pos[i] >= 0 && static_cast<size_t>(pos[i]) < rope_table->shape()[0],
+                           "LinearQKV: position outside the RoPE table.");
+                }
+            }
+            return cpu::linear_packed_split(out_data, bias_data, cols, 3, in->data(), weight->data(), in->dtype(),
+                                            batch_size, in_features, pos, table, head_dim, 2);
+        }
+        // Heads that straddle the kernels' blocks are rotated in place afterwards.
+        cpu::linear_packed_split(out_data, bias_data, cols, 3, in->data(), weight->data(), in->dtype(), batch_size,
+                                 in_features, nullptr, nullptr, 0, 0);
+        for (size_t s = 0; s < 2; s++) {
+            tensor_t heads = outs[s]->view({batch_size, cols[s] / head_dim, head_dim});
+            rope_cached(heads, heads, pos_ids, rope_table);
+        }
+        return;
+    }
+
+    llaisys::core::context().setDevice(in->deviceType(), in->deviceId());
+
+    switch (in->deviceType()) {
+    case LLAISYS_DEVICE_CPU:
+        return cpu::linear_packed_split(out_data, bias_data, cols, 3, in->data(), weight->data(), in->dtype(),
+                                        batch_size, in_features, pos, table, head_dim, 2);
+#ifdef ENABLE_NVIDIA_API
+    case LLAISYS_DEVICE_NVIDIA:
+        TO_BE_IMPLEMENTED();
+        return;
+#endif
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+
+tensor_t linear_prepack_qkv(tensor_t q, tensor_t k, tensor_t v) {
+    CHECK_SAME_DEVICE(q, k, v);
+    CHECK_SAME_DTYPE(q->dtype(), k->dtype(), v->dtype());
+    ASSERT(q->shape().size() == 2 && k->shape().size() == 2 && v->shape().size() == 2,
+           "Linear: q, k and v weights must be 2D.");
+    ASSERT(k->shape()[1] == q->shape()[1] && v->shape()[1] == q->shape()[1],
+           "Linear: q, k and v weights must share in_features.");
+    ASSERT(q->isContiguous() && k->isContiguous() && v->isContiguous(),
+           "Linear: only contiguous weights can be packed.");
+    ASSERT(q->dtype() == LLAISYS_DTYPE_F32 || q->dtype() == LLAISYS_DTYPE_F16 || q->dtype() == LLAISYS_DTYPE_BF16,
+           "Linear: only F32, F16 and BF16 weights can be packed.");
+
+    const size_t in_features = q->shape()[1];
+    const std::byte *weights[3] = {q->data(), k->data(), v->data()};
+    const size_t rows[3] = {q->shape()[0], k->shape()[0], v->shape()[0]};
+    const size_t out_features = rows[0] + rows[1] + rows[2];
+    const auto device_type = q->deviceType();
+    auto packed = Tensor::createPacked({out_features, in_features}, q->dtype(), linear_packing(device_type),
+                                       linear_packed_bytes(device_type, q->dtype(), out_features, in_features),
+                                       device_type, q->deviceId());
+
+    switch (device_type) {
+    case LLAISYS_DEVICE_CPU:
+        cpu::prepack_concat(packed->data(), weights, rows, 3, q->dtype(), in_features);
+        return packed;
+#ifdef ENABLE_NVIDIA_API
+    case LLAISYS_DEVICE_NVIDIA:
+        TO_BE_IMPLEMENTED();
+        return nullptr;
+#endif
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+
+void linear_swiglu(tensor_t out, tensor_t in, tensor_t gate_up) {
+    CHECK_SAME_DEVICE(out, in, gate_up);
+    ASSERT(out->isContiguous() && in->isContiguous(), "LinearSwiGLU: out and in tensors must be contiguous.");
+    ASSERT(gate_up->packing() != 0 && gate_up->packing() == linear_gate_up_packing(gate_up->deviceType()),
+           "LinearSwiGLU: gate_up must come from linear_prepack_gate_up on this host.");
+    CHECK_SAME_DTYPE(out->dtype(), in->dtype(), gate_up->dtype());
+    ASSERT(in->shape().size() == 2 && gate_up->shape().size() == 2 && out->shape().size() == 2,
+           "LinearSwiGLU: all tensors must be 2D.");
+
+    const size_t batch_size = in->shape()[0];
+    const size_t in_features = in->shape()[1];
+    const size_t di = gate_up->shape()[0] / 2;
+    ASSERT(gate_up->shape()[1] == in_features, "LinearSwiGLU: weight shape mismatch.");
+    ASSERT(out->shape()[0] == batch_size && out->shape()[1] == di, "LinearSwiGLU: output shape mismatch.");
+
+    // always support cpu calculation
+    if (out->deviceType() == LLAISYS_DEVICE_CPU) {
+        return cpu::linear_swiglu(out->data(), in->data(), gate_up->data(), out->dtype(), batch_size, in_features,
+                                  di);
+    }
+
+    llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
+
+    switch (out->deviceType()) {
+    case LLAISYS_DEVICE_CPU:
+        return cpu::linear_swiglu(out->data(), in->data(), gate_up->data(), out->dtype(), batch_size, in_features,
+                                  di);
+#ifdef ENABLE_NVIDIA_API
+    case LLAISYS_DEVICE_NVIDIA:
+        TO_BE_IMPLEMENTED();
+        return;
+#endif
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+
+uint64_t linear_gate_up_packing(llaisysDeviceType_t device_type) {
+    switch (device_type) {
+    case LLAISYS_DEVICE_CPU:
+        return cpu::gate_up_packing();
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+
+size_t linear_gate_up_packed_bytes(llaisysDeviceType_t device_type, llaisysDataType_t dtype, size_t di,
+                                   size_t in_features) {
+    switch (device_type) {
+    case LLAISYS_DEVICE_CPU:
+        return cpu::gate_up_packed_bytes(dtype, di, in_features);
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+
+tensor_t linear_prepack_gate_up(tensor_t gate, tensor_t up) {
+    CHECK_SAME_DEVICE(gate, up);
+    CHECK_SAME_DTYPE(gate->dtype(), up->dtype());
+    CHECK_SAME_SHAPE(gate->shape(), up->shape());
+    ASSERT(gate->shape().size() == 2, "Linear: gate and up weights must be 2D.");
+    ASSERT(gate->isContiguous() && up->isContiguous(), "Linear: only contiguous weights can be packed.");
+    ASSERT(gate->dtype() == LLAISYS_DTYPE_F32 || gate->dtype() == LLAISYS_DTYPE_F16 ||
+               gate->dtype() == LLAISYS_DTYPE_BF16,
+           "Linear: only F32, F16 and BF16 weights can be packed.");
+
+    const size_t di = gate->shape()[0];
+    const size_t in_features = gate->shape()[1];
+    const auto device_type = gate->deviceType();
+    auto packed = Tensor::createPacked({2 * di, in_features}, gate->dtype(), linear_gate_up_packing(device_type),
+                                       linear_gate_up_packed_bytes(device_type, gate->dtype(), di, in_features),
+                                       device_type, gate->deviceId());
+
+    switch (device_type) {
+    case LLAISYS_DEVICE_CPU:
+        cpu::prepack_gate_up(packed->data(), gate->data(), up->data(), gate->dtype(), di, in_features);
+        return packed;
+#ifdef ENABLE_NVIDIA_API
+    case LLAISYS_DEVICE_NVIDIA:
+        TO_BE_IMPLEMENTED();
+        return nullptr;
+#endif
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
 } // namespace llaisys::ops
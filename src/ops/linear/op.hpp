@@ -3,5 +3,48 @@
 #include "../../tensor/tensor.hpp"
 
 namespace llaisys::ops {
+// weight is [out_features, in_features] row-major, I8/Q4 with scales, or from linear_prepack.
 void linear(tensor_t out, tensor_t in, tensor_t weight, tensor_t bias);
+
+// The k largest outputs of linear(in, weight) without a bias for each input row, largest
+// first: indices into idx [n, k] (int64) and values into val [n, k] (in's dtype), k being
+// their width. Ties keep the lower index, so k = 1 is linear + argmax. The outputs are
+// never written to memory, which spares an LM head the whole row of logits; the weight
+// is streamed once per call, so it suits a few rows (a decode step) best.
+void linear_topk(tensor_t idx, tensor_t val, tensor_t in, tensor_t weight);
+
+// Lay an F32/F16/BF16 weight out once in the panel order of the linear kernels picked for
+// this host, so no call has to repack it. The result only feeds linear.
+tensor_t linear_prepack(tensor_t weight);
+// The packing tag linear_prepack gives its results on this device, and their size in
+// bytes; a packed blob saved elsewhere can be reused where the tag matches.
+uint64_t linear_packing(llaisysDeviceType_t device_type);
+size_t linear_packed_bytes(llaisysDeviceType_t device_type, llaisysDataType_t dtype, size_t out_features,
+                           size_t in_features);
+
+// The q, k and v projections of attention in one pass over `in`, from a weight made by
+// linear_prepack_qkv: q = in * Wq^T + q_bias, and likewise k and v, each written straight
+// into its own contiguous tensor of [n, features] elements (e.g. rows of a KV cache).
+// Biases are optional. Given pos_ids and a rope_table (see ops::rope_table), q and k come
+// out rotated as rope_cached would leave them, applied to the accumulators before they
+// are stored, so the projections are written once.
+void linear_qkv(tensor_t q, tensor_t k, tensor_t v, tensor_t in, tensor_t weight, tensor_t q_bias,
+                tensor_t k_bias, tensor_t v_bias, tensor_t pos_ids = nullptr, tensor_t rope_table = nullptr);
+// Pack [nq, in_features], [nk, in_features] and [nv, in_features] weights as one
+// [nq + nk + nv, in_features] weight with the linear_prepack layout, so linear takes it too.
+tensor_t linear_prepack_qkv(tensor_t q, tensor_t k, tensor_t v);
+
+// The gate and up projections of a SwiGLU MLP in one pass over the input:
+// out[m, di] = silu(in * gate^T) * (in * up^T), where gate_up comes from
+// linear_prepack_gate_up. Neither projection is written to memory; the activation is
+// applied to the float accumulators as they are stored.
+void linear_swiglu(tensor_t out, tensor_t in, tensor_t gate_up);
+
+// Pack two [di, in_features] F32/F16/BF16 weights together for linear_swiglu. The result
+// is shaped [2 * di, in_features] and only feeds linear_swiglu.
+tensor_t linear_prepack_gate_up(tensor_t gate, tensor_t up);
+// As linear_packing and linear_packed_bytes, for linear_prepack_gate_up.
+uint64_t linear_gate_up_packing(llaisysDeviceType_t device_type);
+size_t linear_gate_up_packed_bytes(llaisysDeviceType_t device_type, llaisysDataType_t dtype, size_t di,
+                                   size_t in_features);
 }
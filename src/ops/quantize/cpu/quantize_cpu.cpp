@@ -0,0 +1,114 @@
+#include "quantize_cpu.hpp"
+
+#include "../../../core/llaisys_core.hpp"
+#include "../../../utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+// Rows handed to a thread at a time.
+constexpr size_t ROW_GRAIN = 16;
+
+template <typename T>
+void quantize_rows(int8_t *q, float *scales, const T *in, size_t cols, size_t group, size_t begin, size_t end) {
+    const size_t groups = cols / group;
+    for (size_t i = begin; i < end; i++) {
+        for (size_t g = 0; g < groups; g++) {
+            const T *src = in + i * cols + g * group;
+            int8_t *dst = q + i * cols + g * group;
+            float amax = 0.0f;
+            for (size_t j = 0; j < group; j++) {
+                amax = std::max(amax, std::fabs(llaisys::utils::cast<float>(src[j])));
+            }
+            // An all-zero group keeps scale 0 and quantizes to zeros.
+            const float scale = amax / 127.0f;
+            const float inv = amax > 0.0f ? 127.0f / amax : 0.0f;
+            for (size_t j = 0; j < group; j++) {
+                float v = std::nearbyint(llaisys::utils::cast<float>(src[j]) * inv);
+                dst[j] = static_cast<int8_t>(std::clamp(v, -127.0f, 127.0f));
+            }
+            scales[i * groups + g] = scale;
+        }
+    }
+}
+
+template <typename T>
+void quantize_q4_rows(uint8_t *q, llaisys::fp16_t *scales, uint8_t *zeros, const T *in, size_t cols, size_t group,
+                      size_t begin, size_t end) {
+    const size_t groups = cols / group;
+    for (size_t i = begin; i < end; i++) {
+        for (size_t g = 0; g < groups; g++) {
+            const T *src = in + i * cols + g * group;
+            uint8_t *dst = q + (i * cols + g * group) / 2;
+            float lo = 0.0f;
+            float hi = 0.0f;
+            for (size_t j = 0; j < group; j++) {
+                float v = llaisys::utils::cast<float>(src[j]);
+                lo = std::min(lo, v);
+                hi = std::max(hi, v);
+            }
+            // Quantize against the scale as stored, so that dequantization sees the same one.
+            const auto stored = llaisys::utils::cast<llaisys::fp16_t>(zeros ? (hi - lo) / 15.0f
+                                                                            : std::max(hi, -lo) / 7.0f);
+            const float scale = llaisys::utils::cast<float>(stored);
+            const float inv = scale > 0.0f ? 1.0f / scale : 0.0f;
+            const float zero = zeros ? std::clamp(std::nearbyint(-lo * inv), 0.0f, 15.0f) : 8.0f;
+            for (size_t b = 0; b < group; b += 32) {
+                for (size_t j = 0; j < 16; j++) {
+                    float v0 = std::nearbyint(llaisys::utils::cast<float>(src[b + j]) * inv) + zero;
+                    float v1 = std::nearbyint(llaisys::utils::cast<float>(src[b + j + 16]) * inv) + zero;
+                    auto n0 = static_cast<uint8_t>(std::clamp(v0, 0.0f, 15.0f));
+                    auto n1 = static_cast<uint8_t>(std::clamp(v1, 0.0f, 15.0f));
+                    dst[b / 2 + j] = static_cast<uint8_t>(n0 | (n1 << 4));
+                }
+            }
+            scales[i * groups + g] = stored;
+            if (zeros) {
+                zeros[i * groups + g] = static_cast<uint8_t>(zero);
+            }
+        }
+    }
+}
+
+// Call fn(T{}) with the floating-point element type behind `type`.
+template <typename Fn>
+void with_float_type(llaisysDataType_t type, Fn &&fn) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return fn(float{});
+    case LLAISYS_DTYPE_BF16:
+        return fn(llaisys::bf16_t{});
+    case LLAISYS_DTYPE_F16:
+        return fn(llaisys::fp16_t{});
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+} // namespace
+
+namespace llaisys::ops::cpu {
+void quantize(std::byte *q, std::byte *scales, const std::byte *in, llaisysDataType_t type,
+              size_t rows, size_t cols, size_t group) {
+    with_float_type(type, [&](auto tag) {
+        using T = decltype(tag);
+        core::parallel_for(0, rows, ROW_GRAIN, [&](size_t begin, size_t end) {
+            quantize_rows(reinterpret_cast<int8_t *>(q), reinterpret_cast<float *>(scales),
+                          reinterpret_cast<const T *>(in), cols, group, begin, end);
+        });
+    });
+}
+
+void quantize_q4(std::byte *q, std::byte *scales, std::byte *zeros, const std::byte *in, llaisysDataType_t type,
+                 size_t rows, size_t cols, size_t group) {
+    with_float_type(type, [&](auto tag) {
+        using T = decltype(tag);
+        core::parallel_for(0, rows, ROW_GRAIN, [&](size_t begin, size_t end) {
+            quantize_q4_rows(reinterpret_cast<uint8_t *>(q), reinterpret_cast<fp16_t *>(scales),
+                             reinterpret_cast<uint8_t *>(zeros), reinterpret_cast<const T *>(in), cols, group,
+                             begin, end);
+        });
+    });
+}
+} // namespace llaisys::ops::cpu
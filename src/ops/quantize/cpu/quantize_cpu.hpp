@@ -0,0 +1,14 @@
+#pragma once
+#include "llaisys.h"
+
+#include <cstddef>
+
+namespace llaisys::ops::cpu {
+// q[i, j] = round(in[i, j] / s[i, j / group]) with s = max|in| / 127 over each group.
+void quantize(std::byte *q, std::byte *scales, const std::byte *in, llaisysDataType_t type,
+              size_t rows, size_t cols, size_t group);
+
+// Q4 with F16 scales, symmetric without `zeros`; see ops::quantize. `group` is a multiple of 32.
+void quantize_q4(std::byte *q, std::byte *scales, std::byte *zeros, const std::byte *in, llaisysDataType_t type,
+                 size_t rows, size_t cols, size_t group);
+}
@@ -0,0 +1,63 @@
+#include "op.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+#include "cpu/quantize_cpu.hpp"
+
+namespace llaisys::ops {
+void quantize(tensor_t out, tensor_t scales, tensor_t in, tensor_t zeros) {
+    CHECK_SAME_DEVICE(out, scales, in);
+    if (zeros) CHECK_SAME_DEVICE(out, zeros);
+    ASSERT(out->isContiguous() && scales->isContiguous() && in->isContiguous(),
+           "Quantize: all tensors must be contiguous.");
+    if (zeros) ASSERT(zeros->isContiguous(), "Quantize: zeros must be contiguous.");
+    ASSERT(in->ndim() == 2 && out->ndim() == 2 && scales->ndim() == 2, "Quantize: all tensors must be 2D.");
+
+    const size_t rows = in->shape()[0];
+    const size_t cols = in->shape()[1];
+    const size_t groups = scales->shape()[1];
+    ASSERT(scales->shape()[0] == rows && groups > 0 && cols % groups == 0,
+           "Quantize: scales shape mismatch.");
+    if (zeros) ASSERT(zeros->shape() == scales->shape(), "Quantize: zeros shape mismatch.");
+
+    switch (out->dtype()) {
+    case LLAISYS_DTYPE_I8:
+        CHECK_SAME_SHAPE(out->shape(), in->shape());
+        ASSERT(scales->dtype() == LLAISYS_DTYPE_F32, "Quantize: I8 scales must be F32.");
+        ASSERT(zeros == nullptr, "Quantize: I8 is symmetric and takes no zeros.");
+        break;
+    case LLAISYS_DTYPE_Q4:
+        ASSERT(out->shape()[0] == rows && out->shape()[1] * 2 == cols, "Quantize: Q4 out must be [rows, cols / 2].");
+        ASSERT(scales->dtype() == LLAISYS_DTYPE_F16, "Quantize: Q4 scales must be F16.");
+        ASSERT((cols / groups) % 32 == 0, "Quantize: Q4 groups must be a multiple of 32 columns.");
+        if (zeros) ASSERT(zeros->dtype() == LLAISYS_DTYPE_U8, "Quantize: zeros must be U8.");
+        break;
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(out->dtype());
+    }
+
+    // always support cpu calculation
+    if (out->deviceType() == LLAISYS_DEVICE_CPU) {
+        if (out->dtype() == LLAISYS_DTYPE_Q4) {
+            cpu::quantize_q4(out->data(), scales->data(), zeros ? zeros->data() : nullptr, in->data(), in->dtype(),
+                             rows, cols, cols / groups);
+        } else {
+            cpu::quantize(out->data(), scales->data(), in->data(), in->dtype(), rows, cols, cols / groups);
+        }
+        return out->setScales(scales, zeros);
+    }
+
+    llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
+
+    switch (out->deviceType()) {
+#ifdef ENABLE_NVIDIA_API
+    case LLAISYS_DEVICE_NVIDIA:
+        TO_BE_IMPLEMENTED();
+        return;
+#endif
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+} // namespace llaisys::ops
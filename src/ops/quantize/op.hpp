@@ -0,0 +1,17 @@
+#pragma once
+
+#include "../../tensor/tensor.hpp"
+
+namespace llaisys::ops {
+// Weight-only quantization of a [rows, cols] tensor, with one scale per group of
+// cols / groups columns in `scales` [rows, groups]. `scales` (and `zeros`) are
+// attached to `out`, which linear then accepts as the weight.
+//
+//   I8: `out` [rows, cols], F32 scales, symmetric: s = max|w| / 127, q = round(w / s),
+//       w ~ q * s. No zero points.
+//   Q4: `out` [rows, cols / 2] packed as described at LLAISYS_DTYPE_Q4, F16 scales,
+//       groups of a multiple of 32 columns. Without `zeros`, symmetric: s = max|w| / 7,
+//       q = round(w / s) + 8, w ~ (q - 8) * s. With U8 `zeros`, the group range
+//       [min(w, 0), max(w, 0)] is spread over 0..15: w ~ (q - z) * s.
+void quantize(tensor_t out, tensor_t scales, tensor_t in, tensor_t zeros = nullptr);
+}
@@ -0,0 +1,2 @@
+#define LLAISYS_CPU_ISA avx512
+#include "../rms_norm_kernel.hpp"
@@ -0,0 +1,52 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../../device/cpu/cpu_isa.hpp"
+
+#include <cstddef>
+
+namespace llaisys::ops::cpu {
+// out[b, :] = in[b, :] / sqrt(mean(in[b, :]^2) + eps) * weight for every row b.
+LLAISYS_CPU_DECLARE_VARIANTS(void rms_norm(std::byte *out, const std::byte *in, const std::byte *weight,
+                                           llaisysDataType_t type, size_t batch_size, size_t hidden_size,
+                                           float eps))
+} // namespace llaisys::ops::cpu
+
+#ifdef LLAISYS_CPU_ISA
+#include "../../../device/cpu/simd.hpp"
+
+namespace {
+using namespace llaisys::device::cpu::simd;
+
+template <typename T>
+void rms_norm_(T *out, const T *in, const T *weight, size_t batch_size, size_t hidden_size, float eps) {
+    for (size_t b = 0; b < batch_size; b++) {
+        const T *x = in + b * hidden_size;
+        T *y = out + b * hidden_size;
+
+        float sum_squares = dot(x, x, hidden_size);
+        float scale = 1.0f / sqrtf(sum_squares / hidden_size + eps);
+
+        const vfloat vscale = vset1(scale);
+        size_t i = 0;
+        for (; i + W <= hidden_size; i += W) {
+            vstore(y + i, vmul(vmul(vload(x + i), vscale), vload(weight + i)));
+        }
+        for (; i < hidden_size; i++) {
+            y[i] = from_float<T>(to_float(x[i]) * scale * to_float(weight[i]));
+        }
+    }
+}
+} // namespace
+
+namespace llaisys::ops::cpu::LLAISYS_CPU_ISA {
+void rms_norm(std::byte *out, const std::byte *in, const std::byte *weight,
+              llaisysDataType_t type, size_t batch_size, size_t hidden_size, float eps) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        rms_norm_(reinterpret_cast<T *>(out), reinterpret_cast<const T *>(in), reinterpret_cast<const T *>(weight),
+                  batch_size, hidden_size, eps);
+    });
+}
+} // namespace llaisys::ops::cpu::LLAISYS_CPU_ISA
+#endif // LLAISYS_CPU_ISA
@@ -1,75 +1,74 @@
 #include "rope_cpu.hpp"
 
+#define LLAISYS_CPU_ISA generic
+#include "rope_kernel.hpp"
+
+#include "../../../core/llaisys_core.hpp"
 #include "../../../utils.hpp"
 
 #include <cmath>
 #include <cstddef>
-#include <type_traits>
+#include <vector>
+
+namespace llaisys::ops::cpu {
+namespace {
+const auto rope_impl = LLAISYS_CPU_SELECT(rope);
+const auto rope_cached_impl = LLAISYS_CPU_SELECT(rope_cached);
+} // namespace
 
-template <typename T>
-void rope_(T *out, const T *in, const int64_t *pos_ids, 
-           size_t seq_len, size_t n_heads, size_t head_dim, float theta) {
-    // RoPE implementation
+void rope(std::byte *out, const std::byte *in, const std::byte *pos_ids, 
+          llaisysDataType_t type, size_t seq_len, size_t n_heads, size_t head_dim, float theta) {
     // Input shape: [seq_len, n_heads, head_dim]
     // pos_ids shape: [seq_len]
-    
-    size_t half_dim = head_dim / 2;
-    
-    for (size_t s = 0; s < seq_len; s++) {
-        int64_t pos = pos_ids[s];
-        
-        for (size_t h = 0; h < n_heads; h++) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+    case LLAISYS_DTYPE_BF16:
+    case LLAISYS_DTYPE_F16: {
+        const size_t row_bytes = n_heads * head_dim * utils::dsize(type);
+        const int64_t *pos = reinterpret_cast<const int64_t *>(pos_ids);
+        return core::parallel_for(0, seq_len, 1, [&](size_t begin, size_t end) {
+            thread_local std::vector<float> table;
+            table.resize(head_dim);
+            rope_impl(out + begin * row_bytes, in + begin * row_bytes, pos + begin, type,
+                      end - begin, n_heads, head_dim, theta, table.data());
+        });
+    }
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+
+void rope_table(float *table, size_t npos, size_t head_dim, float theta) {
+    const size_t half_dim = head_dim / 2;
+    // The same float expression as rope, so both paths rotate by identical angles.
+    core::parallel_for(0, npos, 64, [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; p++) {
+            float *cos_tab = table + p * head_dim;
+            float *sin_tab = cos_tab + half_dim;
             for (size_t d = 0; d < half_dim; d++) {
-                // Calculate frequency
-                float freq = pos / std::pow(theta, 2.0f * d / head_dim);
-                float cos_val = std::cos(freq);
-                float sin_val = std::sin(freq);
-                
-                // Get input values
-                size_t idx_a = s * n_heads * head_dim + h * head_dim + d;
-                size_t idx_b = s * n_heads * head_dim + h * head_dim + d + half_dim;
-                
-                float a_val, b_val;
-                if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-                    a_val = llaisys::utils::cast<float>(in[idx_a]);
-                    b_val = llaisys::utils::cast<float>(in[idx_b]);
-                } else {
-                    a_val = in[idx_a];
-                    b_val = in[idx_b];
-                }
-                
-                // Apply RoPE rotation
-                float new_a = a_val * cos_val - b_val * sin_val;
-                float new_b = b_val * cos_val + a_val * sin_val;
-                
-                // Store results
-                if constexpr (std::is_same_v<T, llaisys::bf16_t> || std::is_same_v<T, llaisys::fp16_t>) {
-                    out[idx_a] = llaisys::utils::cast<T>(new_a);
-                    out[idx_b] = llaisys::utils::cast<T>(new_b);
-                } else {
-                    out[idx_a] = new_a;
-                    out[idx_b] = new_b;
-                }
+                float freq = static_cast<int64_t>(p) / powf(theta, 2.0f * d / head_dim);
+                cos_tab[d] = cosf(freq);
+                sin_tab[d] = sinf(freq);
             }
         }
-    }
+    });
 }
 
-namespace llaisys::ops::cpu {
-void rope(std::byte *out, const std::byte *in, const std::byte *pos_ids, 
-          llaisysDataType_t type, size_t seq_len, size_t n_heads, size_t head_dim, float theta) {
+void rope_cached(std::byte *out, const std::byte *in, const std::byte *pos_ids, const float *table,
+                 llaisysDataType_t type, size_t seq_len, size_t n_heads, size_t head_dim) {
     switch (type) {
     case LLAISYS_DTYPE_F32:
-        return rope_(reinterpret_cast<float *>(out), reinterpret_cast<const float *>(in),
-                    reinterpret_cast<const int64_t *>(pos_ids), seq_len, n_heads, head_dim, theta);
     case LLAISYS_DTYPE_BF16:
-        return rope_(reinterpret_cast<llaisys::bf16_t *>(out), reinterpret_cast<const llaisys::bf16_t *>(in),
-                    reinterpret_cast<const int64_t *>(pos_ids), seq_len, n_heads, head_dim, theta);
-    case LLAISYS_DTYPE_F16:
-        return rope_(reinterpret_cast<llaisys::fp16_t *>(out), reinterpret_cast<const llaisys::fp16_t *>(in),
-                    reinterpret_cast<const int64_t *>(pos_ids), seq_len, n_heads, head_dim, theta);
+    case LLAISYS_DTYPE_F16: {
+        const size_t row_bytes = n_heads * head_dim * utils::dsize(type);
+        const int64_t *pos = reinterpret_cast<const int64_t *>(pos_ids);
+        return core::parallel_for(0, seq_len, 1, [&](size_t begin, size_t end) {
+            rope_cached_impl(out + begin * row_bytes, in + begin * row_bytes, pos + begin, table, type,
+                             end - begin, n_heads, head_dim);
+        });
+    }
     default:
         EXCEPTION_UNSUPPORTED_DATATYPE(type);
     }
 }
-} // namespace llaisys::ops::cpu
\ No newline at end of file
+} // namespace llaisys::ops::cpu
@@ -6,4 +6,10 @@
 namespace llaisys::ops::cpu {
 void rope(std::byte *out, const std::byte *in, const std::byte *pos_ids, 
           llaisysDataType_t type, size_t seq_len, size_t n_heads, size_t head_dim, float theta);
-}
\ No newline at end of file
+
+// Row p of the [npos, head_dim] table holds the cos of position p's angles
+// p / theta^(2d / head_dim), d < head_dim / 2, followed by their sin.
+void rope_table(float *table, size_t npos, size_t head_dim, float theta);
+void rope_cached(std::byte *out, const std::byte *in, const std::byte *pos_ids, const float *table,
+                 llaisysDataType_t type, size_t seq_len, size_t n_heads, size_t head_dim);
+} // namespace llaisys::ops::cpu
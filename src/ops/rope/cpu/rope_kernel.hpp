@@ -0,0 +1,101 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../../device/cpu/cpu_isa.hpp"
+
+#include <cstddef>
+
+namespace llaisys::ops::cpu {
+// Rotate the two halves of every head by pos / theta^(2d / head_dim).
+// `table` is caller-provided scratch of head_dim floats.
+LLAISYS_CPU_DECLARE_VARIANTS(void rope(std::byte *out, const std::byte *in, const int64_t *pos_ids,
+                                       llaisysDataType_t type, size_t seq_len, size_t n_heads, size_t head_dim,
+                                       float theta, float *table))
+// rope with the cos and sin of position p's angles read from row p of a [*, head_dim] table.
+LLAISYS_CPU_DECLARE_VARIANTS(void rope_cached(std::byte *out, const std::byte *in, const int64_t *pos_ids,
+                                              const float *table, llaisysDataType_t type, size_t seq_len,
+                                              size_t n_heads, size_t head_dim))
+} // namespace llaisys::ops::cpu
+
+#ifdef LLAISYS_CPU_ISA
+#include "../../../device/cpu/simd.hpp"
+
+namespace {
+using namespace llaisys::device::cpu::simd;
+
+// Rotate the n_heads heads of one position by the angles in cos_tab and sin_tab.
+template <typename T>
+void rotate_heads_(T *out, const T *in, const float *cos_tab, const float *sin_tab, size_t n_heads,
+                   size_t head_dim) {
+    const size_t half_dim = head_dim / 2;
+    for (size_t h = 0; h < n_heads; h++) {
+        const T *a = in + h * head_dim;
+        const T *b = a + half_dim;
+        T *oa = out + h * head_dim;
+        T *ob = oa + half_dim;
+        size_t d = 0;
+        for (; d + W <= half_dim; d += W) {
+            vfloat va = vload(a + d), vb = vload(b + d);
+            vfloat vc = vload(cos_tab + d), vs = vload(sin_tab + d);
+            vstore(oa + d, vsub(vmul(va, vc), vmul(vb, vs)));
+            vstore(ob + d, vfmadd(va, vs, vmul(vb, vc)));
+        }
+        for (; d < half_dim; d++) {
+            float va = to_float(a[d]), vb = to_float(b[d]);
+            oa[d] = from_float<T>(va * cos_tab[d] - vb * sin_tab[d]);
+            ob[d] = from_float<T>(vb * cos_tab[d] + va * sin_tab[d]);
+        }
+    }
+}
+
+template <typename T>
+void rope_(T *out, const T *in, const int64_t *pos_ids, size_t seq_len, size_t n_heads, size_t head_dim,
+           float theta, float *table) {
+    const size_t half_dim = head_dim / 2;
+    float *cos_tab = table;
+    float *sin_tab = table + half_dim;
+
+    for (size_t s = 0; s < seq_len; s++) {
+        // The angles only depend on the position, share them across heads.
+        int64_t pos = pos_ids[s];
+        for (size_t d = 0; d < half_dim; d++) {
+            float freq = pos / powf(theta, 2.0f * d / head_dim);
+            cos_tab[d] = cosf(freq);
+            sin_tab[d] = sinf(freq);
+        }
+        rotate_heads_(out + s * n_heads * head_dim, in + s * n_heads * head_dim, cos_tab, sin_tab, n_heads,
+                      head_dim);
+    }
+}
+
+template <typename T>
+void rope_cached_(T *out, const T *in, const int64_t *pos_ids, const float *table, size_t seq_len,
+                  size_t n_heads, size_t head_dim) {
+    for (size_t s = 0; s < seq_len; s++) {
+        const float *cos_tab = table + pos_ids[s] * head_dim;
+        rotate_heads_(out + s * n_heads * head_dim, in + s * n_heads * head_dim, cos_tab, cos_tab + head_dim / 2,
+                      n_heads, head_dim);
+    }
+}
+} // namespace
+
+namespace llaisys::ops::cpu::LLAISYS_CPU_ISA {
+void rope(std::byte *out, const std::byte *in, const int64_t *pos_ids, llaisysDataType_t type,
+          size_t seq_len, size_t n_heads, size_t head_dim, float theta, float *table) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        rope_(reinterpret_cast<T *>(out), reinterpret_cast<const T *>(in), pos_ids,
+              seq_len, n_heads, head_dim, theta, table);
+    });
+}
+
+void rope_cached(std::byte *out, const std::byte *in, const int64_t *pos_ids, const float *table,
+                 llaisysDataType_t type, size_t seq_len, size_t n_heads, size_t head_dim) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        rope_cached_(reinterpret_cast<T *>(out), reinterpret_cast<const T *>(in), pos_ids, table,
+                     seq_len, n_heads, head_dim);
+    });
+}
+} // namespace llaisys::ops::cpu::LLAISYS_CPU_ISA
+#endif // LLAISYS_CPU_ISA
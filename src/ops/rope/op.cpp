@@ -49,4 +49,80 @@ void rope(tensor_t out, tensor_t in, tensor_t pos_ids, float theta) {
         EXCEPTION_UNSUPPORTED_DEVICE;
     }
 }
+
+void rope_table(tensor_t table, float theta) {
+    ASSERT(table->isContiguous() && table->shape().size() == 2, "RoPE: table must be a contiguous 2D tensor.");
+    ASSERT(table->dtype() == LLAISYS_DTYPE_F32, "RoPE: table must be F32.");
+    ASSERT(table->shape()[1] % 2 == 0, "RoPE: head dimension must be even.");
+
+    // always support cpu calculation
+    if (table->deviceType() == LLAISYS_DEVICE_CPU) {
+        return cpu::rope_table(reinterpret_cast<float *>(table->data()), table->shape()[0], table->shape()[1],
+                               theta);
+    }
+
+    llaisys::core::context().setDevice(table->deviceType(), table->deviceId());
+
+    switch (table->deviceType()) {
+    case LLAISYS_DEVICE_CPU:
+        return cpu::rope_table(reinterpret_cast<float *>(table->data()), table->shape()[0], table->shape()[1],
+                               theta);
+#ifdef ENABLE_NVIDIA_API
+    case LLAISYS_DEVICE_NVIDIA:
+        TO_BE_IMPLEMENTED();
+        return;
+#endif
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+
+void rope_cached(tensor_t out, tensor_t in, tensor_t pos_ids, tensor_t table) {
+    CHECK_SAME_DEVICE(out, in, pos_ids, table);
+
+    ASSERT(out->isContiguous() && in->isContiguous() && pos_ids->isContiguous() && table->isContiguous(),
+           "RoPE: all tensors must be contiguous.");
+
+    ASSERT(out->dtype() == in->dtype(), "RoPE: out and in must have same dtype.");
+    ASSERT(pos_ids->dtype() == LLAISYS_DTYPE_I64, "RoPE: pos_ids must be int64 type.");
+    ASSERT(table->dtype() == LLAISYS_DTYPE_F32, "RoPE: table must be F32.");
+
+    ASSERT(in->shape().size() == 3 && pos_ids->shape().size() == 1 && table->shape().size() == 2,
+           "RoPE: in and out must be 3D, pos_ids must be 1D, table must be 2D.");
+    CHECK_SAME_SHAPE(out->shape(), in->shape());
+    ASSERT(pos_ids->shape()[0] == in->shape()[0], "RoPE: pos_ids length must match sequence length.");
+    ASSERT(table->shape()[1] == in->shape()[2], "RoPE: table rows must be one head long.");
+
+    size_t seq_len = in->shape()[0];
+    size_t n_heads = in->shape()[1];
+    size_t head_dim = in->shape()[2];
+
+    // always support cpu calculation
+    if (out->deviceType() == LLAISYS_DEVICE_CPU) {
+        const int64_t *pos = reinterpret_cast<const int64_t *>(pos_ids->data());
+        for (size_t s = 0; s < seq_len; s++) {
+            ASSERT(pos[s] >= 0 && static_cast<size_t>(pos[s]) < table->shape()[0],
+                   "RoPE: position outside the table.");
+        }
+        return cpu::rope_cached(out->data(), in->data(), pos_ids->data(),
+                                reinterpret_cast<const float *>(table->data()), out->dtype(), seq_len, n_heads,
+                                head_dim);
+    }
+
+    llaisys::core::context().setDevice(out->deviceType(), out->deviceId());
+
+    switch (out->deviceType()) {
+    case LLAISYS_DEVICE_CPU:
+        return cpu::rope_cached(out->data(), in->data(), pos_ids->data(),
+                                reinterpret_cast<const float *>(table->data()), out->dtype(), seq_len, n_heads,
+                                head_dim);
+#ifdef ENABLE_NVIDIA_API
+    case LLAISYS_DEVICE_NVIDIA:
+        TO_BE_IMPLEMENTED();
+        return;
+#endif
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
 } // namespace llaisys::ops
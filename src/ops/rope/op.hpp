@@ -4,4 +4,11 @@
 
 namespace llaisys::ops {
 void rope(tensor_t out, tensor_t in, tensor_t pos_ids, float theta);
+
+// Fill an F32 [npos, head_dim] table with the cos (first half of row p) and sin (second
+// half) of the angles of position p. Built once per model, it spares rope_cached every
+// transcendental call, and its rows can feed linear_qkv's RoPE epilogue.
+void rope_table(tensor_t table, float theta);
+// rope with the angles read from a rope_table holding every position in pos_ids.
+void rope_cached(tensor_t out, tensor_t in, tensor_t pos_ids, tensor_t table);
 }
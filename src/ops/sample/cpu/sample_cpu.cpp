@@ -0,0 +1,361 @@
+#include "sample_cpu.hpp"
+
+#define LLAISYS_CPU_ISA generic
+#include "sample_kernel.hpp"
+
+#include "../../../device/cpu/simd.hpp"
+#include "../../../utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+namespace llaisys::ops::cpu {
+namespace {
+const auto sample_block_max_impl = LLAISYS_CPU_SELECT(sample_block_max);
+const auto sample_exp_impl = LLAISYS_CPU_SELECT(sample_exp);
+const auto sample_sum_impl = LLAISYS_CPU_SELECT(sample_sum);
+
+// Logits per block maximum, which lets candidate searches pass over whole blocks, and
+// probabilities per vector sum when walking the cumulative distribution.
+constexpr size_t BLOCK = 64;
+// Best tokens a top-p draw without top-k looks for its nucleus among before it falls back
+// to a histogram of the whole vocabulary.
+constexpr size_t NUCLEUS_GUESS = 256;
+// Histogram buckets of that fallback: probabilities in (0, 1] keyed by their exponent and
+// top 4 mantissa bits, so that a bucket spans at most 1/16 of its values.
+constexpr size_t BUCKET_SHIFT = 19;
+constexpr size_t NUM_BUCKETS = (0x3f800000u >> BUCKET_SHIFT) + 1;
+
+struct Candidate {
+    float logit;
+    int64_t idx;
+};
+
+// Larger logit first; ties keep the lower index.
+bool before(const Candidate &a, const Candidate &b) {
+    return a.logit > b.logit || (a.logit == b.logit && a.idx < b.idx);
+}
+
+// Per-thread scratch, grown to the vocabulary by the first draw; later draws allocate
+// nothing. The logits themselves are never copied: penalized tokens are flagged in `seen`
+// and read from `penalized` instead.
+struct Scratch {
+    std::vector<float> block_max;
+    std::vector<float> floors;
+    std::vector<uint8_t> seen; // all zero between calls
+    std::vector<float> penalized;
+    std::vector<int64_t> distinct; // the penalized history, each token once
+    std::vector<float> probs;      // unnormalized softmax, per token
+    std::vector<Candidate> top;
+    std::vector<float> weights; // unnormalized softmax, per candidate
+    std::vector<double> buckets;
+};
+
+// The logits as floats, penalties applied.
+template <typename T>
+struct Logits {
+    const T *raw;
+    size_t voc;
+    const uint8_t *seen; // null without penalties
+    const float *penalized;
+
+    float operator[](size_t i) const {
+        return seen != nullptr && seen[i] ? penalized[i] : device::cpu::simd::to_float(raw[i]);
+    }
+};
+
+// A uniform draw in [0, 1) from the high 53 bits of SplitMix64 at `seed`. A pure function
+// of the seed, and consecutive seeds give independent draws, so callers step the seed by
+// one per token.
+double uniform(uint64_t seed) {
+    uint64_t z = seed + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z ^= z >> 31;
+    return static_cast<double>(z >> 11) * 0x1.0p-53;
+}
+
+// Once per distinct token of the history: the repetition penalty divides a positive logit
+// and multiplies a negative one (as Hugging Face does), then the presence penalty is
+// subtracted. The maxima of the blocks they are in are brought up to date.
+template <typename T>
+void penalize(Scratch &s, Logits<T> &logits, const int64_t *history, size_t nhistory, float repetition,
+              float presence) {
+    const size_t voc = logits.voc;
+    for (size_t i = 0; i < nhistory; i++) {
+        CHECK_ARGUMENT(history[i] >= 0 && static_cast<size_t>(history[i]) < voc,
+                       "Sample: history token out of vocabulary");
+    }
+    s.seen.resize(voc);
+    s.penalized.resize(voc);
+    for (size_t i = 0; i < nhistory; i++) {
+        const int64_t t = history[i];
+        if (s.seen[t]) {
+            continue;
+        }
+        s.seen[t] = 1;
+        const float l = device::cpu::simd::to_float(logits.raw[t]);
+        s.penalized[t] = (l > 0.0f ? l / repetition : l * repetition) - presence;
+        s.distinct.push_back(t);
+    }
+    logits.seen = s.seen.data();
+    logits.penalized = s.penalized.data();
+
+    std::sort(s.distinct.begin(), s.distinct.end());
+    for (size_t j = 0; j < s.distinct.size(); j++) {
+        const size_t b = s.distinct[j] / BLOCK;
+        if (j > 0 && static_cast<size_t>(s.distinct[j - 1]) / BLOCK == b) {
+            continue;
+        }
+        float m = -HUGE_VALF;
+        for (size_t i = b * BLOCK; i < std::min((b + 1) * BLOCK, voc); i++) {
+            m = std::max(m, logits[i]);
+        }
+        s.block_max[b] = m;
+    }
+}
+
+// Index of the first maximum: the first block holding the largest block maximum, walked.
+template <typename T>
+int64_t greedy(const Scratch &s, const Logits<T> &logits) {
+    const size_t b = std::max_element(s.block_max.begin(), s.block_max.end()) - s.block_max.begin();
+    for (size_t i = b * BLOCK; i < std::min((b + 1) * BLOCK, logits.voc); i++) {
+        if (logits[i] == s.block_max[b]) {
+            return static_cast<int64_t>(i);
+        }
+    }
+    return 0;
+}
+
+// The k largest logits into s.top, best first. The k-th largest block maximum is a floor:
+// k tokens reach it, so none below it can be among the best k, and only blocks whose
+// maximum reaches it are walked, through a heap that keeps the worst candidate on top.
+template <typename T>
+void select_top(Scratch &s, const Logits<T> &logits, size_t k) {
+    const size_t nblock = s.block_max.size();
+    float floor = -HUGE_VALF;
+    if (k < nblock) {
+        s.floors.assign(s.block_max.begin(), s.block_max.end());
+        std::nth_element(s.floors.begin(), s.floors.begin() + (k - 1), s.floors.end(), std::greater<float>());
+        floor = s.floors[k - 1];
+    }
+
+    auto &top = s.top;
+    top.clear();
+    for (size_t b = 0; b < nblock; b++) {
+        if (s.block_max[b] < floor) {
+            continue;
+        }
+        for (size_t i = b * BLOCK; i < std::min((b + 1) * BLOCK, logits.voc); i++) {
+            const float l = logits[i];
+            if (l < floor) {
+                continue;
+            }
+            if (top.size() < k) {
+                top.push_back({l, static_cast<int64_t>(i)});
+                std::push_heap(top.begin(), top.end(), before);
+            } else if (l > top.front().logit) {
+                // A later index only wins with a strictly larger logit.
+                std::pop_heap(top.begin(), top.end(), before);
+                top.back() = {l, static_cast<int64_t>(i)};
+                std::push_heap(top.begin(), top.end(), before);
+            }
+        }
+    }
+    std::sort_heap(top.begin(), top.end(), before);
+}
+
+size_t bucket(float prob) {
+    uint32_t bits;
+    std::memcpy(&bits, &prob, sizeof(bits));
+    return bits >> BUCKET_SHIFT;
+}
+
+// Top-p over a distribution too flat for its nucleus to be among a few best tokens. The
+// mass per bucket finds the bucket the cut falls in; every token of higher buckets is in
+// the nucleus, and only the cut bucket is sorted, into s.top, to find where in it the
+// nucleus ends. Tokens out of the nucleus then get a zero prob. Returns the nucleus mass.
+template <typename T>
+double cut_nucleus(Scratch &s, const Logits<T> &logits, double target) {
+    const size_t voc = logits.voc;
+    float *probs = s.probs.data();
+    s.buckets.assign(NUM_BUCKETS, 0.0);
+    for (size_t i = 0; i < voc; i++) {
+        s.buckets[bucket(probs[i])] += probs[i];
+    }
+    size_t cut = NUM_BUCKETS - 1;
+    double mass = 0.0; // of the buckets above `cut`
+    while (cut > 0 && mass + s.buckets[cut] < target) {
+        mass += s.buckets[cut--];
+    }
+
+    s.top.clear();
+    for (size_t i = 0; i < voc; i++) {
+        if (bucket(probs[i]) == cut) {
+            s.top.push_back({logits[i], static_cast<int64_t>(i)});
+        }
+    }
+    std::sort(s.top.begin(), s.top.end(), before);
+    size_t keep = 0;
+    while (keep < s.top.size() && (mass < target || mass == 0.0)) {
+        mass += probs[s.top[keep++].idx];
+    }
+    for (size_t i = keep; i < s.top.size(); i++) {
+        probs[s.top[i].idx] = 0.0f;
+    }
+    for (size_t i = 0; i < voc; i++) {
+        if (bucket(probs[i]) < cut) {
+            probs[i] = 0.0f;
+        }
+    }
+    return mass;
+}
+
+// Length of the shortest prefix of `weights` whose sum reaches `target`, or 0 if none does.
+size_t prefix_reaching(const float *weights, size_t n, double target) {
+    double cum = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        cum += weights[i];
+        if (cum >= target) {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// Index at which the running sum of `weights` first exceeds u times their total.
+size_t draw(const float *weights, size_t n, double u) {
+    double total = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        total += weights[i];
+    }
+    const double target = u * total;
+    double cum = 0.0;
+    size_t last = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (weights[i] > 0.0f) {
+            cum += weights[i];
+            last = i;
+            if (cum > target) {
+                return i;
+            }
+        }
+    }
+    return last;
+}
+
+// draw() over the whole vocabulary, whose probs sum to `total`: blocks are summed as
+// vectors, and only the block the draw lands in is walked token by token.
+size_t draw_all(const float *probs, size_t voc, double total, double u) {
+    const double target = u * total;
+    double cum = 0.0;
+    for (size_t b = 0; b < voc; b += BLOCK) {
+        const size_t end = std::min(b + BLOCK, voc);
+        const double block = sample_sum_impl(probs + b, end - b);
+        if (cum + block <= target) {
+            cum += block;
+            continue;
+        }
+        for (size_t i = b; i < end; i++) {
+            cum += probs[i];
+            if (cum > target) {
+                return i;
+            }
+        }
+    }
+    // Rounding left the target past the end: take the last token with any mass.
+    size_t i = voc - 1;
+    while (i > 0 && probs[i] <= 0.0f) {
+        i--;
+    }
+    return i;
+}
+
+template <typename T>
+int64_t sample_(Scratch &s, const Logits<T> &logits, llaisysDataType_t type, const LlaisysSamplingParams &params) {
+    const size_t voc = logits.voc;
+    const size_t top_k = params.top_k == 0 ? voc : std::min(params.top_k, voc);
+    if (params.temperature <= 0.0f || top_k == 1) {
+        return greedy(s, logits);
+    }
+    const float max_value = *std::max_element(s.block_max.begin(), s.block_max.end());
+    const float scale = 1.0f / params.temperature;
+    const double u = uniform(params.seed);
+    const bool nucleus = params.top_p < 1.0f;
+
+    // Top-k: only the best k logits are kept, and top-p cuts their sorted prefix.
+    if (top_k < voc) {
+        select_top(s, logits, top_k);
+        s.weights.resize(top_k);
+        double mass = 0.0;
+        for (size_t i = 0; i < top_k; i++) {
+            s.weights[i] = expf((s.top[i].logit - max_value) * scale);
+            mass += s.weights[i];
+        }
+        const size_t keep = nucleus ? prefix_reaching(s.weights.data(), top_k, params.top_p * mass) : top_k;
+        return s.top[draw(s.weights.data(), keep == 0 ? top_k : keep, u)].idx;
+    }
+
+    s.probs.resize(voc);
+    double mass = sample_exp_impl(s.probs.data(), reinterpret_cast<const std::byte *>(logits.raw), type, voc,
+                                  max_value, scale);
+    for (int64_t t : s.distinct) {
+        const float p = expf((logits.penalized[t] - max_value) * scale);
+        mass += p - s.probs[t];
+        s.probs[t] = p;
+    }
+    if (!nucleus) {
+        return static_cast<int64_t>(draw_all(s.probs.data(), voc, mass, u));
+    }
+
+    // Top-p alone: the nucleus of a peaked distribution is among the best few tokens; only
+    // a flat one needs the whole vocabulary.
+    const double target = params.top_p * mass;
+    const size_t guess = std::min(NUCLEUS_GUESS, voc);
+    select_top(s, logits, guess);
+    s.weights.resize(std::max(s.weights.size(), guess));
+    for (size_t i = 0; i < guess; i++) {
+        s.weights[i] = s.probs[s.top[i].idx];
+    }
+    const size_t keep = prefix_reaching(s.weights.data(), guess, target);
+    if (keep > 0) {
+        return s.top[draw(s.weights.data(), keep, u)].idx;
+    }
+    const double nucleus_mass = cut_nucleus(s, logits, target);
+    return static_cast<int64_t>(draw_all(s.probs.data(), voc, nucleus_mass, u));
+}
+} // namespace
+
+void sample(int64_t *idx, const std::byte *logits, llaisysDataType_t type, size_t voc, const int64_t *history,
+            size_t nhistory, const LlaisysSamplingParams &params) {
+    thread_local Scratch s;
+    auto run = [&](auto tag) {
+        using T = decltype(tag);
+        Logits<T> view{reinterpret_cast<const T *>(logits), voc, nullptr, nullptr};
+        s.block_max.resize((voc + BLOCK - 1) / BLOCK);
+        sample_block_max_impl(s.block_max.data(), logits, type, voc, BLOCK);
+        s.distinct.clear();
+        if (nhistory > 0 && (params.repetition_penalty != 1.0f || params.presence_penalty != 0.0f)) {
+            penalize(s, view, history, nhistory, params.repetition_penalty, params.presence_penalty);
+        }
+        *idx = sample_(s, view, type, params);
+        for (int64_t t : s.distinct) {
+            s.seen[t] = 0;
+        }
+    };
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+        return run(float{});
+    case LLAISYS_DTYPE_BF16:
+        return run(llaisys::bf16_t{});
+    case LLAISYS_DTYPE_F16:
+        return run(llaisys::fp16_t{});
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+} // namespace llaisys::ops::cpu
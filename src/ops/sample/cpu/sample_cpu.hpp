@@ -0,0 +1,10 @@
+#pragma once
+#include "llaisys.h"
+#include "llaisys/ops.h"
+
+#include <cstddef>
+
+namespace llaisys::ops::cpu {
+void sample(int64_t *idx, const std::byte *logits, llaisysDataType_t type, size_t voc, const int64_t *history,
+            size_t nhistory, const LlaisysSamplingParams &params);
+}
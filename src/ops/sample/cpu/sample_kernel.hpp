@@ -0,0 +1,101 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../../device/cpu/cpu_isa.hpp"
+
+#include <cstddef>
+
+namespace llaisys::ops::cpu {
+// block_max[b] = the largest of logits [b * block, (b + 1) * block), `numel` in all.
+LLAISYS_CPU_DECLARE_VARIANTS(void sample_block_max(float *block_max, const std::byte *logits, llaisysDataType_t type,
+                                                   size_t numel, size_t block))
+// out = exp((logits - shift) * scale) and return the sum of out: the unnormalized softmax
+// at temperature 1 / scale when shift is the largest logit.
+LLAISYS_CPU_DECLARE_VARIANTS(float sample_exp(float *out, const std::byte *logits, llaisysDataType_t type,
+                                              size_t numel, float shift, float scale))
+// Sum of `numel` floats.
+LLAISYS_CPU_DECLARE_VARIANTS(float sample_sum(const float *x, size_t numel))
+} // namespace llaisys::ops::cpu
+
+#ifdef LLAISYS_CPU_ISA
+#include "../../../device/cpu/simd.hpp"
+
+namespace {
+using namespace llaisys::device::cpu::simd;
+
+template <typename T>
+float max_(const T *x, size_t numel) {
+    float max_value = -HUGE_VALF;
+    size_t i = 0;
+    if (numel >= W) {
+        vfloat acc = vset1(-HUGE_VALF);
+        for (; i + W <= numel; i += W) {
+            acc = vmax(acc, vload(x + i));
+        }
+        max_value = vmaxval(acc);
+    }
+    for (; i < numel; i++) {
+        max_value = fmax2(max_value, to_float(x[i]));
+    }
+    return max_value;
+}
+
+template <typename T>
+void sample_block_max_(float *block_max, const T *logits, size_t numel, size_t block) {
+    for (size_t b = 0; b * block < numel; b++) {
+        block_max[b] = max_(logits + b * block, smin(block, numel - b * block));
+    }
+}
+
+template <typename T>
+float sample_exp_(float *out, const T *logits, size_t numel, float shift, float scale) {
+    const vfloat vshift = vset1(shift);
+    const vfloat vscale = vset1(scale);
+    vfloat acc = vzero();
+    size_t i = 0;
+    for (; i + W <= numel; i += W) {
+        vfloat e = vexp(vmul(vsub(vload(logits + i), vshift), vscale));
+        vstore(out + i, e);
+        acc = vadd(acc, e);
+    }
+    float sum = vsum(acc);
+    for (; i < numel; i++) {
+        out[i] = expf((to_float(logits[i]) - shift) * scale);
+        sum += out[i];
+    }
+    return sum;
+}
+} // namespace
+
+namespace llaisys::ops::cpu::LLAISYS_CPU_ISA {
+void sample_block_max(float *block_max, const std::byte *logits, llaisysDataType_t type, size_t numel, size_t block) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        sample_block_max_(block_max, reinterpret_cast<const T *>(logits), numel, block);
+    });
+}
+
+float sample_exp(float *out, const std::byte *logits, llaisysDataType_t type, size_t numel, float shift,
+                 float scale) {
+    float sum = 0.0f;
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        sum = sample_exp_(out, reinterpret_cast<const T *>(logits), numel, shift, scale);
+    });
+    return sum;
+}
+
+float sample_sum(const float *x, size_t numel) {
+    vfloat acc = vzero();
+    size_t i = 0;
+    for (; i + W <= numel; i += W) {
+        acc = vadd(acc, vload(x + i));
+    }
+    float sum = vsum(acc);
+    for (; i < numel; i++) {
+        sum += x[i];
+    }
+    return sum;
+}
+} // namespace llaisys::ops::cpu::LLAISYS_CPU_ISA
+#endif // LLAISYS_CPU_ISA
@@ -0,0 +1,50 @@
+#include "op.hpp"
+
+#include "../../core/llaisys_core.hpp"
+#include "../../utils.hpp"
+
+#include "cpu/sample_cpu.hpp"
+
+namespace llaisys::ops {
+void sample(tensor_t idx, tensor_t logits, tensor_t history, const LlaisysSamplingParams &params) {
+    sample(idx, logits, history, history ? history->numel() : 0, params);
+}
+
+void sample(tensor_t idx, tensor_t logits, tensor_t history, size_t nhistory, const LlaisysSamplingParams &params) {
+    CHECK_SAME_DEVICE(idx, logits);
+    ASSERT(logits->isContiguous() && logits->numel() > 0, "Sample: logits tensor must be contiguous and non-empty.");
+    ASSERT(idx->dtype() == LLAISYS_DTYPE_I64 && idx->numel() == 1, "Sample: idx must be a single int64.");
+    const int64_t *history_ids = nullptr;
+    if (history) {
+        CHECK_SAME_DEVICE(idx, history);
+        ASSERT(history->isContiguous(), "Sample: history tensor must be contiguous.");
+        ASSERT(history->dtype() == LLAISYS_DTYPE_I64, "Sample: history must be int64 type.");
+        ASSERT(nhistory <= history->numel(), "Sample: nhistory exceeds the history tensor.");
+        history_ids = reinterpret_cast<const int64_t *>(history->data());
+    } else {
+        nhistory = 0;
+    }
+    CHECK_ARGUMENT(params.repetition_penalty > 0.0f, "Sample: repetition_penalty must be positive");
+
+    // always support cpu calculation
+    if (logits->deviceType() == LLAISYS_DEVICE_CPU) {
+        return cpu::sample(reinterpret_cast<int64_t *>(idx->data()), logits->data(), logits->dtype(), logits->numel(),
+                           history_ids, nhistory, params);
+    }
+
+    llaisys::core::context().setDevice(logits->deviceType(), logits->deviceId());
+
+    switch (logits->deviceType()) {
+    case LLAISYS_DEVICE_CPU:
+        return cpu::sample(reinterpret_cast<int64_t *>(idx->data()), logits->data(), logits->dtype(), logits->numel(),
+                           history_ids, nhistory, params);
+#ifdef ENABLE_NVIDIA_API
+    case LLAISYS_DEVICE_NVIDIA:
+        TO_BE_IMPLEMENTED();
+        return;
+#endif
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
+} // namespace llaisys::ops
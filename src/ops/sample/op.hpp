@@ -0,0 +1,15 @@
+#pragma once
+
+#include "../../tensor/tensor.hpp"
+
+#include "llaisys/ops.h"
+
+namespace llaisys::ops {
+// Draw the next token from `logits` into `idx` (one int64). `history` (int64 token ids, may
+// be null) is what the repetition and presence penalties look at. The draw is a pure
+// function of params.seed; see LlaisysSamplingParams.
+void sample(tensor_t idx, tensor_t logits, tensor_t history, const LlaisysSamplingParams &params);
+// The same, looking only at the first `nhistory` ids of `history`, so a buffer that holds a
+// growing sequence can be passed whole instead of sliced on every draw.
+void sample(tensor_t idx, tensor_t logits, tensor_t history, size_t nhistory, const LlaisysSamplingParams &params);
+}
@@ -0,0 +1,2 @@
+#define LLAISYS_CPU_ISA avx512
+#include "../self_attention_kernel.hpp"
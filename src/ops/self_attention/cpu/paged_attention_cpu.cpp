@@ -0,0 +1,41 @@
+#include "paged_attention_cpu.hpp"
+
+// Variants are defined by self_attention_cpu.cpp and the per-ISA sources; only
+// their declarations are needed here.
+#include "self_attention_kernel.hpp"
+
+#include "../../../core/llaisys_core.hpp"
+#include "../../../utils.hpp"
+
+#include <vector>
+
+namespace llaisys::ops::cpu {
+namespace {
+const auto paged_attention_impl = LLAISYS_CPU_SELECT(self_attention);
+} // namespace
+
+void paged_self_attention(std::byte *attn_val, const std::byte *q, const std::byte *k_blocks,
+                          const std::byte *v_blocks, const int64_t *block_table, size_t block_size,
+                          llaisysDataType_t type, size_t seq_len, size_t kv_len, size_t n_heads,
+                          size_t n_kv_heads, size_t head_dim, float scale) {
+    switch (type) {
+    case LLAISYS_DTYPE_F32:
+    case LLAISYS_DTYPE_BF16:
+    case LLAISYS_DTYPE_F16: {
+        // Same tiling as the contiguous kernel; KV tiles are gathered through the block table.
+        const size_t scratch_size = attention_scratch_size(n_heads, n_kv_heads, head_dim);
+        return core::parallel_for(0, attention_tasks(seq_len, n_heads, n_kv_heads), 1,
+                                  [&](size_t begin, size_t end) {
+                                      thread_local std::vector<float> scratch;
+                                      scratch.resize(scratch_size);
+                                      paged_attention_impl(attn_val, q, k_blocks, v_blocks, block_table,
+                                                           block_size, type, seq_len, kv_len, n_heads,
+                                                           n_kv_heads, head_dim, scale, scratch.data(),
+                                                           begin, end);
+                                  });
+    }
+    default:
+        EXCEPTION_UNSUPPORTED_DATATYPE(type);
+    }
+}
+} // namespace llaisys::ops::cpu
@@ -0,0 +1,12 @@
+#pragma once
+#include "llaisys.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace llaisys::ops::cpu {
+void paged_self_attention(std::byte *attn_val, const std::byte *q, const std::byte *k_blocks,
+                          const std::byte *v_blocks, const int64_t *block_table, size_t block_size,
+                          llaisysDataType_t type, size_t seq_len, size_t kv_len, size_t n_heads,
+                          size_t n_kv_heads, size_t head_dim, float scale);
+}
@@ -0,0 +1,311 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../../device/cpu/cpu_isa.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace llaisys::ops::cpu {
+// (query, head) rows processed together against each KV tile. All query heads that
+// share a KV head are always in the same block, so K and V are read once per group.
+constexpr size_t ATTN_BLOCK_ROWS = 32;
+// Keys per KV tile; one tile of scores per row is all that is ever materialized.
+constexpr size_t ATTN_BLOCK_KV = 64;
+
+// Queries per block for a head group of `group` query heads.
+inline size_t attention_block_q(size_t group) {
+    return group >= ATTN_BLOCK_ROWS ? 1 : ATTN_BLOCK_ROWS / group;
+}
+
+// Independent work items: one per (KV head, query block), KV-head major.
+inline size_t attention_tasks(size_t seq_len, size_t n_heads, size_t n_kv_heads) {
+    size_t block_q = attention_block_q(n_heads / n_kv_heads);
+    return n_kv_heads * ((seq_len + block_q - 1) / block_q);
+}
+
+// Floats of scratch one call needs.
+inline size_t attention_scratch_size(size_t n_heads, size_t n_kv_heads, size_t head_dim) {
+    size_t group = n_heads / n_kv_heads;
+    size_t rows = attention_block_q(group) * group;
+    return rows * (2 * head_dim + ATTN_BLOCK_KV + 2) + 2 * ATTN_BLOCK_KV * head_dim;
+}
+
+// Causal softmax(Q K^T * scale) V with grouped KV heads for tasks [task_begin, task_end)
+// (see attention_tasks), computed tile by tile with an online softmax.
+// K and V are [kv_len, n_kv_heads, head_dim], or, given a block table, blocks of
+// [block_size, n_kv_heads, head_dim] where position j lives in block block_table[j / block_size].
+// `scratch` is caller-provided space of attention_scratch_size() floats.
+LLAISYS_CPU_DECLARE_VARIANTS(void self_attention(std::byte *attn_val, const std::byte *q, const std::byte *k,
+                                                 const std::byte *v, const int64_t *block_table, size_t block_size,
+                                                 llaisysDataType_t type, size_t seq_len, size_t kv_len,
+                                                 size_t n_heads, size_t n_kv_heads, size_t head_dim, float scale,
+                                                 float *scratch, size_t task_begin, size_t task_end))
+} // namespace llaisys::ops::cpu
+
+#ifdef LLAISYS_CPU_ISA
+#include "../../../device/cpu/simd.hpp"
+
+namespace {
+using namespace llaisys::device::cpu::simd;
+
+using llaisys::ops::cpu::ATTN_BLOCK_KV;
+
+// With a KV cache, query i sees keys 0 ..= i + (kv_len - seq_len).
+inline size_t visible_keys(size_t q_pos, size_t seq_len, size_t kv_len) {
+    size_t max_attend_pos = q_pos + (kv_len - seq_len);
+    if (max_attend_pos >= kv_len) {
+        max_attend_pos = kv_len - 1;
+    }
+    return max_attend_pos + 1;
+}
+
+inline void scale_row(float *x, float s, size_t n) {
+    const vfloat vs = vset1(s);
+    size_t i = 0;
+    for (; i + W <= n; i += W) {
+        vstore(x + i, vmul(vload(x + i), vs));
+    }
+    for (; i < n; i++) {
+        x[i] *= s;
+    }
+}
+
+// p[j] = exp(s[j] - max), returns sum(p).
+inline float exp_row(float *s, float max, size_t n) {
+    const vfloat vmax_s = vset1(max);
+    vfloat vsum_p = vzero();
+    size_t j = 0;
+    for (; j + W <= n; j += W) {
+        vfloat p = vexp(vsub(vload(s + j), vmax_s));
+        vstore(s + j, p);
+        vsum_p = vadd(vsum_p, p);
+    }
+    float sum = vsum(vsum_p);
+    for (; j < n; j++) {
+        s[j] = expf(s[j] - max);
+        sum += s[j];
+    }
+    return sum;
+}
+
+template <typename T>
+inline void widen_rows(float *dst, const T *src, size_t stride, size_t rows, size_t n) {
+    for (size_t r = 0; r < rows; r++) {
+        const T *s = src + r * stride;
+        float *d = dst + r * n;
+        size_t i = 0;
+        for (; i + W <= n; i += W) {
+            vstore(d + i, vload(s + i));
+        }
+        for (; i < n; i++) {
+            d[i] = to_float(s[i]);
+        }
+    }
+}
+
+// Widen keys or values [k0, k0 + n) of one KV head. Without a block table the rows
+// are `stride` apart; with one, each run of rows inside a block is contiguous.
+template <typename T>
+inline void widen_kv(float *dst, const T *base, size_t stride, const int64_t *block_table, size_t block_size,
+                     size_t k0, size_t n, size_t head_dim) {
+    if (block_table == nullptr) {
+        widen_rows(dst, base + k0 * stride, stride, n, head_dim);
+        return;
+    }
+    for (size_t j = k0; j < k0 + n;) {
+        const size_t offset = j % block_size;
+        const size_t rows = smin(block_size - offset, k0 + n - j);
+        const size_t block = static_cast<size_t>(block_table[j / block_size]);
+        widen_rows(dst + (j - k0) * head_dim, base + (block * block_size + offset) * stride, stride, rows, head_dim);
+        j += rows;
+    }
+}
+
+// S[r, j] = Q[r, :] . K[j, :] for R rows against n keys (S row stride ATTN_BLOCK_KV).
+// Four query rows share every load of a key row.
+inline void tile_scores(float *s, const float *qf, const float *kf, size_t rows, size_t n, size_t head_dim) {
+    size_t r = 0;
+    for (; r + 4 <= rows; r += 4) {
+        const float *q0 = qf + r * head_dim;
+        const float *q1 = q0 + head_dim;
+        const float *q2 = q1 + head_dim;
+        const float *q3 = q2 + head_dim;
+        for (size_t j = 0; j < n; j++) {
+            const float *kj = kf + j * head_dim;
+            vfloat a0 = vzero(), a1 = vzero(), a2 = vzero(), a3 = vzero();
+            size_t d = 0;
+            for (; d + W <= head_dim; d += W) {
+                vfloat kv = vload(kj + d);
+                a0 = vfmadd(vload(q0 + d), kv, a0);
+                a1 = vfmadd(vload(q1 + d), kv, a1);
+                a2 = vfmadd(vload(q2 + d), kv, a2);
+                a3 = vfmadd(vload(q3 + d), kv, a3);
+            }
+            float s0 = vsum(a0), s1 = vsum(a1), s2 = vsum(a2), s3 = vsum(a3);
+            for (; d < head_dim; d++) {
+                s0 += q0[d] * kj[d];
+                s1 += q1[d] * kj[d];
+                s2 += q2[d] * kj[d];
+                s3 += q3[d] * kj[d];
+            }
+            s[(r + 0) * ATTN_BLOCK_KV + j] = s0;
+            s[(r + 1) * ATTN_BLOCK_KV + j] = s1;
+            s[(r + 2) * ATTN_BLOCK_KV + j] = s2;
+            s[(r + 3) * ATTN_BLOCK_KV + j] = s3;
+        }
+    }
+    for (; r < rows; r++) {
+        for (size_t j = 0; j < n; j++) {
+            s[r * ATTN_BLOCK_KV + j] = dot(qf + r * head_dim, kf + j * head_dim, head_dim);
+        }
+    }
+}
+
+// O[r, :] += sum_j P[r, j] * V[j, :]. Every loaded slice of a V row feeds all rows.
+inline void tile_accumulate(float *acc, const float *p, const float *vf, size_t rows, size_t n, size_t head_dim) {
+    for (size_t j = 0; j < n; j++) {
+        const float *vj = vf + j * head_dim;
+        size_t d = 0;
+        for (; d + W <= head_dim; d += W) {
+            vfloat vv = vload(vj + d);
+            for (size_t r = 0; r < rows; r++) {
+                float *o = acc + r * head_dim + d;
+                vstore(o, vfmadd(vset1(p[r * ATTN_BLOCK_KV + j]), vv, vload(o)));
+            }
+        }
+        for (; d < head_dim; d++) {
+            for (size_t r = 0; r < rows; r++) {
+                acc[r * head_dim + d] += p[r * ATTN_BLOCK_KV + j] * vj[d];
+            }
+        }
+    }
+}
+
+// Queries [q0, q1) of every head in KV head `kv_head`'s group, as one block of
+// (q1 - q0) * group rows. Row i * group + g is query q0 + i of head kv_head * group + g,
+// which is also how those rows sit in Q. Each KV tile is widened once for the whole
+// block, scores never exceed one tile per row, and tiles past the last key any row
+// of the block can see are skipped outright.
+template <typename T>
+void attention_block(T *attn_val, const T *q, const T *k, const T *v, const int64_t *block_table,
+                     size_t block_size, size_t seq_len, size_t kv_len,
+                     size_t n_heads, size_t n_kv_heads, size_t head_dim, float scale, float *scratch,
+                     size_t kv_head, size_t q0, size_t q1) {
+    const size_t group = n_heads / n_kv_heads;
+    const size_t nq = q1 - q0;
+    const size_t rows = nq * group;
+    const size_t kv_stride = n_kv_heads * head_dim;
+    const T *k_base = k + kv_head * head_dim;
+    const T *v_base = v + kv_head * head_dim;
+
+    float *q_f = scratch;
+    float *acc = q_f + rows * head_dim;
+    float *scores = acc + rows * head_dim;
+    float *row_max = scores + rows * ATTN_BLOCK_KV;
+    float *row_sum = row_max + rows;
+    float *k_f = row_sum + rows;
+    float *v_f = k_f + ATTN_BLOCK_KV * head_dim;
+
+    // Fold the softmax scale into the widened queries.
+    for (size_t i = 0; i < nq; i++) {
+        const T *q_rows = q + ((q0 + i) * n_heads + kv_head * group) * head_dim;
+        widen_rows(q_f + i * group * head_dim, q_rows, head_dim, group, head_dim);
+    }
+    scale_row(q_f, scale, rows * head_dim);
+    for (size_t r = 0; r < rows * head_dim; r++) {
+        acc[r] = 0.0f;
+    }
+    for (size_t r = 0; r < rows; r++) {
+        row_max[r] = -HUGE_VALF;
+        row_sum[r] = 0.0f;
+    }
+
+    const size_t block_keys = visible_keys(q1 - 1, seq_len, kv_len);
+    for (size_t k0 = 0; k0 < block_keys; k0 += ATTN_BLOCK_KV) {
+        const size_t n = smin(ATTN_BLOCK_KV, block_keys - k0);
+        widen_kv(k_f, k_base, kv_stride, block_table, block_size, k0, n, head_dim);
+        widen_kv(v_f, v_base, kv_stride, block_table, block_size, k0, n, head_dim);
+        tile_scores(scores, q_f, k_f, rows, n, head_dim);
+
+        for (size_t r = 0; r < rows; r++) {
+            float *s = scores + r * ATTN_BLOCK_KV;
+            const size_t visible = visible_keys(q0 + r / group, seq_len, kv_len);
+            const size_t n_r = visible > k0 ? smin(n, visible - k0) : 0;
+            float tile_max = -HUGE_VALF;
+            for (size_t j = 0; j < n_r; j++) {
+                tile_max = fmax2(tile_max, s[j]);
+            }
+
+            // Rescale what has been accumulated so far to the new running max.
+            const float new_max = fmax2(row_max[r], tile_max);
+            if (new_max > row_max[r] && row_sum[r] > 0.0f) {
+                const float correction = expf(row_max[r] - new_max);
+                row_sum[r] *= correction;
+                scale_row(acc + r * head_dim, correction, head_dim);
+            }
+            row_max[r] = new_max;
+            row_sum[r] += n_r > 0 ? exp_row(s, new_max, n_r) : 0.0f;
+            // Masked keys of a partially visible tile contribute nothing.
+            for (size_t j = n_r; j < n; j++) {
+                s[j] = 0.0f;
+            }
+        }
+
+        tile_accumulate(acc, scores, v_f, rows, n, head_dim);
+    }
+
+    for (size_t i = 0; i < nq; i++) {
+        T *out_rows = attn_val + ((q0 + i) * n_heads + kv_head * group) * head_dim;
+        for (size_t g = 0; g < group; g++) {
+            const size_t r = i * group + g;
+            const float inv_sum = row_sum[r] > 0.0f ? 1.0f / row_sum[r] : 0.0f;
+            const float *acc_row = acc + r * head_dim;
+            T *out_row = out_rows + g * head_dim;
+            const vfloat vinv_sum = vset1(inv_sum);
+            size_t d = 0;
+            for (; d + W <= head_dim; d += W) {
+                vstore(out_row + d, vmul(vload(acc_row + d), vinv_sum));
+            }
+            for (; d < head_dim; d++) {
+                out_row[d] = from_float<T>(acc_row[d] * inv_sum);
+            }
+        }
+    }
+}
+
+template <typename T>
+void self_attention_(T *attn_val, const T *q, const T *k, const T *v,
+                     const int64_t *block_table, size_t block_size, size_t seq_len, size_t kv_len, size_t n_heads,
+                     size_t n_kv_heads, size_t head_dim, float scale, float *scratch,
+                     size_t task_begin, size_t task_end) {
+    // Q: [seq_len, n_heads, head_dim]
+    // K: [kv_len, n_kv_heads, head_dim]
+    // V: [kv_len, n_kv_heads, head_dim]
+    // Output: [seq_len, n_heads, head_dim]
+    const size_t block_q = llaisys::ops::cpu::attention_block_q(n_heads / n_kv_heads);
+    const size_t q_blocks = (seq_len + block_q - 1) / block_q;
+    for (size_t task = task_begin; task < task_end; task++) {
+        const size_t kv_head = task / q_blocks;
+        const size_t q0 = (task % q_blocks) * block_q;
+        attention_block(attn_val, q, k, v, block_table, block_size, seq_len, kv_len, n_heads, n_kv_heads,
+                        head_dim, scale, scratch, kv_head, q0, smin(q0 + block_q, seq_len));
+    }
+}
+} // namespace
+
+namespace llaisys::ops::cpu::LLAISYS_CPU_ISA {
+void self_attention(std::byte *attn_val, const std::byte *q, const std::byte *k, const std::byte *v,
+                    const int64_t *block_table, size_t block_size, llaisysDataType_t type, size_t seq_len,
+                    size_t kv_len, size_t n_heads, size_t n_kv_heads, size_t head_dim, float scale,
+                    float *scratch, size_t task_begin, size_t task_end) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        self_attention_(reinterpret_cast<T *>(attn_val), reinterpret_cast<const T *>(q),
+                        reinterpret_cast<const T *>(k), reinterpret_cast<const T *>(v), block_table, block_size,
+                        seq_len, kv_len, n_heads, n_kv_heads, head_dim, scale, scratch,
+                        task_begin, task_end);
+    });
+}
+} // namespace llaisys::ops::cpu::LLAISYS_CPU_ISA
+#endif // LLAISYS_CPU_ISA
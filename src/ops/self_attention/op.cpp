@@ -3,10 +3,16 @@
 #include "../../core/llaisys_core.hpp"
 #include "../../utils.hpp"
 
+#include "cpu/paged_attention_cpu.hpp"
 #include "cpu/self_attention_cpu.hpp"
 
 namespace llaisys::ops {
 void self_attention(tensor_t attn_val, tensor_t q, tensor_t k, tensor_t v, float scale) {
+    ASSERT(k->shape().size() == 3, "Self Attention: all tensors must be 3D.");
+    self_attention(attn_val, q, k, v, k->shape()[0], scale);
+}
+
+void self_attention(tensor_t attn_val, tensor_t q, tensor_t k, tensor_t v, size_t kv_len, float scale) {
     CHECK_SAME_DEVICE(attn_val, q, k, v);
     
     ASSERT(attn_val->isContiguous() && q->isContiguous() && k->isContiguous() && v->isContiguous(), 
@@ -21,13 +27,13 @@ void self_attention(tensor_t attn_val, tensor_t q, tensor_t k, tensor_t v, float
     size_t seq_len = q->shape()[0];
     size_t n_heads = q->shape()[1];
     size_t head_dim = q->shape()[2];
-    size_t kv_len = k->shape()[0];
     size_t n_kv_heads = k->shape()[1];
     
     ASSERT(k->shape()[2] == head_dim && v->shape()[2] == head_dim, 
            "Self Attention: head dimensions must match.");
-    ASSERT(v->shape()[0] == kv_len && v->shape()[1] == n_kv_heads,
+    ASSERT(v->shape()[0] == k->shape()[0] && v->shape()[1] == n_kv_heads,
            "Self Attention: k and v must have same sequence length and head count.");
+    ASSERT(kv_len > 0 && kv_len <= k->shape()[0], "Self Attention: kv_len out of range.");
     ASSERT(attn_val->shape()[0] == seq_len && attn_val->shape()[1] == n_heads && attn_val->shape()[2] == head_dim,
            "Self Attention: output shape mismatch.");
     ASSERT(n_heads % n_kv_heads == 0, "Self Attention: n_heads must be divisible by n_kv_heads.");
@@ -53,4 +59,60 @@ void self_attention(tensor_t attn_val, tensor_t q, tensor_t k, tensor_t v, float
         EXCEPTION_UNSUPPORTED_DEVICE;
     }
 }
+
+void paged_self_attention(tensor_t attn_val, tensor_t q, tensor_t k_blocks, tensor_t v_blocks,
+                          tensor_t block_table, size_t kv_len, float scale) {
+    CHECK_SAME_DEVICE(attn_val, q, k_blocks, v_blocks, block_table);
+
+    ASSERT(attn_val->isContiguous() && q->isContiguous() && k_blocks->isContiguous() && v_blocks->isContiguous()
+               && block_table->isContiguous(),
+           "Paged Self Attention: all tensors must be contiguous.");
+    ASSERT(attn_val->dtype() == q->dtype() && q->dtype() == k_blocks->dtype() && k_blocks->dtype() == v_blocks->dtype(),
+           "Paged Self Attention: attn_val, q, k_blocks and v_blocks must have same dtype.");
+    ASSERT(block_table->dtype() == LLAISYS_DTYPE_I64, "Paged Self Attention: block_table must be int64 type.");
+
+    ASSERT(q->shape().size() == 3 && attn_val->shape().size() == 3, "Paged Self Attention: q and attn_val must be 3D.");
+    ASSERT(k_blocks->shape().size() == 4 && v_blocks->shape().size() == 4,
+           "Paged Self Attention: k_blocks and v_blocks must be 4D.");
+    ASSERT(block_table->shape().size() == 1, "Paged Self Attention: block_table must be 1D.");
+    CHECK_SAME_SHAPE(q->shape(), attn_val->shape());
+    CHECK_SAME_SHAPE(k_blocks->shape(), v_blocks->shape());
+
+    size_t seq_len = q->shape()[0];
+    size_t n_heads = q->shape()[1];
+    size_t head_dim = q->shape()[2];
+    size_t num_blocks = k_blocks->shape()[0];
+    size_t block_size = k_blocks->shape()[1];
+    size_t n_kv_heads = k_blocks->shape()[2];
+
+    ASSERT(k_blocks->shape()[3] == head_dim, "Paged Self Attention: head dimensions must match.");
+    ASSERT(n_heads % n_kv_heads == 0, "Paged Self Attention: n_heads must be divisible by n_kv_heads.");
+    ASSERT(kv_len > 0, "Paged Self Attention: kv_len must be positive.");
+    ASSERT(block_table->shape()[0] * block_size >= kv_len,
+           "Paged Self Attention: block_table does not cover kv_len positions.");
+
+    // always support cpu calculation
+    if (attn_val->deviceType() == LLAISYS_DEVICE_CPU) {
+        const int64_t *table = reinterpret_cast<const int64_t *>(block_table->data());
+        for (size_t i = 0; i < (kv_len + block_size - 1) / block_size; i++) {
+            ASSERT(table[i] >= 0 && static_cast<size_t>(table[i]) < num_blocks,
+                   "Paged Self Attention: block index out of range.");
+        }
+        return cpu::paged_self_attention(attn_val->data(), q->data(), k_blocks->data(), v_blocks->data(), table,
+                                         block_size, attn_val->dtype(), seq_len, kv_len, n_heads, n_kv_heads,
+                                         head_dim, scale);
+    }
+
+    llaisys::core::context().setDevice(attn_val->deviceType(), attn_val->deviceId());
+
+    switch (attn_val->deviceType()) {
+#ifdef ENABLE_NVIDIA_API
+    case LLAISYS_DEVICE_NVIDIA:
+        TO_BE_IMPLEMENTED();
+        return;
+#endif
+    default:
+        EXCEPTION_UNSUPPORTED_DEVICE;
+    }
+}
 } // namespace llaisys::ops
@@ -4,4 +4,11 @@
 
 namespace llaisys::ops {
 void self_attention(tensor_t attn_val, tensor_t q, tensor_t k, tensor_t v, float scale);
+// Self attention over only the first kv_len rows of k and v, e.g. the filled part of a
+// preallocated KV cache, so that the caller needs no slice per step.
+void self_attention(tensor_t attn_val, tensor_t q, tensor_t k, tensor_t v, size_t kv_len, float scale);
+// Self attention over the first kv_len positions of a paged KV cache. k_blocks and v_blocks
+// are [num_blocks, block_size, nkvh, dh]; position j lives in block block_table[j / block_size].
+void paged_self_attention(tensor_t attn_val, tensor_t q, tensor_t k_blocks, tensor_t v_blocks,
+                          tensor_t block_table, size_t kv_len, float scale);
 }
@@ -0,0 +1,45 @@
+#pragma once
+#include "llaisys.h"
+
+#include "../../../device/cpu/cpu_isa.hpp"
+
+#include <cstddef>
+
+namespace llaisys::ops::cpu {
+// out = up * gate / (1 + exp(-gate)) over `numel` contiguous elements.
+LLAISYS_CPU_DECLARE_VARIANTS(void swiglu(std::byte *out, const std::byte *gate, const std::byte *up,
+                                         llaisysDataType_t type, size_t numel))
+} // namespace llaisys::ops::cpu
+
+#ifdef LLAISYS_CPU_ISA
+#include "../../../device/cpu/simd.hpp"
+
+namespace {
+using namespace llaisys::device::cpu::simd;
+
+template <typename T>
+void swiglu_(T *out, const T *gate, const T *up, size_t numel) {
+    const vfloat one = vset1(1.0f);
+    const vfloat zero = vzero();
+    size_t i = 0;
+    for (; i + W <= numel; i += W) {
+        vfloat g = vload(gate + i);
+        vfloat silu = vdiv(g, vadd(one, vexp(vsub(zero, g))));
+        vstore(out + i, vmul(vload(up + i), silu));
+    }
+    for (; i < numel; i++) {
+        float g = to_float(gate[i]);
+        out[i] = from_float<T>(to_float(up[i]) * (g / (1.0f + expf(-g))));
+    }
+}
+} // namespace
+
+namespace llaisys::ops::cpu::LLAISYS_CPU_ISA {
+void swiglu(std::byte *out, const std::byte *gate, const std::byte *up, llaisysDataType_t type, size_t numel) {
+    with_dtype(type, [&](auto tag) {
+        using T = decltype(tag);
+        swiglu_(reinterpret_cast<T *>(out), reinterpret_cast<const T *>(gate), reinterpret_cast<const T *>(up), numel);
+    });
+}
+} // namespace llaisys::ops::cpu::LLAISYS_CPU_ISA
+#endif // LLAISYS_CPU_ISA
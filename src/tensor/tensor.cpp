@@ -38,6 +38,52 @@ tensor_t Tensor::create(const std::vector<size_t> &shape,
   }
 }
 
+tensor_t Tensor::create(const std::vector<size_t> &shape,
+                        llaisysDataType_t dtype, core::storage_t storage,
+                        size_t offset) {
+  size_t ndim_ = shape.size();
+  std::vector<ptrdiff_t> strides(ndim_);
+  size_t stride = 1;
+  for (size_t i = 1; i <= ndim_; i++) {
+    strides[ndim_ - i] = stride;
+    stride *= shape[ndim_ - i];
+  }
+  CHECK_ARGUMENT(storage != nullptr, "storage must not be null");
+  CHECK_ARGUMENT(offset + stride * utils::dsize(dtype) <= storage->size(),
+                 "tensor exceeds its storage");
+  TensorMeta meta{dtype, shape, strides};
+  return std::shared_ptr<Tensor>(new Tensor(meta, std::move(storage), offset));
+}
+
+tensor_t Tensor::createPacked(const std::vector<size_t> &shape,
+                              llaisysDataType_t dtype, uint64_t packing,
+                              size_t bytes, llaisysDeviceType_t device_type,
+                              int device) {
+  CHECK_ARGUMENT(packing != 0, "packing must be nonzero");
+  core::storage_t storage;
+  if (device_type == LLAISYS_DEVICE_CPU &&
+      core::context().runtime().deviceType() != LLAISYS_DEVICE_CPU) {
+    storage = core::context().runtime().allocateHostStorage(bytes);
+  } else {
+    core::context().setDevice(device_type, device);
+    storage = core::context().runtime().allocateDeviceStorage(bytes);
+  }
+  return createPacked(shape, dtype, packing, bytes, std::move(storage));
+}
+
+tensor_t Tensor::createPacked(const std::vector<size_t> &shape,
+                              llaisysDataType_t dtype, uint64_t packing,
+                              size_t bytes, core::storage_t storage,
+                              size_t offset) {
+  CHECK_ARGUMENT(packing != 0, "packing must be nonzero");
+  CHECK_ARGUMENT(storage != nullptr, "storage must not be null");
+  CHECK_ARGUMENT(offset + bytes <= storage->size(), "tensor exceeds its storage");
+  // Strides are kept row-major for info(); nothing reads through them.
+  auto tensor = create(shape, dtype, std::move(storage), offset);
+  tensor->_packing = packing;
+  return tensor;
+}
+
 std::byte *Tensor::data() { return _storage->memory() + _offset; }
 
 const std::byte *Tensor::data() const { return _storage->memory() + _offset; }
@@ -63,6 +109,36 @@ size_t Tensor::numel() const {
 
 size_t Tensor::elementSize() const { return utils::dsize(_meta.dtype); }
 
+const tensor_t &Tensor::scales() const { return _scales; }
+
+const tensor_t &Tensor::zeros() const { return _zeros; }
+
+void Tensor::setScales(tensor_t scales, tensor_t zeros) {
+  CHECK_ARGUMENT(scales || !zeros, "zero points need scales");
+  if (scales) {
+    CHECK_ARGUMENT(ndim() == 2 && scales->ndim() == 2, "scales must be 2D, on a 2D tensor");
+    CHECK_ARGUMENT(scales->dtype() == LLAISYS_DTYPE_F32 || scales->dtype() == LLAISYS_DTYPE_F16,
+                   "scales must be F32 or F16");
+    CHECK_ARGUMENT(scales->deviceType() == deviceType() && scales->deviceId() == deviceId(),
+                   "scales must be on the device of the tensor");
+    CHECK_ARGUMENT(scales->isContiguous(), "scales must be contiguous");
+    // Q4 packs two columns per element.
+    const size_t cols = shape()[1] * (dtype() == LLAISYS_DTYPE_Q4 ? 2 : 1);
+    const size_t groups = scales->shape()[1];
+    CHECK_ARGUMENT(scales->shape()[0] == shape()[0] && groups > 0 && cols % groups == 0,
+                   "scales shape does not match the tensor");
+  }
+  if (zeros) {
+    CHECK_ARGUMENT(zeros->dtype() == LLAISYS_DTYPE_U8, "zero points must be U8");
+    CHECK_ARGUMENT(zeros->shape() == scales->shape(), "zero points must match the scales");
+    CHECK_ARGUMENT(zeros->deviceType() == deviceType() && zeros->deviceId() == deviceId(),
+                   "zero points must be on the device of the tensor");
+    CHECK_ARGUMENT(zeros->isContiguous(), "zero points must be contiguous");
+  }
+  _scales = std::move(scales);
+  _zeros = std::move(zeros);
+}
+
 std::string Tensor::info() const {
   std::stringstream ss;
 
@@ -76,6 +152,9 @@ std::string Tensor::info() const {
     ss << s << " ";
   }
   ss << "] dtype=" << this->dtype();
+  if (_packing != 0) {
+    ss << " packing=" << _packing;
+  }
 
   return ss.str();
 }
@@ -164,6 +243,9 @@ void Tensor::debug() const {
 }
 
 bool Tensor::isContiguous() const {
+  if (_packing != 0) {
+    return false;
+  }
   if (this->ndim() == 0) {
     return true;
   }
@@ -181,7 +263,10 @@ bool Tensor::isContiguous() const {
   return true;
 }
 
+uint64_t Tensor::packing() const { return _packing; }
+
 tensor_t Tensor::permute(const std::vector<size_t> &order) const {
+  CHECK_ARGUMENT(_packing == 0, "cannot permute a packed tensor");
   if (order.size() != this->ndim()) {
     CHECK_ARGUMENT(false,
                    "permute order must have the same size as tensor ndim");
@@ -223,6 +308,7 @@ tensor_t Tensor::view(const std::vector<size_t> &shape) const {
 }
 
 tensor_t Tensor::slice(size_t dim, size_t start, size_t end) const {
+  CHECK_ARGUMENT(_packing == 0, "cannot slice a packed tensor");
   if (dim >= this->ndim()) {
     CHECK_ARGUMENT(false, "dimension out of range");
   }
@@ -240,34 +326,44 @@ tensor_t Tensor::slice(size_t dim, size_t start, size_t end) const {
   return std::shared_ptr<Tensor>(new Tensor(new_meta, _storage, new_offset));
 }
 
-void Tensor::load(const void *src_) {
-  std::cerr << "[DEBUG] Entering load function" << std::endl;
-
-  // Set device context
-  core::context().setDevice(this->deviceType(), this->deviceId());
-  std::cerr << "[DEBUG] Device context set" << std::endl;
-
-  // Calculate copy size
-  size_t copy_size = this->numel() * this->elementSize();
-  std::cerr << "[DEBUG] Copy size calculated: " << copy_size << std::endl;
+void Tensor::reslice(const Tensor &base, size_t dim, size_t start) {
+  CHECK_ARGUMENT(_packing == 0, "cannot slice a packed tensor");
+  CHECK_ARGUMENT(_storage == base._storage, "reslice needs a view of the base tensor");
+  if (dim >= this->ndim() || dim >= base.ndim()) {
+    CHECK_ARGUMENT(false, "dimension out of range");
+  }
+  if (start + this->shape()[dim] > base.shape()[dim]) {
+    CHECK_ARGUMENT(false, "slice indices out of range");
+  }
+  _offset = base._offset + start * base.strides()[dim] * base.elementSize();
+}
 
-  // Determine copy kind
-  llaisysMemcpyKind_t copy_kind;
-  if (this->deviceType() == LLAISYS_DEVICE_CPU) {
-    copy_kind = LLAISYS_MEMCPY_H2H;
-  } else {
-    copy_kind = LLAISYS_MEMCPY_H2D;
+void Tensor::reslice(const Tensor &base, size_t dim, size_t start, size_t end) {
+  CHECK_ARGUMENT(_packing == 0, "cannot slice a packed tensor");
+  CHECK_ARGUMENT(_storage == base._storage, "reslice needs a view of the base tensor");
+  if (dim >= this->ndim() || dim >= base.ndim()) {
+    CHECK_ARGUMENT(false, "dimension out of range");
   }
-  std::cerr << "[DEBUG] Copy kind determined: " << copy_kind << std::endl;
+  if (start >= end || end > base.shape()[dim]) {
+    CHECK_ARGUMENT(false, "slice indices out of range");
+  }
+  _meta.shape[dim] = end - start;
+  _offset = base._offset + start * base.strides()[dim] * base.elementSize();
+}
 
-  // Perform memory copy
-  std::cerr << "[DEBUG] About to call memcpy_sync" << std::endl;
-  core::context().runtime().api()->memcpy_sync(this->data(), src_, copy_size,
-                                               copy_kind);
-  std::cerr << "[DEBUG] memcpy_sync completed" << std::endl;
+void Tensor::load(const void *src_) {
+  CHECK_ARGUMENT(_packing == 0, "cannot load into a packed tensor");
+  CHECK_ARGUMENT(!_storage->isReadOnly(), "cannot load into a read-only tensor");
+  core::context().setDevice(this->deviceType(), this->deviceId());
+  llaisysMemcpyKind_t copy_kind = this->deviceType() == LLAISYS_DEVICE_CPU
+                                      ? LLAISYS_MEMCPY_H2H
+                                      : LLAISYS_MEMCPY_H2D;
+  core::context().runtime().api()->memcpy_sync(
+      this->data(), src_, this->numel() * this->elementSize(), copy_kind);
 }
 
 tensor_t Tensor::contiguous() const {
+  CHECK_ARGUMENT(_packing == 0, "a packed tensor has no contiguous form");
   if (this->isContiguous()) {
     return std::shared_ptr<Tensor>(new Tensor(_meta, _storage, _offset));
   }
@@ -304,6 +400,7 @@ tensor_t Tensor::reshape(const std::vector<size_t> &shape) const {
 }
 
 tensor_t Tensor::to(llaisysDeviceType_t device_type, int device) const {
+  CHECK_ARGUMENT(_packing == 0, "cannot copy a packed tensor");
   if (this->deviceType() == device_type && this->deviceId() == device) {
     return std::shared_ptr<Tensor>(new Tensor(_meta, _storage, _offset));
   }
@@ -17,6 +17,9 @@ private:
     TensorMeta _meta;
     core::storage_t _storage;
     size_t _offset;
+    tensor_t _scales;
+    tensor_t _zeros;
+    uint64_t _packing = 0;
     Tensor(TensorMeta meta, core::storage_t storage, size_t offset = 0);
 
 public:
@@ -25,6 +28,29 @@ public:
         llaisysDataType_t dtype,
         llaisysDeviceType_t device_type = LLAISYS_DEVICE_CPU,
         int device = 0);
+    // Contiguous tensor placed `offset` bytes into existing storage, which it shares.
+    static tensor_t create(
+        const std::vector<size_t> &shape,
+        llaisysDataType_t dtype,
+        core::storage_t storage,
+        size_t offset = 0);
+    // Packed tensor: the logical shape and dtype of what it holds, in `bytes` laid out as
+    // named by the nonzero `packing` tag of the op that produced it (see ops::linear_prepack).
+    // It is not contiguous and cannot be viewed, sliced, loaded or copied.
+    static tensor_t createPacked(
+        const std::vector<size_t> &shape,
+        llaisysDataType_t dtype,
+        uint64_t packing,
+        size_t bytes,
+        llaisysDeviceType_t device_type = LLAISYS_DEVICE_CPU,
+        int device = 0);
+    static tensor_t createPacked(
+        const std::vector<size_t> &shape,
+        llaisysDataType_t dtype,
+        uint64_t packing,
+        size_t bytes,
+        core::storage_t storage,
+        size_t offset = 0);
     ~Tensor() = default;
     // Info
     std::byte *data();
@@ -42,11 +68,27 @@ public:
     void debug() const;
 
     bool isContiguous() const;
+    // 0 for ordinary strided tensors.
+    uint64_t packing() const;
+
+    // Quantization. A quantized [rows, cols] weight carries scales of shape [rows, groups],
+    // each group covering cols / groups consecutive columns, and optionally U8 zero points
+    // of the same shape. See ops::quantize for the formats. Null for plain tensors; views
+    // and copies do not carry them.
+    const tensor_t &scales() const;
+    const tensor_t &zeros() const;
+    void setScales(tensor_t scales, tensor_t zeros = nullptr);
 
     // Meta Transform
     tensor_t permute(const std::vector<size_t> &order) const;
     tensor_t slice(size_t dim, size_t start, size_t end) const;
     tensor_t view(const std::vector<size_t> &shape) const;
+    // Move this view, in place, to start at `start` along dimension `dim` of `base`, whose
+    // storage it shares; its shape and strides are kept. For a view that slides along a
+    // buffer from step to step without being rebuilt.
+    void reslice(const Tensor &base, size_t dim, size_t start);
+    // Like the above, but the view also takes the length of [start, end) along `dim`.
+    void reslice(const Tensor &base, size_t dim, size_t start, size_t end);
 
     // Load data from host memory
     void load(const void *src);
@@ -1,7 +1,9 @@
 #include "llaisys.h"
 
+#include <cstdint>
 #include <iostream>
 #include <stdexcept>
+#include <vector>
 
 namespace llaisys {
 struct CustomFloat16 {
@@ -55,12 +57,26 @@ inline size_t dsize(llaisysDataType_t dtype) {
         return 8; // 8 bytes complex
     case LLAISYS_DTYPE_C128:
         return 16; // 16 bytes complex
+    case LLAISYS_DTYPE_Q4:
+        return 1; // two packed 4-bit values
     case LLAISYS_DTYPE_INVALID:
     default:
         throw std::invalid_argument("Unsupported or invalid data type.");
     }
 }
 
+// Bytes of a dense tensor of `shape` and `dtype` into `bytes`; false if that overflows.
+inline bool tensorBytes(const std::vector<size_t> &shape, llaisysDataType_t dtype, size_t &bytes) {
+    bytes = dsize(dtype);
+    for (size_t s : shape) {
+        if (s != 0 && bytes > SIZE_MAX / s) {
+            return false;
+        }
+        bytes *= s;
+    }
+    return true;
+}
+
 inline const char *dtype_to_str(llaisysDataType_t dtype) {
     switch (dtype) {
     case LLAISYS_DTYPE_BYTE:
@@ -101,6 +117,8 @@ inline const char *dtype_to_str(llaisysDataType_t dtype) {
         return "complex64";
     case LLAISYS_DTYPE_C128:
         return "complex128";
+    case LLAISYS_DTYPE_Q4:
+        return "q4";
     case LLAISYS_DTYPE_INVALID:
     default:
         throw std::invalid_argument("Unsupported or invalid data type.");
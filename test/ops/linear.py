@@ -5,7 +5,8 @@ parent_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
 sys.path.insert(0, parent_dir)
 import llaisys
 import torch
-from test_utils import random_tensor, check_equal, benchmark
+from test_utils import random_tensor, zero_tensor, arrange_tensor, check_equal, benchmark, torch_device, device_name
+from rope import torch_rope
 
 
 def torch_linear(out, x, w, bias):
@@ -45,6 +46,337 @@ def test_op_linear(
         )
 
 
+def torch_quantize(w):
+    # Symmetric per-output-channel int8, as Ops.quantize computes it.
+    wf = w.float()
+    amax = wf.abs().amax(dim=1, keepdim=True)
+    inv = torch.where(amax > 0, 127.0 / amax, torch.zeros_like(amax))
+    q = torch.round(wf * inv).clamp(-127, 127)
+    return q.to(torch.int8), amax / 127.0
+
+
+def test_op_linear_int8(
+    out_shape,
+    x_shape,
+    w_shape,
+    use_bias=True,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+    profile=False,
+):
+    print(f"   out {out_shape}, x {x_shape}, w {w_shape} int8, bias {use_bias}, dtype <{dtype_name}>")
+    x, x_ = random_tensor(x_shape, dtype_name, device_name, scale=0.1)
+    w, w_ = random_tensor(w_shape, dtype_name, device_name, scale=0.01, bias=-0.005)
+
+    bias, bias_ = None, None
+    if use_bias:
+        bias, bias_ = random_tensor((w_shape[0],), dtype_name, device_name)
+
+    q, scales = torch_quantize(w)
+    _, q_ = zero_tensor(w_shape, "i8", device_name)
+    _, scales_ = zero_tensor((w_shape[0], 1), "f32", device_name)
+    llaisys.Ops.quantize(q_, scales_, w_)
+    assert check_equal(q_, q, strict=True)
+    assert check_equal(scales_, scales, strict=True)
+
+    # The reference uses the dequantized weight, so only the kernel's error is measured.
+    out, out_ = random_tensor(out_shape, dtype_name, device_name)
+    w_deq = q.float() * scales
+    out = torch.nn.functional.linear(
+        x.float(), w_deq, None if bias is None else bias.float()
+    ).to(out.dtype)
+    llaisys.Ops.linear(out_, x_, q_, bias_)
+
+    assert check_equal(out_, out, atol=atol, rtol=rtol)
+
+    if profile:
+        benchmark(
+            lambda: torch_linear(out, x, w, bias),
+            lambda: llaisys.Ops.linear(out_, x_, q_, bias_),
+            device_name,
+        )
+
+
+def test_op_linear_prepacked(
+    out_shape,
+    x_shape,
+    w_shape,
+    use_bias=True,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+    profile=False,
+):
+    print(f"   out {out_shape}, x {x_shape}, w {w_shape} prepacked, bias {use_bias}, dtype <{dtype_name}>")
+    x, x_ = random_tensor(x_shape, dtype_name, device_name, scale=0.1)
+    w, w_ = random_tensor(w_shape, dtype_name, device_name, scale=0.01)
+
+    bias, bias_ = None, None
+    if use_bias:
+        bias, bias_ = random_tensor((w_shape[0],), dtype_name, device_name)
+
+    packed_ = llaisys.Ops.linear_prepack(w_)
+    assert packed_.shape() == w_shape and packed_.dtype() == w_.dtype()
+
+    # Same arithmetic as the raw weight, so the results match it, not just torch.
+    out, out_ = random_tensor(out_shape, dtype_name, device_name)
+    _, raw_ = random_tensor(out_shape, dtype_name, device_name)
+    torch_linear(out, x, w, bias)
+    llaisys.Ops.linear(out_, x_, packed_, bias_)
+    llaisys.Ops.linear(raw_, x_, w_, bias_)
+
+    assert check_equal(out_, out, atol=atol, rtol=rtol)
+    assert check_equal(out_, read_back(raw_, out.dtype), atol=atol, rtol=rtol)
+
+    if profile:
+        benchmark(
+            lambda: llaisys.Ops.linear(raw_, x_, w_, bias_),
+            lambda: llaisys.Ops.linear(out_, x_, packed_, bias_),
+            device_name,
+        )
+
+
+def test_op_linear_qkv(
+    x_shape,
+    qkv_features,
+    use_bias=True,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+    profile=False,
+):
+    print(f"   x {x_shape}, q/k/v {qkv_features} fused, bias {use_bias}, dtype <{dtype_name}>")
+    n, in_features = x_shape
+    x, x_ = random_tensor(x_shape, dtype_name, device_name, scale=0.1)
+    ws = [random_tensor((f, in_features), dtype_name, device_name, scale=0.01) for f in qkv_features]
+    bs = [random_tensor((f,), dtype_name, device_name) if use_bias else (None, None) for f in qkv_features]
+
+    packed_ = llaisys.Ops.linear_prepack_qkv(*(w_ for _, w_ in ws))
+    assert packed_.shape() == (sum(qkv_features), in_features)
+
+    # v lands in rows of a larger buffer, as it does in a KV cache.
+    q, q_ = random_tensor((n, qkv_features[0]), dtype_name, device_name)
+    k, k_ = random_tensor((n, qkv_features[1]), dtype_name, device_name)
+    _, cache_ = random_tensor((n + 3, qkv_features[2]), dtype_name, device_name)
+    v_ = cache_.slice(0, 2, 2 + n)
+    llaisys.Ops.linear_qkv(q_, k_, v_, x_, packed_, *(b_ for _, b_ in bs))
+
+    for out_, (w, _), (b, _) in zip((q_, k_, v_), ws, bs):
+        assert check_equal(out_, torch.nn.functional.linear(x, w, b), atol=atol, rtol=rtol)
+
+    if profile:
+        def unfused():
+            for out_, (_, w_), (_, b_) in zip((q_, k_, v_), ws, bs):
+                llaisys.Ops.linear(out_, x_, w_, b_)
+
+        benchmark(
+            unfused,
+            lambda: llaisys.Ops.linear_qkv(q_, k_, v_, x_, packed_, *(b_ for _, b_ in bs)),
+            device_name,
+        )
+
+
+def test_op_linear_qkv_rope(
+    x_shape,
+    heads,
+    start,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+):
+    nh, nkvh, dh = heads
+    print(f"   x {x_shape}, heads {heads} from position {start} fused with rope, dtype <{dtype_name}>")
+    n, in_features = x_shape
+    theta = 10000.0
+    x, x_ = random_tensor(x_shape, dtype_name, device_name, scale=0.1)
+    ws = [random_tensor((f, in_features), dtype_name, device_name, scale=0.01) for f in (nh * dh, nkvh * dh, nkvh * dh)]
+    bs = [random_tensor((w.shape[0],), dtype_name, device_name) for w, _ in ws]
+    packed_ = llaisys.Ops.linear_prepack_qkv(*(w_ for _, w_ in ws))
+    pos_ids, pos_ids_ = arrange_tensor(start, start + n, device_name)
+    _, table_ = zero_tensor((start + n, dh), "f32", device_name)
+    llaisys.Ops.rope_table(table_, theta)
+
+    q, q_ = random_tensor((n, nh, dh), dtype_name, device_name)
+    k, k_ = random_tensor((n, nkvh, dh), dtype_name, device_name)
+    v, v_ = random_tensor((n, nkvh * dh), dtype_name, device_name)
+    llaisys.Ops.linear_qkv(q_, k_, v_, x_, packed_, *(b_ for _, b_ in bs), pos_ids_, table_)
+
+    # Rotating the float products before rounding can differ from rotating rounded ones by an ulp.
+    for out, out_, (w, _), (b, _) in zip((q, k), (q_, k_), ws, bs):
+        proj = torch.nn.functional.linear(x.float(), w.float(), b.float()).view(out.shape)
+        ref = torch.empty_like(proj)
+        torch_rope(ref, proj, pos_ids, theta)
+        assert check_equal(out_, ref.to(out.dtype), atol=atol, rtol=rtol)
+    assert check_equal(v_, torch.nn.functional.linear(x, ws[2][0], bs[2][0]), atol=atol, rtol=rtol)
+
+
+def test_op_linear_swiglu(
+    out_shape,
+    x_shape,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+    profile=False,
+):
+    print(f"   out {out_shape}, x {x_shape} gate/up swiglu, dtype <{dtype_name}>")
+    w_shape = (out_shape[1], x_shape[1])
+    x, x_ = random_tensor(x_shape, dtype_name, device_name, scale=0.1)
+    gate, gate_ = random_tensor(w_shape, dtype_name, device_name, scale=0.05)
+    up, up_ = random_tensor(w_shape, dtype_name, device_name, scale=0.05)
+
+    gate_up_ = llaisys.Ops.linear_prepack_gate_up(gate_, up_)
+    assert gate_up_.shape() == (2 * w_shape[0], w_shape[1]) and gate_up_.dtype() == gate_.dtype()
+
+    out, out_ = random_tensor(out_shape, dtype_name, device_name)
+    g = torch.nn.functional.linear(x.float(), gate.float())
+    u = torch.nn.functional.linear(x.float(), up.float())
+    out = (g / (1 + torch.exp(-g)) * u).to(out.dtype)
+    llaisys.Ops.linear_swiglu(out_, x_, gate_up_)
+
+    assert check_equal(out_, out, atol=atol, rtol=rtol)
+
+    if profile:
+        _, g_ = random_tensor(out_shape, dtype_name, device_name)
+        _, u_ = random_tensor(out_shape, dtype_name, device_name)
+        gate_p_ = llaisys.Ops.linear_prepack(gate_)
+        up_p_ = llaisys.Ops.linear_prepack(up_)
+
+        def unfused():
+            llaisys.Ops.linear(g_, x_, gate_p_)
+            llaisys.Ops.linear(u_, x_, up_p_)
+            llaisys.Ops.swiglu(out_, g_, u_)
+
+        benchmark(unfused, lambda: llaisys.Ops.linear_swiglu(out_, x_, gate_up_), device_name)
+
+
+def read_back(t: llaisys.Tensor, torch_dtype_):
+    # Copy a llaisys tensor into a torch tensor of the same bytes.
+    out = torch.zeros(t.shape(), dtype=torch_dtype_, device=torch_device(device_name(t.device_type())))
+    api = llaisys.RuntimeAPI(t.device_type())
+    api.memcpy_sync(out.data_ptr(), t.data_ptr(), out.numel() * out.element_size(), llaisys.MemcpyKind.D2D)
+    return out
+
+
+def test_op_linear_topk(
+    x_shape,
+    w_shape,
+    topk,
+    weight_format="raw",
+    dtype_name="f32",
+    device_name="cpu",
+    profile=False,
+):
+    print(f"   x {x_shape}, w {w_shape} {weight_format}, top {topk}, dtype <{dtype_name}>")
+    x, x_ = random_tensor(x_shape, dtype_name, device_name, scale=0.1)
+    w, w_ = random_tensor(w_shape, dtype_name, device_name, scale=0.01, bias=-0.005)
+    if weight_format == "packed":
+        w_ = llaisys.Ops.linear_prepack(w_)
+    elif weight_format == "i8":
+        _, q_ = zero_tensor(w_shape, "i8", device_name)
+        _, scales_ = zero_tensor((w_shape[0], 1), "f32", device_name)
+        llaisys.Ops.quantize(q_, scales_, w_)
+        w_ = q_
+
+    # The selection must be exactly linear + a stable descending sort of its outputs.
+    out, out_ = zero_tensor((x_shape[0], w_shape[0]), dtype_name, device_name)
+    llaisys.Ops.linear(out_, x_, w_)
+    logits = read_back(out_, out.dtype)
+    ref_idx, ref_val = [], []
+    for row in logits.float().tolist():
+        best = sorted(range(len(row)), key=lambda j: (-row[j], j))[:topk]
+        ref_idx.append(best)
+        ref_val.append([row[j] for j in best])
+
+    idx, idx_ = zero_tensor((x_shape[0], topk), "i64", device_name)
+    val, val_ = zero_tensor((x_shape[0], topk), dtype_name, device_name)
+    llaisys.Ops.linear_topk(idx_, val_, x_, w_)
+    assert check_equal(idx_, torch.tensor(ref_idx, dtype=torch.int64), strict=True)
+    assert check_equal(val_, torch.tensor(ref_val, dtype=torch.float32).to(out.dtype), strict=True)
+
+    if profile:
+        def unfused():
+            llaisys.Ops.linear(out_, x_, w_)
+            llaisys.Ops.argmax(idx_, val_, out_)
+
+        benchmark(unfused, lambda: llaisys.Ops.linear_topk(idx_, val_, x_, w_), device_name)
+
+
+def torch_dequantize_q4(w, scales, zeros):
+    # Recompute the Q4 codes from llaisys's scales and zero points, as Ops.quantize does,
+    # and return them packed the way LLAISYS_DTYPE_Q4 stores them plus the dequantized weight.
+    rows, cols = w.shape
+    groups = scales.shape[1]
+    wf = w.float().view(rows, groups, -1)
+    s = scales.float().unsqueeze(-1)
+    z = torch.full_like(s, 8.0) if zeros is None else zeros.float().unsqueeze(-1)
+    inv = torch.where(s > 0, 1.0 / s, torch.zeros_like(s))
+    q = (torch.round(wf * inv) + z).clamp(0, 15)
+    w_deq = ((q - z) * s).view(rows, cols)
+    q = q.to(torch.uint8).view(rows, cols // 32, 2, 16)
+    packed = (q[:, :, 0, :] | (q[:, :, 1, :] << 4)).reshape(rows, cols // 2)
+    return packed, w_deq
+
+
+def test_op_linear_q4(
+    out_shape,
+    x_shape,
+    w_shape,
+    use_bias=True,
+    group=32,
+    asymmetric=False,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+    profile=False,
+):
+    print(
+        f"   out {out_shape}, x {x_shape}, w {w_shape} q4/{group}{' asym' if asymmetric else ''}, "
+        f"bias {use_bias}, dtype <{dtype_name}>"
+    )
+    x, x_ = random_tensor(x_shape, dtype_name, device_name, scale=0.1)
+    w, w_ = random_tensor(w_shape, dtype_name, device_name, scale=0.01, bias=-0.003)
+
+    bias, bias_ = None, None
+    if use_bias:
+        bias, bias_ = random_tensor((w_shape[0],), dtype_name, device_name)
+
+    rows, cols = w_shape
+    groups = cols // group
+    _, q_ = zero_tensor((rows, cols // 2), "q4", device_name)
+    _, scales_ = zero_tensor((rows, groups), "f16", device_name)
+    zeros_ = zero_tensor((rows, groups), "u8", device_name)[1] if asymmetric else None
+    llaisys.Ops.quantize(q_, scales_, w_, zeros_)
+
+    scales = read_back(scales_, torch.float16)
+    zeros = read_back(zeros_, torch.uint8) if asymmetric else None
+    packed, w_deq = torch_dequantize_q4(w, scales, zeros)
+    assert check_equal(q_, packed, strict=True)
+    # The scales must fit the group: the quantized weight stays within a step of the input.
+    assert (w_deq - w.float()).abs().max() <= scales.float().max() * (1 if asymmetric else 0.5) + 1e-6
+
+    out, out_ = random_tensor(out_shape, dtype_name, device_name)
+    out = torch.nn.functional.linear(
+        x.float(), w_deq, None if bias is None else bias.float()
+    ).to(out.dtype)
+    llaisys.Ops.linear(out_, x_, q_, bias_)
+
+    assert check_equal(out_, out, atol=atol, rtol=rtol)
+
+    if profile:
+        benchmark(
+            lambda: torch_linear(out, x, w, bias),
+            lambda: llaisys.Ops.linear(out_, x_, q_, bias_),
+            device_name,
+        )
+
+
 if __name__ == "__main__":
     import argparse
 
@@ -67,4 +399,81 @@ if __name__ == "__main__":
         for dtype_name, atol, rtol in testDtypePrec:
             test_op_linear(*shapes, dtype_name, atol, rtol, args.device, args.profile)
 
+    print(f"Testing Ops.linear with prepacked weights on {args.device}")
+    packedShapes = [
+        ((2, 3), (2, 4), (3, 4), True),
+        ((1, 517), (1, 300), (517, 300), False),
+        ((3, 1000), (3, 1536), (1000, 1536), True),
+        ((100, 777), (100, 600), (777, 600), True),
+        ((512, 4096), (512, 4096), (4096, 4096), True),
+    ]
+    for shapes in packedShapes:
+        for dtype_name, atol, rtol in testDtypePrec:
+            test_op_linear_prepacked(*shapes, dtype_name, atol, rtol, args.device, args.profile)
+
+    print(f"Testing Ops.linear_qkv on {args.device}")
+    qkvShapes = [
+        ((1, 4), (3, 2, 2), True),
+        ((1, 1536), (1536, 256, 256), True),
+        ((3, 300), (100, 20, 20), False),
+        ((100, 600), (96, 40, 40), True),
+        ((0, 300), (100, 20, 20), True),
+    ]
+    for shapes in qkvShapes:
+        for dtype_name, atol, rtol in testDtypePrec:
+            test_op_linear_qkv(*shapes, dtype_name, atol, rtol, args.device, args.profile)
+
+    print(f"Testing Ops.linear_qkv with rope on {args.device}")
+    qkvRopeShapes = [
+        ((1, 64), (2, 1, 8), 5),
+        ((1, 1536), (12, 2, 128), 100),
+        ((100, 600), (14, 2, 64), 0),
+        ((3, 300), (4, 2, 6), 7),  # heads straddle the kernel blocks, rotated afterwards
+    ]
+    for shapes in qkvRopeShapes:
+        for dtype_name, atol, rtol in testDtypePrec:
+            test_op_linear_qkv_rope(*shapes, dtype_name, atol, rtol, args.device)
+
+    print(f"Testing Ops.linear_topk on {args.device}")
+    topkShapes = [
+        ((1, 4), (3, 4), 1),
+        ((1, 896), (4099, 896), 1),
+        ((1, 896), (4099, 896), 40),
+        ((3, 300), (1000, 300), 5),
+    ]
+    for shapes in topkShapes:
+        for weight_format in ("raw", "packed", "i8"):
+            for dtype_name, _, _ in testDtypePrec:
+                test_op_linear_topk(*shapes, weight_format, dtype_name, args.device)
+
+    print(f"Testing Ops.linear_swiglu on {args.device}")
+    swigluShapes = [
+        ((1, 3), (1, 4)),
+        ((1, 8960), (1, 1536)),
+        ((3, 1000), (3, 300)),
+        ((100, 777), (100, 600)),
+    ]
+    for shapes in swigluShapes:
+        for dtype_name, atol, rtol in testDtypePrec:
+            test_op_linear_swiglu(*shapes, dtype_name, atol, rtol, args.device, args.profile)
+
+    print(f"Testing Ops.linear with int8 weights on {args.device}")
+    for shapes in testShapes + [((1, 4096), (1, 4096), (4096, 4096), False)]:
+        for dtype_name, atol, rtol in testDtypePrec:
+            test_op_linear_int8(*shapes, dtype_name, atol, rtol, args.device, args.profile)
+
+    print(f"Testing Ops.linear with 4-bit weights on {args.device}")
+    q4Shapes = [
+        ((2, 3), (2, 256), (3, 256), True),
+        ((1, 4096), (1, 4096), (4096, 4096), False),
+        ((512, 4096), (512, 4096), (4096, 4096), True),
+    ]
+    for shapes in q4Shapes:
+        for group in [32, 128]:
+            for asymmetric in [False, True]:
+                for dtype_name, atol, rtol in testDtypePrec:
+                    test_op_linear_q4(
+                        *shapes, group, asymmetric, dtype_name, atol, rtol, args.device, args.profile
+                    )
+
     print("\033[92mTest passed!\033[0m\n")
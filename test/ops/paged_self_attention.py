@@ -0,0 +1,85 @@
+import sys
+import os
+
+parent_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+sys.path.insert(0, parent_dir)
+import llaisys
+import torch
+from test_utils import random_tensor, random_int_tensor, check_equal, benchmark
+from self_attention import torch_self_attention
+
+
+def torch_gather_blocks(blocks, block_table, kv_len):
+    # [num_blocks, block_size, nkvh, hd] -> [kv_len, nkvh, hd] in block table order
+    return blocks[block_table].flatten(0, 1)[:kv_len]
+
+
+def test_op_paged_self_attention(
+    qlen,
+    kvlen,
+    nh,
+    nkvh,
+    hd,
+    block_size,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+    profile=False,
+):
+    print(
+        f"   qlen={qlen} kvlen={kvlen} nh={nh} nkvh={nkvh} hd={hd} block_size={block_size} dtype <{dtype_name}>"
+    )
+    nblocks = (kvlen + block_size - 1) // block_size
+    num_blocks = 2 * nblocks + 1
+    q, q_ = random_tensor((qlen, nh, hd), dtype_name, device_name)
+    k_blocks, k_blocks_ = random_tensor((num_blocks, block_size, nkvh, hd), dtype_name, device_name)
+    v_blocks, v_blocks_ = random_tensor((num_blocks, block_size, nkvh, hd), dtype_name, device_name)
+    block_table, block_table_ = random_int_tensor((nblocks,), device_name, low=0, high=num_blocks)
+    scale = 1.0 / (hd**0.5)
+
+    k = torch_gather_blocks(k_blocks, block_table, kvlen)
+    v = torch_gather_blocks(v_blocks, block_table, kvlen)
+    attn_val, attn_val_ = random_tensor((qlen, nh, hd), dtype_name, device_name)
+    torch_self_attention(attn_val, q, k, v, scale)
+    llaisys.Ops.paged_self_attention(attn_val_, q_, k_blocks_, v_blocks_, block_table_, kvlen, scale)
+    assert check_equal(attn_val_, attn_val, atol=atol, rtol=rtol)
+
+    if profile:
+        benchmark(
+            lambda: torch_self_attention(attn_val, q, k, v, scale),
+            lambda: llaisys.Ops.paged_self_attention(
+                attn_val_, q_, k_blocks_, v_blocks_, block_table_, kvlen, scale
+            ),
+            device_name,
+        )
+
+
+if __name__ == "__main__":
+    import argparse
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--device", default="cpu", choices=["cpu", "nvidia"], type=str)
+    parser.add_argument("--profile", action="store_true")
+    args = parser.parse_args()
+    testShapes = [
+        # qlen, kvlen, nh, nkvh, hd, block_size
+        (1, 11, 4, 2, 8, 4),
+        # blocks smaller than a KV tile, with a partly filled last block
+        (70, 200, 6, 3, 72, 7),
+        (1, 300, 12, 2, 128, 16),
+    ]
+    testDtypePrec = [
+        # type, atol, rtol
+        ("f32", 1e-5, 1e-5),
+        ("f16", 1e-3, 1e-3),
+        ("bf16", 1e-2, 1e-2),
+    ]
+    print(f"Testing Ops.paged_self_attention on {args.device}")
+    for shape in testShapes:
+        for dtype_name, atol, rtol in testDtypePrec:
+            test_op_paged_self_attention(
+                *shape, dtype_name, atol, rtol, args.device, args.profile
+            )
+
+    print("\033[92mTest passed!\033[0m\n")
@@ -5,7 +5,7 @@ parent_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
 sys.path.insert(0, parent_dir)
 import llaisys
 import torch
-from test_utils import arrange_tensor, random_tensor, check_equal, benchmark
+from test_utils import arrange_tensor, random_tensor, zero_tensor, check_equal, benchmark
 
 
 def torch_rope(y: torch.Tensor, x: torch.Tensor, pos_ids: torch.Tensor, theta: float):
@@ -59,6 +59,41 @@ def test_op_rope(
         )
 
 
+def test_op_rope_cached(
+    shape,
+    start_end,
+    dtype_name="f32",
+    atol=1e-5,
+    rtol=1e-5,
+    device_name="cpu",
+    profile=False,
+):
+    print(f"   shape {shape} range {start_end} dtype <{dtype_name}> cached")
+    head_dim = shape[2]
+    x, x_ = random_tensor(shape, dtype_name, device_name)
+    pos_ids, pos_ids_ = arrange_tensor(start_end[0], start_end[1], device_name)
+    theta = 10000.0
+    # The table covers every position up to the end of the range, as a model's covers maxseq.
+    positions = torch.arange(0, start_end[1], dtype=torch.float32).unsqueeze(1)
+    i = torch.arange(0, head_dim // 2, dtype=torch.float32)
+    freqs = positions / (theta ** (2 * i / head_dim))
+    table, table_ = zero_tensor((start_end[1], head_dim), "f32", device_name)
+    llaisys.Ops.rope_table(table_, theta)
+    assert check_equal(table_, torch.cat([freqs.cos(), freqs.sin()], dim=1), atol=1e-4, rtol=1e-4)
+
+    y, y_ = random_tensor(shape, dtype_name, device_name)
+    torch_rope(y, x, pos_ids, theta)
+    llaisys.Ops.rope_cached(y_, x_, pos_ids_, table_)
+    assert check_equal(y_, y, atol=atol, rtol=rtol)
+
+    if profile:
+        benchmark(
+            lambda: llaisys.Ops.rope(y_, x_, pos_ids_, theta),
+            lambda: llaisys.Ops.rope_cached(y_, x_, pos_ids_, table_),
+            device_name,
+        )
+
+
 if __name__ == "__main__":
     import argparse
 
@@ -80,4 +115,9 @@ if __name__ == "__main__":
         for dtype_name, atol, rtol in testDtypePrec:
             test_op_rope(shape, start_end, dtype_name, atol, rtol, args.device, args.profile)
 
+    print(f"Testing Ops.rope_cached on {args.device}")
+    for shape, start_end in testShapes:
+        for dtype_name, atol, rtol in testDtypePrec:
+            test_op_rope_cached(shape, start_end, dtype_name, atol, rtol, args.device, args.profile)
+
     print("\033[92mTest passed!\033[0m\n")
@@ -0,0 +1,123 @@
+import sys
+import os
+import math
+
+parent_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), ".."))
+sys.path.insert(0, parent_dir)
+import llaisys
+import torch
+from test_utils import random_tensor, zero_tensor, benchmark, llaisys_device
+
+
+def expected_probs(logits, history, temperature, top_k, top_p, repetition_penalty, presence_penalty):
+    # The distribution Ops.sample draws from, as {token: probability}.
+    logits = list(logits)
+    for t in set(history):
+        x = logits[t]
+        logits[t] = (x / repetition_penalty if x > 0 else x * repetition_penalty) - presence_penalty
+    order = sorted(range(len(logits)), key=lambda i: (-logits[i], i))
+    if top_k > 0:
+        order = order[:top_k]
+    weights = [math.exp((logits[i] - logits[order[0]]) / temperature) for i in order]
+    keep = len(order)
+    if top_p < 1.0:
+        cum, keep = 0.0, 0
+        while keep < len(order) and cum < top_p * sum(weights):
+            cum += weights[keep]
+            keep += 1
+        keep = max(keep, 1)
+    total = sum(weights[:keep])
+    return {order[i]: weights[i] / total for i in range(keep)}
+
+
+def history_tensor(history, device_name):
+    t = llaisys.Tensor((len(history),), dtype=llaisys.DataType.I64, device=llaisys_device(device_name))
+    t.load((torch.tensor(history, dtype=torch.int64)).data_ptr())
+    return t
+
+
+def draw(idx_, logits_, history_, seed, **params):
+    llaisys.Ops.sample(idx_, logits_, history_, seed=seed, **params)
+    out = torch.zeros((1,), dtype=torch.int64)
+    api = llaisys.RuntimeAPI(idx_.device_type())
+    api.memcpy_sync(out.data_ptr(), idx_.data_ptr(), 8, llaisys.MemcpyKind.D2D)
+    return int(out.tolist()[0])
+
+
+def test_op_sample(
+    voc,
+    params,
+    history=(),
+    ndraw=0,
+    dtype_name="f32",
+    device_name="cpu",
+    profile=False,
+):
+    print(f"   voc {voc} {params} history {len(history)} dtype <{dtype_name}>")
+    logits, logits_ = random_tensor((voc,), dtype_name, device_name, scale=8.0, bias=-4.0)
+    idx, idx_ = zero_tensor((1,), "i64", device_name)
+    history_ = history_tensor(list(history), device_name) if history else None
+    full = {
+        "temperature": 1.0,
+        "top_k": 0,
+        "top_p": 1.0,
+        "repetition_penalty": 1.0,
+        "presence_penalty": 0.0,
+        **params,
+    }
+    values = [float(x) for x in logits.float().tolist()]
+
+    if full["temperature"] <= 0 or full["top_k"] == 1:
+        expected = expected_probs(values, history, 1.0, 1, 1.0, full["repetition_penalty"], full["presence_penalty"])
+        for seed in range(8):
+            assert draw(idx_, logits_, history_, seed, **params) in expected
+        return
+
+    expected = expected_probs(values, history, **full)
+    # Equal seeds draw equal tokens.
+    assert draw(idx_, logits_, history_, 7, **params) == draw(idx_, logits_, history_, 7, **params)
+    counts = {}
+    for seed in range(ndraw):
+        t = draw(idx_, logits_, history_, seed, **params)
+        assert t in expected, f"token {t} outside the sampled set"
+        counts[t] = counts.get(t, 0) + 1
+    for t, p in expected.items():
+        freq = counts.get(t, 0) / ndraw
+        assert abs(freq - p) <= 4 * math.sqrt(p * (1 - p) / ndraw) + 0.005, (t, freq, p)
+
+    if profile:
+        benchmark(
+            lambda: torch.softmax(torch.topk(logits.float(), max(full["top_k"], 1))[0], dim=-1),
+            lambda: llaisys.Ops.sample(idx_, logits_, history_, **params),
+            device_name,
+        )
+
+
+if __name__ == "__main__":
+    import argparse
+
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--device", default="cpu", choices=["cpu", "nvidia"], type=str)
+    parser.add_argument("--profile", action="store_true")
+    args = parser.parse_args()
+    testDtype = ["f32", "f16", "bf16"]
+    testCases = [
+        # voc, params, history, draws
+        (64, {"temperature": 0.0}, (), 0),
+        (64, {"top_k": 1, "repetition_penalty": 1e9}, (3, 5, 3), 0),
+        (16, {"temperature": 1.0}, (), 3000),
+        (16, {"temperature": 0.5, "top_k": 5}, (), 3000),
+        (16, {"temperature": 1.5, "top_p": 0.7}, (), 3000),
+        (16, {"top_k": 8, "top_p": 0.9, "repetition_penalty": 1.3, "presence_penalty": 0.5}, (1, 2, 2, 9), 3000),
+        (1000, {"temperature": 0.8, "top_p": 0.5}, (), 500),
+        (1000, {"temperature": 4.0, "top_p": 0.9}, (), 500),
+        (1000, {"temperature": 0.8, "top_k": 40, "top_p": 0.95}, tuple(range(0, 1000, 7)), 500),
+    ]
+    print(f"Testing Ops.sample on {args.device}")
+    for voc, params, history, ndraw in testCases:
+        for dtype_name in testDtype:
+            test_op_sample(voc, params, history, ndraw, dtype_name, args.device)
+    if args.profile:
+        test_op_sample(151936, {"temperature": 0.8, "top_k": 50, "top_p": 0.9}, (), 10, "bf16", args.device, True)
+
+    print("\033[92mTest passed!\033[0m\n")
@@ -72,6 +72,10 @@ if __name__ == "__main__":
         # qlen, kvlen, nh, nkvh, hd
         (2, 2, 1, 1, 4),
         (5, 11, 4, 2, 8),
+        # several query blocks and KV tiles, with fully masked causal tiles
+        (70, 200, 6, 3, 72),
+        # head group larger than one block of rows
+        (9, 40, 40, 1, 24),
     ]
     testDtypePrec = [
         # type, atol, rtol
@@ -54,8 +54,8 @@ def hf_infer(
     return outputs[0].tolist(), result
 
 
-def load_llaisys_model(model_path, device_name):
-    model = llaisys.models.Qwen2(model_path, llaisys_device(device_name))
+def load_llaisys_model(model_path, device_name, weight_dtype=None):
+    model = llaisys.models.Qwen2(model_path, llaisys_device(device_name), weight_dtype=weight_dtype)
     return model
 
 
@@ -79,6 +79,15 @@ def llaisys_infer(
     return outputs, tokenizer.decode(outputs, skip_special_tokens=True)
 
 
+def test_batch(model, inputs, max_new_tokens, **scheduler_args):
+    # Greedy generations through the scheduler must match running each prompt alone.
+    expected = [model.generate(x, max_new_tokens=max_new_tokens, top_k=1) for x in inputs]
+    scheduler = model.scheduler(**scheduler_args)
+    outputs = scheduler.generate(inputs, max_new_tokens=max_new_tokens, top_k=1)
+    print(f"{len(inputs)} prompts through the scheduler with {scheduler_args}")
+    assert outputs == expected
+
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser()
     parser.add_argument("--device", default="cpu", choices=["cpu", "nvidia"], type=str)
@@ -89,9 +98,56 @@ if __name__ == "__main__":
     parser.add_argument("--top_k", default=50, type=int)
     parser.add_argument("--temperature", default=1.0, type=float)
     parser.add_argument("--test", action="store_true")
+    parser.add_argument("--int8", action="store_true", help="quantize linear weights to int8")
+    parser.add_argument("--q4", action="store_true", help="quantize linear weights to 4 bits")
+    parser.add_argument(
+        "--batch",
+        action="store_true",
+        help="check Qwen2Scheduler against generate on several prompts instead",
+    )
+    parser.add_argument(
+        "--min_match",
+        default=None,
+        type=int,
+        help="leading tokens a quantized --test must match (default 16 for int8, 4 for q4)",
+    )
 
     args = parser.parse_args()
 
+    if args.batch:
+        model_path = args.model
+        if not (model_path and os.path.isdir(model_path)):
+            model_path = snapshot_download("deepseek-ai/DeepSeek-R1-Distill-Qwen-1.5B")
+        tokenizer = AutoTokenizer.from_pretrained(model_path, trust_remote_code=True)
+        prompts = [args.prompt, "Hi", "What is 17 times 23?", "Write a haiku about autumn leaves.", "Name three colors."]
+        inputs = [
+            tokenizer.encode(
+                tokenizer.apply_chat_template(
+                    conversation=[{"role": "user", "content": p}], add_generation_prompt=True, tokenize=False
+                )
+            )
+            for p in prompts
+        ]
+        # The KV cache pool is sized for a single full sequence, so running every prompt at
+        # once runs it dry and preempts requests.
+        max_seq_len = max(len(x) for x in inputs) + args.max_steps
+        block_size = 16
+        model = llaisys.models.Qwen2(model_path, llaisys_device(args.device), max_seq_len=max_seq_len)
+        # Whole prompts per step, then chunks shorter than any prompt, so that each prompt
+        # is prefilled over several steps while the requests admitted before it decode.
+        for prefill_chunk in (max_seq_len, 5):
+            test_batch(
+                model,
+                inputs,
+                args.max_steps,
+                max_batch=len(inputs),
+                num_blocks=-(-max_seq_len // block_size),
+                block_size=block_size,
+                prefill_chunk=prefill_chunk,
+            )
+        print("\033[92mTest passed!\033[0m\n")
+        sys.exit(0)
+
     top_p, top_k, temperature = args.top_p, args.top_k, args.temperature
     if args.test:
         top_p, top_k, temperature = 1.0, 1, 1.0
@@ -122,7 +178,12 @@ if __name__ == "__main__":
     print("\n")
     print(f"Time elapsed: {(end_time - start_time):.2f}s\n")
 
-    model = load_llaisys_model(model_path, args.device)
+    weight_dtype = None
+    if args.int8:
+        weight_dtype = llaisys.DataType.I8
+    elif args.q4:
+        weight_dtype = llaisys.DataType.Q4
+    model = load_llaisys_model(model_path, args.device, weight_dtype)
     start_time = time.time()
     llaisys_tokens, llaisys_output = llaisys_infer(
         args.prompt,
@@ -144,6 +205,19 @@ if __name__ == "__main__":
     print("\n")
     print(f"Time elapsed: {(end_time - start_time):.2f}s\n")
 
-    if args.test:
+    if args.test and weight_dtype is not None:
+        # Quantized weights may drift from the reference eventually, but not right away.
+        agree = 0
+        while agree < min(len(tokens), len(llaisys_tokens)) and tokens[agree] == llaisys_tokens[agree]:
+            agree += 1
+        print(f"{weight_dtype.name.lower()} output matches the reference for {agree} of {len(tokens)} tokens\n")
+        min_match = args.min_match
+        if min_match is None:
+            min_match = 16 if args.int8 else 4
+        chat = [{"role": "user", "content": args.prompt}]
+        prompt_len = len(tokenizer.encode(tokenizer.apply_chat_template(chat, add_generation_prompt=True, tokenize=False)))
+        assert agree >= min(len(tokens), prompt_len + min_match), f"only {agree - prompt_len} new tokens match"
+        print("\033[92mTest passed!\033[0m\n")
+    elif args.test:
         assert llaisys_tokens == tokens
         print("\033[92mTest passed!\033[0m\n")
@@ -53,10 +53,41 @@ def test_memcpy(api, size_bytes: int):
     torch.testing.assert_close(a, b)
 
 
+def test_caching_allocator(device_name: str = "cpu"):
+    device = llaisys_device(device_name)
+    if llaisys.RuntimeAPI(device).get_device_count() == 0:
+        return
+    print(f"Testing caching allocator on {device_name}...")
+    llaisys.set_allocator(device, llaisys.AllocatorType.CACHING)
+    llaisys.trim_memory(device)
+
+    shape = (123, 77)
+    tensor = llaisys.Tensor(shape, llaisys.DataType.F32, device)
+    assert tensor.data_ptr() % 64 == 0
+    before = llaisys.memory_stats(device)
+    assert before["bytes_in_use"] >= 123 * 77 * 4
+    del tensor
+
+    # The freed block is cached and serves the next tensor of the same size.
+    cached = llaisys.memory_stats(device)
+    assert cached["bytes_cached"] > 0
+    tensor = llaisys.Tensor(shape, llaisys.DataType.F32, device)
+    after = llaisys.memory_stats(device)
+    assert after["num_device_allocations"] == before["num_device_allocations"]
+    assert after["num_allocations"] == before["num_allocations"] + 1
+    assert after["peak_bytes_in_use"] >= after["bytes_in_use"]
+    del tensor
+
+    llaisys.trim_memory(device)
+    assert llaisys.memory_stats(device)["bytes_cached"] == 0
+    print("     Passed")
+
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser()
     parser.add_argument("--device", default="cpu", choices=["cpu", "nvidia"], type=str)
     args = parser.parse_args()
     test_basic_runtime_api(args.device)
+    test_caching_allocator(args.device)
     
     print("\033[92mTest passed!\033[0m\n")
@@ -0,0 +1,164 @@
+import llaisys
+
+import ctypes
+import json
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+import numpy as np
+
+CONFIG = {
+    "torch_dtype": "float32",
+    "num_hidden_layers": 2,
+    "hidden_size": 8,
+    "num_attention_heads": 2,
+    "num_key_value_heads": 1,
+    "intermediate_size": 16,
+    "vocab_size": 11,
+    "max_position_embeddings": 32,
+    "eos_token_id": 10,
+}
+
+LAYER_SHAPES = {
+    "input_layernorm.weight": (8,),
+    "self_attn.q_proj.weight": (8, 8),
+    "self_attn.q_proj.bias": (8,),
+    "self_attn.k_proj.weight": (4, 8),
+    "self_attn.k_proj.bias": (4,),
+    "self_attn.v_proj.weight": (4, 8),
+    "self_attn.v_proj.bias": (4,),
+    "self_attn.o_proj.weight": (8, 8),
+    "post_attention_layernorm.weight": (8,),
+    "mlp.gate_proj.weight": (16, 8),
+    "mlp.up_proj.weight": (16, 8),
+    "mlp.down_proj.weight": (8, 16),
+}
+
+
+def checkpoint_tensors():
+    # A tiny Qwen2 with tied embeddings, so it has no lm_head.weight.
+    rng = np.random.default_rng(0)
+    tensors = {
+        "model.embed_tokens.weight": rng.standard_normal((11, 8), dtype=np.float32),
+        "model.norm.weight": rng.standard_normal((8,), dtype=np.float32),
+    }
+    for layer in range(CONFIG["num_hidden_layers"]):
+        for name, shape in LAYER_SHAPES.items():
+            tensors[f"model.layers.{layer}.{name}"] = rng.standard_normal(shape, dtype=np.float32)
+    return tensors
+
+
+def write_safetensors(path, tensors, offsets=None, shapes=None, patch=None, truncate=0):
+    # `offsets` and `shapes` override the data_offsets and shapes of the named tensors, `patch`
+    # replaces (old, new) byte strings in the encoded header, and `truncate` drops bytes off the end.
+    header = {"__metadata__": {"format": "pt"}}
+    data = b""
+    for name, array in tensors.items():
+        begin = len(data)
+        data += array.tobytes()
+        header[name] = {"dtype": "F32", "shape": list(array.shape), "data_offsets": [begin, len(data)]}
+    for name, range_ in (offsets or {}).items():
+        header[name]["data_offsets"] = list(range_)
+    for name, shape in (shapes or {}).items():
+        header[name]["shape"] = list(shape)
+    encoded = json.dumps(header).encode()
+    for old, new in patch or []:
+        encoded = encoded.replace(old, new)
+    with open(path, "wb") as f:
+        f.write(struct.pack("<Q", len(encoded)))
+        f.write(encoded)
+        f.write(data[: len(data) - truncate])
+
+
+def write_model(model_dir, tensors, **kwargs):
+    with open(os.path.join(model_dir, "config.json"), "w") as f:
+        json.dump(CONFIG, f)
+    write_safetensors(os.path.join(model_dir, "model.safetensors"), tensors, **kwargs)
+
+
+def read_weight(handle, shape):
+    ptr = llaisys.libllaisys.LIB_LLAISYS.tensorGetData(handle)
+    n = int(np.prod(shape))
+    return np.ctypeslib.as_array(ctypes.cast(ptr, ctypes.POINTER(ctypes.c_float)), (n,)).reshape(shape).copy()
+
+
+def load_fails(model_dir, message):
+    # Load errors end the process, so each bad checkpoint is loaded in a child.
+    code = f"import llaisys; llaisys.models.Qwen2({model_dir!r}, prepack=False)"
+    result = subprocess.run([sys.executable, "-c", code], capture_output=True, text=True)
+    assert result.returncode != 0, "loading the bad checkpoint succeeded"
+    assert message in result.stderr, result.stderr
+
+
+def test_safetensors_load():
+    print("===Test load===")
+    tensors = checkpoint_tensors()
+    with tempfile.TemporaryDirectory() as model_dir:
+        write_model(model_dir, tensors)
+        model = llaisys.models.Qwen2(model_dir, prepack=False)
+        weights = llaisys.libllaisys.LIB_LLAISYS.llaisysQwen2ModelWeights(model._model).contents
+        embed = tensors["model.embed_tokens.weight"]
+        assert np.array_equal(read_weight(weights.in_embed, embed.shape), embed)
+        assert np.array_equal(read_weight(weights.out_embed, embed.shape), embed)
+        norm = tensors["model.norm.weight"]
+        assert np.array_equal(read_weight(weights.out_norm_w, norm.shape), norm)
+        down = tensors["model.layers.1.mlp.down_proj.weight"]
+        assert np.array_equal(read_weight(weights.mlp_down_w[1], down.shape), down)
+        k_bias = tensors["model.layers.0.self_attn.k_proj.bias"]
+        assert np.array_equal(read_weight(weights.attn_k_b[0], k_bias.shape), k_bias)
+        del model
+
+
+def test_safetensors_missing_weight():
+    print("===Test missing weight===")
+    tensors = checkpoint_tensors()
+    del tensors["model.layers.1.post_attention_layernorm.weight"]
+    with tempfile.TemporaryDirectory() as model_dir:
+        write_model(model_dir, tensors)
+        load_fails(model_dir, "Qwen2: checkpoint lacks model.layers.1.post_attention_layernorm.weight")
+
+
+def test_safetensors_truncated():
+    print("===Test truncated file===")
+    with tempfile.TemporaryDirectory() as model_dir:
+        write_model(model_dir, checkpoint_tensors(), truncate=4)
+        load_fails(model_dir, "safetensors: tensor data exceeds the file")
+
+
+def test_safetensors_bad_offsets():
+    print("===Test out-of-range data_offsets===")
+    with tempfile.TemporaryDirectory() as model_dir:
+        write_model(model_dir, checkpoint_tensors(), offsets={"model.norm.weight": (1 << 40, (1 << 40) + 32)})
+        load_fails(model_dir, "safetensors: tensor data exceeds the file")
+    with tempfile.TemporaryDirectory() as model_dir:
+        write_model(model_dir, checkpoint_tensors(), offsets={"model.norm.weight": (32, 0)})
+        load_fails(model_dir, "safetensors: malformed header")
+
+
+def test_safetensors_malformed_header():
+    print("===Test malformed header===")
+    # 2^64 + 32 wraps to the 32 bytes model.norm.weight really has.
+    with tempfile.TemporaryDirectory() as model_dir:
+        write_model(model_dir, checkpoint_tensors(), offsets={"model.norm.weight": (0, (1 << 64) + 32)})
+        load_fails(model_dir, "safetensors: malformed header")
+    # (2^62 + 8) * 4 bytes also wraps to 32.
+    with tempfile.TemporaryDirectory() as model_dir:
+        write_model(model_dir, checkpoint_tensors(), shapes={"model.norm.weight": ((1 << 62) + 8,)})
+        load_fails(model_dir, "safetensors: tensor size does not match its shape")
+    for escape in (b"\\uzzzz", b"\\u 1f0", b"\\u+1f0"):
+        with tempfile.TemporaryDirectory() as model_dir:
+            write_model(model_dir, checkpoint_tensors(), patch=[(b'"format"', b'"form' + escape + b'"')])
+            load_fails(model_dir, "safetensors: malformed header")
+
+
+if __name__ == "__main__":
+    test_safetensors_load()
+    test_safetensors_missing_weight()
+    test_safetensors_truncated()
+    test_safetensors_bad_offsets()
+    test_safetensors_malformed_header()
+
+    print("\n\033[92mTest passed!\033[0m\n")
@@ -3,6 +3,8 @@ import llaisys
 import torch
 from test_utils import *
 import argparse
+import os
+import tempfile
 
 
 def test_tensor():
@@ -49,7 +51,26 @@ def test_tensor():
     assert check_equal(llaisys_tensor_slice, torch_tensor_slice)
 
 
+def test_tensor_from_file():
+    print("===Test from_file===")
+    torch_tensor = torch.arange(60, dtype=torch_dtype("f32")).reshape(3, 4, 5)
+    header = b"x" * 13
+    with tempfile.NamedTemporaryFile(delete=False) as f:
+        f.write(header)
+        f.write(torch_tensor.numpy().tobytes())
+        path = f.name
+    try:
+        llaisys_tensor = llaisys.Tensor.from_file(path, len(header), (3, 4, 5), llaisys_dtype("f32"))
+        assert llaisys_tensor.shape() == torch_tensor.shape
+        assert check_equal(llaisys_tensor, torch_tensor)
+        assert check_equal(llaisys_tensor.slice(1, 1, 3), torch_tensor[:, 1:3, :])
+        del llaisys_tensor
+    finally:
+        os.remove(path)
+
+
 if __name__ == "__main__":
     test_tensor()
+    test_tensor_from_file()
 
     print("\n\033[92mTest passed!\033[0m\n")
@@ -11,6 +11,38 @@ target("llaisys-device-cpu")
     on_install(function (target) end)
 target_end()
 
+-- Per-ISA kernel variants. Each tier is compiled with its own instruction-set
+-- flags and only reached through runtime dispatch (src/device/cpu/cpu_isa.hpp),
+-- so the rest of the library keeps the baseline target.
+local cpu_isa_variants = {
+    {name = "sse4",   define = "LLAISYS_CPU_HAVE_SSE4",   cxflags = {"-msse4.1", "-msse4.2"}},
+    {name = "avx2",   define = "LLAISYS_CPU_HAVE_AVX2",   cxflags = {"-mavx2", "-mfma", "-mf16c"}, msvc = "/arch:AVX2"},
+    {name = "avx512", define = "LLAISYS_CPU_HAVE_AVX512", cxflags = {"-mavx512f", "-mavx512bw", "-mavx512dq", "-mavx512vl", "-mfma", "-mf16c"}, msvc = "/arch:AVX512"},
+}
+
+if is_arch("x86_64", "x64", "i386", "x86") then
+    for _, isa in ipairs(cpu_isa_variants) do
+        target("llaisys-ops-cpu-" .. isa.name)
+            set_kind("static")
+            add_deps("llaisys-tensor")
+            set_languages("cxx17")
+            set_warnings("all", "error")
+            if is_plat("windows") then
+                if isa.msvc then
+                    add_cxflags(isa.msvc)
+                end
+            else
+                add_cxflags("-fPIC", "-Wno-unknown-pragmas")
+                add_cxflags(isa.cxflags)
+            end
+
+            add_files("../src/ops/*/cpu/" .. isa.name .. "/*.cpp")
+
+            on_install(function (target) end)
+        target_end()
+    end
+end
+
 target("llaisys-ops-cpu")
     set_kind("static")
     add_deps("llaisys-tensor")
@@ -20,6 +52,13 @@ target("llaisys-ops-cpu")
         add_cxflags("-fPIC", "-Wno-unknown-pragmas")
     end
 
+    if is_arch("x86_64", "x64", "i386", "x86") then
+        for _, isa in ipairs(cpu_isa_variants) do
+            add_deps("llaisys-ops-cpu-" .. isa.name)
+            add_defines(isa.define)
+        end
+    end
+
     add_files("../src/ops/*/cpu/*.cpp")
 
     on_install(function (target) end)